@@ -1,6 +1,7 @@
 #include "analog.h"
 #include "pins.h"
 #include "protocol.h"
+#include "telemetry.h"
 
 #include "pico/stdlib.h"
 #include "hardware/spi.h"
@@ -67,8 +68,6 @@ void adc_task(void *param)
     TickType_t last_wake = xTaskGetTickCount();
     const TickType_t period = pdMS_TO_TICKS(10);  /* 100 Hz */
 
-    uint8_t serial_buf[TX_BUF_SIZE];
-
     while (1) {
         adc_packet_t pkt;
 
@@ -76,20 +75,12 @@ void adc_task(void *param)
             pkt.ch[ch] = mcp3208_read((uint8_t)ch);
         }
 
-        pkt.ts_ms = (uint16_t)(xTaskGetTickCount() & 0xFFFF);
+        pkt.ts_us = time_us_32();
 
         /* Update shared latest sample for screen task */
         memcpy((void *)&g_latest_adc, &pkt, sizeof(pkt));
 
-        int len = proto_serialize(serial_buf, sizeof(serial_buf),
-                                  PROTO_TYPE_ADC,
-                                  (const uint8_t *)&pkt, sizeof(pkt));
-        if (len > 0 && g_tx_queue) {
-            tx_item_t item;
-            item.len = (uint8_t)len;
-            memcpy(item.buf, serial_buf, (size_t)len);
-            xQueueSend(g_tx_queue, &item, 0);
-        }
+        telemetry_mark_fresh(TELEM_FRESH_ADC);
 
         vTaskDelayUntil(&last_wake, period);
     }
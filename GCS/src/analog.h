@@ -15,8 +15,8 @@ extern volatile adc_packet_t g_latest_adc;
 void analog_init(void);
 
 /**
- * FreeRTOS task: reads MCP3208 CH0-CH5 at 100 Hz, serializes type-0x01
- * packets and enqueues them on g_tx_queue.
+ * FreeRTOS task: reads MCP3208 CH0-CH5 at 100 Hz into g_latest_adc and
+ * hands each sample to the telemetry scheduler (telemetry.h).
  */
 void adc_task(void *param);
 
@@ -2,6 +2,7 @@
 #include "pins.h"
 #include "protocol.h"
 #include "system_state.h"
+#include "telemetry.h"
 
 #include "pico/stdlib.h"
 #include "hardware/i2c.h"
@@ -115,7 +116,6 @@ void digital_io_task(void *param)
     TickType_t last_wake = xTaskGetTickCount();
     const TickType_t period = pdMS_TO_TICKS(20);  /* 50 Hz */
 
-    uint8_t serial_buf[TX_BUF_SIZE];
     led_request_t req;
 
     while (1) {
@@ -192,19 +192,9 @@ void digital_io_task(void *param)
         /* -- Update shared latest state ---------------------------------- */
         g_latest_digital.port_a = s_stable_a;
         g_latest_digital.port_b = s_stable_b;
-        g_latest_digital.ts_ms  = (uint16_t)(xTaskGetTickCount() & 0xFFFF);
-
-        /* -- Serialize and enqueue full state packet --------------------- */
-        int len = proto_serialize(serial_buf, sizeof(serial_buf),
-                                  PROTO_TYPE_DIGITAL,
-                                  (const uint8_t *)&g_latest_digital,
-                                  sizeof(digital_packet_t));
-        if (len > 0 && g_tx_queue) {
-            tx_item_t item;
-            item.len = (uint8_t)len;
-            memcpy(item.buf, serial_buf, (size_t)len);
-            xQueueSend(g_tx_queue, &item, 0);
-        }
+        g_latest_digital.ts_us  = time_us_32();
+
+        telemetry_mark_fresh(TELEM_FRESH_DIGITAL);
 
         vTaskDelayUntil(&last_wake, period);
     }
@@ -22,7 +22,8 @@ void digital_io_init(void);
 
 /**
  * FreeRTOS task: reads MCP23017, applies debounce, emits input-event
- * packets on state changes, and enqueues full type-0x02 state packets.
+ * packets on state changes, and hands the full port state (g_latest_digital)
+ * to the telemetry scheduler (telemetry.h).
  */
 void digital_io_task(void *param);
 
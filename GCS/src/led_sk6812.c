@@ -21,12 +21,16 @@
 
 /*
  * Pixel buffer: 32-bit words packed as (G<<24)|(R<<16)|(B<<8)|(W<<0).
- * Brightness is applied when led_sk6812_set() is called.
+ * Brightness is applied when pixels are written (led_sk6812_set() and the
+ * partial-update calls).
  */
 static uint32_t s_pixel_buf[SK6812_MAX_PIXELS];
 static uint8_t  s_num_pixels = 0;
 static volatile uint8_t s_brightness = 255;
 
+/* Palette for indexed updates — raw GRBW, brightness applied on use */
+static uint8_t  s_palette[SK6812_PALETTE_SIZE][4];
+
 static int               s_dma_chan = -1;
 static SemaphoreHandle_t s_dma_sem  = NULL;
 
@@ -182,6 +186,37 @@ void led_sk6812_set_worklight(uint8_t on, uint8_t r, uint8_t g, uint8_t b)
         s_num_pixels = needed;
 }
 
+/* GRBW bytes → pixel word with brightness applied per channel */
+static uint32_t grbw_to_word(const uint8_t *grbw, uint8_t br)
+{
+    uint8_t g = (uint8_t)(((uint16_t)grbw[0] * br) >> 8);
+    uint8_t r = (uint8_t)(((uint16_t)grbw[1] * br) >> 8);
+    uint8_t b = (uint8_t)(((uint16_t)grbw[2] * br) >> 8);
+    uint8_t w = (uint8_t)(((uint16_t)grbw[3] * br) >> 8);
+    return ((uint32_t)g << 24) |
+           ((uint32_t)r << 16) |
+           ((uint32_t)b <<  8) |
+           ((uint32_t)w      );
+}
+
+/* Clamp [start, start+count) to the strip; returns the clamped count */
+static uint8_t clamp_span(uint8_t start, uint16_t count)
+{
+    if (start >= SK6812_MAX_PIXELS) return 0;
+    if (count > (uint16_t)(SK6812_MAX_PIXELS - start))
+        count = (uint16_t)(SK6812_MAX_PIXELS - start);
+    return (uint8_t)count;
+}
+
+/* Make sure the next DMA transfer reaches pixel end-1 of a write that
+   began at start; a write that fell wholly off the strip covers nothing */
+static void cover_pixels(uint16_t start, uint16_t end)
+{
+    if (end > SK6812_MAX_PIXELS) end = SK6812_MAX_PIXELS;
+    if (end <= start) return;
+    if (end > s_num_pixels) s_num_pixels = (uint8_t)end;
+}
+
 void led_sk6812_set(const uint8_t *pixel_data, uint8_t num_pixels)
 {
     if (num_pixels > SK6812_MAX_PIXELS) num_pixels = SK6812_MAX_PIXELS;
@@ -189,15 +224,8 @@ void led_sk6812_set(const uint8_t *pixel_data, uint8_t num_pixels)
     uint8_t br = s_brightness;
 
     for (uint8_t i = 0; i < num_pixels; i++) {
-        /* Input is GRBW order; apply brightness per channel */
-        uint8_t g = (uint8_t)(((uint16_t)pixel_data[i * 4 + 0] * br) >> 8);
-        uint8_t r = (uint8_t)(((uint16_t)pixel_data[i * 4 + 1] * br) >> 8);
-        uint8_t b = (uint8_t)(((uint16_t)pixel_data[i * 4 + 2] * br) >> 8);
-        uint8_t w = (uint8_t)(((uint16_t)pixel_data[i * 4 + 3] * br) >> 8);
-        s_pixel_buf[i] = ((uint32_t)g << 24) |
-                         ((uint32_t)r << 16) |
-                         ((uint32_t)b <<  8) |
-                         ((uint32_t)w      );
+        /* Input is GRBW order */
+        s_pixel_buf[i] = grbw_to_word(&pixel_data[i * 4], br);
     }
 
     /* Always cover the warning panel so it is included in every DMA transfer */
@@ -212,6 +240,56 @@ void led_sk6812_set(const uint8_t *pixel_data, uint8_t num_pixels)
     }
 }
 
+void led_sk6812_fill(uint8_t start, uint8_t count, const uint8_t grbw[4])
+{
+    count = clamp_span(start, count);
+    uint32_t word = grbw_to_word(grbw, s_brightness);
+
+    for (uint8_t i = 0; i < count; i++)
+        s_pixel_buf[start + i] = word;
+    cover_pixels(start, (uint16_t)start + count);
+}
+
+void led_sk6812_set_runs(uint8_t start, const uint8_t *runs, uint8_t n_runs)
+{
+    uint8_t  br = s_brightness;
+    uint16_t px = start;
+
+    for (uint8_t r = 0; r < n_runs && px < SK6812_MAX_PIXELS; r++) {
+        const uint8_t *run = &runs[r * 5];
+        uint8_t  len  = clamp_span((uint8_t)px, run[0]);
+        uint32_t word = grbw_to_word(&run[1], br);
+        for (uint8_t i = 0; i < len; i++)
+            s_pixel_buf[px + i] = word;
+        px += len;
+    }
+    cover_pixels(start, px);
+}
+
+void led_sk6812_set_palette(uint8_t first, const uint8_t *grbw, uint8_t count)
+{
+    for (uint8_t i = 0; i < count && first + i < SK6812_PALETTE_SIZE; i++)
+        memcpy(s_palette[first + i], &grbw[i * 4], 4);
+}
+
+void led_sk6812_set_indexed(uint8_t start, const uint8_t *idx, uint8_t count)
+{
+    count = clamp_span(start, count);
+    uint8_t br = s_brightness;
+
+    /* Scale the palette once rather than per pixel */
+    uint32_t words[SK6812_PALETTE_SIZE];
+    for (uint8_t c = 0; c < SK6812_PALETTE_SIZE; c++)
+        words[c] = grbw_to_word(s_palette[c], br);
+
+    for (uint8_t i = 0; i < count; i++) {
+        uint8_t pair = idx[i >> 1];
+        uint8_t c    = (i & 1u) ? (pair & 0x0Fu) : (pair >> 4);
+        s_pixel_buf[start + i] = words[c];
+    }
+    cover_pixels(start, (uint16_t)start + count);
+}
+
 void sk6812_task(void *param)
 {
     (void)param;
@@ -4,6 +4,7 @@
 #include <stdint.h>
 
 #define SK6812_MAX_PIXELS       128
+#define SK6812_PALETTE_SIZE     16
 #define WORKLIGHT_LED_BASE      60
 #define WORKLIGHT_LED_COUNT     23
 
@@ -21,6 +22,35 @@ void led_sk6812_init(void);
  */
 void led_sk6812_set(const uint8_t *pixel_data, uint8_t num_pixels);
 
+/*
+ * Partial updates — write only the addressed pixels and leave the rest of
+ * the strip as it is. Brightness is applied as in led_sk6812_set(); pixels
+ * past SK6812_MAX_PIXELS are ignored. Same threading rules as
+ * led_sk6812_set().
+ */
+
+/** Set count pixels from start to one GRBW colour. */
+void led_sk6812_fill(uint8_t start, uint8_t count, const uint8_t grbw[4]);
+
+/**
+ * Write n_runs consecutive runs from start. runs: n_runs * 5 bytes of
+ * [len][G][R][B][W]; each run sets len pixels.
+ */
+void led_sk6812_set_runs(uint8_t start, const uint8_t *runs, uint8_t n_runs);
+
+/**
+ * Load count palette entries from index first (GRBW, 4 bytes each, stored
+ * unscaled). Entries past SK6812_PALETTE_SIZE are ignored. Does not
+ * repaint pixels already drawn from the palette.
+ */
+void led_sk6812_set_palette(uint8_t first, const uint8_t *grbw, uint8_t count);
+
+/**
+ * Set count pixels from start to palette colours. idx holds two 4-bit
+ * palette indices per byte, first pixel in the high nibble.
+ */
+void led_sk6812_set_indexed(uint8_t start, const uint8_t *idx, uint8_t count);
+
 /**
  * Set global brightness scale for the SK6812 chain (0=off, 255=full).
  * Applied on the next call to led_sk6812_set(). Thread-safe (volatile write).
@@ -15,6 +15,7 @@
 #include "screen_display.h"
 #include "veml7700.h"
 #include "rs485.h"
+#include "telemetry.h"
 
 /* Task handles — needed so protocol.c can notify LED/screen tasks */
 static TaskHandle_t s_sk6812_handle = NULL;
@@ -72,21 +73,21 @@ int main(void)
 
     sys_state_set(SYS_INIT);
 
-    /* ---- Shared TX queue ---- */
-    g_tx_queue = xQueueCreate(TX_QUEUE_DEPTH, sizeof(tx_item_t));
-    configASSERT(g_tx_queue != NULL);
+    /* ---- Shared TX ring ---- */
+    proto_tx_init();
 
     /* ---- Create tasks ---- */
     /* USB device task — must be highest priority for timely enumeration */
     xTaskCreate(usb_device_task, "USB",    1024, NULL, 4, NULL);
 
-    /* CDC task — TX queue consumer + RX protocol handler + heartbeat */
+    /* CDC task — TX ring consumer + RX protocol handler + heartbeat */
     xTaskCreate(cdc_task,        "CDC",    512,  NULL, 3, NULL);
 
     /* Sensor tasks */
     xTaskCreate(adc_task,        "ADC",    512,  NULL, 2, NULL);
     xTaskCreate(digital_io_task, "DIO",    512,  NULL, 2, NULL);
     xTaskCreate(veml7700_task,   "ALS",    512,  NULL, 2, NULL);
+    xTaskCreate(telemetry_task,  "TELEM",  256,  NULL, 2, NULL);
 
     /* LED tasks */
     xTaskCreate(sk6812_task,     "SK6812", 512,  NULL, 1, &s_sk6812_handle);
@@ -100,7 +100,8 @@
 #define PIN_RS485_INT       6   /* GP6  — /INT input (active low, pulled */
                                 /*         high; peripheral open-drains) */
 #define RS485_UART_INST     uart1
-#define RS485_BAUD          115200
+#define RS485_UART_IRQ      UART1_IRQ
+#define RS485_BAUD          115200  /* boot / fallback rate — see RS485_BAUD_MAX */
 
 /* ------------------------------------------------------------------ */
 /* MCP3208 channel assignments                                          */
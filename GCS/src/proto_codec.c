@@ -0,0 +1,256 @@
+#include "proto_codec.h"
+#include <string.h>
+
+/* XOR of n bytes, a word at a time — shared by encoder and parser */
+static uint8_t xor_bytes(const uint8_t *d, size_t n)
+{
+    uint32_t acc = 0;
+    size_t   i   = 0;
+    for (; i + 4 <= n; i += 4) {
+        uint32_t w;
+        memcpy(&w, &d[i], 4);
+        acc ^= w;
+    }
+    acc ^= acc >> 16;
+    acc ^= acc >> 8;
+    uint8_t c = (uint8_t)acc;
+    for (; i < n; i++) c ^= d[i];
+    return c;
+}
+
+/* ------------------------------------------------------------------ */
+/* Encoder                                                               */
+/* ------------------------------------------------------------------ */
+uint16_t proto_cobs_encode(uint8_t *dst, const uint8_t *src, uint16_t n)
+{
+    uint16_t o = 0;     /* current code byte */
+    uint16_t i = 0;
+
+    /* One block per pass: copy up to 254 non-zero bytes in one go. memmove
+     * because in-place callers have src a few bytes ahead of dst. */
+    for (;;) {
+        uint16_t max = (uint16_t)(n - i) < 254 ? (uint16_t)(n - i) : 254;
+        const uint8_t *z = memchr(&src[i], 0, max);
+        uint16_t run = z ? (uint16_t)(z - &src[i]) : max;
+
+        memmove(&dst[o + 1], &src[i], run);
+        dst[o] = (uint8_t)(run + 1);
+        o = (uint16_t)(o + 1 + run);
+        i = (uint16_t)(i + run);
+
+        if (z) {
+            i++;                /* the zero is implied by the code byte */
+        } else if (run < 254) {
+            break;              /* input exhausted */
+        }
+    }
+    return o;
+}
+
+uint8_t *proto_frame_begin(uint8_t *buf, uint8_t framing, uint8_t type,
+                           uint16_t payload_len)
+{
+    uint8_t *raw;
+    if (framing == PROTO_FRAMING_COBS) {
+        /* Encoded forward into buf[0..] by proto_frame_end() */
+        raw = &buf[PROTO_COBS_OVERHEAD(PROTO_RAW_LEN(payload_len))];
+    } else {
+        buf[0] = PROTO_SOF;
+        raw    = &buf[1];
+    }
+    raw[0] = type;
+    raw[1] = (uint8_t)(payload_len & 0xFF);
+    raw[2] = (uint8_t)(payload_len >> 8);
+    return &raw[3];
+}
+
+uint16_t proto_frame_end(uint8_t *buf, uint8_t framing, uint8_t *payload)
+{
+    uint8_t *raw         = payload - 3;
+    uint16_t payload_len = (uint16_t)raw[1] | ((uint16_t)raw[2] << 8);
+    uint16_t raw_len     = (uint16_t)PROTO_RAW_LEN(payload_len);
+
+    raw[3 + payload_len] = (uint8_t)(raw[0] ^ raw[1] ^ raw[2] ^
+                                     xor_bytes(payload, payload_len));
+
+    if (framing != PROTO_FRAMING_COBS) return (uint16_t)(1 + raw_len);
+
+    uint16_t n = proto_cobs_encode(buf, raw, raw_len);
+    buf[n++] = 0x00;
+    return n;
+}
+
+uint16_t proto_encode(uint8_t *buf, size_t buf_size, uint8_t framing,
+                      uint8_t type, const void *payload, uint16_t payload_len)
+{
+    if (payload_len > PROTO_MAX_PAYLOAD) return 0;
+    if (buf_size < PROTO_FRAME_MAX(payload_len)) return 0;
+
+    uint8_t *p = proto_frame_begin(buf, framing, type, payload_len);
+    if (payload_len > 0) memcpy(p, payload, payload_len);
+    return proto_frame_end(buf, framing, p);
+}
+
+/* ------------------------------------------------------------------ */
+/* Streaming parser                                                      */
+/* ------------------------------------------------------------------ */
+enum {
+    RX_WAIT_SOF,
+    RX_WAIT_TYPE,
+    RX_WAIT_LEN,
+    RX_WAIT_LEN2,
+    RX_WAIT_PAYLOAD,
+    RX_WAIT_CHECKSUM
+};
+
+void proto_parser_init(proto_parser_t *p, uint8_t framing,
+                       proto_rx_cb_t cb, void *ctx)
+{
+    p->cb  = cb;
+    p->ctx = ctx;
+    proto_parser_set_framing(p, framing);
+}
+
+void proto_parser_set_framing(proto_parser_t *p, uint8_t framing)
+{
+    p->framing   = framing;
+    /* COBS: a session starts on a frame boundary, like after a 0x00 */
+    p->state     = (framing == PROTO_FRAMING_COBS) ? RX_WAIT_TYPE : RX_WAIT_SOF;
+    p->idx       = 0;
+    p->cobs_left = 0;
+    p->cobs_code = 0xFF;
+}
+
+static bool emit(proto_parser_t *p, proto_rx_status_t status)
+{
+    p->state = RX_WAIT_SOF;
+    return p->cb ? p->cb(p->ctx, status, p->type, p->buf, p->len) : false;
+}
+
+/* One decoded frame byte. Returns true if the callback asked to stop. */
+static bool rx_byte(proto_parser_t *p, uint8_t b)
+{
+    switch (p->state) {
+        case RX_WAIT_SOF:
+            /* COBS mode: frame start is signalled by the 0x00 delimiter */
+            if (b == PROTO_SOF && p->framing == PROTO_FRAMING_SOF) {
+                p->state = RX_WAIT_TYPE;
+            }
+            break;
+
+        case RX_WAIT_TYPE:
+            p->type  = b;
+            p->cksum = b;
+            p->state = RX_WAIT_LEN;
+            break;
+
+        case RX_WAIT_LEN:
+            p->len    = b;
+            p->cksum ^= b;
+            p->state  = RX_WAIT_LEN2;
+            break;
+
+        case RX_WAIT_LEN2:
+            p->len   |= (uint16_t)((uint16_t)b << 8);
+            p->cksum ^= b;
+            p->idx    = 0;
+            if (p->len == 0) {
+                p->state = RX_WAIT_CHECKSUM;
+            } else if (p->len > PROTO_MAX_PAYLOAD) {
+                return emit(p, PROTO_RX_OVERSIZE);
+            } else {
+                p->state = RX_WAIT_PAYLOAD;
+            }
+            break;
+
+        case RX_WAIT_PAYLOAD:
+            p->buf[p->idx++] = b;
+            p->cksum ^= b;
+            if (p->idx >= p->len) p->state = RX_WAIT_CHECKSUM;
+            break;
+
+        case RX_WAIT_CHECKSUM:
+            return emit(p, p->cksum == b ? PROTO_RX_OK : PROTO_RX_BAD_CKSUM);
+    }
+    return false;
+}
+
+/* Bulk-copy up to n payload bytes; returns how many were taken */
+static size_t rx_payload_run(proto_parser_t *p, const uint8_t *d, size_t n)
+{
+    size_t want = (size_t)(p->len - p->idx);
+    if (n > want) n = want;
+    memcpy(&p->buf[p->idx], d, n);
+    p->cksum ^= xor_bytes(d, n);
+    p->idx    = (uint16_t)(p->idx + n);
+    if (p->idx >= p->len) p->state = RX_WAIT_CHECKSUM;
+    return n;
+}
+
+static size_t feed_sof(proto_parser_t *p, const uint8_t *data, size_t len)
+{
+    size_t i = 0;
+    while (i < len) {
+        if (p->state == RX_WAIT_PAYLOAD) {
+            i += rx_payload_run(p, &data[i], len - i);
+        } else if (p->state == RX_WAIT_SOF) {
+            const uint8_t *s = memchr(&data[i], PROTO_SOF, len - i);
+            if (!s) return len;
+            i = (size_t)(s - data) + 1;
+            p->state = RX_WAIT_TYPE;
+        } else if (rx_byte(p, data[i++])) {
+            return i;
+        }
+    }
+    return len;
+}
+
+static size_t feed_cobs(proto_parser_t *p, const uint8_t *data, size_t len)
+{
+    size_t i = 0;
+    while (i < len) {
+        uint8_t b = data[i];
+
+        /* 0x00 ends the frame — anything unfinished is dropped here, so a
+         * corrupted frame never costs more than itself. */
+        if (b == 0x00) {
+            p->state     = RX_WAIT_TYPE;
+            p->cobs_left = 0;
+            p->cobs_code = 0xFF;
+            i++;
+            continue;
+        }
+
+        if (p->cobs_left == 0) {
+            /* Code byte: emit the zero implied by the previous block */
+            uint8_t prev = p->cobs_code;
+            p->cobs_code = b;
+            p->cobs_left = (uint8_t)(b - 1);
+            i++;
+            if (prev != 0xFF && rx_byte(p, 0x00)) return i;
+            continue;
+        }
+
+        if (p->state == RX_WAIT_PAYLOAD) {
+            /* Data bytes up to the end of the block, the chunk or a stray 0x00 */
+            size_t run = p->cobs_left < len - i ? p->cobs_left : len - i;
+            const uint8_t *z = memchr(&data[i], 0x00, run);
+            if (z) run = (size_t)(z - &data[i]);
+            run = rx_payload_run(p, &data[i], run);
+            p->cobs_left = (uint8_t)(p->cobs_left - run);
+            i += run;
+            continue;
+        }
+
+        p->cobs_left--;
+        i++;
+        if (rx_byte(p, b)) return i;
+    }
+    return len;
+}
+
+size_t proto_parser_feed(proto_parser_t *p, const uint8_t *data, size_t len)
+{
+    return (p->framing == PROTO_FRAMING_COBS) ? feed_cobs(p, data, len)
+                                              : feed_sof(p, data, len);
+}
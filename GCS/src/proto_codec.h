@@ -0,0 +1,152 @@
+#ifndef PROTO_CODEC_H
+#define PROTO_CODEC_H
+
+/*
+ * Pico <-> Pi CDC frame codec — portable C99, no RTOS or SDK dependencies.
+ *
+ * Built into the GCS firmware, the Pi app (PicoLink) and the host tools in
+ * Testcode/ProtoCodec (benchmark + fuzz harness), so framing is implemented
+ * and checked in one place. Payload layouts stay in protocol.h.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ------------------------------------------------------------------ */
+/* Packet types                                                          */
+/* ------------------------------------------------------------------ */
+#define PROTO_SOF               0xAA
+
+#define PROTO_TYPE_ADC          0x01  /* Pico→Pi: ADC channel data         */
+#define PROTO_TYPE_DIGITAL      0x02  /* Pico→Pi: digital I/O state        */
+#define PROTO_TYPE_LED          0x03  /* Pi→Pico: LED command               */
+#define PROTO_TYPE_SCREEN       0x04  /* Pi→Pico: screen mode command       */
+#define PROTO_TYPE_HEARTBEAT    0x05  /* bidirectional: alive signal        */
+#define PROTO_TYPE_EVENT        0x06  /* Pico→Pi: input event               */
+#define PROTO_TYPE_ERROR        0x07  /* Pico→Pi: error status              */
+#define PROTO_TYPE_BRIGHTNESS   0x08  /* Pi→Pico: global brightness         */
+#define PROTO_TYPE_MODE         0x09  /* Pi→Pico: state machine override    */
+#define PROTO_TYPE_WARNING      0x0A  /* Pi→Pico: warning panel severity    */
+#define PROTO_TYPE_ALS          0x0B  /* Pico→Pi: ambient light sensor data */
+#define PROTO_TYPE_PERIPH_CMD   0x0C  /* Pi→Pico:  command for a bus peripheral  */
+#define PROTO_TYPE_PERIPH_DATA  0x0D  /* Pico→Pi:  data from a bus peripheral    */
+#define PROTO_TYPE_PERIPH_STATE 0x0E  /* Pico→Pi:  peripheral online/offline     */
+#define PROTO_TYPE_PERIPH_SCREEN 0x0F /* Pi→Pico:  select peripheral detail screen */
+#define PROTO_TYPE_WORKLIGHT     0x10 /* Pi→Pico:  worklight on/off + colour        */
+#define PROTO_TYPE_TELEMETRY     0x11 /* Pico→Pi:  ADC + digital + ALS bundle       */
+#define PROTO_TYPE_LINK_CFG      0x12 /* bidirectional: framing negotiation         */
+#define PROTO_TYPE_LINK_STATS    0x13 /* Pico→Pi:  CDC link health counters         */
+#define PROTO_TYPE_BATCH         0x14 /* Pi→Pico:  several control commands at once */
+#define PROTO_TYPE_SUBSCRIBE     0x15 /* Pi→Pico:  telemetry topic rates / modes    */
+#define PROTO_TYPE_PERIPH_SCAN   0x16 /* Pi→Pico:  rediscover RS-485 peripherals    */
+#define PROTO_TYPE_PERIPH_STATS  0x17 /* Pico→Pi:  RS-485 per-device latency, errors */
+
+/*
+ * Framing modes — negotiated with PROTO_TYPE_LINK_CFG after every USB connect.
+ *
+ * SOF:  [0xAA][type][len_lo][len_hi][payload][cksum]          (default)
+ * COBS: COBS([type][len_lo][len_hi][payload][cksum]) [0x00]
+ *
+ * In COBS mode 0x00 never occurs inside a frame, so a receiver that loses
+ * sync discards at most the frame in progress and restarts at the next 0x00.
+ * cksum = XOR of type, len_lo, len_hi and every payload byte.
+ */
+#define PROTO_FRAMING_SOF       0
+#define PROTO_FRAMING_COBS      1
+
+/* SK6812 chain: 2-byte header + SK6812_MAX_PIXELS(128) * 4 bytes GRBW = 514 */
+#define PROTO_MAX_PAYLOAD   514
+/* Frame: SOF(1)+TYPE(1)+LEN_LO(1)+LEN_HI(1)+PAYLOAD+CKSUM(1) */
+#define PROTO_MAX_PACKET    (5 + PROTO_MAX_PAYLOAD)
+
+/* Raw frame = [type][len_lo][len_hi][payload][cksum] */
+#define PROTO_RAW_LEN(payload_len)      (4u + (payload_len))
+/* COBS code bytes added to a raw frame of n bytes */
+#define PROTO_COBS_OVERHEAD(n)          (1u + (n) / 254u)
+/* Buffer needed to encode one frame in either framing */
+#define PROTO_FRAME_MAX(payload_len) \
+    (PROTO_COBS_OVERHEAD(PROTO_RAW_LEN(payload_len)) + PROTO_RAW_LEN(payload_len) + 1u)
+
+/* ------------------------------------------------------------------ */
+/* Encoder                                                               */
+/* ------------------------------------------------------------------ */
+
+/**
+ * Start a frame in buf (at least PROTO_FRAME_MAX(payload_len) bytes) and
+ * return where the payload goes. Write the payload there, then call
+ * proto_frame_end() with the same buf, framing and pointer.
+ */
+uint8_t *proto_frame_begin(uint8_t *buf, uint8_t framing, uint8_t type,
+                           uint16_t payload_len);
+
+/** Finish a frame opened by proto_frame_begin(). Returns the encoded length. */
+uint16_t proto_frame_end(uint8_t *buf, uint8_t framing, uint8_t *payload);
+
+/**
+ * Encode one frame from a separate payload buffer. Returns the encoded
+ * length, or 0 if payload_len > PROTO_MAX_PAYLOAD or buf_size is too small.
+ */
+uint16_t proto_encode(uint8_t *buf, size_t buf_size, uint8_t framing,
+                      uint8_t type, const void *payload, uint16_t payload_len);
+
+/**
+ * COBS-encode n bytes from src into dst (no 0x00 delimiter). src may lie in
+ * the same buffer at least PROTO_COBS_OVERHEAD(n) bytes after dst — the
+ * output never overtakes the input. Returns the encoded length.
+ */
+uint16_t proto_cobs_encode(uint8_t *dst, const uint8_t *src, uint16_t n);
+
+/* ------------------------------------------------------------------ */
+/* Streaming parser                                                      */
+/* ------------------------------------------------------------------ */
+typedef enum {
+    PROTO_RX_OK = 0,
+    PROTO_RX_BAD_CKSUM,     /* payload not valid */
+    PROTO_RX_OVERSIZE       /* length field > PROTO_MAX_PAYLOAD; payload not valid */
+} proto_rx_status_t;
+
+/**
+ * Called once per frame (good or rejected) with the type byte from its
+ * header. payload is valid only during the call. Return true to make
+ * proto_parser_feed() stop right after this frame, e.g. to switch framing
+ * before the next byte is parsed.
+ */
+typedef bool (*proto_rx_cb_t)(void *ctx, proto_rx_status_t status, uint8_t type,
+                              const uint8_t *payload, uint16_t len);
+
+typedef struct {
+    uint8_t        framing;
+    uint8_t        state;
+    uint8_t        type;
+    uint8_t        cksum;       /* running XOR of the frame so far */
+    uint16_t       len;
+    uint16_t       idx;
+    uint8_t        cobs_left;   /* data bytes left in current COBS block */
+    uint8_t        cobs_code;   /* code of current block; 0xFF = no implied zero */
+    proto_rx_cb_t  cb;
+    void          *ctx;
+    uint8_t        buf[PROTO_MAX_PAYLOAD];
+} proto_parser_t;
+
+void proto_parser_init(proto_parser_t *p, uint8_t framing,
+                       proto_rx_cb_t cb, void *ctx);
+
+/** Switch framing and drop any frame in progress. */
+void proto_parser_set_framing(proto_parser_t *p, uint8_t framing);
+
+/**
+ * Parse a chunk of any size; frames may span calls. Returns the number of
+ * bytes consumed — len, unless the callback asked to stop.
+ */
+size_t proto_parser_feed(proto_parser_t *p, const uint8_t *data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PROTO_CODEC_H */
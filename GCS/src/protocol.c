@@ -7,9 +7,80 @@
 #include "screen_st7735.h"
 #include "screen_display.h"
 #include "rs485.h"
+#include "telemetry.h"
+#include "pico/stdlib.h"
 #include <string.h>
+#include <stddef.h>
+
+tx_ring_t g_tx_lane[PROTO_LANE_COUNT];
+
+/* LINK_STATS rides the event lane, so a full report (every type active)
+ * must fit beside queued events. Reservations are contiguous; the larger of
+ * the two free runs is at least half the free space, so at half the ring
+ * a report fits with up to size - 2 * report bytes of events queued. */
+#define LINK_STATS_FRAME_MAX \
+    (PROTO_FRAME_MAX(33u + LINK_STATS_MAX_TYPES * 21u) + TX_RING_REC_HDR)
+#if LINK_STATS_FRAME_MAX > TX_EVENT_RING_SIZE / 2u
+#error "TX_EVENT_RING_SIZE too small for a full LINK_STATS report beside queued events"
+#endif
+
+static uint8_t  s_tx_event_storage[TX_EVENT_RING_SIZE];
+static uint8_t  s_tx_bulk_storage[TX_BULK_RING_SIZE];
+
+/* Frame opened by proto_tx_begin(), per lane — protected by that lane's lock */
+typedef struct {
+    uint8_t *frame;     /* start of reservation             */
+    uint8_t *payload;   /* returned by proto_frame_begin()  */
+} tx_open_t;
+
+static tx_open_t s_tx_open[PROTO_LANE_COUNT];
+
+/* Written only while holding both lane locks; read under either one */
+static uint8_t  s_tx_framing      = PROTO_FRAMING_SOF;
+static int16_t  s_tx_framing_next = -1;    /* applied after the open frame    */
+static volatile int16_t s_link_cfg_want = -1;  /* LINK_CFG request awaiting reply */
+
+/* RX frame parser (proto_codec.c); s_rx.framing is the current RX framing */
+static proto_parser_t s_rx;
+static bool rx_frame(void *ctx, proto_rx_status_t status, uint8_t type,
+                     const uint8_t *p, uint16_t len);
+
+/* Latest-wins sample mailboxes (xQueueOverwrite, depth 1) */
+typedef struct {
+    uint8_t type;
+    uint8_t len;
+    uint8_t data[PROTO_SAMPLE_MAX];
+} tx_sample_t;
+
+#define TX_SAMPLE_SLOTS     4   /* ADC, DIGITAL, ALS, TELEMETRY */
+
+static QueueHandle_t     s_sample_mbox[TX_SAMPLE_SLOTS];
+static volatile uint32_t s_samples_superseded = 0;
+
+/* LINK_STATS counters. Plain increments from several tasks — diagnostics
+ * only, an occasional lost count is acceptable. Slot 0 (no such type)
+ * collects every type >= LINK_STATS_MAX_TYPES. */
+typedef struct {
+    uint32_t enqueued;
+    uint32_t serialized;
+    uint32_t dropped;
+    uint32_t rx_ok;
+    uint32_t rx_rejected;
+} type_stats_t;
+
+static type_stats_t s_type_stats[LINK_STATS_MAX_TYPES];
+static uint32_t     s_rx_bad_cksum = 0;
+static uint32_t     s_rx_oversize  = 0;
+
+static type_stats_t *type_stats(uint8_t type)
+{
+    return &s_type_stats[type < LINK_STATS_MAX_TYPES ? type : 0];
+}
 
-QueueHandle_t g_tx_queue = NULL;
+static bool type_stats_active(const type_stats_t *s)
+{
+    return s->enqueued || s->serialized || s->dropped || s->rx_ok || s->rx_rejected;
+}
 
 static TaskHandle_t s_sk6812_handle = NULL;
 static TaskHandle_t s_ws2811_handle  = NULL;
@@ -80,231 +151,559 @@ int proto_parse(const uint8_t *buf, uint16_t buf_len,
 }
 
 /* ------------------------------------------------------------------ */
-/* TX helpers                                                            */
+/* TX ring                                                               */
 /* ------------------------------------------------------------------ */
+void proto_tx_init(void)
+{
+    tx_ring_init(&g_tx_lane[PROTO_LANE_EVENT],
+                 s_tx_event_storage, sizeof(s_tx_event_storage));
+    tx_ring_init(&g_tx_lane[PROTO_LANE_BULK],
+                 s_tx_bulk_storage, sizeof(s_tx_bulk_storage));
+    proto_parser_init(&s_rx, PROTO_FRAMING_SOF, rx_frame, NULL);
+
+    for (int i = 0; i < TX_SAMPLE_SLOTS; i++) {
+        s_sample_mbox[i] = xQueueCreate(1, sizeof(tx_sample_t));
+        configASSERT(s_sample_mbox[i] != NULL);
+    }
+}
+
+static proto_lane_t lane_for_type(uint8_t type)
+{
+    switch (type) {
+        case PROTO_TYPE_EVENT:
+        case PROTO_TYPE_ERROR:
+        case PROTO_TYPE_PERIPH_STATE:
+        case PROTO_TYPE_HEARTBEAT:
+        case PROTO_TYPE_LINK_CFG:
+        case PROTO_TYPE_LINK_STATS:
+            return PROTO_LANE_EVENT;
+        default:
+            return PROTO_LANE_BULK;
+    }
+}
+
+static int sample_slot(uint8_t type)
+{
+    switch (type) {
+        case PROTO_TYPE_ADC:       return 0;
+        case PROTO_TYPE_DIGITAL:   return 1;
+        case PROTO_TYPE_ALS:       return 2;
+        case PROTO_TYPE_TELEMETRY: return 3;
+        default:                   return -1;
+    }
+}
+
+uint8_t *proto_tx_begin(uint8_t type, uint16_t payload_len)
+{
+    if (payload_len > PROTO_MAX_PAYLOAD) return NULL;
+
+    proto_lane_t lane = lane_for_type(type);
+
+    /* Framing can only change under the lane lock, so reserve the worst case */
+    uint8_t *f = tx_ring_reserve(&g_tx_lane[lane], (uint16_t)PROTO_FRAME_MAX(payload_len),
+                                 pdMS_TO_TICKS(TX_RING_LOCK_TIMEOUT_MS));
+    if (!f) {
+        type_stats(type)->dropped++;
+        return NULL;
+    }
+
+    uint8_t *p = proto_frame_begin(f, s_tx_framing, type, payload_len);
+    s_tx_open[lane].frame   = f;
+    s_tx_open[lane].payload = p;
+    return p;
+}
+
+void proto_tx_end(uint8_t *payload)
+{
+    proto_lane_t lane = PROTO_LANE_EVENT;
+    while (lane < PROTO_LANE_COUNT && s_tx_open[lane].payload != payload) {
+        lane++;
+    }
+    configASSERT(lane < PROTO_LANE_COUNT);
+    if (lane == PROTO_LANE_COUNT || !payload) return;
+
+    uint8_t type = payload[-3];     /* header written by proto_frame_begin() */
+    type_stats_t *ts = type_stats(type);
+    ts->serialized++;
+    if (sample_slot(type) < 0) ts->enqueued++;  /* samples count at post time */
+
+    uint16_t used = proto_frame_end(s_tx_open[lane].frame, s_tx_framing, payload);
+    tx_ring_trim(&g_tx_lane[lane], used);
+
+    if (s_tx_framing_next >= 0) {
+        s_tx_framing      = (uint8_t)s_tx_framing_next;
+        s_tx_framing_next = -1;
+    }
+
+    s_tx_open[lane].frame   = NULL;
+    s_tx_open[lane].payload = NULL;
+    tx_ring_commit(&g_tx_lane[lane]);
+}
+
+bool proto_send(uint8_t type, const void *payload, uint16_t payload_len)
+{
+    uint8_t *p = proto_tx_begin(type, payload_len);
+    if (!p) return false;
+    if (payload_len > 0) memcpy(p, payload, payload_len);
+    proto_tx_end(p);
+    return true;
+}
+
+void proto_post_sample(uint8_t type, const void *payload, uint16_t payload_len)
+{
+    int slot = sample_slot(type);
+    if (slot < 0 || payload_len > PROTO_SAMPLE_MAX || !s_sample_mbox[slot]) return;
+
+    tx_sample_t s = { .type = type, .len = (uint8_t)payload_len };
+    memcpy(s.data, payload, payload_len);
+
+    type_stats(type)->enqueued++;
+
+    tx_sample_t old;
+    if (xQueueReceive(s_sample_mbox[slot], &old, 0) == pdTRUE) {
+        s_samples_superseded++;
+        type_stats(type)->dropped++;
+        if (type == PROTO_TYPE_TELEMETRY) {
+            /* Sections that were fresh in the lost bundle still are */
+            s.data[offsetof(telemetry_bundle_t, fresh)] |=
+                old.data[offsetof(telemetry_bundle_t, fresh)];
+        }
+    }
+    xQueueOverwrite(s_sample_mbox[slot], &s);
+}
+
 void proto_send_event(uint8_t event_id, uint16_t value)
 {
-    if (!g_tx_queue) return;
     event_pkt_t pkt = { .event_id = event_id, .value = value };
-    tx_item_t item;
-    int len = proto_serialize(item.buf, sizeof(item.buf),
-                              PROTO_TYPE_EVENT,
-                              (const uint8_t *)&pkt, sizeof(pkt));
-    if (len > 0) {
-        item.len = (uint8_t)len;
-        xQueueSend(g_tx_queue, &item, 0);
-    }
+    proto_send(PROTO_TYPE_EVENT, &pkt, sizeof(pkt));
 }
 
 void proto_send_error(uint8_t error_code)
 {
-    if (!g_tx_queue) return;
     error_pkt_t pkt = { .error_code = error_code };
-    tx_item_t item;
-    int len = proto_serialize(item.buf, sizeof(item.buf),
-                              PROTO_TYPE_ERROR,
-                              (const uint8_t *)&pkt, sizeof(pkt));
-    if (len > 0) {
-        item.len = (uint8_t)len;
-        xQueueSend(g_tx_queue, &item, 0);
+    proto_send(PROTO_TYPE_ERROR, &pkt, sizeof(pkt));
+}
+
+void proto_tx_get_stats(proto_tx_stats_t *out)
+{
+    out->event_dropped   = g_tx_lane[PROTO_LANE_EVENT].dropped;
+    out->bulk_dropped    = g_tx_lane[PROTO_LANE_BULK].dropped;
+    out->bulk_superseded = s_samples_superseded;
+}
+
+void proto_send_link_stats(uint32_t cdc_short_writes)
+{
+    uint8_t n = 0;
+    for (int t = 0; t < LINK_STATS_MAX_TYPES; t++) {
+        if (type_stats_active(&s_type_stats[t])) n++;
     }
+
+    uint8_t *p = proto_tx_begin(PROTO_TYPE_LINK_STATS,
+                                (uint16_t)(sizeof(link_stats_hdr_t) +
+                                           n * sizeof(link_stats_type_t)));
+    if (!p) return;
+
+    const tx_ring_t *ev = &g_tx_lane[PROTO_LANE_EVENT];
+    const tx_ring_t *bk = &g_tx_lane[PROTO_LANE_BULK];
+
+    link_stats_hdr_t *h = (link_stats_hdr_t *)p;
+    h->ts_ms            = (uint32_t)(xTaskGetTickCount() * portTICK_PERIOD_MS);
+    h->event_hwm        = ev->hwm;
+    h->event_size       = ev->size;
+    h->bulk_hwm         = bk->hwm;
+    h->bulk_size        = bk->size;
+    h->event_dropped    = ev->dropped;
+    h->bulk_dropped     = bk->dropped;
+    h->cdc_short_writes = cdc_short_writes;
+    h->rx_bad_cksum     = s_rx_bad_cksum;
+    h->rx_oversize      = s_rx_oversize;
+    h->n_types          = n;
+
+    /* Counters only grow, so every type counted above is still active; one
+     * that became active since is reported next time */
+    link_stats_type_t *e = (link_stats_type_t *)(p + sizeof(link_stats_hdr_t));
+    uint8_t i = 0;
+    for (int t = 0; t < LINK_STATS_MAX_TYPES && i < n; t++) {
+        const type_stats_t *s = &s_type_stats[t];
+        if (!type_stats_active(s)) continue;
+        e[i].type        = (uint8_t)t;
+        e[i].enqueued    = s->enqueued;
+        e[i].serialized  = s->serialized;
+        e[i].dropped     = s->dropped;
+        e[i].rx_ok       = s->rx_ok;
+        e[i].rx_rejected = s->rx_rejected;
+        i++;
+    }
+
+    proto_tx_end(p);
 }
 
 /* ------------------------------------------------------------------ */
-/* RX state machine — variables declared here so dispatch can use them  */
+/* RX state                                                              */
 /* ------------------------------------------------------------------ */
-typedef enum {
-    RX_WAIT_SOF,
-    RX_WAIT_TYPE,
-    RX_WAIT_LEN,
-    RX_WAIT_LEN2,
-    RX_WAIT_PAYLOAD,
-    RX_WAIT_CHECKSUM
-} rx_state_t;
-
-static rx_state_t s_rx_state = RX_WAIT_SOF;
-static uint8_t    s_rx_type  = 0;
-static uint16_t   s_rx_len   = 0;
-static uint8_t    s_rx_buf[PROTO_MAX_PAYLOAD];
-static uint16_t   s_rx_idx   = 0;
+static uint32_t s_rx_time_us = 0;     /* time_us_32() when the current chunk was read */
 
 /* ------------------------------------------------------------------ */
 /* LED command dispatcher                                                */
 /* ------------------------------------------------------------------ */
-static void dispatch_led_command(void)
+
+/* SK6812 partial update (SK_OP_*). Returns false if malformed. */
+static bool dispatch_sk6812_op(const uint8_t *p, uint16_t len)
 {
-    if (s_rx_len < 1) return;
-    uint8_t chain = s_rx_buf[0];
+    if (len < 3) return false;
+    uint8_t        op   = p[0];
+    uint8_t        a    = p[1];     /* start / first */
+    uint8_t        n    = p[2];     /* count / n_runs */
+    const uint8_t *d    = &p[3];
+    uint16_t       dlen = (uint16_t)(len - 3);
+
+    switch (op) {
+        case SK_OP_FILL:
+            if (dlen < 4) return false;
+            led_sk6812_fill(a, n, d);
+            return true;
+        case SK_OP_RUNS:
+            if (dlen < (uint16_t)n * 5) return false;
+            led_sk6812_set_runs(a, d, n);
+            return true;
+        case SK_OP_PALETTE:
+            if (dlen < (uint16_t)n * 4) return false;
+            led_sk6812_set_palette(a, d, n);
+            return true;
+        case SK_OP_INDEXED:
+            if (dlen < (uint16_t)((n + 1) / 2)) return false;
+            led_sk6812_set_indexed(a, d, n);
+            return true;
+        default:
+            return false;
+    }
+}
+/* Task wakeups owed by the commands just applied — sent once per frame */
+typedef struct {
+    bool    sk6812;
+    bool    ws2811;
+    int16_t screen_mode;        /* -1 = none */
+} rx_wake_t;
+
+static void rx_wake_flush(const rx_wake_t *w)
+{
+    if (w->sk6812 && s_sk6812_handle) xTaskNotifyGive(s_sk6812_handle);
+    /* ws2811_task wakes on its own 50 ms tick; notify for immediate update */
+    if (w->ws2811 && s_ws2811_handle) xTaskNotifyGive(s_ws2811_handle);
+    if (w->screen_mode >= 0 && s_screen_handle) {
+        xTaskNotify(s_screen_handle, (uint32_t)w->screen_mode,
+                    eSetValueWithOverwrite);
+    }
+}
+
+static void dispatch_led_command(const uint8_t *p, uint16_t len, rx_wake_t *w)
+{
+    if (len < 1) return;
+    uint8_t chain = p[0];
 
     if (chain == 0x00) {
         /* SK6812 — raw GRBW pixels: [chain][num_pixels][G R B W ...] */
-        if (s_rx_len < 2) return;
-        uint8_t  num_pixels = s_rx_buf[1];
-        uint16_t data_len   = (uint16_t)(s_rx_len - 2);
-        if (num_pixels == 0 || data_len < (uint16_t)num_pixels * 4) return;
-        led_sk6812_set(&s_rx_buf[2], num_pixels);
-        if (s_sk6812_handle) xTaskNotifyGive(s_sk6812_handle);
+        if (len < 2) return;
+        uint8_t  num_pixels = p[1];
+        uint16_t data_len   = (uint16_t)(len - 2);
+        if (num_pixels == 0) {
+            /* num_pixels=0: partial update — [chain][0][op][a][b][data...] */
+            if (!dispatch_sk6812_op(&p[2], data_len)) return;
+        } else {
+            if (data_len < (uint16_t)num_pixels * 4) return;
+            led_sk6812_set(&p[2], num_pixels);
+        }
+        w->sk6812 = true;
 
     } else if (chain == 0x01) {
         /* WS2811 RGB buttons — [chain][button_id][R][G][B][anim_mode] */
-        if (s_rx_len < 6) return;
-        uint8_t button_id = s_rx_buf[1];
-        uint8_t r         = s_rx_buf[2];
-        uint8_t g_c       = s_rx_buf[3];
-        uint8_t b         = s_rx_buf[4];
-        uint8_t anim      = s_rx_buf[5];
-        led_ws2811_set_button(button_id, r, g_c, b, anim);
-        /* ws2811_task wakes on its own 50 ms tick; notify for immediate update */
-        if (s_ws2811_handle) xTaskNotifyGive(s_ws2811_handle);
+        if (len < 6) return;
+        led_ws2811_set_button(p[1], p[2], p[3], p[4], p[5]);
+        w->ws2811 = true;
 
     } else if (chain == 0x02) {
         /* MCP23017 indicator LEDs — [chain][led_mask][led_state] */
-        if (s_rx_len < 3) return;
-        digital_io_set_leds_async(s_rx_buf[1], s_rx_buf[2]);
+        if (len < 3) return;
+        digital_io_set_leds_async(p[1], p[2]);
     }
 }
 
 /* ------------------------------------------------------------------ */
-/* RX entry point (called from CDC task context)                         */
+/* Control commands — standalone or inside a BATCH                      */
 /* ------------------------------------------------------------------ */
-void proto_handle_rx(const uint8_t *data, uint32_t len)
+static bool is_batchable(uint8_t type)
+{
+    switch (type) {
+        case PROTO_TYPE_LED:
+        case PROTO_TYPE_SCREEN:
+        case PROTO_TYPE_BRIGHTNESS:
+        case PROTO_TYPE_WARNING:
+        case PROTO_TYPE_WORKLIGHT:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static void dispatch_control(uint8_t type, const uint8_t *p, uint16_t len,
+                             rx_wake_t *w)
 {
-    for (uint32_t i = 0; i < len; i++) {
-        uint8_t byte = data[i];
-
-        switch (s_rx_state) {
-            case RX_WAIT_SOF:
-                if (byte == PROTO_SOF) s_rx_state = RX_WAIT_TYPE;
-                break;
-
-            case RX_WAIT_TYPE:
-                s_rx_type  = byte;
-                s_rx_state = RX_WAIT_LEN;
-                break;
-
-            case RX_WAIT_LEN:
-                s_rx_len   = byte;   /* low byte */
-                s_rx_state = RX_WAIT_LEN2;
-                break;
-
-            case RX_WAIT_LEN2:
-                s_rx_len |= ((uint16_t)byte << 8);  /* high byte */
-                s_rx_idx   = 0;
-                if (s_rx_len == 0) {
-                    s_rx_state = RX_WAIT_CHECKSUM;
-                } else if (s_rx_len > PROTO_MAX_PAYLOAD) {
-                    s_rx_state = RX_WAIT_SOF;
-                } else {
-                    s_rx_state = RX_WAIT_PAYLOAD;
+    switch (type) {
+        case PROTO_TYPE_LED:
+            dispatch_led_command(p, len, w);
+            break;
+
+        case PROTO_TYPE_SCREEN:
+            if (len >= 1) w->screen_mode = p[0];
+            break;
+
+        case PROTO_TYPE_BRIGHTNESS:
+            if (len >= 2) {
+                if (p[0] == BRIGHTNESS_TGT_SK6812) {
+                    led_sk6812_set_brightness(p[1]);
+                } else if (p[0] == BRIGHTNESS_TGT_WS2811) {
+                    led_ws2811_set_brightness(p[1]);
+                } else if (p[0] == BRIGHTNESS_TGT_TFT_BLK) {
+                    st7735_set_backlight(p[1]);
                 }
-                break;
-
-            case RX_WAIT_PAYLOAD:
-                s_rx_buf[s_rx_idx++] = byte;
-                if (s_rx_idx >= s_rx_len) s_rx_state = RX_WAIT_CHECKSUM;
-                break;
-
-            case RX_WAIT_CHECKSUM: {
-                uint8_t cksum = s_rx_type
-                              ^ (uint8_t)(s_rx_len & 0xFF)
-                              ^ (uint8_t)(s_rx_len >> 8);
-                for (uint16_t j = 0; j < s_rx_len; j++) cksum ^= s_rx_buf[j];
-
-                if (cksum == byte) {
-                    switch (s_rx_type) {
-
-                        case PROTO_TYPE_LED:
-                            dispatch_led_command();
-                            break;
-
-                        case PROTO_TYPE_SCREEN:
-                            if (s_screen_handle && s_rx_len >= 1) {
-                                xTaskNotify(s_screen_handle,
-                                            (uint32_t)s_rx_buf[0],
-                                            eSetValueWithOverwrite);
-                            }
-                            break;
-
-                        case PROTO_TYPE_HEARTBEAT:
-                            /* Update RX timestamp (task context) */
-                            g_last_heartbeat_rx_tick = xTaskGetTickCount();
-                            /* Echo heartbeat back to host */
-                            if (g_tx_queue && s_rx_len >= 1) {
-                                tx_item_t item;
-                                int hlen = proto_serialize(
-                                    item.buf, sizeof(item.buf),
-                                    PROTO_TYPE_HEARTBEAT, s_rx_buf, 1);
-                                if (hlen > 0) {
-                                    item.len = (uint8_t)hlen;
-                                    xQueueSend(g_tx_queue, &item, 0);
-                                }
-                            }
-                            break;
-
-                        case PROTO_TYPE_BRIGHTNESS:
-                            if (s_rx_len >= 2) {
-                                if (s_rx_buf[0] == BRIGHTNESS_TGT_SK6812) {
-                                    led_sk6812_set_brightness(s_rx_buf[1]);
-                                } else if (s_rx_buf[0] == BRIGHTNESS_TGT_WS2811) {
-                                    led_ws2811_set_brightness(s_rx_buf[1]);
-                                } else if (s_rx_buf[0] == BRIGHTNESS_TGT_TFT_BLK) {
-                                    st7735_set_backlight(s_rx_buf[1]);
-                                }
-                            }
-                            break;
-
-                        case PROTO_TYPE_MODE:
-                            if (s_rx_len >= 1) {
-                                sys_state_set((sys_state_t)s_rx_buf[0]);
-                            }
-                            break;
-
-                        case PROTO_TYPE_WARNING:
-                            if (s_rx_len >= WARN_ICON_COUNT) {
-                                for (uint8_t i = 0; i < WARN_ICON_COUNT; i++) {
-                                    led_sk6812_set_warning_state(i, s_rx_buf[i]);
-                                }
-                                /* Wake sk6812_task for an immediate visual update */
-                                if (s_sk6812_handle) xTaskNotifyGive(s_sk6812_handle);
-                            }
-                            break;
-
-                        case PROTO_TYPE_PERIPH_CMD:
-                            /* Forward to rs485_task via its command queue */
-                            if (s_rx_len >= 3) {
-                                rs485_forward_cmd(s_rx_buf, s_rx_len);
-                            }
-                            break;
-
-                        case PROTO_TYPE_WORKLIGHT:
-                            if (s_rx_len >= 4) {
-                                led_sk6812_set_worklight(s_rx_buf[0],
-                                                         s_rx_buf[1],
-                                                         s_rx_buf[2],
-                                                         s_rx_buf[3]);
-                                if (s_sk6812_handle) xTaskNotifyGive(s_sk6812_handle);
-                            }
-                            break;
-
-                        case PROTO_TYPE_PERIPH_SCREEN:
-                            /* Select peripheral for detail screen and switch mode */
-                            if (s_rx_len >= 1) {
-                                screen_periph_set_detail_addr(s_rx_buf[0]);
-                                if (s_screen_handle) {
-                                    xTaskNotify(s_screen_handle,
-                                                (uint32_t)SCREEN_MODE_PERIPH_DETAIL,
-                                                eSetValueWithOverwrite);
-                                }
-                            }
-                            break;
-
-                        default:
-                            break;
-                    }
+            }
+            break;
+
+        case PROTO_TYPE_WARNING:
+            if (len >= WARN_ICON_COUNT) {
+                for (uint8_t i = 0; i < WARN_ICON_COUNT; i++) {
+                    led_sk6812_set_warning_state(i, p[i]);
                 }
-                s_rx_state = RX_WAIT_SOF;
-                break;
+                /* Wake sk6812_task for an immediate visual update */
+                w->sk6812 = true;
             }
+            break;
+
+        case PROTO_TYPE_WORKLIGHT:
+            if (len >= 4) {
+                led_sk6812_set_worklight(p[0], p[1], p[2], p[3]);
+                w->sk6812 = true;
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+/* Validate the whole batch before applying any of it. Returns false if malformed. */
+static bool dispatch_batch(const uint8_t *p, uint16_t len, rx_wake_t *w)
+{
+    uint16_t off = 0;
+    while (off < len) {
+        if ((uint16_t)(len - off) < BATCH_SUB_HDR) return false;
+        uint8_t sub_len = p[off + 1];
+        if (!is_batchable(p[off])) return false;
+        if ((uint16_t)(len - off - BATCH_SUB_HDR) < sub_len) return false;
+        off = (uint16_t)(off + BATCH_SUB_HDR + sub_len);
+    }
+
+    for (off = 0; off < len; ) {
+        uint8_t sub_type = p[off];
+        uint8_t sub_len  = p[off + 1];
+        type_stats(sub_type)->rx_ok++;
+        dispatch_control(sub_type, &p[off + BATCH_SUB_HDR], sub_len, w);
+        off = (uint16_t)(off + BATCH_SUB_HDR + sub_len);
+    }
+    return true;
+}
+
+/* Telemetry subscription: all entries are checked before any is applied */
+static bool dispatch_subscribe(const uint8_t *p, uint16_t len)
+{
+    const uint16_t n = sizeof(subscribe_entry_t);
+    if (len == 0 || len % n != 0) return false;
+
+    subscribe_entry_t e;
+    for (uint16_t off = 0; off < len; off = (uint16_t)(off + n)) {
+        memcpy(&e, &p[off], n);
+        if (e.topic >= TELEM_TOPIC_COUNT || e.mode > SUB_MODE_ON_CHANGE) return false;
+    }
+    for (uint16_t off = 0; off < len; off = (uint16_t)(off + n)) {
+        memcpy(&e, &p[off], n);
+        telemetry_subscribe(&e);
+    }
+    return true;
+}
+
+/* ------------------------------------------------------------------ */
+/* Framing negotiation                                                   */
+/* ------------------------------------------------------------------ */
+static void handle_link_cfg(const uint8_t *p, uint16_t len)
+{
+    if (len < 1) return;
+    uint8_t want = p[0];
+    if (want != PROTO_FRAMING_SOF && want != PROTO_FRAMING_COBS) {
+        want = s_rx.framing;        /* unsupported — report current mode */
+    }
+
+    /* Replied from proto_tx_service() once no frame is half-written */
+    s_link_cfg_want = want;
+}
+
+/*
+ * Send the LINK_CFG reply and switch framing. Holding the bulk lock keeps
+ * bulk producers out while the switch happens; whatever the bulk lane still
+ * holds is in the old framing and would reach the Pi after the reply (the
+ * event lane drains first), so it is discarded.
+ */
+static void apply_link_cfg(void)
+{
+    tx_ring_t *bulk = &g_tx_lane[PROTO_LANE_BULK];
+    if (bulk->rec_left != 0) return;    /* bulk frame on the wire — next pass */
+
+    uint8_t want = (uint8_t)s_link_cfg_want;
+    s_link_cfg_want = -1;
+
+    xSemaphoreTake(bulk->lock, portMAX_DELAY);
+    uint8_t *p = proto_tx_begin(PROTO_TYPE_LINK_CFG, sizeof(link_cfg_t));
+    if (p) {
+        tx_ring_clear(bulk);
+        p[0] = want;
+        s_tx_framing_next = want;   /* proto_tx_end() switches TX right after it */
+        proto_tx_end(p);
+    }
+    xSemaphoreGive(bulk->lock);
+    if (!p) return;                 /* no reply sent — keep current framing */
+
+    proto_parser_set_framing(&s_rx, want);
+}
+
+void proto_tx_service(void)
+{
+    if (s_link_cfg_want >= 0) apply_link_cfg();
+
+    /* Samples only enter the bulk lane when it has nothing else to send,
+     * so what goes out is always the newest one */
+    if (!tx_ring_empty(&g_tx_lane[PROTO_LANE_BULK])) return;
+
+    tx_sample_t s;
+    for (int i = 0; i < TX_SAMPLE_SLOTS; i++) {
+        if (xQueueReceive(s_sample_mbox[i], &s, 0) == pdTRUE) {
+            proto_send(s.type, s.data, s.len);
         }
     }
 }
+
+void proto_reset_framing(void)
+{
+    /* Same lock order as apply_link_cfg(): bulk, then event */
+    SemaphoreHandle_t bulk  = g_tx_lane[PROTO_LANE_BULK].lock;
+    SemaphoreHandle_t event = g_tx_lane[PROTO_LANE_EVENT].lock;
+    if (bulk)  xSemaphoreTake(bulk, portMAX_DELAY);
+    if (event) xSemaphoreTake(event, portMAX_DELAY);
+    s_tx_framing      = PROTO_FRAMING_SOF;
+    s_tx_framing_next = -1;
+    s_link_cfg_want   = -1;
+    if (event) xSemaphoreGive(event);
+    if (bulk)  xSemaphoreGive(bulk);
+
+    proto_parser_set_framing(&s_rx, PROTO_FRAMING_SOF);
+}
+
+/* ------------------------------------------------------------------ */
+/* RX frame handler — called by the parser once per complete frame       */
+/* ------------------------------------------------------------------ */
+static bool rx_frame(void *ctx, proto_rx_status_t status, uint8_t type,
+                     const uint8_t *p, uint16_t len)
+{
+    (void)ctx;
+
+    if (status != PROTO_RX_OK) {
+        if (status == PROTO_RX_OVERSIZE) s_rx_oversize++;
+        else                             s_rx_bad_cksum++;
+        type_stats(type)->rx_rejected++;
+        return false;
+    }
+
+    type_stats(type)->rx_ok++;
+    rx_wake_t wake = { .sk6812 = false, .ws2811 = false, .screen_mode = -1 };
+    switch (type) {
+
+        case PROTO_TYPE_LED:
+        case PROTO_TYPE_SCREEN:
+        case PROTO_TYPE_BRIGHTNESS:
+        case PROTO_TYPE_WARNING:
+        case PROTO_TYPE_WORKLIGHT:
+            dispatch_control(type, p, len, &wake);
+            break;
+
+        case PROTO_TYPE_BATCH:
+            if (!dispatch_batch(p, len, &wake)) {
+                type_stats(PROTO_TYPE_BATCH)->rx_rejected++;
+            }
+            break;
+
+        case PROTO_TYPE_SUBSCRIBE:
+            if (!dispatch_subscribe(p, len)) {
+                type_stats(PROTO_TYPE_SUBSCRIBE)->rx_rejected++;
+            }
+            break;
+
+        case PROTO_TYPE_HEARTBEAT:
+            /* Update RX timestamp (task context) */
+            g_last_heartbeat_rx_tick = xTaskGetTickCount();
+            /* Echo heartbeat back to host, with our receive and
+             * send times for the Pi's clock sync */
+            if (len >= sizeof(heartbeat_pkt_t)) {
+                heartbeat_echo_t e;
+                e.seq   = p[0];
+                memcpy(&e.t1_us, &p[1], sizeof(e.t1_us));
+                e.t2_us = s_rx_time_us;
+                e.t3_us = time_us_32();
+                proto_send(PROTO_TYPE_HEARTBEAT, &e, sizeof(e));
+            } else if (len >= 1) {
+                proto_send(PROTO_TYPE_HEARTBEAT, p, 1);
+            }
+            break;
+
+        case PROTO_TYPE_MODE:
+            if (len >= 1) {
+                sys_state_set((sys_state_t)p[0]);
+            }
+            break;
+
+        case PROTO_TYPE_PERIPH_CMD:
+            /* Forward to rs485_task via its command pool */
+            if (len >= sizeof(periph_cmd_t)) {
+                rs485_forward_cmd(p, len);
+            }
+            break;
+
+        case PROTO_TYPE_PERIPH_SCAN:
+            rs485_request_scan();
+            break;
+
+        case PROTO_TYPE_LINK_CFG:
+            handle_link_cfg(p, len);
+            break;
+
+        case PROTO_TYPE_PERIPH_SCREEN:
+            /* Select peripheral for detail screen and switch mode */
+            if (len >= 1) {
+                screen_periph_set_detail_addr(p[0]);
+                wake.screen_mode = SCREEN_MODE_PERIPH_DETAIL;
+            }
+            break;
+
+        default:
+            break;
+    }
+    rx_wake_flush(&wake);
+
+    return false;
+}
+
+/* ------------------------------------------------------------------ */
+/* RX entry point (called from CDC task context)                         */
+/* ------------------------------------------------------------------ */
+void proto_handle_rx(const uint8_t *data, uint32_t len)
+{
+    s_rx_time_us = time_us_32();
+    proto_parser_feed(&s_rx, data, len);
+}
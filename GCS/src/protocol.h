@@ -6,28 +6,10 @@
 #include "FreeRTOS.h"
 #include "queue.h"
 #include "task.h"
+#include "tx_ring.h"
 
-/* ------------------------------------------------------------------ */
-/* Packet framing                                                        */
-/* ------------------------------------------------------------------ */
-#define PROTO_SOF               0xAA
-
-#define PROTO_TYPE_ADC          0x01  /* Pico→Pi: ADC channel data         */
-#define PROTO_TYPE_DIGITAL      0x02  /* Pico→Pi: digital I/O state        */
-#define PROTO_TYPE_LED          0x03  /* Pi→Pico: LED command               */
-#define PROTO_TYPE_SCREEN       0x04  /* Pi→Pico: screen mode command       */
-#define PROTO_TYPE_HEARTBEAT    0x05  /* bidirectional: alive signal        */
-#define PROTO_TYPE_EVENT        0x06  /* Pico→Pi: input event               */
-#define PROTO_TYPE_ERROR        0x07  /* Pico→Pi: error status              */
-#define PROTO_TYPE_BRIGHTNESS   0x08  /* Pi→Pico: global brightness         */
-#define PROTO_TYPE_MODE         0x09  /* Pi→Pico: state machine override    */
-#define PROTO_TYPE_WARNING      0x0A  /* Pi→Pico: warning panel severity    */
-#define PROTO_TYPE_ALS          0x0B  /* Pico→Pi: ambient light sensor data */
-#define PROTO_TYPE_PERIPH_CMD   0x0C  /* Pi→Pico:  command for a bus peripheral  */
-#define PROTO_TYPE_PERIPH_DATA  0x0D  /* Pico→Pi:  data from a bus peripheral    */
-#define PROTO_TYPE_PERIPH_STATE 0x0E  /* Pico→Pi:  peripheral online/offline     */
-#define PROTO_TYPE_PERIPH_SCREEN 0x0F /* Pi→Pico:  select peripheral detail screen */
-#define PROTO_TYPE_WORKLIGHT     0x10 /* Pi→Pico:  worklight on/off + colour        */
+/* Packet types, framing and PROTO_MAX_PAYLOAD live in the shared codec */
+#include "proto_codec.h"
 
 /* Warning severity levels — type 0x0A */
 #define WARN_OK                 0
@@ -56,6 +38,31 @@
 #define LED_ANIM_BLINK_FAST     3   /* 100 ms period */
 #define LED_ANIM_PULSE          4   /* sine-wave 0-100% brightness */
 
+/*
+ * SK6812 partial updates — type 0x03, chain=0x00 with num_pixels=0, followed
+ * by [op][a][b][data...]. Only the addressed pixels change.
+ *
+ *   FILL     [start][count] G R B W                   count pixels, one colour
+ *   RUNS     [start][n_runs] n_runs × (len G R B W)    consecutive runs
+ *   PALETTE  [first][count] count × (G R B W)          load palette entries
+ *   INDEXED  [start][count] ceil(count/2) bytes        4-bit palette index per
+ *                                                      pixel, high nibble first
+ */
+#define SK_OP_FILL              0x01
+#define SK_OP_RUNS              0x02
+#define SK_OP_PALETTE           0x03
+#define SK_OP_INDEXED           0x04
+
+/*
+ * Batch — type 0x14. Payload is a sequence of sub-commands, each
+ * [type][len][payload...] with the same payload as the standalone frame.
+ * Allowed types: LED, SCREEN, BRIGHTNESS, WARNING, WORKLIGHT. The whole batch
+ * is checked first and dropped if any sub-command is malformed or of another
+ * type; otherwise all are applied in one pass and each LED task / the screen
+ * task is woken once at the end.
+ */
+#define BATCH_SUB_HDR           2
+
 /* Event IDs — type 0x06 */
 #define EVT_SWITCH_CHANGED      0x01  /* value = port_a<<8 | port_b */
 #define EVT_BUTTON_PRESSED      0x02  /* value = button_id */
@@ -70,26 +77,27 @@
 #define ERR_STACK_OVERFLOW      0x02
 #define ERR_MALLOC_FAILED       0x03
 
-/* SK6812 chain: 2-byte header + SK6812_MAX_PIXELS(128) * 4 bytes GRBW = 514 */
-#define PROTO_MAX_PAYLOAD   514
-/* Frame: SOF(1)+TYPE(1)+LEN_LO(1)+LEN_HI(1)+PAYLOAD+CKSUM(1) */
-#define PROTO_MAX_PACKET    (5 + PROTO_MAX_PAYLOAD)
-
 /* ------------------------------------------------------------------ */
 /* Packet payload structures                                            */
 /* ------------------------------------------------------------------ */
 
-/* Type 0x01 — ADC data (14 bytes) */
+/*
+ * Sample timestamps (ts_us) are time_us_32() at capture: µs since boot,
+ * wrapping every ~71.6 min. The Pi maps them onto its own clock with the
+ * offset/drift it keeps from the heartbeat exchange (type 0x05).
+ */
+
+/* Type 0x01 — ADC data (16 bytes) */
 typedef struct __attribute__((packed)) {
     uint16_t ch[6];       /* raw 12-bit ADC counts for CH0-CH5 */
-    uint16_t ts_ms;       /* FreeRTOS tick count in ms */
+    uint32_t ts_us;       /* time_us_32() at capture */
 } adc_packet_t;
 
-/* Type 0x02 — Digital I/O state (4 bytes) */
+/* Type 0x02 — Digital I/O state (6 bytes) */
 typedef struct __attribute__((packed)) {
     uint8_t  port_a;      /* MCP23017 GPIOA state */
     uint8_t  port_b;      /* MCP23017 GPIOB state */
-    uint16_t ts_ms;
+    uint32_t ts_us;       /* time_us_32() at capture */
 } digital_packet_t;
 
 /* Type 0x03 — LED command header */
@@ -103,10 +111,26 @@ typedef struct __attribute__((packed)) {
     uint8_t mode;   /* 0=auto, 1=main, 2=warning, 3=lock, 4=bat_warning */
 } screen_cmd_t;
 
-/* Type 0x05 — Heartbeat */
+/*
+ * Type 0x05 — Heartbeat. Both sides send heartbeat_pkt_t once a second with
+ * their own clock in t_us. The Pico answers each Pi heartbeat with
+ * heartbeat_echo_t, which gives the Pi all four NTP timestamps:
+ *   offset = ((t2 - t1) + (t3 - t4)) / 2      (Pico clock − Pi clock)
+ *   rtt    =  (t4 - t1) - (t3 - t2)
+ * t4 is the Pi's receive time. A 1-byte heartbeat (seq only) is still
+ * accepted and echoed as 1 byte.
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t  seq;
+    uint32_t t_us;        /* sender's µs clock at send */
+} heartbeat_pkt_t;        /* 5 bytes */
+
 typedef struct __attribute__((packed)) {
-    uint8_t seq;
-} heartbeat_pkt_t;
+    uint8_t  seq;         /* Pi's seq */
+    uint32_t t1_us;       /* Pi: heartbeat sent (echoed) */
+    uint32_t t2_us;       /* Pico: heartbeat received */
+    uint32_t t3_us;       /* Pico: echo sent */
+} heartbeat_echo_t;       /* 13 bytes */
 
 /* Type 0x06 — Input event */
 typedef struct __attribute__((packed)) {
@@ -139,16 +163,30 @@ typedef struct __attribute__((packed)) {
     uint8_t severity[WARN_ICON_COUNT];  /* one WARN_* value per icon, index = WARN_ICON_* */
 } warning_cmd_t;
 
-/* Type 0x0C — Peripheral command (Pi → Pico → RS-485 bus) */
+/* Type 0x0C — Peripheral command (Pi → Pico → RS-485 bus)
+ * req_id comes back in the PERIPH_DATA that answers the command, so the Pi
+ * can keep several in flight. The Pi numbers them 1–255; 0 is reserved for
+ * data the Pico sends unasked (status polls, STREAM_DATA). */
 typedef struct __attribute__((packed)) {
-    uint8_t addr;       /* target peripheral address (0x01–0xFE) */
+    uint8_t req_id;     /* correlation ID, 1–255                 */
+    uint8_t addr;       /* device 0x01–0xEF, group 0xF0–0xFE     */
     uint8_t cmd;        /* RS-485 bus CMD byte                   */
     uint8_t len;        /* payload byte count (0–255)            */
     uint8_t payload[];  /* flexible array — len bytes            */
 } periph_cmd_t;
 
-/* Type 0x0D — Peripheral data (RS-485 bus → Pico → Pi) */
+/* periph_data_t.result — outcome of the command with that req_id */
+#define PERIPH_RESULT_OK        0   /* reply in cmd / payload            */
+#define PERIPH_RESULT_SENT      1   /* group or broadcast, never answered */
+#define PERIPH_RESULT_TIMEOUT   2   /* device did not answer             */
+#define PERIPH_RESULT_BAD_REPLY 3   /* answer failed its CRC             */
+#define PERIPH_RESULT_NACK      4   /* refused: pool full or truncated   */
+
+/* Type 0x0D — Peripheral data (RS-485 bus → Pico → Pi). With a result
+ * other than OK, addr / cmd echo the command and len is 0. */
 typedef struct __attribute__((packed)) {
+    uint8_t req_id;     /* from periph_cmd_t; 0 = unsolicited    */
+    uint8_t result;     /* PERIPH_RESULT_*                       */
     uint8_t addr;       /* source peripheral address             */
     uint8_t cmd;        /* RS-485 CMD byte of the response       */
     uint8_t len;        /* payload byte count                    */
@@ -174,26 +212,169 @@ typedef struct __attribute__((packed)) {
     uint8_t b;
 } worklight_cmd_t;
 
+/* Type 0x12 — Link configuration.
+ * Pi→Pico: requested framing. Pico→Pi: framing now in effect. The Pico sends
+ * the reply in the old framing and uses the new one for every later frame in
+ * both directions; the Pi switches when it receives the reply. Bulk frames
+ * still queued in the old framing are discarded at the switch. */
+typedef struct __attribute__((packed)) {
+    uint8_t framing;    /* PROTO_FRAMING_* */
+} link_cfg_t;
+
+/* Type 0x13 — Link health counters, sent every LINK_STATS_PERIOD_MS on the
+ * event lane. All counters are monotonic since boot (u32, wrap-around); the
+ * Pi derives rates from consecutive packets. Fixed header followed by
+ * n_types link_stats_type_t entries, one per packet type with any activity. */
+#define LINK_STATS_PERIOD_MS    1000
+
+typedef struct __attribute__((packed)) {
+    uint32_t ts_ms;             /* ms since boot */
+    uint16_t event_hwm;         /* event lane peak fill, bytes */
+    uint16_t event_size;        /* event lane capacity, bytes  */
+    uint16_t bulk_hwm;          /* bulk lane peak fill, bytes  */
+    uint16_t bulk_size;         /* bulk lane capacity, bytes   */
+    uint32_t event_dropped;     /* event lane: refused (full / lock timeout) */
+    uint32_t bulk_dropped;      /* bulk lane: refused, or discarded at a framing switch */
+    uint32_t cdc_short_writes;  /* tud_cdc_write() took less than offered (FIFO full) */
+    uint32_t rx_bad_cksum;      /* RX frames rejected on checksum */
+    uint32_t rx_oversize;       /* RX frames rejected on length > PROTO_MAX_PAYLOAD */
+    uint8_t  n_types;           /* entries that follow */
+} link_stats_hdr_t;             /* 33 bytes */
+
+typedef struct __attribute__((packed)) {
+    uint8_t  type;              /* PROTO_TYPE_* */
+    uint32_t enqueued;          /* TX: accepted into a lane or sample mailbox   */
+    uint32_t serialized;        /* TX: frames written into a lane               */
+    uint32_t dropped;           /* TX: refused by a full lane, or sample superseded */
+    uint32_t rx_ok;             /* RX: frames accepted                          */
+    uint32_t rx_rejected;       /* RX: checksum / oversize, by header type byte */
+} link_stats_type_t;            /* 21 bytes */
+
+/* Per-type counters cover PROTO_TYPE_* values below this */
+#define LINK_STATS_MAX_TYPES    32
+
+/* Type 0x17 — RS-485 transaction stats per peripheral, sent with LINK_STATS.
+ * Counters are monotonic since the device was discovered (u32, wrap-around).
+ * Latency runs from the end of the master's frame to a reply with a good
+ * CRC, in log2 bins: bin 0 is below lat_base_us, bin i below lat_base_us·2^i,
+ * the last bin is everything above. Fixed header followed by n_periph
+ * periph_stats_entry_t; with more devices than fit one frame, successive
+ * frames carry on round the registry. */
+#define PERIPH_STATS_LAT_BINS       10
+#define PERIPH_STATS_LAT_BASE_US    128
+#define PERIPH_STATS_MAX_ENTRIES    8       /* per frame, within PROTO_MAX_PAYLOAD */
+
+typedef struct __attribute__((packed)) {
+    uint32_t ts_ms;             /* ms since boot */
+    uint32_t baud;              /* current bus rate */
+    uint16_t lat_base_us;       /* PERIPH_STATS_LAT_BASE_US */
+    uint8_t  lat_bins;          /* PERIPH_STATS_LAT_BINS */
+    uint8_t  n_periph;          /* entries that follow */
+} periph_stats_hdr_t;           /* 12 bytes */
+
+typedef struct __attribute__((packed)) {
+    uint8_t  addr;
+    uint8_t  online;
+    uint32_t answered;          /* addressed transactions with a good reply */
+    uint32_t timeouts;          /* ... with no complete reply in time       */
+    uint32_t crc_errors;        /* replies (or stream frames) failing CRC   */
+    uint32_t timeout_us;        /* current adaptive response-start timeout  */
+    uint32_t lat_max_us;        /* slowest good reply                        */
+    uint32_t lat_hist[PERIPH_STATS_LAT_BINS];
+} periph_stats_entry_t;         /* 62 bytes */
+
 /* Type 0x0B — Ambient light sensor data (VEML7700) */
 typedef struct __attribute__((packed)) {
     uint16_t als_raw;   /* raw ALS register count (16-bit) */
     uint16_t white_raw; /* raw WHITE register count (16-bit) */
     uint32_t lux_milli; /* lux × 1000 (i.e. millilux), avoids float on wire */
-    uint16_t ts_ms;     /* FreeRTOS tick count in ms */
+    uint32_t ts_us;     /* time_us_32() at capture */
 } als_packet_t;
 
+/* Type 0x11 — Telemetry bundle: latest ADC, digital and ALS snapshots in one
+ * frame. Replaces the separate 0x01/0x02/0x0B frames when
+ * TELEMETRY_BUNDLE_ENABLE is set. `fresh` tells the Pi which sections carry
+ * a new sample since the previous bundle; stale sections repeat old values. */
+#define TELEM_FRESH_ADC         0x01
+#define TELEM_FRESH_DIGITAL     0x02
+#define TELEM_FRESH_ALS         0x04
+
+typedef struct __attribute__((packed)) {
+    uint32_t ts_us;       /* capture time of the newest fresh section */
+    uint8_t  fresh;       /* TELEM_FRESH_* bitmask */
+    uint16_t adc[6];      /* as adc_packet_t.ch */
+    uint8_t  port_a;      /* as digital_packet_t */
+    uint8_t  port_b;
+    uint16_t als_raw;     /* as als_packet_t */
+    uint16_t white_raw;
+    uint32_t lux_milli;
+} telemetry_bundle_t;     /* 27 bytes */
+
+/* Type 0x15 — Telemetry subscription (Pi → Pico). One to TELEM_TOPIC_COUNT
+ * subscribe_entry_t, each replacing the settings of its topic; topics not
+ * listed keep theirs. Every topic reverts to SUB_MODE_PERIODIC at
+ * TELEMETRY_DEFAULT_PERIOD_MS on USB connect, so a Pi that never subscribes
+ * gets the full stream. Topic numbers are the TELEM_FRESH_* bit positions and
+ * select the bundle section (or the standalone 0x01/0x02/0x0B frame). */
+#define TELEM_TOPIC_ADC         0
+#define TELEM_TOPIC_DIGITAL     1
+#define TELEM_TOPIC_ALS         2
+#define TELEM_TOPIC_COUNT       3
+
+#define SUB_MODE_OFF            0   /* never sent                                      */
+#define SUB_MODE_PERIODIC       1   /* latest sample every period_ms, if there is a new one */
+#define SUB_MODE_ON_CHANGE      2   /* when the value moves by more than deadband,
+                                       at most every period_ms                         */
+
+typedef struct __attribute__((packed)) {
+    uint8_t  topic;         /* TELEM_TOPIC_* */
+    uint8_t  mode;          /* SUB_MODE_* */
+    uint16_t period_ms;     /* 0 = every scheduler tick (TELEMETRY_TICK_MS) */
+    uint8_t  decimation;    /* use 1 of every N sensor samples; 0 and 1 = all */
+    uint16_t deadband;      /* ON_CHANGE: ADC counts on any channel, or lux; digital ignores it */
+} subscribe_entry_t;        /* 7 bytes */
+
 /* ------------------------------------------------------------------ */
-/* TX queue                                                              */
+/* TX lanes                                                              */
 /* ------------------------------------------------------------------ */
-#define TX_BUF_SIZE     64
-#define TX_QUEUE_DEPTH  16
-
+/*
+ * Pico→Pi frames travel in one of two lanes, each its own record ring:
+ *
+ *   EVENT  EVENT, ERROR, PERIPH_STATE, HEARTBEAT, LINK_CFG, LINK_STATS —
+ *          small or rare, and the link's health report must get out when
+ *          bulk is congested;
+ *          drained first by cdc_task, so an operator input waits at most for
+ *          the one bulk frame already on the wire.
+ *   BULK   PERIPH_DATA, plus sensor samples (ADC, DIGITAL, ALS, TELEMETRY).
+ *
+ * Sensor samples are not queued at all: proto_post_sample() overwrites a
+ * one-deep mailbox per type, and cdc_task serializes the newest sample into
+ * the bulk lane only when that lane has gone idle. A stalled link therefore
+ * costs old samples (counted as superseded), never blocks a producer and
+ * never fills the event lane.
+ */
+typedef enum {
+    PROTO_LANE_EVENT = 0,
+    PROTO_LANE_BULK,
+    PROTO_LANE_COUNT
+} proto_lane_t;
+
+#define TX_EVENT_RING_SIZE      2048  /* bytes; a full LINK_STATS + ~60 event frames */
+#define TX_BULK_RING_SIZE       2048  /* bytes; ~3 max-size PERIPH_DATA frames */
+#define TX_RING_LOCK_TIMEOUT_MS 5     /* max wait for another producer      */
+
+/* Largest payload accepted by proto_post_sample() */
+#define PROTO_SAMPLE_MAX        sizeof(telemetry_bundle_t)
+
+/** CDC TX lanes — filled by proto_tx_*(), drained by cdc_task(). */
+extern tx_ring_t g_tx_lane[PROTO_LANE_COUNT];
+
+/* Per-lane drop accounting (monotonic since boot) */
 typedef struct {
-    uint8_t buf[TX_BUF_SIZE];
-    uint8_t len;
-} tx_item_t;
-
-extern QueueHandle_t g_tx_queue;
+    uint32_t event_dropped;     /* event-lane frames refused: ring full / lock timeout */
+    uint32_t bulk_dropped;      /* bulk-lane frames refused or discarded               */
+    uint32_t bulk_superseded;   /* samples overwritten by a newer one before sending   */
+} proto_tx_stats_t;
 
 /* ------------------------------------------------------------------ */
 /* API                                                                   */
@@ -207,10 +388,54 @@ void proto_set_led_task_handles(TaskHandle_t sk6812_handle,
                                 TaskHandle_t ws2811_handle);
 void proto_set_screen_task_handle(TaskHandle_t screen_handle);
 
-/** Enqueue a Pico→Pi event packet on g_tx_queue (safe from any task). */
+/** Initialise the TX lanes. Must be called before any producer task runs. */
+void proto_tx_init(void);
+
+/**
+ * Reserve a complete frame for payload_len bytes in the lane that carries
+ * `type` and write its header. Returns a pointer to the payload area, which
+ * the caller fills in place before passing it to proto_tx_end(). Returns
+ * NULL if the lane is full; in that case proto_tx_end() must not be called.
+ */
+uint8_t *proto_tx_begin(uint8_t type, uint16_t payload_len);
+
+/** Append the checksum to the frame whose payload proto_tx_begin() returned and commit it. */
+void proto_tx_end(uint8_t *payload);
+
+/**
+ * Revert both directions to PROTO_FRAMING_SOF (called on USB connect so
+ * every new host session starts from the default framing).
+ */
+void proto_reset_framing(void);
+
+/** Serialize one frame straight into its lane. Returns false if dropped. */
+bool proto_send(uint8_t type, const void *payload, uint16_t payload_len);
+
+/**
+ * Latest-wins: replace the pending sample of `type` (ADC, DIGITAL, ALS or
+ * TELEMETRY) with this one. Never blocks. payload_len <= PROTO_SAMPLE_MAX.
+ */
+void proto_post_sample(uint8_t type, const void *payload, uint16_t payload_len);
+
+/**
+ * cdc_task only, between frames: apply a pending framing switch, then move
+ * pending samples into the bulk lane if it is idle.
+ */
+void proto_tx_service(void);
+
+/** Snapshot the per-lane drop counters. */
+void proto_tx_get_stats(proto_tx_stats_t *out);
+
+/**
+ * Serialize a PROTO_TYPE_LINK_STATS frame onto the event lane.
+ * cdc_short_writes is owned by cdc_task and passed in.
+ */
+void proto_send_link_stats(uint32_t cdc_short_writes);
+
+/** Enqueue a Pico→Pi event packet on the event lane (safe from any task). */
 void proto_send_event(uint8_t event_id, uint16_t value);
 
-/** Enqueue a Pico→Pi error packet on g_tx_queue. */
+/** Enqueue a Pico→Pi error packet on the event lane. */
 void proto_send_error(uint8_t error_code);
 
 #endif /* PROTOCOL_H */
@@ -2,54 +2,157 @@
 #include "pins.h"
 #include "protocol.h"
 #include "screen_display.h"
+#include "tx_ring.h"
+#include "crc8.h"         /* Peripherals/Framework/core, shared with the slaves */
 #include "hardware/uart.h"
 #include "hardware/gpio.h"
+#include "hardware/irq.h"
+#include "hardware/flash.h"
+#include "pico/stdlib.h"
+#include "pico/flash.h"
 #include "FreeRTOS.h"
 #include "task.h"
-#include "queue.h"
 #include <string.h>
 
 /* ------------------------------------------------------------------ */
-/* Internal command queue (CDC → RS-485 task)                           */
+/* Internal command pool (CDC → RS-485 task)                            */
 /* ------------------------------------------------------------------ */
-#define RS485_CMD_QUEUE_DEPTH  8
-#define RS485_CMD_BUF_SIZE     64
+#define RS485_CMD_POOL_SIZE    4096 /* bytes; a firmware-update window and then some, ~370 short commands */
+#define RS485_CMD_BURST        4    /* commands in a row before housekeeping gets a turn */
 
-typedef struct {
-    uint8_t buf[RS485_CMD_BUF_SIZE];
-    uint8_t len;
+/* One record in the pool: the PERIPH_CMD as received, sized to its payload.
+ * Records sit at any byte offset, hence packed. */
+typedef struct __attribute__((packed)) {
+    uint32_t queued_us;     /* time_us_32() at rs485_forward_cmd() */
+    uint8_t  req_id;        /* from here on, a copy of periph_cmd_t */
+    uint8_t  addr;
+    uint8_t  cmd;
+    uint8_t  len;
+    uint8_t  payload[];
 } rs485_cmd_item_t;
 
-static QueueHandle_t s_cmd_queue;
+static uint8_t   s_cmd_pool[RS485_CMD_POOL_SIZE];
+static tx_ring_t s_cmd_ring;        /* producer: cdc_task; consumer: rs485_task */
 
 /* ------------------------------------------------------------------ */
 /* Peripheral registry                                                   */
 /* ------------------------------------------------------------------ */
-static uint8_t s_known_addrs[RS485_MAX_PERIPHERALS] = {
-    0x01, 0x02, 0x03, 0x04,
-    0x00, 0x00, 0x00, 0x00
-};
-static bool s_online[RS485_MAX_PERIPHERALS];
+typedef struct {
+    uint8_t    addr;        /* 0 = empty slot */
+    bool       online;
+    uint8_t    misses;      /* consecutive unanswered PING / GET_STATUS */
+    uint32_t   srtt_us;     /* smoothed send-done → first byte; 0 = no sample yet */
+    uint32_t   rttvar_us;   /* its mean deviation */
+    uint32_t   backoff_ms;  /* re-probe interval while offline */
+    TickType_t next_ping;
+    uint16_t   stream_every; /* stream cycles per slot; 0 = not streaming */
+
+    /* Transaction stats since discovery — PROTO_TYPE_PERIPH_STATS */
+    uint32_t   answered;
+    uint32_t   timeouts;
+    uint32_t   crc_errors;
+    uint32_t   lat_max_us;  /* send done → CRC valid */
+    uint32_t   lat_hist[PERIPH_STATS_LAT_BINS];
+} periph_t;
+
+/* Filled from the flash cache at boot, or by discovery */
+static periph_t s_periph[RS485_MAX_PERIPHERALS];
+
+static rs485_sched_stats_t s_stats;
 
 /* ------------------------------------------------------------------ */
-/* CRC-8/MAXIM (polynomial 0x31, init 0x00)                             */
+/* RX ring — filled by the UART1 IRQ, drained by rs485_task              */
 /* ------------------------------------------------------------------ */
-static uint8_t crc8(const uint8_t *data, size_t len)
+#define RS485_RX_RING_SIZE  512     /* power of two; > one max-size frame */
+#define RS485_RX_RING_MASK  (RS485_RX_RING_SIZE - 1)
+
+static uint8_t           s_rx_ring[RS485_RX_RING_SIZE];
+static volatile uint16_t s_rx_head = 0;     /* written by the IRQ only  */
+static volatile uint16_t s_rx_tail = 0;     /* written by the task only */
+static volatile uint16_t s_rx_need = 0;     /* wake the task at this many bytes; 0 = not waiting */
+static TaskHandle_t      s_bus_task = NULL;  /* rs485_task: woken by RX bytes and new commands */
+static volatile bool     s_rx_stamp_armed = false;
+static volatile uint32_t s_rx_first_us;     /* first byte after the last send */
+
+static uint16_t rx_ring_count(void)
+{
+    return (uint16_t)((s_rx_head - s_rx_tail) & RS485_RX_RING_MASK);
+}
+
+static void __isr rs485_uart_isr(void)
 {
-    uint8_t crc = 0x00;
-    for (size_t i = 0; i < len; i++) {
-        crc ^= data[i];
-        for (int b = 0; b < 8; b++)
-            crc = (crc & 0x80) ? (crc << 1) ^ 0x31 : (crc << 1);
+    /* Drains the FIFO on the RX level interrupt and on the RX timeout
+     * (32 bit times of silence), so the last byte of a frame is never left
+     * behind in the FIFO */
+    while (uart_is_readable(RS485_UART_INST)) {
+        uint8_t  b    = (uint8_t)uart_getc(RS485_UART_INST);
+        uint16_t head = s_rx_head;
+        uint16_t next = (uint16_t)((head + 1) & RS485_RX_RING_MASK);
+        if (next == s_rx_tail) continue;    /* full — the frame's CRC fails */
+        s_rx_ring[head] = b;
+        s_rx_head = next;
+        if (s_rx_stamp_armed) {
+            s_rx_first_us    = time_us_32();
+            s_rx_stamp_armed = false;
+        }
     }
-    return crc;
+
+    uint16_t need = s_rx_need;
+    if (need && rx_ring_count() >= need && s_bus_task) {
+        s_rx_need = 0;
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(s_bus_task, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+}
+
+static bool rx_ring_pop(uint8_t *b)
+{
+    uint16_t tail = s_rx_tail;
+    if (tail == s_rx_head) return false;
+    *b = s_rx_ring[tail];
+    s_rx_tail = (uint16_t)((tail + 1) & RS485_RX_RING_MASK);
+    return true;
+}
+
+/* Drop anything left over from an earlier, abandoned transaction */
+static void rx_ring_flush(void)
+{
+    s_rx_tail = s_rx_head;
 }
 
 /* ------------------------------------------------------------------ */
 /* Transmit one RS-485 frame                                             */
 /* ------------------------------------------------------------------ */
-static void rs485_send(uint8_t addr, uint8_t cmd,
-                       const uint8_t *payload, uint8_t plen)
+static uint32_t s_tx_done_us;       /* end of the last frame we sent        */
+static uint8_t  s_tx_addr;          /* ... and who it was addressed to      */
+static uint32_t s_bus_free_us;      /* earliest next send (inter-frame gap) */
+static uint32_t s_baud = RS485_BAUD;
+static uint32_t s_byte_us = (10u * 1000000u + RS485_BAUD - 1) / RS485_BAUD;
+
+static void bus_set_baud(uint32_t baud)
+{
+    uart_set_baudrate(RS485_UART_INST, baud);
+    s_baud    = baud;
+    s_byte_us = (10u * 1000000u + baud - 1) / baud;
+}
+
+/* Waits at least us. vTaskDelay(t) ends anywhere in the t-th tick, so a
+   wait under a tick spins instead of rounding up to a whole one, and a
+   longer one takes a tick extra to stay a minimum. */
+static void sleep_us_rtos(uint32_t us)
+{
+    const uint32_t tick_us = 1000u * portTICK_PERIOD_MS;
+    if (us < tick_us) {
+        busy_wait_us_32(us);
+        return;
+    }
+    vTaskDelay((TickType_t)((us + tick_us - 1u) / tick_us) + 1u);
+}
+
+/* Returns time_us_32() at the start of transmission */
+static uint32_t rs485_send(uint8_t addr, uint8_t cmd,
+                           const uint8_t *payload, uint8_t plen)
 {
     uint8_t frame[4 + 255 + 1];
     frame[0] = RS485_SOF;
@@ -59,68 +162,172 @@ static void rs485_send(uint8_t addr, uint8_t cmd,
     if (plen && payload) memcpy(&frame[4], payload, plen);
     frame[4 + plen] = crc8(&frame[1], 3 + plen);
 
+    /* Inter-frame gap, measured from the end of the previous frame in
+     * either direction — usually already over by the time we get here */
+    int32_t wait = (int32_t)(s_bus_free_us - time_us_32());
+    if (wait > 0) sleep_us_rtos((uint32_t)wait);
+
+    rx_ring_flush();
+    uint32_t start = time_us_32();
     gpio_put(PIN_RS485_DE, 1);
     uart_write_blocking(RS485_UART_INST, frame, 5 + plen);
     uart_tx_wait_blocking(RS485_UART_INST);
     gpio_put(PIN_RS485_DE, 0);
+
+    s_tx_addr        = addr;
+    s_tx_done_us     = time_us_32();
+    s_bus_free_us    = s_tx_done_us + RS485_GAP_US;
+    s_rx_stamp_armed = true;
+    return start;
 }
 
 /* ------------------------------------------------------------------ */
-/* Receive one RS-485 frame (blocking with timeout)                      */
-/* Returns payload length on success, -1 on timeout or CRC error.       */
+/* Receive one RS-485 frame                                              */
+/* first_us bounds the wait for the response to start (after the send); */
+/* once its header is in, the deadline moves out to cover the payload.   */
+/* Returns payload length on success, RX_TIMEOUT or RX_BAD_FRAME, and  */
+/* the send-done → first-byte latency in *latency_us. STREAM_DATA that   */
+/* turns up is passed to the Pi and the screen, and the wait goes on.   */
 /* ------------------------------------------------------------------ */
+#define RX_TIMEOUT      (-1)
+#define RX_BAD_FRAME    (-2)    /* CRC mismatch, or too long for the buffer */
+
+typedef enum { S_SOF, S_ADDR, S_CMD, S_LEN, S_PAYLOAD, S_CRC } rx_state_t;
+
+typedef struct {
+    rx_state_t state;
+    uint8_t    addr, cmd, plen, idx;
+    uint8_t    crc;         /* running CRC over addr, cmd, len, payload */
+} rx_fsm_t;
+
+/* Bytes the FSM must see before it can get further — the task sleeps until
+ * the ring holds this many, so a frame costs one wake for the header and
+ * one when the CRC byte lands */
+static uint16_t rx_fsm_need(const rx_fsm_t *f)
+{
+    switch (f->state) {
+        case S_ADDR:    return 3;
+        case S_CMD:     return 2;
+        case S_PAYLOAD: return (uint16_t)(f->plen - f->idx + 1);
+        default:        return 1;
+    }
+}
+
+static void forward_to_pi(uint8_t req_id, uint8_t result, uint8_t addr,
+                          uint8_t cmd, const uint8_t *payload, uint8_t plen);
+static periph_t *periph_find(uint8_t addr);
+
+/* Registry entry a transaction outcome is charged to: the device the last
+ * frame was addressed to, or — after a broadcast, i.e. in the stream
+ * slots — whoever the frame claims to be from. NULL if unknown. */
+static periph_t *stats_periph(uint8_t from)
+{
+    uint8_t a = s_tx_addr < RS485_ADDR_GROUP_FIRST ? s_tx_addr : from;
+    return (a && a < RS485_ADDR_GROUP_FIRST) ? periph_find(a) : NULL;
+}
+
+static void stats_answered(periph_t *p, uint32_t us)
+{
+    uint8_t  bin  = 0;
+    uint32_t edge = PERIPH_STATS_LAT_BASE_US;
+    while (us >= edge && bin < PERIPH_STATS_LAT_BINS - 1) {
+        edge <<= 1;
+        bin++;
+    }
+    p->answered++;
+    p->lat_hist[bin]++;
+    if (us > p->lat_max_us) p->lat_max_us = us;
+}
+
 static int rs485_recv(uint8_t *addr_out, uint8_t *cmd_out,
-                      uint8_t *buf, uint8_t buf_size)
+                      uint8_t *buf, uint8_t buf_size,
+                      uint32_t first_us, uint32_t *latency_us)
 {
-    typedef enum { S_SOF, S_ADDR, S_CMD, S_LEN, S_PAYLOAD, S_CRC } state_t;
-    state_t  state = S_SOF;
-    uint8_t  addr = 0, cmd = 0, plen = 0, idx = 0;
-    TickType_t t0 = xTaskGetTickCount();
+    rx_fsm_t f = { .state = S_SOF };
+    uint32_t deadline = s_tx_done_us + first_us;
+    uint32_t give_up  = deadline;
 
-    while ((xTaskGetTickCount() - t0) < pdMS_TO_TICKS(RS485_TIMEOUT_MS)) {
-        if (!uart_is_readable(RS485_UART_INST)) {
-            taskYIELD();
-            continue;
-        }
-        uint8_t b = (uint8_t)uart_getc(RS485_UART_INST);
-
-        switch (state) {
-            case S_SOF:
-                if (b == RS485_SOF) state = S_ADDR;
-                break;
-            case S_ADDR:
-                addr  = b;
-                state = S_CMD;
-                break;
-            case S_CMD:
-                cmd   = b;
-                state = S_LEN;
-                break;
-            case S_LEN:
-                plen  = b;
-                if (plen > buf_size) return -1;   /* won't fit */
-                idx   = 0;
-                state = (plen == 0) ? S_CRC : S_PAYLOAD;
-                break;
-            case S_PAYLOAD:
-                buf[idx++] = b;
-                if (idx >= plen) state = S_CRC;
-                break;
-            case S_CRC: {
-                /* CRC over addr, cmd, len, payload */
-                uint8_t tmp[3 + 255];
-                tmp[0] = addr; tmp[1] = cmd; tmp[2] = plen;
-                if (plen) memcpy(&tmp[3], buf, plen);
-                if (b == crc8(tmp, 3 + plen)) {
-                    *addr_out = addr;
-                    *cmd_out  = cmd;
-                    return (int)plen;
+    for (;;) {
+        uint8_t b;
+        while (rx_ring_pop(&b)) {
+            switch (f.state) {
+                case S_SOF:
+                    if (b == RS485_SOF) {
+                        f.state = S_ADDR;
+                        f.crc   = CRC8_INIT;
+                    }
+                    break;
+                case S_ADDR:
+                    f.addr  = b;
+                    f.crc   = crc8_update(f.crc, b);
+                    f.state = S_CMD;
+                    break;
+                case S_CMD:
+                    f.cmd   = b;
+                    f.crc   = crc8_update(f.crc, b);
+                    f.state = S_LEN;
+                    break;
+                case S_LEN:
+                    f.plen  = b;
+                    f.crc   = crc8_update(f.crc, b);
+                    if (f.plen > buf_size) return RX_BAD_FRAME;
+                    f.idx   = 0;
+                    f.state = (f.plen == 0) ? S_CRC : S_PAYLOAD;
+                    /* The slave is answering: allow the rest of the frame
+                     * plus the RX-timeout IRQ and a tick of slack */
+                    deadline = time_us_32() +
+                               (uint32_t)(f.plen + 1 + 4) * s_byte_us + 1000u;
+                    break;
+                case S_PAYLOAD:
+                    buf[f.idx++] = b;
+                    f.crc = crc8_update(f.crc, b);
+                    if (f.idx >= f.plen) f.state = S_CRC;
+                    break;
+                case S_CRC: {
+                    uint32_t  now = time_us_32();
+                    periph_t *p   = stats_periph(f.addr);
+                    s_bus_free_us = now + RS485_GAP_US;
+                    if (b != f.crc) {
+                        if (p) p->crc_errors++;
+                        return RX_BAD_FRAME;
+                    }
+                    if (f.cmd == RS485_CMD_STREAM_DATA) {
+                        forward_to_pi(0, PERIPH_RESULT_OK, f.addr, f.cmd, buf, f.plen);
+                        screen_periph_update_data(f.addr, f.cmd, buf, f.plen);
+                        s_stats.stream_frames++;
+                        f.state  = S_SOF;
+                        deadline = give_up;
+                        break;
+                    }
+                    if (p && s_tx_addr < RS485_ADDR_GROUP_FIRST) {
+                        stats_answered(p, now - s_tx_done_us);
+                    }
+                    *addr_out = f.addr;
+                    *cmd_out  = f.cmd;
+                    if (latency_us) *latency_us = s_rx_first_us - s_tx_done_us;
+                    return (int)f.plen;
                 }
-                return -1;  /* CRC mismatch */
             }
         }
+
+        int32_t left = (int32_t)(deadline - time_us_32());
+        if (left <= 0) {
+            /* After a broadcast this is just the end of the stream slots */
+            periph_t *p = stats_periph(0);
+            if (p) p->timeouts++;
+            return RX_TIMEOUT;
+        }
+
+        /* Arm the IRQ, then re-check: bytes may have landed in between */
+        s_rx_need = rx_fsm_need(&f);
+        if (rx_ring_count() >= s_rx_need) {
+            s_rx_need = 0;
+            continue;
+        }
+        TickType_t t = pdMS_TO_TICKS(((uint32_t)left + 999u) / 1000u);
+        ulTaskNotifyTake(pdTRUE, t ? t : 1);
+        s_rx_need = 0;
     }
-    return -1;  /* timeout */
 }
 
 /* ------------------------------------------------------------------ */
@@ -129,50 +336,111 @@ static int rs485_recv(uint8_t *addr_out, uint8_t *cmd_out,
 static void notify_state(uint8_t addr, bool online)
 {
     periph_state_t pkt = { .addr = addr, .online = online ? 1u : 0u };
-    tx_item_t item;
-    int len = proto_serialize(item.buf, sizeof(item.buf),
-                              PROTO_TYPE_PERIPH_STATE,
-                              (const uint8_t *)&pkt, sizeof(pkt));
-    if (len > 0) {
-        item.len = (uint8_t)len;
-        xQueueSend(g_tx_queue, &item, 0);
-    }
+    proto_send(PROTO_TYPE_PERIPH_STATE, &pkt, sizeof(pkt));
 }
 
 /* ------------------------------------------------------------------ */
 /* Forward RS-485 response to Pi over CDC                                */
 /* ------------------------------------------------------------------ */
-static void forward_to_pi(uint8_t addr, uint8_t cmd,
-                           const uint8_t *payload, uint8_t plen)
+static void forward_to_pi(uint8_t req_id, uint8_t result, uint8_t addr,
+                          uint8_t cmd, const uint8_t *payload, uint8_t plen)
 {
-    /* Payload on wire: [addr, cmd, data...] */
-    uint8_t cdc_payload[2 + 255];
-    cdc_payload[0] = addr;
-    cdc_payload[1] = cmd;
-    if (plen) memcpy(&cdc_payload[2], payload, plen);
+    /* periph_data_t, built in place in the TX ring */
+    uint8_t *p = proto_tx_begin(PROTO_TYPE_PERIPH_DATA,
+                                (uint16_t)(sizeof(periph_data_t) + plen));
+    if (!p) return;
+    periph_data_t *d = (periph_data_t *)p;
+    d->req_id = req_id;
+    d->result = result;
+    d->addr   = addr;
+    d->cmd    = cmd;
+    d->len    = plen;
+    if (plen) memcpy(d->payload, payload, plen);
+    proto_tx_end(p);
+}
+
+/* ------------------------------------------------------------------ */
+/* Per-device timeouts and health                                        */
+/* ------------------------------------------------------------------ */
+
+/* Response-start timeout: smoothed latency + 4 deviations (as TCP's RTO),
+ * doubled for every consecutive miss so a slow reply is not mistaken for
+ * a dead device, clamped to [RS485_TIMEOUT_MIN_MS, RS485_TIMEOUT_MS] */
+static uint32_t periph_timeout_us(const periph_t *p)
+{
+    uint32_t t = p->srtt_us ? p->srtt_us + 4u * p->rttvar_us + 1000u
+                            : RS485_PROBE_TIMEOUT_MS * 1000u;
+    t <<= p->misses;
+    if (t < RS485_TIMEOUT_MIN_MS * 1000u) t = RS485_TIMEOUT_MIN_MS * 1000u;
+    if (t > RS485_TIMEOUT_MS * 1000u)     t = RS485_TIMEOUT_MS * 1000u;
+    return t;
+}
 
-    tx_item_t item;
-    int len = proto_serialize(item.buf, sizeof(item.buf),
-                              PROTO_TYPE_PERIPH_DATA,
-                              cdc_payload, 2 + plen);
-    if (len > 0) {
-        item.len = (uint8_t)len;
-        xQueueSend(g_tx_queue, &item, 0);
+static void periph_rtt_sample(periph_t *p, uint32_t us)
+{
+    if (!p->srtt_us) {
+        p->srtt_us   = us ? us : 1;
+        p->rttvar_us = us / 2;
+        return;
+    }
+    int32_t err = (int32_t)(us - p->srtt_us);
+    p->srtt_us   = (uint32_t)((int32_t)p->srtt_us + err / 8);
+    if (err < 0) err = -err;
+    p->rttvar_us = (uint32_t)((int32_t)p->rttvar_us + (err - (int32_t)p->rttvar_us) / 4);
+    if (!p->srtt_us) p->srtt_us = 1;
+}
+
+static void periph_answered(periph_t *p, uint32_t latency_us, TickType_t now)
+{
+    periph_rtt_sample(p, latency_us);
+    p->misses     = 0;
+    p->backoff_ms = RS485_PING_INTERVAL_MS;
+    p->next_ping  = now + pdMS_TO_TICKS(RS485_PING_INTERVAL_MS);
+    if (!p->online) {
+        p->online = true;
+        notify_state(p->addr, true);
     }
 }
 
+static void periph_missed(periph_t *p, TickType_t now)
+{
+    s_stats.hk_timeouts++;
+    if (p->online) {
+        /* Retry soon with a longer timeout; offline after RS485_MAX_RETRIES */
+        if (++p->misses < RS485_MAX_RETRIES) {
+            p->next_ping = now + pdMS_TO_TICKS(RS485_RETRY_MS);
+            return;
+        }
+        p->online     = false;
+        p->misses     = 0;
+        p->backoff_ms = RS485_PING_INTERVAL_MS;
+        p->stream_every = 0;    /* a reset slave comes back not streaming */
+        notify_state(p->addr, false);
+    }
+    p->next_ping = now + pdMS_TO_TICKS(p->backoff_ms);
+
+    /* Absent device: each failed probe doubles the interval to the next */
+    p->backoff_ms *= 2;
+    if (p->backoff_ms > RS485_BACKOFF_MAX_MS) p->backoff_ms = RS485_BACKOFF_MAX_MS;
+}
+
 /* ------------------------------------------------------------------ */
 /* Public API                                                             */
 /* ------------------------------------------------------------------ */
 
 void rs485_init(void)
 {
-    s_cmd_queue = xQueueCreate(RS485_CMD_QUEUE_DEPTH, sizeof(rs485_cmd_item_t));
+    tx_ring_init(&s_cmd_ring, s_cmd_pool, sizeof(s_cmd_pool));
 
     uart_init(RS485_UART_INST, RS485_BAUD);
     gpio_set_function(PIN_RS485_TX, GPIO_FUNC_UART);
     gpio_set_function(PIN_RS485_RX, GPIO_FUNC_UART);
 
+    /* RX is interrupt-driven into s_rx_ring; TX stays polled */
+    irq_set_exclusive_handler(RS485_UART_IRQ, rs485_uart_isr);
+    irq_set_enabled(RS485_UART_IRQ, true);
+    uart_set_irq_enables(RS485_UART_INST, true, false);
+
     gpio_init(PIN_RS485_DE);
     gpio_set_dir(PIN_RS485_DE, GPIO_OUT);
     gpio_put(PIN_RS485_DE, 0);   /* receive mode by default */
@@ -184,11 +452,25 @@ void rs485_init(void)
 
 void rs485_forward_cmd(const uint8_t *payload, uint16_t len)
 {
-    if (!s_cmd_queue || len > RS485_CMD_BUF_SIZE) return;
-    rs485_cmd_item_t item;
-    memcpy(item.buf, payload, len);
-    item.len = (uint8_t)len;
-    xQueueSend(s_cmd_queue, &item, 0);
+    const periph_cmd_t *c = (const periph_cmd_t *)payload;
+    if (len < sizeof(periph_cmd_t)) return;
+
+    uint16_t n   = (uint16_t)(sizeof(periph_cmd_t) + c->len);
+    uint8_t *rec = NULL;
+    if (len >= n) {
+        rec = tx_ring_reserve(&s_cmd_ring, (uint16_t)(sizeof(rs485_cmd_item_t) + c->len), 0);
+    }
+    if (!rec) {
+        /* Truncated, or the pool is full: never reaches the bus */
+        forward_to_pi(c->req_id, PERIPH_RESULT_NACK, c->addr, c->cmd, NULL, 0);
+        return;
+    }
+
+    rs485_cmd_item_t *item = (rs485_cmd_item_t *)rec;
+    item->queued_us = time_us_32();
+    memcpy(&item->req_id, payload, n);
+    tx_ring_commit(&s_cmd_ring);
+    if (s_bus_task) xTaskNotifyGive(s_bus_task);
 }
 
 uint8_t rs485_get_peripherals(uint8_t *addrs_out, bool *online_out,
@@ -196,77 +478,674 @@ uint8_t rs485_get_peripherals(uint8_t *addrs_out, bool *online_out,
 {
     uint8_t n = 0;
     for (int i = 0; i < RS485_MAX_PERIPHERALS && n < max_entries; i++) {
-        if (!s_known_addrs[i]) continue;
-        addrs_out[n]  = s_known_addrs[i];
-        online_out[n] = s_online[i];
+        if (!s_periph[i].addr) continue;
+        addrs_out[n]  = s_periph[i].addr;
+        online_out[n] = s_periph[i].online;
         n++;
     }
     return n;
 }
 
+void rs485_get_sched_stats(rs485_sched_stats_t *out)
+{
+    taskENTER_CRITICAL();
+    *out = s_stats;
+    out->baud = s_baud;
+    taskEXIT_CRITICAL();
+}
+
+void rs485_send_periph_stats(void)
+{
+    static int s_next;          /* registry slot the next frame starts at */
+    periph_t   snap[PERIPH_STATS_MAX_ENTRIES];
+    uint8_t    n = 0;
+    int        k;
+
+    for (k = 0; k < RS485_MAX_PERIPHERALS && n < PERIPH_STATS_MAX_ENTRIES; k++) {
+        const periph_t *p = &s_periph[(s_next + k) % RS485_MAX_PERIPHERALS];
+        taskENTER_CRITICAL();
+        if (p->addr) snap[n++] = *p;
+        taskEXIT_CRITICAL();
+    }
+    /* Everything fitted: start from the top again */
+    s_next = (k < RS485_MAX_PERIPHERALS) ? (s_next + k) % RS485_MAX_PERIPHERALS : 0;
+    if (!n) return;
+
+    uint8_t *pl = proto_tx_begin(PROTO_TYPE_PERIPH_STATS,
+                                 (uint16_t)(sizeof(periph_stats_hdr_t) +
+                                            n * sizeof(periph_stats_entry_t)));
+    if (!pl) return;
+
+    periph_stats_hdr_t *h = (periph_stats_hdr_t *)pl;
+    h->ts_ms       = (uint32_t)(xTaskGetTickCount() * portTICK_PERIOD_MS);
+    h->baud        = s_baud;
+    h->lat_base_us = PERIPH_STATS_LAT_BASE_US;
+    h->lat_bins    = PERIPH_STATS_LAT_BINS;
+    h->n_periph    = n;
+
+    periph_stats_entry_t *e = (periph_stats_entry_t *)(pl + sizeof(periph_stats_hdr_t));
+    for (uint8_t i = 0; i < n; i++) {
+        e[i].addr       = snap[i].addr;
+        e[i].online     = snap[i].online ? 1u : 0u;
+        e[i].answered   = snap[i].answered;
+        e[i].timeouts   = snap[i].timeouts;
+        e[i].crc_errors = snap[i].crc_errors;
+        e[i].timeout_us = periph_timeout_us(&snap[i]);
+        e[i].lat_max_us = snap[i].lat_max_us;
+        memcpy(e[i].lat_hist, snap[i].lat_hist, sizeof(e[i].lat_hist));
+    }
+
+    proto_tx_end(pl);
+}
+
+/* ------------------------------------------------------------------ */
+/* RS-485 task — one transaction per pass, Pi commands first             */
+/* ------------------------------------------------------------------ */
+static uint8_t s_resp_buf[255];
+
+static TickType_t s_sync_next;      /* next stream cycle */
+static uint32_t   s_sync_count;     /* stream cycles since boot */
+
+/* Follow the Pi's STREAM_ON [interval_ms u16] / STREAM_OFF, so streaming
+ * devices get slots at their interval, in whole RS485_TDMA_CYCLE_MS. An
+ * interval of 0 is a STREAM_OFF. Group membership is not known here: a
+ * group STREAM_ON gives every device slots (non-members leave theirs
+ * empty), and a group STREAM_OFF takes none away. */
+static void track_streaming(const rs485_cmd_item_t *cmd)
+{
+    uint8_t  addr  = cmd->addr;
+    uint16_t every = 0;
+
+    if (cmd->cmd == RS485_CMD_STREAM_ON) {
+        if (cmd->len < 2) return;
+        uint16_t interval = (uint16_t)(cmd->payload[0] | (cmd->payload[1] << 8));
+        every = interval / RS485_TDMA_CYCLE_MS;
+        if (interval && !every) every = 1;
+    } else if (cmd->cmd != RS485_CMD_STREAM_OFF) {
+        return;
+    }
+    if (!every && addr >= RS485_ADDR_GROUP_FIRST && addr != RS485_ADDR_BROADCAST) {
+        return;
+    }
+
+    for (int i = 0; i < RS485_MAX_PERIPHERALS; i++) {
+        periph_t *p = &s_periph[i];
+        if (p->addr && (p->addr == addr || addr >= RS485_ADDR_GROUP_FIRST)) {
+            p->stream_every = every;
+        }
+    }
+}
+
+/* Put one Pi command on the bus and answer it with a PERIPH_DATA carrying
+ * its req_id: the reply, or why there is none */
+static void run_cmd(const rs485_cmd_item_t *cmd)
+{
+    track_streaming(cmd);
+
+    uint32_t start = rs485_send(cmd->addr, cmd->cmd, cmd->payload, cmd->len);
+    uint32_t wait  = start - cmd->queued_us;
+
+    taskENTER_CRITICAL();
+    s_stats.cmds++;
+    s_stats.cmd_wait_sum_us += wait;
+    if (wait > s_stats.cmd_wait_max_us) s_stats.cmd_wait_max_us = wait;
+    taskEXIT_CRITICAL();
+
+    /* Broadcast and group frames are never answered */
+    if (cmd->addr >= RS485_ADDR_GROUP_FIRST) {
+        forward_to_pi(cmd->req_id, PERIPH_RESULT_SENT, cmd->addr, cmd->cmd, NULL, 0);
+        return;
+    }
+
+    /* Nor is BOOT_DATA: the window goes out back to back, with only the
+     * short gap the slave's receiver needs, and BOOT_STATUS collects */
+    if (cmd->cmd == RS485_CMD_BOOT_DATA) {
+        s_bus_free_us = s_tx_done_us + RS485_BOOT_GAP_US;
+        forward_to_pi(cmd->req_id, PERIPH_RESULT_SENT, cmd->addr, cmd->cmd, NULL, 0);
+        return;
+    }
+
+    /* Full timeout: the Pi may ask for anything, and unknown CMDs are not
+     * answered at all, so these don't feed the latency estimate. A device
+     * known to be offline only gets its probe timeout. The other BOOT_*
+     * commands write or check flash before they answer. */
+    uint32_t timeout = RS485_TIMEOUT_MS * 1000u;
+    if (cmd->cmd >= RS485_CMD_BOOT_BEGIN && cmd->cmd <= RS485_CMD_BOOT_END) {
+        timeout = RS485_BOOT_TIMEOUT_MS * 1000u;
+    } else {
+        for (int i = 0; i < RS485_MAX_PERIPHERALS; i++) {
+            if (s_periph[i].addr == cmd->addr && !s_periph[i].online) {
+                timeout = periph_timeout_us(&s_periph[i]);
+            }
+        }
+    }
+    uint8_t resp_addr, resp_cmd;
+    int r = rs485_recv(&resp_addr, &resp_cmd, s_resp_buf, sizeof(s_resp_buf),
+                       timeout, NULL);
+    if (r >= 0) {
+        forward_to_pi(cmd->req_id, PERIPH_RESULT_OK, resp_addr, resp_cmd, s_resp_buf, (uint8_t)r);
+        screen_periph_update_data(resp_addr, resp_cmd, s_resp_buf, (uint8_t)r);
+    } else {
+        forward_to_pi(cmd->req_id,
+                      r == RX_BAD_FRAME ? PERIPH_RESULT_BAD_REPLY : PERIPH_RESULT_TIMEOUT,
+                      cmd->addr, cmd->cmd, NULL, 0);
+    }
+}
+
+/* rs485_task is the pool's only consumer, so it may peek at will */
+static bool cmd_pending(void)
+{
+    const uint8_t *rec;
+    return tx_ring_peek(&s_cmd_ring, &rec) != 0;
+}
+
+/* Run the oldest pooled command, if any; its record is freed afterwards */
+static bool cmd_run_next(void)
+{
+    const uint8_t *rec;
+    if (!tx_ring_peek(&s_cmd_ring, &rec)) return false;
+    const rs485_cmd_item_t *cmd = (const rs485_cmd_item_t *)rec;
+    run_cmd(cmd);
+    tx_ring_consume(&s_cmd_ring, (uint16_t)(sizeof(rs485_cmd_item_t) + cmd->len));
+    return true;
+}
+
+/* ------------------------------------------------------------------ */
+/* Baud negotiation                                                       */
+/* ------------------------------------------------------------------ */
+static TickType_t s_baud_next_try;
+
+static void put_le32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t get_le32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/* Broadcast the change, give the slaves RS485_BAUD_SWITCH_MS to
+ * reprogram their UARTs, then follow */
+static void baud_switch(uint32_t baud)
+{
+    uint8_t pl[4];
+    put_le32(pl, baud);
+    rs485_send(RS485_ADDR_BROADCAST, RS485_CMD_BAUD, pl, sizeof(pl));
+    vTaskDelay(pdMS_TO_TICKS(RS485_BAUD_SWITCH_MS));
+    bus_set_baud(baud);
+}
+
+/* Whole bus back to RS485_BAUD; negotiate again after RS485_BAUD_SETTLE_MS */
+static void baud_fall_back(void)
+{
+    baud_switch(RS485_BAUD);
+    s_stats.baud_fallbacks++;
+    s_baud_next_try = xTaskGetTickCount() + pdMS_TO_TICKS(RS485_BAUD_SETTLE_MS);
+}
+
+/* Ask every online device for its fastest rate, move the bus to the
+ * slowest of those (capped at RS485_BAUD_MAX), and have each one confirm
+ * by answering a PING at the new rate. A device that doesn't confirm puts
+ * the whole bus back on RS485_BAUD. */
+static void baud_negotiate(void)
+{
+    uint8_t  resp_addr, resp_cmd;
+    uint32_t rate = RS485_BAUD_MAX;
+    int      n    = 0;
+
+    s_baud_next_try = xTaskGetTickCount() + pdMS_TO_TICKS(RS485_BAUD_RETRY_MS);
+
+    for (int i = 0; i < RS485_MAX_PERIPHERALS; i++) {
+        periph_t *p = &s_periph[i];
+        if (!p->addr || !p->online) continue;
+        rs485_send(p->addr, RS485_CMD_BAUD, NULL, 0);
+        int r = rs485_recv(&resp_addr, &resp_cmd, s_resp_buf, sizeof(s_resp_buf),
+                           periph_timeout_us(p), NULL);
+        /* No answer: firmware without BAUD, or a glitch — stay put */
+        if (r < 4 || resp_addr != p->addr || resp_cmd != RS485_CMD_BAUD) return;
+        uint32_t max = get_le32(s_resp_buf);
+        if (max < rate) rate = max;
+        n++;
+    }
+    if (!n || rate <= RS485_BAUD) return;
+
+    baud_switch(rate);
+
+    for (int i = 0; i < RS485_MAX_PERIPHERALS; i++) {
+        periph_t *p = &s_periph[i];
+        if (!p->addr || !p->online) continue;
+        bool ok = false;
+        for (int tries = 0; tries < 2 && !ok; tries++) {
+            rs485_send(p->addr, RS485_CMD_PING, NULL, 0);
+            int r = rs485_recv(&resp_addr, &resp_cmd, s_resp_buf, sizeof(s_resp_buf),
+                               RS485_PROBE_TIMEOUT_MS * 1000u, NULL);
+            ok = (r >= 0 && resp_addr == p->addr && resp_cmd == RS485_CMD_PONG);
+        }
+        if (!ok) {
+            baud_fall_back();
+            s_baud_next_try = xTaskGetTickCount() + pdMS_TO_TICKS(RS485_BAUD_RETRY_MS);
+            return;
+        }
+    }
+}
+
+static bool any_online(void)
+{
+    for (int i = 0; i < RS485_MAX_PERIPHERALS; i++) {
+        if (s_periph[i].addr && s_periph[i].online) return true;
+    }
+    return false;
+}
+
 /* ------------------------------------------------------------------ */
-/* RS-485 task                                                            */
+/* Stream slots                                                           */
+/* ------------------------------------------------------------------ */
+
+/* Ticks until the next cycle: 0 = now, portMAX_DELAY = nothing streams */
+static TickType_t tdma_until(TickType_t now)
+{
+    for (int i = 0; i < RS485_MAX_PERIPHERALS; i++) {
+        const periph_t *p = &s_periph[i];
+        if (!(p->addr && p->online && p->stream_every)) continue;
+        int32_t d = (int32_t)(s_sync_next - now);
+        return d > 0 ? (TickType_t)d : 0;
+    }
+    return portMAX_DELAY;
+}
+
+/* Cycles keep to the clock: a late one does not push back the rest */
+static void tdma_next(TickType_t now, uint32_t cycle_ms)
+{
+    s_sync_next += pdMS_TO_TICKS(cycle_ms);
+    if ((int32_t)(s_sync_next - now) <= 0) s_sync_next = now + pdMS_TO_TICKS(cycle_ms);
+}
+
+/* One stream cycle. The devices whose interval is up — on a common grid,
+ * so those with the same interval share cycles — are listed in a
+ * broadcast SYNC
+ *   [timestamp_ms u32][slot_ms u8][n u8][addr × n]
+ * and each sends one STREAM_DATA in its own slot; slot i opens RS485_GAP_US
+ * after the SYNC plus i·slot_ms. The master listens through the slots, and
+ * rs485_recv() passes the frames on to the Pi. No device due, no SYNC. */
+static void tdma_cycle(TickType_t now)
+{
+    uint8_t pl[6 + RS485_TDMA_MAX_SLOTS];
+    uint8_t n = 0;
+
+    s_sync_count++;
+    for (int i = 0; i < RS485_MAX_PERIPHERALS && n < RS485_TDMA_MAX_SLOTS; i++) {
+        const periph_t *p = &s_periph[i];
+        if (p->addr && p->online && p->stream_every &&
+            s_sync_count % p->stream_every == 0) {
+            pl[6 + n++] = p->addr;
+        }
+    }
+    if (!n) {
+        tdma_next(now, RS485_TDMA_CYCLE_MS);
+        return;
+    }
+
+    /* A full-length frame, plus 1 ms for a slave's millisecond clock and
+     * poll loop at the slot start and 1 ms of gap before the next slot */
+    uint32_t slot_ms   = (RS485_TDMA_SLOT_BYTES * s_byte_us + 999u) / 1000u + 2u;
+    uint32_t window_us = RS485_GAP_US + n * slot_ms * 1000u;
+
+    /* Streams get at most half the bus: a long slot list stretches the cycle */
+    uint32_t cycle_ms = RS485_TDMA_CYCLE_MS;
+    if (cycle_ms * 1000u < 2u * window_us) cycle_ms = (2u * window_us + 999u) / 1000u;
+
+    put_le32(pl, (uint32_t)(now * portTICK_PERIOD_MS));
+    pl[4] = (uint8_t)slot_ms;
+    pl[5] = n;
+    rs485_send(RS485_ADDR_BROADCAST, RS485_CMD_SYNC, pl, (uint8_t)(6 + n));
+    tdma_next(now, cycle_ms);
+
+    uint32_t end = s_tx_done_us + window_us;
+    uint8_t  resp_addr, resp_cmd;
+    while ((int32_t)(end - time_us_32()) > 0) {
+        rs485_recv(&resp_addr, &resp_cmd, s_resp_buf, sizeof(s_resp_buf),
+                   end - s_tx_done_us, NULL);
+    }
+}
+
+/* PING addr. On a bus running above RS485_BAUD, also try RS485_BAUD: the
+ * device may have been (re)powered since the negotiation — if it answers
+ * there, bring the whole bus down so it can be talked to */
+static bool probe_addr(uint8_t addr, uint32_t timeout_us, uint32_t *latency)
+{
+    uint8_t resp_addr, resp_cmd;
+
+    rs485_send(addr, RS485_CMD_PING, NULL, 0);
+    int r = rs485_recv(&resp_addr, &resp_cmd, s_resp_buf, sizeof(s_resp_buf),
+                       timeout_us, latency);
+    if (r >= 0 && resp_addr == addr) return true;
+    if (s_baud == RS485_BAUD) return false;
+
+    uint32_t fast = s_baud;
+    bus_set_baud(RS485_BAUD);
+    rs485_send(addr, RS485_CMD_PING, NULL, 0);
+    r = rs485_recv(&resp_addr, &resp_cmd, s_resp_buf, sizeof(s_resp_buf),
+                   timeout_us, latency);
+    bus_set_baud(fast);
+    if (r < 0 || resp_addr != addr) return false;
+    baud_fall_back();
+    return true;
+}
+
+/* PING or GET_STATUS one device and update its health */
+static void poll_periph(periph_t *p, uint8_t cmd)
+{
+    uint8_t  resp_addr, resp_cmd;
+    uint32_t latency;
+    int      r = -1;
+    bool     ok;
+
+    if (p->online) {
+        rs485_send(p->addr, cmd, NULL, 0);
+        r  = rs485_recv(&resp_addr, &resp_cmd, s_resp_buf, sizeof(s_resp_buf),
+                        periph_timeout_us(p), &latency);
+        ok = (r >= 0 && resp_addr == p->addr);
+    } else {
+        ok = probe_addr(p->addr, periph_timeout_us(p), &latency);
+    }
+    TickType_t now = xTaskGetTickCount();
+
+    if (!ok) {
+        periph_missed(p, now);
+        return;
+    }
+    periph_answered(p, latency, now);
+    if (r >= 0 && cmd == RS485_CMD_GET_STATUS) {
+        forward_to_pi(0, PERIPH_RESULT_OK, resp_addr, resp_cmd, s_resp_buf, (uint8_t)r);
+        screen_periph_update_data(resp_addr, resp_cmd, s_resp_buf, (uint8_t)r);
+    }
+}
+
+/* Device whose PING is most overdue, or NULL */
+static periph_t *next_ping_due(TickType_t now, TickType_t *until)
+{
+    periph_t  *due  = NULL;
+    TickType_t wait = portMAX_DELAY;
+
+    for (int i = 0; i < RS485_MAX_PERIPHERALS; i++) {
+        periph_t *p = &s_periph[i];
+        if (!p->addr) continue;
+        int32_t d = (int32_t)(p->next_ping - now);
+        if (d <= 0) {
+            if (!due || (int32_t)(p->next_ping - due->next_ping) < 0) due = p;
+        } else if ((TickType_t)d < wait) {
+            wait = (TickType_t)d;
+        }
+    }
+    *until = wait;
+    return due;
+}
+
+/* ------------------------------------------------------------------ */
+/* Discovered-address cache — last flash sector                           */
+/* ------------------------------------------------------------------ */
+#define RS485_CACHE_OFFSET  (PICO_FLASH_SIZE_BYTES - FLASH_SECTOR_SIZE)
+#define RS485_CACHE_MAGIC   0x35383452u     /* "R485" */
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint8_t  count;
+    uint8_t  addrs[RS485_MAX_PERIPHERALS];  /* ascending */
+    uint8_t  crc;                           /* CRC-8 over count + addrs */
+} addr_cache_t;
+
+static const addr_cache_t *cache_flash(void)
+{
+    return (const addr_cache_t *)(XIP_BASE + RS485_CACHE_OFFSET);
+}
+
+static uint8_t cache_crc(const addr_cache_t *c)
+{
+    return crc8(&c->count, 1 + sizeof(c->addrs));
+}
+
+/* Registry → cache image, addresses in ascending order */
+static void cache_build(addr_cache_t *c)
+{
+    memset(c, 0, sizeof(*c));
+    c->magic = RS485_CACHE_MAGIC;
+    for (unsigned a = RS485_ADDR_MIN; a <= RS485_ADDR_MAX; a++) {
+        for (int i = 0; i < RS485_MAX_PERIPHERALS; i++) {
+            if (s_periph[i].addr == a) c->addrs[c->count++] = (uint8_t)a;
+        }
+    }
+    c->crc = cache_crc(c);
+}
+
+static bool cache_load(void)
+{
+    const addr_cache_t *c = cache_flash();
+    if (c->magic != RS485_CACHE_MAGIC || c->count > RS485_MAX_PERIPHERALS ||
+        c->crc != cache_crc(c)) {
+        return false;
+    }
+    for (int i = 0; i < c->count; i++) s_periph[i].addr = c->addrs[i];
+    return true;
+}
+
+static void cache_write(void *param)
+{
+    static uint8_t page[FLASH_PAGE_SIZE];
+    memset(page, 0xFF, sizeof(page));
+    memcpy(page, param, sizeof(addr_cache_t));
+    flash_range_erase(RS485_CACHE_OFFSET, FLASH_SECTOR_SIZE);
+    flash_range_program(RS485_CACHE_OFFSET, page, sizeof(page));
+}
+
+/* Only when the set changed — a sector erase stalls both cores for tens
+ * of ms. A failure just means a rescan at the next boot. */
+static void cache_save(void)
+{
+    addr_cache_t c;
+    cache_build(&c);
+    if (memcmp(&c, cache_flash(), sizeof(c)) == 0) return;
+    flash_safe_execute(cache_write, &c, 100);
+}
+
+/* ------------------------------------------------------------------ */
+/* Discovery                                                              */
+/* ------------------------------------------------------------------ */
+static volatile bool s_scan_request = false;
+static bool          s_scan_running = false;
+static uint16_t      s_scan_addr;               /* next address of a full scan */
+static uint32_t      s_scan_seen[8];            /* addresses that answered it  */
+static uint8_t       s_trickle_addr = RS485_ADDR_MIN;
+static TickType_t    s_trickle_next;
+
+static periph_t *periph_find(uint8_t addr)
+{
+    for (int i = 0; i < RS485_MAX_PERIPHERALS; i++) {
+        if (s_periph[i].addr == addr) return &s_periph[i];
+    }
+    return NULL;
+}
+
+static periph_t *periph_add(uint8_t addr, TickType_t now)
+{
+    periph_t *p = periph_find(0);
+    if (!p) return NULL;    /* registry full */
+    memset(p, 0, sizeof(*p));
+    p->addr       = addr;
+    p->backoff_ms = RS485_PING_INTERVAL_MS;
+    p->next_ping  = now;
+    return p;
+}
+
+/* PING one address with the short scan timeout; a new device is added to
+ * the registry (and reported online). True if it answered. */
+static bool scan_probe(uint8_t addr)
+{
+    periph_t *p = periph_find(addr);
+    if (p && p->online) return true;    /* already answering its own PINGs */
+
+    uint32_t latency;
+    if (!probe_addr(addr, RS485_SCAN_TIMEOUT_MS * 1000u, &latency)) return false;
+
+    TickType_t now = xTaskGetTickCount();
+    if (!p) p = periph_add(addr, now);
+    if (p) periph_answered(p, latency, now);
+    return true;
+}
+
+static void scan_finish(void)
+{
+    s_scan_running = false;
+
+    /* Drop devices that didn't answer, then give the Pi the whole list */
+    for (int i = 0; i < RS485_MAX_PERIPHERALS; i++) {
+        periph_t *p = &s_periph[i];
+        if (!p->addr) continue;
+        if (!(s_scan_seen[p->addr >> 5] & (1u << (p->addr & 31)))) {
+            notify_state(p->addr, false);
+            p->addr = 0;
+            continue;
+        }
+        notify_state(p->addr, p->online);
+    }
+    cache_save();
+}
+
+/* Up to RS485_SCAN_BATCH addresses, yielding early to a pooled command */
+static void scan_batch(void)
+{
+    for (int n = 0; n < RS485_SCAN_BATCH && s_scan_addr <= RS485_ADDR_MAX; n++) {
+        if (cmd_pending()) return;
+        if (tdma_until(xTaskGetTickCount()) == 0) return;
+        if (scan_probe((uint8_t)s_scan_addr)) {
+            s_scan_seen[s_scan_addr >> 5] |= 1u << (s_scan_addr & 31);
+        }
+        s_scan_addr++;
+    }
+    if (s_scan_addr > RS485_ADDR_MAX) scan_finish();
+}
+
+/* Idle bus: PING the next address nobody has claimed yet */
+static void scan_trickle(TickType_t now)
+{
+    s_trickle_next = now + pdMS_TO_TICKS(RS485_SCAN_IDLE_MS);
+    for (int n = RS485_ADDR_MIN; n <= RS485_ADDR_MAX; n++) {
+        uint8_t a = s_trickle_addr;
+        s_trickle_addr = (a >= RS485_ADDR_MAX) ? RS485_ADDR_MIN : (uint8_t)(a + 1);
+        if (periph_find(a)) continue;
+        if (scan_probe(a)) cache_save();
+        return;
+    }
+}
+
+void rs485_request_scan(void)
+{
+    s_scan_request = true;
+}
+
+/* ------------------------------------------------------------------ */
+/* RS-485 task main loop                                                  */
 /* ------------------------------------------------------------------ */
 void rs485_task(void *arg)
 {
     (void)arg;
-    TickType_t last_ping = xTaskGetTickCount();
-    uint8_t    resp_buf[255];
-    uint8_t    resp_addr, resp_cmd;
+    s_bus_task = xTaskGetCurrentTaskHandle();
+
+    /* Known devices from the last run; with no cache, scan everything */
+    if (!cache_load()) s_scan_request = true;
+
+    /* First probe of every known device at boot, then their own schedules */
+    TickType_t now = xTaskGetTickCount();
+    for (int i = 0; i < RS485_MAX_PERIPHERALS; i++) {
+        s_periph[i].next_ping  = now;
+        s_periph[i].backoff_ms = RS485_PING_INTERVAL_MS;
+    }
+
+    int        int_pos  = -1;       /* /INT round: next slot, -1 = none running */
+    TickType_t int_next = now;      /* earliest start of the next /INT round   */
+    s_baud_next_try = now + pdMS_TO_TICKS(RS485_BAUD_SETTLE_MS);
+    s_trickle_next  = now + pdMS_TO_TICKS(RS485_BAUD_SETTLE_MS);
 
     for (;;) {
-        /* 1. Forward any commands queued from the Pi */
-        rs485_cmd_item_t cmd;
-        while (xQueueReceive(s_cmd_queue, &cmd, 0) == pdTRUE) {
-            if (cmd.len >= 3) {
-                rs485_send(cmd.buf[0], cmd.buf[1],
-                           &cmd.buf[3], cmd.buf[2]);
-                int r = rs485_recv(&resp_addr, &resp_cmd,
-                                   resp_buf, sizeof(resp_buf));
-                if (r >= 0) {
-                    forward_to_pi(resp_addr, resp_cmd, resp_buf, (uint8_t)r);
-                    screen_periph_update_data(resp_addr, resp_cmd,
-                                              resp_buf, (uint8_t)r);
-                }
-            }
+        /* 0. Stream slots, on their own clock while anything streams */
+        now = xTaskGetTickCount();
+        if (tdma_until(now) == 0) {
+            tdma_cycle(now);
+            continue;
         }
 
-        /* 2. Check /INT line — poll any peripheral asserting an async event */
-        if (!gpio_get(PIN_RS485_INT)) {
-            for (int i = 0; i < RS485_MAX_PERIPHERALS; i++) {
-                if (!s_known_addrs[i] || !s_online[i]) continue;
-                rs485_send(s_known_addrs[i], RS485_CMD_GET_STATUS, NULL, 0);
-                int r = rs485_recv(&resp_addr, &resp_cmd,
-                                   resp_buf, sizeof(resp_buf));
-                if (r >= 0) {
-                    forward_to_pi(resp_addr, resp_cmd, resp_buf, (uint8_t)r);
-                    screen_periph_update_data(resp_addr, resp_cmd,
-                                              resp_buf, (uint8_t)r);
-                }
-                /* inter-frame gap so the slave fully re-arms RX */
-                vTaskDelay(pdMS_TO_TICKS(2));
-            }
+        /* 1. Commands from the Pi — ahead of housekeeping, but a flood of
+         *    them still lets one due housekeeping transaction through every
+         *    RS485_CMD_BURST */
+        for (int n = 0; n < RS485_CMD_BURST; n++) {
+            if (!cmd_run_next()) break;
         }
 
-        /* 3. Periodic PING sweep */
-        if ((xTaskGetTickCount() - last_ping) >=
-                pdMS_TO_TICKS(RS485_PING_INTERVAL_MS)) {
-            last_ping = xTaskGetTickCount();
-            for (int i = 0; i < RS485_MAX_PERIPHERALS; i++) {
-                if (!s_known_addrs[i]) continue;
-                rs485_send(s_known_addrs[i], RS485_CMD_PING, NULL, 0);
-                int r = rs485_recv(&resp_addr, &resp_cmd,
-                                   resp_buf, sizeof(resp_buf));
-                bool now_online = (r >= 0 && resp_cmd == RS485_CMD_PONG);
-                if (now_online != s_online[i]) {
-                    s_online[i] = now_online;
-                    notify_state(s_known_addrs[i], now_online);
-                }
-                /* inter-frame gap so the slave fully re-arms RX */
-                vTaskDelay(pdMS_TO_TICKS(2));
+        now = xTaskGetTickCount();
+
+        /* 2. /INT asserted: GET_STATUS each online device, one per pass */
+        if (int_pos < 0 && !gpio_get(PIN_RS485_INT) && (int32_t)(now - int_next) >= 0) {
+            int_pos = 0;
+        }
+        while (int_pos >= 0 && int_pos < RS485_MAX_PERIPHERALS &&
+               !(s_periph[int_pos].addr && s_periph[int_pos].online)) {
+            int_pos++;
+        }
+        if (int_pos >= RS485_MAX_PERIPHERALS) {
+            int_pos  = -1;
+            int_next = now + pdMS_TO_TICKS(RS485_INT_POLL_MS);
+        }
+        if (int_pos >= 0) {
+            poll_periph(&s_periph[int_pos++], RS485_CMD_GET_STATUS);
+            continue;
+        }
+
+        /* 3. Health PINGs, most overdue first, one per pass */
+        TickType_t until;
+        periph_t  *p = next_ping_due(now, &until);
+        if (p) {
+            poll_periph(p, RS485_CMD_PING);
+            continue;
+        }
+
+        /* 4. Bus still at the boot rate: try for a faster one */
+        if (s_baud == RS485_BAUD && (int32_t)(now - s_baud_next_try) >= 0 && any_online()) {
+            baud_negotiate();
+            continue;
+        }
+
+        /* 5. Discovery, only with no command waiting: a requested scan of
+         *    the whole address space in batches, else now and then one
+         *    address nobody has claimed */
+        if (!cmd_pending()) {
+            if (s_scan_request) {
+                s_scan_request = false;
+                s_scan_running = true;
+                s_scan_addr    = RS485_ADDR_MIN;
+                memset(s_scan_seen, 0, sizeof(s_scan_seen));
+            }
+            if (s_scan_running) {
+                scan_batch();
+                continue;
+            }
+            if (RS485_SCAN_IDLE_MS && (int32_t)(now - s_trickle_next) >= 0) {
+                scan_trickle(now);
+                continue;
             }
         }
 
-        vTaskDelay(pdMS_TO_TICKS(10));
+        /* Idle: sleep until a command arrives, the next PING or SYNC is
+         * due, or it is time to look at /INT again. rs485_forward_cmd()
+         * commits before it notifies, so a command that lands after this
+         * check still ends the wait. */
+        TickType_t idle = pdMS_TO_TICKS(RS485_INT_POLL_MS);
+        if (until < idle) idle = until;
+        until = tdma_until(now);
+        if (until < idle) idle = until;
+        if (!cmd_pending()) ulTaskNotifyTake(pdTRUE, idle);
     }
 }
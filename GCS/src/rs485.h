@@ -12,6 +12,8 @@
 /* RS-485 CMD bytes */
 #define RS485_CMD_PING          0x01
 #define RS485_CMD_PONG          0x02
+#define RS485_CMD_BAUD          0x03
+#define RS485_CMD_GROUP         0x04
 #define RS485_CMD_SET_OUTPUT    0x10
 #define RS485_CMD_GET_STATUS    0x11
 #define RS485_CMD_STATUS        0x12
@@ -21,13 +23,71 @@
 #define RS485_CMD_STREAM_ON     0x30
 #define RS485_CMD_STREAM_OFF    0x31
 #define RS485_CMD_STREAM_DATA   0x32
+#define RS485_CMD_BOOT_BEGIN    0x40
+#define RS485_CMD_BOOT_DATA     0x41
+#define RS485_CMD_BOOT_STATUS   0x42
+#define RS485_CMD_BOOT_END      0x43
 #define RS485_CMD_ERROR         0xF0
 #define RS485_CMD_SYNC          0xFF
 
 #define RS485_ADDR_BROADCAST    0xFF
-#define RS485_TIMEOUT_MS        50
-#define RS485_PING_INTERVAL_MS  1000
-#define RS485_MAX_PERIPHERALS   8
+#define RS485_ADDR_MIN          0x01
+#define RS485_ADDR_MAX          0xEF
+
+/* Multicast group addresses — applied by every member, answered by none.
+ * See "Multicast groups" in docs/RS485_PERIPHERAL_BUS.md */
+#define RS485_ADDR_GROUP_FIRST  0xF0
+#define RS485_ADDR_GROUP_LAST   0xFE
+#define RS485_GROUP_LIGHTS      0xF0    /* searchlight + light bar */
+#define RS485_MAX_PERIPHERALS   32      /* RS-485 unit loads on one segment */
+
+/* Timing — see "Bus scheduling" in docs/RS485_PERIPHERAL_BUS.md */
+#define RS485_TIMEOUT_MS        50      /* longest wait for a response to start       */
+#define RS485_TIMEOUT_MIN_MS    2       /* floor of the adaptive per-device timeout   */
+#define RS485_PROBE_TIMEOUT_MS  10      /* PING to a device with no latency history   */
+#define RS485_PING_INTERVAL_MS  1000    /* health check of an online device           */
+#define RS485_RETRY_MS          20      /* re-PING after an online device missed one  */
+#define RS485_MAX_RETRIES       3       /* consecutive misses before flagging offline */
+#define RS485_BACKOFF_MAX_MS    16000   /* cap of the offline re-probe interval       */
+#define RS485_INT_POLL_MS       10      /* /INT re-check interval while idle          */
+#define RS485_GAP_US            2000    /* inter-frame gap so a slave re-arms RX      */
+
+/* Firmware update — see "Firmware update" in docs/RS485_PERIPHERAL_BUS.md */
+#define RS485_BOOT_TIMEOUT_MS   400     /* BEGIN / STATUS / END: the slave writes flash first */
+#define RS485_BOOT_GAP_US       100     /* between unanswered BOOT_DATA frames        */
+
+/* Baud negotiation — the boot / fallback rate is RS485_BAUD (pins.h).
+ * RS485_BAUD_PROBATION_MS and RS485_BAUD_LINK_LOSS_MS are the slave side's
+ * and must agree with Peripherals/Framework/core/rs485_proto.h. */
+#ifndef RS485_BAUD_MAX
+#define RS485_BAUD_MAX          1000000 /* fastest rate the master will offer         */
+#endif
+#define RS485_BAUD_SETTLE_MS    2000    /* after boot / a fallback, before negotiating */
+#define RS485_BAUD_RETRY_MS     60000   /* after a failed negotiation                  */
+#define RS485_BAUD_SWITCH_MS    5       /* slaves reprogram their UART in this time    */
+#define RS485_BAUD_PROBATION_MS 250     /* slave reverts unless addressed at new rate  */
+#define RS485_BAUD_LINK_LOSS_MS 3000    /* slave reverts after this long with no valid frame */
+
+/* Discovery — see "Peripheral discovery" in docs/RS485_PERIPHERAL_BUS.md */
+#define RS485_SCAN_TIMEOUT_MS   3       /* PING wait per address while scanning       */
+#define RS485_SCAN_BATCH        8       /* addresses per scheduler pass               */
+#define RS485_SCAN_IDLE_MS      100     /* idle bus: probe one unknown address per; 0 = off */
+
+/* Stream slots — see "Stream slots" in docs/RS485_PERIPHERAL_BUS.md */
+#define RS485_TDMA_CYCLE_MS     20      /* SYNC period while anything streams         */
+#define RS485_TDMA_MAX_SLOTS    16      /* streaming devices per cycle                */
+#define RS485_TDMA_SLOT_BYTES   32      /* longest STREAM_DATA frame a slot holds     */
+
+/* Scheduler counters since boot */
+typedef struct {
+    uint32_t cmds;              /* Pi commands put on the bus                    */
+    uint32_t cmd_wait_max_us;   /* worst queued-to-on-the-wire delay of one      */
+    uint32_t cmd_wait_sum_us;   /* mean = cmd_wait_sum_us / cmds (wraps)         */
+    uint32_t hk_timeouts;       /* PING / GET_STATUS polls that got no reply     */
+    uint32_t baud;              /* current bus rate                              */
+    uint32_t baud_fallbacks;    /* negotiations that failed, or rate drops       */
+    uint32_t stream_frames;     /* STREAM_DATA frames forwarded to the Pi        */
+} rs485_sched_stats_t;
 
 /**
  * Initialise UART1 and GPIO for the RS-485 bus.
@@ -36,18 +96,31 @@
 void rs485_init(void);
 
 /**
- * FreeRTOS task: PING sweep, command forwarding, /INT handling.
- * Priority 2 — same as cdc_task.
+ * FreeRTOS task: bus transaction scheduler. While any device streams, a
+ * SYNC cycle of stream slots runs every RS485_TDMA_CYCLE_MS ahead of
+ * everything else. Otherwise commands from the Pi go first; /INT status
+ * polls and PINGs run one transaction at a time in between, so a queued
+ * command waits for at most one housekeeping transaction or one set of
+ * stream slots. Priority 2 — same as cdc_task.
  */
 void rs485_task(void *arg);
 
 /**
- * Queue a command received from the Pi (CDC PROTO_TYPE_PERIPH_CMD)
- * for forwarding onto the RS-485 bus.
- * payload format: [addr, cmd, len, payload...]
+ * Pool a command received from the Pi (CDC PROTO_TYPE_PERIPH_CMD) for
+ * forwarding onto the RS-485 bus; payload is a periph_cmd_t. Commands run
+ * in arrival order and each is answered by one PROTO_TYPE_PERIPH_DATA
+ * carrying its req_id and a PERIPH_RESULT_*. One the pool cannot hold is
+ * answered at once with PERIPH_RESULT_NACK.
  */
 void rs485_forward_cmd(const uint8_t *payload, uint16_t len);
 
+/**
+ * Rescan the whole address space (any task). Devices that no longer
+ * answer are dropped; afterwards every known device is reported to the
+ * Pi as PROTO_TYPE_PERIPH_STATE and the set is cached in flash.
+ */
+void rs485_request_scan(void);
+
 /**
  * Copy current peripheral addresses and online flags into caller buffers.
  * Returns the number of entries written (up to max_entries).
@@ -55,4 +128,15 @@ void rs485_forward_cmd(const uint8_t *payload, uint16_t len);
 uint8_t rs485_get_peripherals(uint8_t *addrs_out, bool *online_out,
                                uint8_t max_entries);
 
+/** Copy the scheduler counters (any task). */
+void rs485_get_sched_stats(rs485_sched_stats_t *out);
+
+/**
+ * Serialize one PROTO_TYPE_PERIPH_STATS frame: answered / timeout / CRC
+ * error counts and the latency histogram of up to PERIPH_STATS_MAX_ENTRIES
+ * known devices, continuing round the registry on the next call if more
+ * are known. Called by cdc_task next to proto_send_link_stats().
+ */
+void rs485_send_periph_stats(void);
+
 #endif /* RS485_H */
@@ -0,0 +1,233 @@
+#include "telemetry.h"
+#include "analog.h"
+#include "digital_io.h"
+#include "veml7700.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include <string.h>
+
+/* Subscription of one topic — written by the CDC task under a critical section */
+typedef struct {
+    uint8_t  mode;          /* SUB_MODE_* */
+    uint16_t period_ms;
+    uint8_t  decimation;    /* >= 1 */
+    uint16_t deadband;
+} topic_sub_t;
+
+#define SUB_DEFAULT     { SUB_MODE_PERIODIC, TELEMETRY_DEFAULT_PERIOD_MS, 1, 0 }
+
+static topic_sub_t      s_sub[TELEM_TOPIC_COUNT] = { SUB_DEFAULT, SUB_DEFAULT, SUB_DEFAULT };
+static uint8_t          s_decim_count[TELEM_TOPIC_COUNT];
+static volatile uint8_t s_fresh = 0;
+static volatile uint8_t s_resub = 0;    /* topics (re)subscribed since the last tick */
+
+/* Scheduler state — telemetry_task only */
+static uint32_t         s_tick = 0;
+static TickType_t       s_last_sent[TELEM_TOPIC_COUNT];
+static uint8_t          s_sent_once = 0;    /* topics sent since (re)subscribe */
+static adc_packet_t     s_sent_adc;         /* values last sent, for ON_CHANGE */
+static digital_packet_t s_sent_digital;
+static als_packet_t     s_sent_als;
+
+#define TOPIC_BIT(t)    ((uint8_t)(1u << (t)))
+
+/* Later of two time_us_32() stamps, wrap-safe */
+static uint32_t newer_us(uint32_t a, uint32_t b)
+{
+    return (int32_t)(a - b) > 0 ? a : b;
+}
+
+static uint32_t abs_diff(uint32_t a, uint32_t b)
+{
+    return a > b ? a - b : b - a;
+}
+
+void telemetry_mark_fresh(uint8_t flag)
+{
+    taskENTER_CRITICAL();
+    for (int t = 0; t < TELEM_TOPIC_COUNT; t++) {
+        if (!(flag & TOPIC_BIT(t))) continue;
+        if (++s_decim_count[t] >= s_sub[t].decimation) {
+            s_decim_count[t] = 0;
+            s_fresh |= TOPIC_BIT(t);
+        }
+    }
+    taskEXIT_CRITICAL();
+}
+
+bool telemetry_subscribe(const subscribe_entry_t *e)
+{
+    if (e->topic >= TELEM_TOPIC_COUNT || e->mode > SUB_MODE_ON_CHANGE) return false;
+
+    topic_sub_t want = {
+        .mode       = e->mode,
+        .period_ms  = e->period_ms,
+        .decimation = e->decimation ? e->decimation : 1,
+        .deadband   = e->deadband,
+    };
+
+    taskENTER_CRITICAL();
+    topic_sub_t *s = &s_sub[e->topic];
+    /* Repeating the current subscription is a no-op, so the Pi may refresh it */
+    if (s->mode != want.mode || s->period_ms != want.period_ms ||
+        s->decimation != want.decimation || s->deadband != want.deadband) {
+        *s = want;
+        s_decim_count[e->topic] = 0;
+        s_resub |= TOPIC_BIT(e->topic);
+    }
+    taskEXIT_CRITICAL();
+    return true;
+}
+
+void telemetry_reset_subscriptions(void)
+{
+    taskENTER_CRITICAL();
+    for (int t = 0; t < TELEM_TOPIC_COUNT; t++) {
+        s_sub[t] = (topic_sub_t)SUB_DEFAULT;
+        s_decim_count[t] = 0;
+    }
+    s_resub = TOPIC_BIT(TELEM_TOPIC_COUNT) - 1;
+    taskEXIT_CRITICAL();
+}
+
+/* ON_CHANGE test against the values last sent */
+static bool topic_changed(int t, uint16_t deadband, const adc_packet_t *adc,
+                          const digital_packet_t *dig, const als_packet_t *als)
+{
+    switch (t) {
+        case TELEM_TOPIC_ADC:
+            for (int i = 0; i < 6; i++) {
+                if (abs_diff(adc->ch[i], s_sent_adc.ch[i]) > deadband) return true;
+            }
+            return false;
+        case TELEM_TOPIC_DIGITAL:
+            return dig->port_a != s_sent_digital.port_a ||
+                   dig->port_b != s_sent_digital.port_b;
+        case TELEM_TOPIC_ALS:
+            return abs_diff(als->lux_milli, s_sent_als.lux_milli) > (uint32_t)deadband * 1000u;
+        default:
+            return false;
+    }
+}
+
+/* Which fresh topics go out this tick */
+static uint8_t topics_due(uint8_t fresh, const topic_sub_t *sub, TickType_t now,
+                          const adc_packet_t *adc, const digital_packet_t *dig,
+                          const als_packet_t *als)
+{
+    uint8_t due = 0;
+
+    for (int t = 0; t < TELEM_TOPIC_COUNT; t++) {
+        uint8_t bit = TOPIC_BIT(t);
+        if (!(fresh & bit) || sub[t].mode == SUB_MODE_OFF) continue;
+
+        /* First send after (re)subscribing is unconditional */
+        if (!(s_sent_once & bit)) {
+            due |= bit;
+            continue;
+        }
+
+        uint32_t period_ticks = sub[t].period_ms / TELEMETRY_TICK_MS;
+        if (period_ticks == 0) period_ticks = 1;
+
+        if (sub[t].mode == SUB_MODE_PERIODIC) {
+            /* Common grid, so topics with the same period share a bundle */
+            if (s_tick % period_ticks == 0) due |= bit;
+        } else if (now - s_last_sent[t] >= pdMS_TO_TICKS(sub[t].period_ms) &&
+                   topic_changed(t, sub[t].deadband, adc, dig, als)) {
+            due |= bit;
+        }
+    }
+    return due;
+}
+
+void telemetry_task(void *param)
+{
+    (void)param;
+
+    TickType_t last_wake = xTaskGetTickCount();
+    const TickType_t period = pdMS_TO_TICKS(TELEMETRY_TICK_MS);
+
+    while (1) {
+        vTaskDelayUntil(&last_wake, period);
+        s_tick++;
+
+        topic_sub_t sub[TELEM_TOPIC_COUNT];
+        taskENTER_CRITICAL();
+        uint8_t fresh = s_fresh;
+        uint8_t resub = s_resub;
+        s_resub = 0;
+        memcpy(sub, s_sub, sizeof(sub));
+        taskEXIT_CRITICAL();
+
+        s_sent_once &= (uint8_t)~resub;
+
+        /* Nothing new since the last send — skip the tick entirely */
+        if (!fresh) continue;
+
+        adc_packet_t     adc;
+        digital_packet_t dig;
+        als_packet_t     als;
+        memcpy(&adc, (const void *)&g_latest_adc, sizeof(adc));
+        memcpy(&dig, (const void *)&g_latest_digital, sizeof(dig));
+        memcpy(&als, (const void *)&g_latest_als, sizeof(als));
+
+        TickType_t now = xTaskGetTickCount();
+        uint8_t    due = topics_due(fresh, sub, now, &adc, &dig, &als);
+
+        /* Sent topics are consumed; unsubscribed ones are never wanted */
+        uint8_t off = 0;
+        for (int t = 0; t < TELEM_TOPIC_COUNT; t++) {
+            if (sub[t].mode == SUB_MODE_OFF) off |= TOPIC_BIT(t);
+        }
+        taskENTER_CRITICAL();
+        s_fresh &= (uint8_t)~(due | off);
+        taskEXIT_CRITICAL();
+
+        if (!due) continue;
+
+        for (int t = 0; t < TELEM_TOPIC_COUNT; t++) {
+            if (due & TOPIC_BIT(t)) s_last_sent[t] = now;
+        }
+        s_sent_once |= due;
+        if (due & TELEM_FRESH_ADC)     s_sent_adc     = adc;
+        if (due & TELEM_FRESH_DIGITAL) s_sent_digital = dig;
+        if (due & TELEM_FRESH_ALS)     s_sent_als     = als;
+
+#if TELEMETRY_BUNDLE_ENABLE
+        /* Stamp with the newest due sample so the Pi sees capture time */
+        uint32_t ts = 0;
+        bool     have_ts = false;
+        if (due & TELEM_FRESH_ADC) {
+            ts = adc.ts_us;
+            have_ts = true;
+        }
+        if (due & TELEM_FRESH_DIGITAL) {
+            ts = have_ts ? newer_us(ts, dig.ts_us) : dig.ts_us;
+            have_ts = true;
+        }
+        if (due & TELEM_FRESH_ALS) {
+            ts = have_ts ? newer_us(ts, als.ts_us) : als.ts_us;
+        }
+
+        telemetry_bundle_t b;
+        b.ts_us = ts;
+        b.fresh = due;
+        for (int i = 0; i < 6; i++) b.adc[i] = adc.ch[i];
+        b.port_a    = dig.port_a;
+        b.port_b    = dig.port_b;
+        b.als_raw   = als.als_raw;
+        b.white_raw = als.white_raw;
+        b.lux_milli = als.lux_milli;
+
+        /* Latest wins: an unsent older bundle is replaced, not queued */
+        proto_post_sample(PROTO_TYPE_TELEMETRY, &b, sizeof(b));
+#else
+        if (due & TELEM_FRESH_ADC)     proto_post_sample(PROTO_TYPE_ADC, &adc, sizeof(adc));
+        if (due & TELEM_FRESH_DIGITAL) proto_post_sample(PROTO_TYPE_DIGITAL, &dig, sizeof(dig));
+        if (due & TELEM_FRESH_ALS)     proto_post_sample(PROTO_TYPE_ALS, &als, sizeof(als));
+#endif
+    }
+}
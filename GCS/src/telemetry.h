@@ -0,0 +1,61 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "protocol.h"   /* telemetry_bundle_t, subscribe_entry_t */
+
+/*
+ * 1 = send one PROTO_TYPE_TELEMETRY bundle per scheduler tick with every
+ *     section that is due, instead of separate ADC / DIGITAL / ALS frames.
+ * 0 = legacy: each due topic goes out as its own frame.
+ */
+#ifndef TELEMETRY_BUNDLE_ENABLE
+#define TELEMETRY_BUNDLE_ENABLE     1
+#endif
+
+/* Scheduler tick — the fastest any topic can be sent (ADC samples at 100 Hz) */
+#ifndef TELEMETRY_TICK_MS
+#define TELEMETRY_TICK_MS           10
+#endif
+
+/*
+ * Period of the default subscription every topic gets on USB connect.
+ * Bundles: 20 ms = 50 Hz, 50 frames/s instead of 100 + 50 + 2.
+ * Legacy:  0 = every new sample.
+ */
+#ifndef TELEMETRY_DEFAULT_PERIOD_MS
+#if TELEMETRY_BUNDLE_ENABLE
+#define TELEMETRY_DEFAULT_PERIOD_MS 20
+#else
+#define TELEMETRY_DEFAULT_PERIOD_MS 0
+#endif
+#endif
+
+/**
+ * Report a new sample. Called by the sensor tasks after they update
+ * g_latest_*; flag = TELEM_FRESH_*. With a decimation of N, only every Nth
+ * call makes the topic due.
+ */
+void telemetry_mark_fresh(uint8_t flag);
+
+/**
+ * Apply one PROTO_TYPE_SUBSCRIBE entry (CDC task context). A changed
+ * subscription sends the topic once at the next tick whatever its mode, so
+ * the Pi starts from a current value; an unchanged one is ignored. Returns
+ * false if the topic or mode is unknown.
+ */
+bool telemetry_subscribe(const subscribe_entry_t *e);
+
+/** Revert every topic to the default subscription (new USB host session). */
+void telemetry_reset_subscriptions(void);
+
+/**
+ * FreeRTOS task: every TELEMETRY_TICK_MS, decides which topics are due under
+ * their subscription and posts them — as one PROTO_TYPE_TELEMETRY (0x11)
+ * sample, or as separate ADC / DIGITAL / ALS samples (latest wins, see
+ * proto_post_sample()).
+ */
+void telemetry_task(void *param);
+
+#endif /* TELEMETRY_H */
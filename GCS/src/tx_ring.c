@@ -0,0 +1,145 @@
+#include "tx_ring.h"
+#include "task.h"
+
+void tx_ring_init(tx_ring_t *r, uint8_t *storage, uint16_t size)
+{
+    r->buf      = storage;
+    r->size     = size;
+    r->head     = 0;
+    r->tail     = 0;
+    r->wrap     = size;
+    r->count    = 0;
+    r->hwm      = 0;
+    r->rec_left = 0;
+    r->resv_off = 0;
+    r->resv_len = 0;
+    r->dropped  = 0;
+    r->lock     = xSemaphoreCreateMutex();
+    configASSERT(r->lock != NULL);
+}
+
+/* ------------------------------------------------------------------ */
+/* Producer side                                                         */
+/* ------------------------------------------------------------------ */
+/* Any producer, on either core, may drop; tx_ring_clear adds to the same
+   count from the consumer */
+static void count_drop(tx_ring_t *r)
+{
+    taskENTER_CRITICAL();
+    r->dropped++;
+    taskEXIT_CRITICAL();
+}
+
+uint8_t *tx_ring_reserve(tx_ring_t *r, uint16_t len, TickType_t timeout)
+{
+    uint16_t need = (uint16_t)(len + TX_RING_REC_HDR);
+    if (!r->lock || len == 0 || need >= r->size) return NULL;
+
+    if (xSemaphoreTake(r->lock, timeout) != pdTRUE) {
+        count_drop(r);
+        return NULL;
+    }
+
+    taskENTER_CRITICAL();
+    uint16_t h = r->head;
+    uint16_t t = r->tail;
+    taskEXIT_CRITICAL();
+
+    /* Keep at least one byte free so head == tail always means empty */
+    int32_t off = -1;
+    if (h >= t) {
+        if ((uint16_t)(r->size - h) >= need) {
+            off = h;
+        } else if (t > need) {
+            off = 0;                    /* skip the tail, wrap to start */
+        }
+    } else if ((uint16_t)(t - h) > need) {
+        off = h;
+    }
+
+    if (off < 0) {
+        count_drop(r);
+        xSemaphoreGive(r->lock);
+        return NULL;
+    }
+
+    r->resv_off = (uint16_t)off;
+    r->resv_len = len;
+    return &r->buf[off + TX_RING_REC_HDR];
+}
+
+void tx_ring_trim(tx_ring_t *r, uint16_t len)
+{
+    if (len < r->resv_len) r->resv_len = len;
+}
+
+void tx_ring_commit(tx_ring_t *r)
+{
+    r->buf[r->resv_off]     = (uint8_t)(r->resv_len & 0xFF);
+    r->buf[r->resv_off + 1] = (uint8_t)(r->resv_len >> 8);
+
+    taskENTER_CRITICAL();
+    if (r->resv_off != r->head) {
+        /* Reservation wrapped: consumer stops at the old head */
+        r->wrap = r->head;
+    }
+    uint16_t h = (uint16_t)(r->resv_off + TX_RING_REC_HDR + r->resv_len);
+    uint16_t t = r->tail;
+    r->head = h;
+    r->count++;
+    uint16_t used = (h >= t) ? (uint16_t)(h - t) : (uint16_t)(r->wrap - t + h);
+    if (used > r->hwm) r->hwm = used;
+    taskEXIT_CRITICAL();
+
+    r->resv_len = 0;
+    xSemaphoreGive(r->lock);
+}
+
+/* ------------------------------------------------------------------ */
+/* Consumer side (single consumer only)                                  */
+/* ------------------------------------------------------------------ */
+uint16_t tx_ring_peek(tx_ring_t *r, const uint8_t **span)
+{
+    if (r->rec_left == 0) {
+        taskENTER_CRITICAL();
+        uint16_t h = r->head;
+        uint16_t t = r->tail;
+        if (h < t && t == r->wrap) {
+            /* Skipped region reached — continue from the start */
+            t = 0;
+        }
+        if (h != t) {
+            r->rec_left = (uint16_t)r->buf[t] | ((uint16_t)r->buf[t + 1] << 8);
+            t = (uint16_t)(t + TX_RING_REC_HDR);
+            r->count--;
+        }
+        r->tail = t;
+        taskEXIT_CRITICAL();
+    }
+
+    *span = &r->buf[r->tail];
+    return r->rec_left;
+}
+
+void tx_ring_consume(tx_ring_t *r, uint16_t n)
+{
+    if (n > r->rec_left) n = r->rec_left;
+    r->rec_left = (uint16_t)(r->rec_left - n);
+    taskENTER_CRITICAL();
+    r->tail = (uint16_t)(r->tail + n);
+    taskEXIT_CRITICAL();
+}
+
+bool tx_ring_empty(const tx_ring_t *r)
+{
+    return r->rec_left == 0 && r->head == r->tail;
+}
+
+void tx_ring_clear(tx_ring_t *r)
+{
+    taskENTER_CRITICAL();
+    r->dropped += r->count;
+    r->count = 0;
+    r->tail  = r->head;
+    taskEXIT_CRITICAL();
+}
@@ -0,0 +1,74 @@
+#ifndef TX_RING_H
+#define TX_RING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "FreeRTOS.h"
+#include "semphr.h"
+
+/*
+ * Variable-length record ring for outgoing CDC frames.
+ *
+ * Producers reserve a contiguous region, serialize straight into it and
+ * commit; a single consumer (cdc_task) peeks the current record and hands
+ * it to tud_cdc_write(), possibly over several calls. A reservation never
+ * straddles the end of the storage: if it does not fit in the tail space
+ * the region is placed at offset 0 and the unused tail is skipped by the
+ * consumer (bip-buffer), so every committed frame is one linear run of
+ * bytes. Each record carries a 2-byte length header (not sent) so the
+ * consumer knows where one frame ends and another lane may take over.
+ */
+#define TX_RING_REC_HDR     2
+
+typedef struct {
+    uint8_t           *buf;
+    uint16_t           size;
+    volatile uint16_t  head;       /* next write offset (producers)          */
+    volatile uint16_t  tail;       /* next read offset (consumer)            */
+    volatile uint16_t  wrap;       /* end of valid data while head < tail    */
+    volatile uint16_t  count;      /* committed records not yet started      */
+    volatile uint16_t  hwm;        /* peak bytes in use since init           */
+    uint16_t           rec_left;   /* unsent bytes of the current record     */
+    uint16_t           resv_off;   /* offset of the open reservation         */
+    uint16_t           resv_len;   /* payload length of the open reservation */
+    SemaphoreHandle_t  lock;       /* held by a producer from reserve→commit */
+    volatile uint32_t  dropped;    /* records refused or discarded           */
+} tx_ring_t;
+
+/** Initialise a ring over caller-provided storage (call before the scheduler). */
+void tx_ring_init(tx_ring_t *r, uint8_t *storage, uint16_t size);
+
+/**
+ * Reserve len contiguous bytes. On success the ring lock is held until
+ * tx_ring_commit() and a pointer into ring memory is returned; on failure
+ * (ring full or lock not obtained within timeout) returns NULL.
+ */
+uint8_t *tx_ring_reserve(tx_ring_t *r, uint16_t len, TickType_t timeout);
+
+/** Shrink the open reservation to len bytes (len <= reserved length). */
+void tx_ring_trim(tx_ring_t *r, uint16_t len);
+
+/** Publish the open reservation to the consumer and release the lock. */
+void tx_ring_commit(tx_ring_t *r);
+
+/**
+ * Consumer: return the number of unsent bytes of the current record and set
+ * *span to the first of them, starting the next record if the current one
+ * is done. Returns 0 when the ring is empty.
+ */
+uint16_t tx_ring_peek(tx_ring_t *r, const uint8_t **span);
+
+/** Consumer: release n bytes previously returned by tx_ring_peek(). */
+void tx_ring_consume(tx_ring_t *r, uint16_t n);
+
+/** Consumer: true if nothing is committed and no record is in progress. */
+bool tx_ring_empty(const tx_ring_t *r);
+
+/**
+ * Consumer: discard every committed record that has not been started and
+ * count them as dropped. Caller must hold r->lock and no record may be in
+ * progress (rec_left == 0).
+ */
+void tx_ring_clear(tx_ring_t *r);
+
+#endif /* TX_RING_H */
@@ -1,7 +1,10 @@
 #include "usb_cdc.h"
 #include "protocol.h"
 #include "system_state.h"
+#include "telemetry.h"
+#include "rs485.h"
 #include "tusb.h"
+#include "pico/stdlib.h"
 
 #include "FreeRTOS.h"
 #include "task.h"
@@ -30,6 +33,56 @@ void usb_device_task(void *param)
     }
 }
 
+/* ------------------------------------------------------------------ */
+/* TX lanes → TinyUSB                                                    */
+/* ------------------------------------------------------------------ */
+
+/* Lane whose current frame is partly in the TinyUSB FIFO, or NULL */
+static tx_ring_t *s_tx_partial = NULL;
+
+/* tud_cdc_write() calls that took less than offered — reported in LINK_STATS */
+static uint32_t s_cdc_short_writes = 0;
+
+/* Write as much of the lane's current frame as fits. True if it completed. */
+static bool tx_send_frame(tx_ring_t *lane)
+{
+    const uint8_t *span;
+    uint16_t avail = tx_ring_peek(lane, &span);
+    if (avail == 0) {
+        s_tx_partial = NULL;
+        return true;
+    }
+
+    uint32_t n = tud_cdc_write(span, avail);
+    tx_ring_consume(lane, (uint16_t)n);
+    if (n < avail) s_cdc_short_writes++;
+    s_tx_partial = (n < avail) ? lane : NULL;
+    return n == avail;
+}
+
+/*
+ * Frames are never interleaved on the wire, so a frame that is partly
+ * written finishes first. After that the event lane always goes before the
+ * next bulk frame, and bulk yields again after every frame it sends.
+ */
+static void cdc_tx_pump(void)
+{
+    tx_ring_t *event = &g_tx_lane[PROTO_LANE_EVENT];
+    tx_ring_t *bulk  = &g_tx_lane[PROTO_LANE_BULK];
+
+    if (s_tx_partial && !tx_send_frame(s_tx_partial)) return;
+
+    while (1) {
+        if (!tx_ring_empty(event)) {
+            if (!tx_send_frame(event)) return;  /* TinyUSB FIFO full */
+            continue;
+        }
+        proto_tx_service();
+        if (tx_ring_empty(bulk)) return;
+        if (!tx_send_frame(bulk)) return;
+    }
+}
+
 /* ------------------------------------------------------------------ */
 /* CDC task                                                              */
 /* ------------------------------------------------------------------ */
@@ -42,9 +95,9 @@ void cdc_task(void *param)
     (void)param;
 
     uint8_t rx_buf[CFG_TUD_CDC_RX_BUFSIZE];
-    tx_item_t tx_item;
 
     TickType_t last_heartbeat_tx = xTaskGetTickCount();
+    TickType_t last_link_stats   = xTaskGetTickCount();
     bool was_connected = false;
     static uint8_t s_hb_seq = 0;
 
@@ -58,7 +111,10 @@ void cdc_task(void *param)
 
         /* -- Detect USB connect / disconnect ----------------------------- */
         if (cdc_connected && !was_connected) {
-            /* Just connected */
+            /* Just connected — new host session starts in SOF framing,
+             * with the default telemetry subscription */
+            proto_reset_framing();
+            telemetry_reset_subscriptions();
             proto_send_event(EVT_USB_CONNECTED, 0);
             /* Reset heartbeat timer so we give the Pi time to respond */
             g_last_heartbeat_rx_tick = xTaskGetTickCount();
@@ -72,10 +128,8 @@ void cdc_task(void *param)
         was_connected = cdc_connected;
 
         if (cdc_connected) {
-            /* -- TX: drain queue ----------------------------------------- */
-            while (xQueueReceive(g_tx_queue, &tx_item, 0) == pdTRUE) {
-                tud_cdc_write(tx_item.buf, tx_item.len);
-            }
+            /* -- TX: event lane first, then bulk ------------------------- */
+            cdc_tx_pump();
             tud_cdc_write_flush();
 
             /* -- RX: feed into protocol state machine -------------------- */
@@ -83,6 +137,10 @@ void cdc_task(void *param)
                 uint32_t n = tud_cdc_read(rx_buf, sizeof(rx_buf));
                 if (n > 0) {
                     proto_handle_rx(rx_buf, n);
+                    /* Send heartbeat echoes now, not a loop later — the Pi's
+                     * clock sync assumes t3 is close to the real send time */
+                    cdc_tx_pump();
+                    tud_cdc_write_flush();
                 }
             }
 
@@ -90,16 +148,16 @@ void cdc_task(void *param)
             TickType_t now = xTaskGetTickCount();
             if ((now - last_heartbeat_tx) >= pdMS_TO_TICKS(HEARTBEAT_TX_INTERVAL_MS)) {
                 last_heartbeat_tx = now;
-                heartbeat_pkt_t hb = { .seq = s_hb_seq++ };
-                tx_item_t hb_item;
-                int len = proto_serialize(hb_item.buf, sizeof(hb_item.buf),
-                                          PROTO_TYPE_HEARTBEAT,
-                                          (const uint8_t *)&hb, sizeof(hb));
-                if (len > 0) {
-                    hb_item.len = (uint8_t)len;
-                    tud_cdc_write(hb_item.buf, hb_item.len);
-                    tud_cdc_write_flush();
-                }
+                heartbeat_pkt_t hb = { .seq = s_hb_seq++, .t_us = time_us_32() };
+                /* Event lane — a telemetry backlog cannot delay it past one frame */
+                proto_send(PROTO_TYPE_HEARTBEAT, &hb, sizeof(hb));
+            }
+
+            /* -- Link health and RS-485 transaction counters ------------- */
+            if ((now - last_link_stats) >= pdMS_TO_TICKS(LINK_STATS_PERIOD_MS)) {
+                last_link_stats = now;
+                proto_send_link_stats(s_cdc_short_writes);
+                rs485_send_periph_stats();
             }
 
             /* -- Heartbeat RX timeout ------------------------------------ */
@@ -17,9 +17,10 @@ extern volatile TickType_t g_last_heartbeat_rx_tick;
 void usb_device_task(void *param);
 
 /**
- * FreeRTOS task: drains g_tx_queue → tud_cdc_write(), feeds received
+ * FreeRTOS task: drains the TX lanes (event lane first) → tud_cdc_write(), feeds received
  * bytes into proto_handle_rx(), and sends heartbeat packets every 1 s.
- * Detects heartbeat timeout (3 s) and USB disconnect/reconnect.
+ * Detects heartbeat timeout (3 s) and USB disconnect/reconnect, and sends
+ * PROTO_TYPE_LINK_STATS every LINK_STATS_PERIOD_MS.
  */
 void cdc_task(void *param);
 
@@ -1,7 +1,9 @@
 #include "veml7700.h"
 #include "pins.h"
 #include "protocol.h"
+#include "telemetry.h"
 
+#include "pico/stdlib.h"
 #include "hardware/i2c.h"
 
 #include "FreeRTOS.h"
@@ -82,8 +84,6 @@ void veml7700_task(void *param)
     TickType_t last_wake = xTaskGetTickCount();
     const TickType_t period = pdMS_TO_TICKS(500);
 
-    uint8_t serial_buf[TX_BUF_SIZE];
-
     while (1) {
         als_packet_t pkt;
 
@@ -94,21 +94,12 @@ void veml7700_task(void *param)
         pkt.lux_milli = (uint32_t)pkt.als_raw *
                         VEML7700_RESOLUTION_MILLILUX_PER_COUNT;
 
-        pkt.ts_ms = (uint16_t)(xTaskGetTickCount() & 0xFFFF);
+        pkt.ts_us = time_us_32();
 
         /* Update shared latest reading for other tasks (e.g. screen) */
         memcpy((void *)&g_latest_als, &pkt, sizeof(pkt));
 
-        /* Enqueue Pico→Pi ALS packet */
-        int len = proto_serialize(serial_buf, sizeof(serial_buf),
-                                  PROTO_TYPE_ALS,
-                                  (const uint8_t *)&pkt, sizeof(pkt));
-        if (len > 0 && g_tx_queue) {
-            tx_item_t item;
-            item.len = (uint8_t)len;
-            memcpy(item.buf, serial_buf, (size_t)len);
-            xQueueSend(g_tx_queue, &item, 0);
-        }
+        telemetry_mark_fresh(TELEM_FRESH_ALS);
 
         vTaskDelayUntil(&last_wake, period);
     }
@@ -20,8 +20,8 @@ void veml7700_init(void);
 
 /**
  * FreeRTOS task: reads VEML7700 ALS and WHITE registers every 500 ms,
- * converts to millilux, and enqueues a PROTO_TYPE_ALS (0x0B) packet on
- * g_tx_queue.
+ * converts to millilux into g_latest_als and hands each reading to the
+ * telemetry scheduler (telemetry.h).
  */
 void veml7700_task(void *param);
 
@@ -91,6 +91,29 @@ void GCSState::updatePicoLink(bool connected, double heartbeatMs, int seq)
     emit linkStateChanged();
 }
 
+void GCSState::updatePicoClock(bool synced, double driftPpm, double sampleLatencyMs)
+{
+    m_picoClockSynced     = synced;
+    m_picoClockDriftPpm   = driftPpm;
+    m_picoSampleLatencyMs = sampleLatencyMs;
+    emit linkStateChanged();
+}
+
+void GCSState::updatePicoLinkStats(int eventDrops, int bulkDrops, int txDrops, int rxRejects,
+                                   int shortWrites, int eventPeakPct, int bulkPeakPct,
+                                   const QVariantList &perType)
+{
+    m_picoEventDrops    = eventDrops;
+    m_picoBulkDrops     = bulkDrops;
+    m_picoTxDrops       = txDrops;
+    m_picoRxRejects     = rxRejects;
+    m_picoShortWrites   = shortWrites;
+    m_picoEventLanePeak = eventPeakPct;
+    m_picoBulkLanePeak  = bulkPeakPct;
+    m_picoLinkTypeStats = perType;
+    emit linkStatsChanged();
+}
+
 void GCSState::updateKeyState(bool unlocked)
 {
     if (m_keyUnlocked == unlocked) return;
@@ -197,6 +220,40 @@ void GCSState::updatePeripheral(int address, const QString &name, bool online,
     emit peripheralsChanged();
 }
 
+// Bus counters from PERIPH_STATS: merged into the entry, name left as it is
+void GCSState::updatePeripheralStats(int address, bool online, const QVariantMap &stats)
+{
+    for (int i = 0; i < m_peripherals.size(); ++i) {
+        if (m_peripherals[i].toMap()["address"].toInt() == address) {
+            QVariantMap entry = m_peripherals[i].toMap();
+            entry["online"] = online;
+            for (auto it = stats.begin(); it != stats.end(); ++it)
+                entry[it.key()] = it.value();
+            m_peripherals[i] = entry;
+            emit peripheralsChanged();
+            return;
+        }
+    }
+    updatePeripheral(address, QString("DEV_0x%1").arg(address, 2, 16, QChar('0')),
+                     online, stats);
+}
+
+// Outcome of a PERIPH_CMD: merged into a known entry only, so commands to
+// a group or an absent address do not add devices
+void GCSState::updatePeripheralRequest(int address, const QVariantMap &req)
+{
+    for (int i = 0; i < m_peripherals.size(); ++i) {
+        if (m_peripherals[i].toMap()["address"].toInt() == address) {
+            QVariantMap entry = m_peripherals[i].toMap();
+            for (auto it = req.begin(); it != req.end(); ++it)
+                entry[it.key()] = it.value();
+            m_peripherals[i] = entry;
+            emit peripheralsChanged();
+            return;
+        }
+    }
+}
+
 void GCSState::updateSystemStats(double uptimeSec, int memPct, int diskPct)
 {
     m_uptimeSeconds = uptimeSec;
@@ -358,6 +415,16 @@ void GCSState::sendTftPeriphDetail(int address)
     emit cmdTftPeriphDetail(address);
 }
 
+void GCSState::sendPeriphScan()
+{
+    emit cmdPeriphScan();
+}
+
+void GCSState::startPeriphUpdate(int address, const QString &path)
+{
+    emit cmdPeriphUpdate(address, path);
+}
+
 bool GCSState::loadCaseTwinConfig(const QString &path)
 {
     QFile file(path);
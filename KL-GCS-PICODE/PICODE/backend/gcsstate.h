@@ -46,6 +46,17 @@ class GCSState : public QObject {
     Q_PROPERTY(bool    picoConnected   READ picoConnected   NOTIFY linkStateChanged)
     Q_PROPERTY(double  picoHeartbeatMs READ picoHeartbeatMs NOTIFY linkStateChanged)
     Q_PROPERTY(int     picoHeartbeatSeq READ picoHeartbeatSeq NOTIFY linkStateChanged)
+    Q_PROPERTY(bool    picoClockSynced READ picoClockSynced NOTIFY linkStateChanged)
+    Q_PROPERTY(double  picoClockDriftPpm READ picoClockDriftPpm NOTIFY linkStateChanged)
+    Q_PROPERTY(double  picoSampleLatencyMs READ picoSampleLatencyMs NOTIFY linkStateChanged)
+    Q_PROPERTY(int     picoEventDrops  READ picoEventDrops  NOTIFY linkStatsChanged)
+    Q_PROPERTY(int     picoBulkDrops   READ picoBulkDrops   NOTIFY linkStatsChanged)
+    Q_PROPERTY(int     picoTxDrops     READ picoTxDrops     NOTIFY linkStatsChanged)
+    Q_PROPERTY(int     picoRxRejects   READ picoRxRejects   NOTIFY linkStatsChanged)
+    Q_PROPERTY(int     picoShortWrites READ picoShortWrites NOTIFY linkStatsChanged)
+    Q_PROPERTY(int     picoEventLanePeak READ picoEventLanePeak NOTIFY linkStatsChanged)
+    Q_PROPERTY(int     picoBulkLanePeak  READ picoBulkLanePeak  NOTIFY linkStatsChanged)
+    Q_PROPERTY(QVariantList picoLinkTypeStats READ picoLinkTypeStats NOTIFY linkStatsChanged)
     Q_PROPERTY(bool    keyUnlocked     READ keyUnlocked     NOTIFY keyStateChanged)
     Q_PROPERTY(double  alsLux          READ alsLux          NOTIFY sensorChanged)
     Q_PROPERTY(int     alsGain         READ alsGain         NOTIFY sensorChanged)
@@ -130,6 +141,17 @@ public:
     bool    picoConnected()    const { return m_picoConnected; }
     double  picoHeartbeatMs()  const { return m_picoHeartbeatMs; }
     int     picoHeartbeatSeq() const { return m_picoHeartbeatSeq; }
+    bool    picoClockSynced()  const { return m_picoClockSynced; }
+    double  picoClockDriftPpm() const { return m_picoClockDriftPpm; }
+    double  picoSampleLatencyMs() const { return m_picoSampleLatencyMs; }
+    int     picoEventDrops()   const { return m_picoEventDrops; }
+    int     picoBulkDrops()    const { return m_picoBulkDrops; }
+    int     picoTxDrops()      const { return m_picoTxDrops; }
+    int     picoRxRejects()    const { return m_picoRxRejects; }
+    int     picoShortWrites()  const { return m_picoShortWrites; }
+    int     picoEventLanePeak() const { return m_picoEventLanePeak; }
+    int     picoBulkLanePeak() const { return m_picoBulkLanePeak; }
+    QVariantList picoLinkTypeStats() const { return m_picoLinkTypeStats; }
     bool    keyUnlocked()      const { return m_keyUnlocked; }
     double  alsLux()           const { return m_alsLux; }
     int     alsGain()          const { return m_alsGain; }
@@ -176,6 +198,10 @@ public slots:
     void updateFlightMode(const QString &mode, bool armed);
     void appendStatusMessage(const QString &msg);
     void updatePicoLink(bool connected, double heartbeatMs, int seq);
+    void updatePicoClock(bool synced, double driftPpm, double sampleLatencyMs);
+    void updatePicoLinkStats(int eventDrops, int bulkDrops, int txDrops, int rxRejects,
+                             int shortWrites, int eventPeakPct, int bulkPeakPct,
+                             const QVariantList &perType);
     void updateKeyState(bool unlocked);
     void updateSwitchStates(int portA, int portB);
     Q_INVOKABLE void setCrosshairActive(bool active);
@@ -186,6 +212,8 @@ public slots:
     void updateWarnings(int temp, int signal, int drone, int gps, int link, int network);
     void updatePeripheral(int address, const QString &name, bool online,
                           const QVariantMap &deviceData);
+    void updatePeripheralStats(int address, bool online, const QVariantMap &stats);
+    void updatePeripheralRequest(int address, const QVariantMap &req);
     void updateSystemStats(double uptimeSec, int memPct, int diskPct);
     void setWaypoints(const QVariantList &wps);
     void setPois(const QVariantList &pois);
@@ -212,6 +240,10 @@ public slots:
     Q_INVOKABLE void sendPeriphCmd(int address, int cmd, const QByteArray &payload = {});
     Q_INVOKABLE void sendTftScreen(int mode);
     Q_INVOKABLE void sendTftPeriphDetail(int address);
+    Q_INVOKABLE void sendPeriphScan();
+    // Flash a peripheral over the bus from an image file (.bin); progress
+    // shows as fwUpdateState / fwUpdatePct on its peripherals entry
+    Q_INVOKABLE void startPeriphUpdate(int address, const QString &path);
     Q_INVOKABLE bool loadCaseTwinConfig(const QString &path);
     Q_INVOKABLE bool saveCaseTwinConfig(const QString &path);
     Q_INVOKABLE void resetCaseTwinConfig();
@@ -220,6 +252,7 @@ signals:
     void droneStateChanged();
     void dronePositionChanged();
     void linkStateChanged();
+    void linkStatsChanged();
     void keyStateChanged();
     void sensorChanged();
     void warningsChanged();
@@ -248,6 +281,8 @@ signals:
     void cmdPeriphCmd(int address, int cmd, const QByteArray &payload);
     void cmdTftScreen(int mode);
     void cmdTftPeriphDetail(int address);
+    void cmdPeriphScan();
+    void cmdPeriphUpdate(int address, const QString &path);
 
 private:
     explicit GCSState(QObject *parent = nullptr);
@@ -287,6 +322,17 @@ private:
     bool    m_picoConnected    = false;
     double  m_picoHeartbeatMs  = 0.0;
     int     m_picoHeartbeatSeq = 0;
+    bool    m_picoClockSynced  = false;
+    double  m_picoClockDriftPpm = 0.0;
+    double  m_picoSampleLatencyMs = 0.0;
+    int     m_picoEventDrops   = 0;
+    int     m_picoBulkDrops    = 0;
+    int     m_picoTxDrops      = 0;
+    int     m_picoRxRejects    = 0;
+    int     m_picoShortWrites  = 0;
+    int     m_picoEventLanePeak = 0;
+    int     m_picoBulkLanePeak = 0;
+    QVariantList m_picoLinkTypeStats;
     bool    m_keyUnlocked      = false;
     double  m_alsLux           = 0.0;
     int     m_alsGain          = 0;
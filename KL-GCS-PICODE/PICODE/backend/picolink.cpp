@@ -1,25 +1,23 @@
 #include "picolink.h"
+#include "rs485_proto.h"
 #include <QDateTime>
 #include <QtMath>
 #include <cstring>
 #include <QFile>
 #include <QStringList>
+#include <QHash>
 
-#define PROTO_SOF               0xAA
-#define PROTO_TYPE_ADC          0x01
-#define PROTO_TYPE_DIGITAL      0x02
-#define PROTO_TYPE_BRIGHTNESS   0x08
-#define PROTO_TYPE_WARNING      0x0A
-#define PROTO_TYPE_ALS          0x0B
-#define PROTO_TYPE_HEARTBEAT    0x05
-#define PROTO_TYPE_EVENT        0x06
-#define PROTO_TYPE_PERIPH_DATA  0x0D
-#define PROTO_TYPE_PERIPH_STATE 0x0E
-#define PROTO_TYPE_PERIPH_CMD   0x0C
-#define PROTO_TYPE_LED            0x03
-#define PROTO_TYPE_SCREEN         0x04
-#define PROTO_TYPE_PERIPH_SCREEN  0x0F
-#define PROTO_TYPE_WORKLIGHT      0x10
+#define TELEM_FRESH_ADC           0x01
+#define TELEM_FRESH_DIGITAL       0x02
+#define TELEM_FRESH_ALS           0x04
+
+#define TELEM_TOPIC_ADC           0
+#define TELEM_TOPIC_DIGITAL       1
+#define TELEM_TOPIC_ALS           2
+
+#define SUB_MODE_OFF              0
+#define SUB_MODE_PERIODIC         1
+#define SUB_MODE_ON_CHANGE        2
 
 #define ADC_CH_BAT_VIN   0
 #define ADC_CH_EXT_VIN   1
@@ -37,6 +35,8 @@ PicoLink::PicoLink(GCSState *state, QObject *parent)
     m_serial.setStopBits(QSerialPort::OneStop);
     m_serial.setParity(QSerialPort::NoParity);
 
+    proto_parser_init(&m_parser, PROTO_FRAMING_SOF, &PicoLink::onFrame, this);
+
     connect(&m_serial, &QSerialPort::readyRead, this, &PicoLink::onReadyRead);
     connect(&m_serial, QOverload<QSerialPort::SerialPortError>::of(&QSerialPort::errorOccurred),
             this, &PicoLink::onSerialError);
@@ -58,6 +58,11 @@ PicoLink::PicoLink(GCSState *state, QObject *parent)
     connect(m_state, &GCSState::cmdPeriphCmd,       this, &PicoLink::onPeriphCmd);
     connect(m_state, &GCSState::cmdTftScreen,       this, &PicoLink::onTftScreen);
     connect(m_state, &GCSState::cmdTftPeriphDetail, this, &PicoLink::onTftPeriphDetail);
+    connect(m_state, &GCSState::cmdPeriphScan,      this, &PicoLink::onPeriphScan);
+    connect(m_state, &GCSState::cmdPeriphUpdate,    this, &PicoLink::onPeriphUpdate);
+
+    m_clockEpochMs = QDateTime::currentMSecsSinceEpoch();
+    m_clock.start();
 }
 
 void PicoLink::start()
@@ -74,6 +79,21 @@ void PicoLink::openPort()
         m_connected = true;
         m_lastHeartbeatRecv = QDateTime::currentDateTime();
         m_retryTimer.stop();
+        // The Pico reverts to SOF framing on every USB connect
+        m_cobs = false;
+        proto_parser_set_framing(&m_parser, PROTO_FRAMING_SOF);
+        m_linkCfgTries = 0;
+        // A reconnect may be a rebooted Pico with a new clock
+        m_clockSynced     = false;
+        m_rttUs           = 0;
+        m_sampleLatencyMs = 0.0;
+        // ...and one that has forgotten every command we had in flight.
+        // An update asks the slave where it got to and carries on.
+        m_periphReqs.clear();
+        if (rs485_update_busy(&m_fwUpdate))
+            fwUpdateReply(m_fwUpdate.last_cmd, nullptr, -1);
+        sendSubscriptions();
+        requestCobsFraming();
     } else {
         m_connected = false;
         m_state->updatePicoLink(false, 0, 0);
@@ -92,6 +112,39 @@ void PicoLink::onSerialError(QSerialPort::SerialPortError error)
     }
 }
 
+void PicoLink::requestCobsFraming()
+{
+    if (!REQUEST_COBS || m_cobs || m_linkCfgTries >= LINK_CFG_MAX_TRIES) return;
+    m_linkCfgTries++;
+    uint8_t framing = PROTO_FRAMING_COBS;
+    sendFrame(PROTO_TYPE_LINK_CFG, &framing, 1);
+}
+
+// Telemetry the UI actually uses: battery and case temperatures (ADC) at 2 Hz,
+// switch state (DIGITAL) and ambient light (ALS) only when they change.
+void PicoLink::sendSubscriptions()
+{
+    struct Sub { uint8_t topic, mode; uint16_t periodMs; uint8_t decimation; uint16_t deadband; };
+    static constexpr Sub subs[] = {
+        { TELEM_TOPIC_ADC,     SUB_MODE_PERIODIC,  500, 1, 0 },
+        { TELEM_TOPIC_DIGITAL, SUB_MODE_ON_CHANGE,   0, 1, 0 },
+        { TELEM_TOPIC_ALS,     SUB_MODE_ON_CHANGE, 500, 1, ALS_DEADBAND_LUX },
+    };
+
+    // subscribe_entry_t: topic mode period_ms(u16) decimation deadband(u16) = 7 bytes
+    uint8_t payload[sizeof(subs) / sizeof(subs[0]) * 7];
+    uint8_t *p = payload;
+    for (const Sub &s : subs) {
+        p[0] = s.topic;
+        p[1] = s.mode;
+        memcpy(p + 2, &s.periodMs, 2);
+        p[4] = s.decimation;
+        memcpy(p + 5, &s.deadband, 2);
+        p += 7;
+    }
+    sendFrame(PROTO_TYPE_SUBSCRIBE, payload, sizeof(payload));
+}
+
 void PicoLink::retryConnect()
 {
     if (!m_connected)
@@ -111,9 +164,22 @@ void PicoLink::sendHeartbeat()
         return;
     }
 
-    uint8_t payload[1];
+    // heartbeat_pkt_t: seq(u8) t_us(u32) — the Pico echoes t_us back as t1
+    uint8_t payload[5];
     payload[0] = m_heartbeatSeqTx++;
-    sendFrame(PROTO_TYPE_HEARTBEAT, payload, 1);
+    uint32_t t1 = piClockUs();
+    memcpy(payload + 1, &t1, 4);
+    sendFrame(PROTO_TYPE_HEARTBEAT, payload, sizeof(payload));
+
+    // The Pico ignores an unchanged subscription; repeating it covers a Pico
+    // that rebooted (back on the default full-rate stream) without a reconnect
+    sendSubscriptions();
+
+    // Older firmware ignores LINK_CFG — stay on SOF framing after a few tries
+    requestCobsFraming();
+
+    // An update waits on one answer at a time: notice if it went missing
+    expirePeriphRequests();
 }
 
 void PicoLink::readCpuTemp()
@@ -168,35 +234,32 @@ void PicoLink::readSystemStats()
 
 void PicoLink::onReadyRead()
 {
-    m_rxBuf.append(m_serial.readAll());
-
-    while (m_rxBuf.size() >= 5) {
-        if (m_rxBuf[0] != PROTO_SOF) {
-            m_rxBuf.remove(0, 1);
-            continue;
-        }
-
-        uint8_t type = m_rxBuf[1];
-        uint8_t lenLo = m_rxBuf[2];
-        uint8_t lenHi = m_rxBuf[3];
-        uint16_t payloadLen = (uint16_t)lenLo | ((uint16_t)lenHi << 8);
-
-        if (m_rxBuf.size() < (int)(5 + payloadLen))
-            break;
-
-        uint8_t cksum = type ^ lenLo ^ lenHi;
-        for (uint16_t i = 0; i < payloadLen; i++)
-            cksum ^= m_rxBuf[4 + i];
+    const QByteArray data = m_serial.readAll();
+    const uint8_t *p = reinterpret_cast<const uint8_t *>(data.constData());
+    size_t left = static_cast<size_t>(data.size());
+
+    // LINK_CFG can switch the framing mid-chunk: the parser stops right after
+    // it and the rest of the chunk is fed in the new framing
+    while (left > 0) {
+        size_t used = proto_parser_feed(&m_parser, p, left);
+        p += used;
+        left -= used;
+
+        uint8_t framing = m_cobs ? PROTO_FRAMING_COBS : PROTO_FRAMING_SOF;
+        if (m_parser.framing != framing)
+            proto_parser_set_framing(&m_parser, framing);
+    }
+}
 
-        uint8_t rxCksum = m_rxBuf[4 + payloadLen];
-        if (cksum != rxCksum) {
-            m_rxBuf.remove(0, 5 + payloadLen);
-            continue;
-        }
+bool PicoLink::onFrame(void *ctx, proto_rx_status_t status, uint8_t type,
+                       const uint8_t *payload, uint16_t len)
+{
+    // Corrupt frames cost only themselves; the Pico counts what it rejects
+    if (status != PROTO_RX_OK)
+        return false;
 
-        processPacket(type, (const uint8_t *)m_rxBuf.constData() + 4, payloadLen);
-        m_rxBuf.remove(0, 5 + payloadLen);
-    }
+    static_cast<PicoLink *>(ctx)->processPacket(type, payload, len);
+    return type == PROTO_TYPE_LINK_CFG;
 }
 
 void PicoLink::processPacket(uint8_t type, const uint8_t *payload, int len)
@@ -214,6 +277,17 @@ void PicoLink::processPacket(uint8_t type, const uint8_t *payload, int len)
     case PROTO_TYPE_ALS:
         handleAlsPacket(payload, len);
         break;
+    case PROTO_TYPE_TELEMETRY:
+        handleTelemetryPacket(payload, len);
+        break;
+    case PROTO_TYPE_LINK_CFG:
+        // Pico has switched; everything after this frame uses the new framing
+        if (len >= 1)
+            m_cobs = (payload[0] == PROTO_FRAMING_COBS);
+        break;
+    case PROTO_TYPE_LINK_STATS:
+        handleLinkStatsPacket(payload, len);
+        break;
     case PROTO_TYPE_EVENT:
         handleEventPacket(payload, len);
         break;
@@ -223,16 +297,27 @@ void PicoLink::processPacket(uint8_t type, const uint8_t *payload, int len)
     case PROTO_TYPE_PERIPH_STATE:
         handlePeriphStatePacket(payload, len);
         break;
+    case PROTO_TYPE_PERIPH_STATS:
+        handlePeriphStatsPacket(payload, len);
+        break;
     }
 }
 
 void PicoLink::handleAdcPacket(const uint8_t *payload, int len)
 {
-    if (len < 14) return;
+    // adc_packet_t: ch[6](u16) ts_us(u32) = 16 bytes
+    if (len < 16) return;
 
     uint16_t ch[6];
+    uint32_t tsUs;
     memcpy(ch, payload, 12);
+    memcpy(&tsUs, payload + 12, 4);
+    noteSampleTime(tsUs);
+    applyAdc(ch);
+}
 
+void PicoLink::applyAdc(const uint16_t ch[6])
+{
     double batV = adcToVolts(ch[ADC_CH_BAT_VIN], BAT_DIVIDER);
     double extV = adcToVolts(ch[ADC_CH_EXT_VIN], EXT_DIVIDER);
     int batPct = batteryPercent(batV);
@@ -249,10 +334,16 @@ void PicoLink::handleAdcPacket(const uint8_t *payload, int len)
 
 void PicoLink::handleDigitalPacket(const uint8_t *payload, int len)
 {
-    if (len < 4) return;
-    uint8_t portA = payload[0];
-    uint8_t portB = payload[1];
+    // digital_packet_t: port_a port_b ts_us(u32) = 6 bytes
+    if (len < 6) return;
+    uint32_t tsUs;
+    memcpy(&tsUs, payload + 2, 4);
+    noteSampleTime(tsUs);
+    applyDigital(payload[0], payload[1]);
+}
 
+void PicoLink::applyDigital(uint8_t portA, uint8_t portB)
+{
     // Key state: active-low, bit 5 of port A
     m_state->updateKeyState(!(portA & (1 << 5)));
 
@@ -275,22 +366,198 @@ void PicoLink::handleDigitalPacket(const uint8_t *payload, int len)
 void PicoLink::handleHeartbeatPacket(const uint8_t *payload, int len)
 {
     if (len < 1) return;
+    uint32_t t4 = piClockUs();
     m_lastHeartbeatRecv = QDateTime::currentDateTime();
     m_connected = true;
-    double elapsed = m_lastHeartbeatSent.msecsTo(m_lastHeartbeatRecv);
-    m_state->updatePicoLink(true, qAbs(elapsed), payload[0]);
+
+    double rttMs;
+    if (len >= 13) {
+        // heartbeat_echo_t: seq t1_us t2_us t3_us — echo of our heartbeat
+        uint32_t t1, t2, t3;
+        memcpy(&t1, payload + 1, 4);
+        memcpy(&t2, payload + 5, 4);
+        memcpy(&t3, payload + 9, 4);
+        updateClockSync(t1, t2, t3, t4);
+        rttMs = m_rttUs / 1000.0;
+        m_state->updatePicoClock(m_clockSynced, m_clockDriftPpm, m_sampleLatencyMs);
+    } else if (len >= 5 || m_rttUs > 0) {
+        // Pico's own heartbeat — keep the last measured round trip
+        rttMs = m_rttUs / 1000.0;
+    } else {
+        // Old firmware: 1-byte heartbeats only, no timestamps
+        rttMs = qAbs(m_lastHeartbeatSent.msecsTo(m_lastHeartbeatRecv));
+    }
+    m_state->updatePicoLink(true, rttMs, payload[0]);
     updateTftMode();
 }
 
+uint32_t PicoLink::piClockUs() const
+{
+    return static_cast<uint32_t>(m_clock.nsecsElapsed() / 1000);
+}
+
+// One NTP exchange: t1 Pi send, t2 Pico receive, t3 Pico send, t4 Pi receive.
+// All arithmetic is mod 2^32 so both 71-minute clock wraps are harmless.
+void PicoLink::updateClockSync(uint32_t t1, uint32_t t2, uint32_t t3, uint32_t t4)
+{
+    int32_t rtt = static_cast<int32_t>(t4 - t1) - static_cast<int32_t>(t3 - t2);
+    if (rtt < 0) rtt = 0;
+    m_rttUs = rtt;
+
+    // ((t2 - t1) + (t3 - t4)) / 2, rearranged so nothing overflows
+    uint32_t offset = (t2 - t1) - static_cast<uint32_t>(rtt / 2);
+
+    if (!m_clockSynced) {
+        m_clockOffsetUs = offset;
+        m_clockRefUs    = t4;
+        m_clockDriftPpm = 0.0;
+        m_rttFloorUs    = rtt;
+        m_clockSynced   = true;
+        return;
+    }
+
+    // Queued echoes carry asymmetric delay: only trust exchanges close to
+    // the best RTT seen lately. The floor creeps up so a route change that
+    // raises the RTT for good is accepted after a while.
+    m_rttFloorUs = qMin(rtt, m_rttFloorUs + m_rttFloorUs / 64 + 1);
+    if (rtt > 2 * m_rttFloorUs + 500) return;
+
+    // Phase error against the offset predicted from the drift estimate
+    int32_t dt = static_cast<int32_t>(t4 - m_clockRefUs);
+    if (dt <= 0) return;
+    uint32_t predicted = m_clockOffsetUs +
+                         static_cast<uint32_t>(static_cast<int32_t>(m_clockDriftPpm * dt / 1e6));
+    int32_t err = static_cast<int32_t>(offset - predicted);
+
+    // PLL: small gains because one-way USB delay jitter (~100s of µs)
+    // dominates a 1 s sample; settles in ~30 heartbeats
+    m_clockOffsetUs = predicted + static_cast<uint32_t>(err / 4);
+    m_clockRefUs    = t4;
+    m_clockDriftPpm = qBound(-CLOCK_DRIFT_MAX_PPM,
+                             m_clockDriftPpm + 0.02 * err * 1e6 / dt,
+                             CLOCK_DRIFT_MAX_PPM);
+}
+
+uint32_t PicoLink::picoToPiUs(uint32_t picoUs) const
+{
+    uint32_t piApprox = picoUs - m_clockOffsetUs;
+    int32_t  dt       = static_cast<int32_t>(piApprox - m_clockRefUs);
+    uint32_t offset   = m_clockOffsetUs +
+                        static_cast<uint32_t>(static_cast<int32_t>(m_clockDriftPpm * dt / 1e6));
+    return picoUs - offset;
+}
+
+qint64 PicoLink::picoToEpochMs(uint32_t picoUs) const
+{
+    if (!m_clockSynced) return -1;
+    qint64 nowUs = m_clock.nsecsElapsed() / 1000;
+    int32_t ago  = static_cast<int32_t>(static_cast<uint32_t>(nowUs) - picoToPiUs(picoUs));
+    return m_clockEpochMs + (nowUs - ago) / 1000;
+}
+
+void PicoLink::noteSampleTime(uint32_t picoUs)
+{
+    if (!m_clockSynced) return;
+    double latencyMs = static_cast<int32_t>(piClockUs() - picoToPiUs(picoUs)) / 1000.0;
+    m_sampleLatencyMs = (m_sampleLatencyMs == 0.0)
+                        ? latencyMs : 0.9 * m_sampleLatencyMs + 0.1 * latencyMs;
+}
+
 void PicoLink::handleAlsPacket(const uint8_t *payload, int len)
 {
-    if (len < 8) return;
-    uint32_t luxMilli;
+    // als_packet_t: als_raw white_raw (u16) lux_milli ts_us (u32) = 12 bytes
+    if (len < 12) return;
+    uint32_t luxMilli, tsUs;
     memcpy(&luxMilli, payload + 4, 4);
+    memcpy(&tsUs, payload + 8, 4);
+    noteSampleTime(tsUs);
+    applyAls(luxMilli);
+}
+
+void PicoLink::applyAls(uint32_t luxMilli)
+{
     double lux = luxMilli / 1000.0;
     m_state->updateAlsSensor(lux, 0, 100);
 }
 
+void PicoLink::handleTelemetryPacket(const uint8_t *payload, int len)
+{
+    // telemetry_bundle_t: ts_us(u32) fresh(u8) adc[6](u16) portA portB
+    //                     als_raw(u16) white_raw(u16) lux_milli(u32) = 27 bytes
+    if (len < 27) return;
+    uint32_t tsUs;
+    memcpy(&tsUs, payload, 4);
+    noteSampleTime(tsUs);
+    uint8_t fresh = payload[4];
+
+    if (fresh & TELEM_FRESH_ADC) {
+        uint16_t ch[6];
+        memcpy(ch, payload + 5, 12);
+        applyAdc(ch);
+    }
+    if (fresh & TELEM_FRESH_DIGITAL)
+        applyDigital(payload[17], payload[18]);
+    if (fresh & TELEM_FRESH_ALS) {
+        uint32_t luxMilli;
+        memcpy(&luxMilli, payload + 23, 4);
+        applyAls(luxMilli);
+    }
+}
+
+void PicoLink::handleLinkStatsPacket(const uint8_t *payload, int len)
+{
+    // link_stats_hdr_t (33 bytes): ts_ms(u32) event_hwm event_size bulk_hwm
+    // bulk_size (u16) event_dropped bulk_dropped cdc_short_writes rx_bad_cksum
+    // rx_oversize (u32) n_types(u8), then n_types × link_stats_type_t (21 bytes):
+    // type(u8) enqueued serialized dropped rx_ok rx_rejected (u32)
+    if (len < 33) return;
+    auto u16 = [payload](int off) { uint16_t v; memcpy(&v, payload + off, 2); return v; };
+    auto u32 = [payload](int off) { uint32_t v; memcpy(&v, payload + off, 4); return v; };
+
+    uint16_t eventHwm  = u16(4),  eventSize = u16(6);
+    uint16_t bulkHwm   = u16(8),  bulkSize  = u16(10);
+    uint8_t  nTypes    = payload[32];
+    if (len < 33 + nTypes * 21) return;
+
+    static const QHash<int, QString> names = {
+        {PROTO_TYPE_ADC, "ADC"}, {PROTO_TYPE_DIGITAL, "DIGITAL"},
+        {PROTO_TYPE_LED, "LED"}, {PROTO_TYPE_SCREEN, "SCREEN"},
+        {PROTO_TYPE_HEARTBEAT, "HEARTBEAT"}, {PROTO_TYPE_EVENT, "EVENT"},
+        {0x07, "ERROR"}, {PROTO_TYPE_BRIGHTNESS, "BRIGHTNESS"},
+        {0x09, "MODE"}, {PROTO_TYPE_WARNING, "WARNING"}, {PROTO_TYPE_ALS, "ALS"},
+        {PROTO_TYPE_PERIPH_CMD, "PERIPH_CMD"}, {PROTO_TYPE_PERIPH_DATA, "PERIPH_DATA"},
+        {PROTO_TYPE_PERIPH_STATE, "PERIPH_STATE"}, {PROTO_TYPE_PERIPH_SCREEN, "PERIPH_SCREEN"},
+        {PROTO_TYPE_WORKLIGHT, "WORKLIGHT"}, {PROTO_TYPE_TELEMETRY, "TELEMETRY"},
+        {PROTO_TYPE_LINK_CFG, "LINK_CFG"}, {PROTO_TYPE_LINK_STATS, "LINK_STATS"},
+        {PROTO_TYPE_BATCH, "BATCH"},
+        {PROTO_TYPE_SUBSCRIBE, "SUBSCRIBE"}, {PROTO_TYPE_PERIPH_SCAN, "PERIPH_SCAN"},
+        {PROTO_TYPE_PERIPH_STATS, "PERIPH_STATS"},
+    };
+
+    QVariantList perType;
+    qint64 txDrops = 0;
+    for (int i = 0; i < nTypes; ++i) {
+        int off = 33 + i * 21;
+        int type = payload[off];
+        QVariantMap e;
+        e["type"]       = type;
+        e["name"]       = names.value(type, QString("0x%1").arg(type, 2, 16, QChar('0')));
+        e["enqueued"]   = (qint64)u32(off + 1);
+        e["serialized"] = (qint64)u32(off + 5);
+        e["dropped"]    = (qint64)u32(off + 9);
+        e["rxOk"]       = (qint64)u32(off + 13);
+        e["rxRejected"] = (qint64)u32(off + 17);
+        txDrops += u32(off + 9);
+        perType.append(e);
+    }
+
+    m_state->updatePicoLinkStats((int)u32(12), (int)u32(16), (int)txDrops,
+                                 (int)(u32(24) + u32(28)), (int)u32(20),
+                                 eventSize ? eventHwm * 100 / eventSize : 0,
+                                 bulkSize  ? bulkHwm  * 100 / bulkSize  : 0,
+                                 perType);
+}
+
 void PicoLink::handleEventPacket(const uint8_t *payload, int len)
 {
     if (len < 3) return;
@@ -326,14 +593,42 @@ void PicoLink::handleEventPacket(const uint8_t *payload, int len)
 
 void PicoLink::handlePeriphDataPacket(const uint8_t *payload, int len)
 {
-    if (len < 3) return;
-    uint8_t addr = payload[0];
-    uint8_t cmd = payload[1];
-    uint8_t dataLen = payload[2];
-
-    const uint8_t *data = (dataLen > 0) ? payload + 3 : nullptr;
-    if (dataLen > 0 && len < (3 + dataLen))
-        dataLen = len - 3;
+    // periph_data_t: req_id result addr cmd len payload[len]
+    if (len < 5) return;
+    uint8_t reqId = payload[0];
+    uint8_t result = payload[1];
+    uint8_t addr = payload[2];
+    uint8_t cmd = payload[3];
+    uint8_t dataLen = payload[4];
+
+    const uint8_t *data = (dataLen > 0) ? payload + 5 : nullptr;
+    if (dataLen > 0 && len < (5 + dataLen))
+        dataLen = len - 5;
+
+    // Answer to one of our commands: 0 = the Pico's own polls and streams
+    auto req = m_periphReqs.find(reqId);
+    if (reqId != 0 && req != m_periphReqs.end() && req->fwUpdate) {
+        uint8_t reqAddr = req->addr;
+        uint8_t reqCmd  = req->cmd;
+        m_periphReqs.erase(req);
+        notePeriphRequest(reqAddr);
+        // BOOT_DATA is only ever SENT; the rest carry the slave's answer
+        if (reqCmd != RS485_CMD_BOOT_DATA)
+            fwUpdateReply(reqCmd, data, result == 0 && cmd == reqCmd ? dataLen : -1);
+        return;
+    }
+    if (reqId != 0 && req != m_periphReqs.end()) {
+        static const char *const kResult[] = { "OK", "SENT", "TIMEOUT", "BAD CRC", "NACK" };
+        uint8_t reqAddr = req->addr;
+        QVariantMap info;
+        info["reqLastCmd"]    = req->cmd;
+        info["reqLastResult"] = result < 5 ? kResult[result] : "?";
+        info["reqLastMs"]     = QDateTime::currentMSecsSinceEpoch() - req->sentMs;
+        m_periphReqs.erase(req);
+        notePeriphRequest(reqAddr);
+        m_state->updatePeripheralRequest(reqAddr, info);
+    }
+    if (result != 0) return;
 
     if (addr == 0x01 && dataLen >= 3) {
         QVariantMap deviceData;
@@ -355,6 +650,42 @@ void PicoLink::handlePeriphStatePacket(const uint8_t *payload, int len)
                               online != 0, empty);
 }
 
+void PicoLink::handlePeriphStatsPacket(const uint8_t *payload, int len)
+{
+    // periph_stats_hdr_t (12 bytes): ts_ms baud (u32) lat_base_us (u16)
+    // lat_bins n_periph (u8), then n_periph × periph_stats_entry_t:
+    // addr online (u8) answered timeouts crc_errors timeout_us lat_max_us
+    // (u32) lat_hist[lat_bins] (u32)
+    if (len < 12) return;
+    auto u32 = [payload](int off) { uint32_t v; memcpy(&v, payload + off, 4); return v; };
+
+    uint32_t baud   = u32(4);
+    uint16_t baseUs;
+    memcpy(&baseUs, payload + 8, 2);
+    int bins  = payload[10];
+    int n     = payload[11];
+    int entry = 22 + 4 * bins;
+    if (len < 12 + n * entry) return;
+
+    for (int i = 0; i < n; ++i) {
+        int off = 12 + i * entry;
+        QVariantList hist;
+        for (int b = 0; b < bins; ++b)
+            hist.append((qint64)u32(off + 22 + 4 * b));
+
+        QVariantMap stats;
+        stats["busAnswered"]  = (qint64)u32(off + 2);
+        stats["busTimeouts"]  = (qint64)u32(off + 6);
+        stats["busCrcErrors"] = (qint64)u32(off + 10);
+        stats["busTimeoutMs"] = u32(off + 14) / 1000.0;
+        stats["busLatMaxMs"]  = u32(off + 18) / 1000.0;
+        stats["busLatHist"]   = hist;
+        stats["busLatBaseUs"] = (int)baseUs;
+        stats["busBaud"]      = (qint64)baud;
+        m_state->updatePeripheralStats(payload[off], payload[off + 1] != 0, stats);
+    }
+}
+
 double PicoLink::ntcTocelsius(uint16_t rawAdc) const
 {
     if (rawAdc == 0) return qQNaN();
@@ -385,67 +716,185 @@ int PicoLink::batteryPercent(double voltage) const
     return static_cast<int>(((voltage - BAT_EMPTY_V) / (BAT_FULL_V - BAT_EMPTY_V)) * 100);
 }
 
-int PicoLink::buildFrame(uint8_t *buf, int bufSize, uint8_t type,
-                         const uint8_t *payload, uint16_t payloadLen)
+void PicoLink::sendFrame(uint8_t type, const uint8_t *payload, uint16_t payloadLen)
 {
-    int total = 5 + payloadLen;
-    if (bufSize < total) return -1;
-
-    uint8_t lenLo = (uint8_t)(payloadLen & 0xFF);
-    uint8_t lenHi = (uint8_t)(payloadLen >> 8);
+    if (!m_connected) return;
 
-    buf[0] = PROTO_SOF;
-    buf[1] = type;
-    buf[2] = lenLo;
-    buf[3] = lenHi;
-    if (payloadLen > 0)
-        memcpy(&buf[4], payload, payloadLen);
+    bool batchable = type == PROTO_TYPE_LED || type == PROTO_TYPE_SCREEN ||
+                     type == PROTO_TYPE_BRIGHTNESS || type == PROTO_TYPE_WARNING ||
+                     type == PROTO_TYPE_WORKLIGHT;
+    if (m_batchDepth > 0 && batchable && payloadLen <= 255) {
+        if (m_batch.size() + 2 + payloadLen > PROTO_MAX_PAYLOAD)
+            flushBatch();
+        m_batch.append(static_cast<char>(type));
+        m_batch.append(static_cast<char>(payloadLen));
+        m_batch.append(reinterpret_cast<const char *>(payload), payloadLen);
+        return;
+    }
 
-    uint8_t cksum = type ^ lenLo ^ lenHi;
-    for (uint16_t i = 0; i < payloadLen; i++)
-        cksum ^= payload[i];
-    buf[4 + payloadLen] = cksum;
+    uint8_t buf[PROTO_FRAME_MAX(PROTO_MAX_PAYLOAD)];
+    uint16_t frameLen = proto_encode(buf, sizeof(buf),
+                                     m_cobs ? PROTO_FRAMING_COBS : PROTO_FRAMING_SOF,
+                                     type, payload, payloadLen);
+    if (frameLen > 0)
+        m_serial.write((const char *)buf, frameLen);
+}
 
-    return total;
+// Control commands sent between beginBatch() and endBatch() go out as one
+// BATCH frame, which the Pico applies in a single pass.
+void PicoLink::beginBatch()
+{
+    m_batchDepth++;
 }
 
-void PicoLink::sendFrame(uint8_t type, const uint8_t *payload, uint16_t payloadLen)
+void PicoLink::endBatch()
 {
-    if (!m_connected) return;
+    if (m_batchDepth > 0 && --m_batchDepth == 0)
+        flushBatch();
+}
 
-    uint8_t buf[520];
-    int frameLen = buildFrame(buf, sizeof(buf), type, payload, payloadLen);
-    if (frameLen > 0)
-        m_serial.write((const char *)buf, frameLen);
+void PicoLink::flushBatch()
+{
+    if (m_batch.isEmpty()) return;
+    QByteArray batch;
+    batch.swap(m_batch);
+    int depth = m_batchDepth;
+    m_batchDepth = 0;
+    sendFrame(PROTO_TYPE_BATCH, reinterpret_cast<const uint8_t *>(batch.constData()),
+              batch.size());
+    m_batchDepth = depth;
 }
 
 void PicoLink::onBrightnessChanged(int screenL, int screenR, int led, int tft, int btnLeds)
 {
     if (!m_connected) return;
 
-    uint8_t brightness[10];
-    brightness[0] = 0;
-    brightness[1] = screenL * 255 / 100;
-    brightness[2] = 1;
-    brightness[3] = screenR * 255 / 100;
-    brightness[4] = 2;
-    brightness[5] = tft * 255 / 100;
+    // One BRIGHTNESS command per target — [target][level]
+    uint8_t sk6812[2] = { 0, static_cast<uint8_t>(screenL * 255 / 100) };
+    uint8_t ws2811[2] = { 1, static_cast<uint8_t>(screenR * 255 / 100) };
+    uint8_t tftBlk[2] = { 2, static_cast<uint8_t>(tft * 255 / 100) };
 
-    sendFrame(PROTO_TYPE_BRIGHTNESS, brightness, 6);
+    beginBatch();
+    sendFrame(PROTO_TYPE_BRIGHTNESS, sk6812, 2);
+    sendFrame(PROTO_TYPE_BRIGHTNESS, ws2811, 2);
+    sendFrame(PROTO_TYPE_BRIGHTNESS, tftBlk, 2);
+    endBatch();
 }
 
 void PicoLink::onPeriphCmd(int address, int cmd, const QByteArray &payload)
 {
-    if (!m_connected) return;
+    if (payload.size() > 255) return;
+    sendPeriphRequest(address, cmd, reinterpret_cast<const uint8_t *>(payload.constData()),
+                      payload.size(), false);
+}
+
+bool PicoLink::sendPeriphRequest(uint8_t address, uint8_t cmd, const uint8_t *payload,
+                                 uint8_t len, bool fwUpdate)
+{
+    if (!m_connected) return false;
+
+    expirePeriphRequests();
+    if (m_periphReqs.size() >= 255) return false;
+
+    // Next free id, 1–255
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    while (m_periphReqs.contains(m_periphReqNext) || m_periphReqNext == 0)
+        ++m_periphReqNext;
+    uint8_t reqId = m_periphReqNext++;
+    m_periphReqs.insert(reqId, { address, cmd, now, fwUpdate });
+    notePeriphRequest(address);
+
+    uint8_t buf[4 + 255];
+    buf[0] = reqId;
+    buf[1] = address;
+    buf[2] = cmd;
+    buf[3] = len;
+    if (len > 0)
+        memcpy(&buf[4], payload, len);
+
+    sendFrame(PROTO_TYPE_PERIPH_CMD, buf, 4 + len);
+    return true;
+}
 
-    uint8_t buf[260];
-    buf[0] = address;
-    buf[1] = cmd;
-    buf[2] = payload.size();
-    if (payload.size() > 0)
-        memcpy(&buf[3], payload.constData(), payload.size());
+// Forget requests whose answer was lost, so their ids can be reused. A lost
+// BOOT_BEGIN / STATUS / END is sent again by the update engine.
+void PicoLink::expirePeriphRequests()
+{
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    bool fwLost = false;
+    for (auto it = m_periphReqs.begin(); it != m_periphReqs.end(); ) {
+        if (now - it->sentMs > PERIPH_REQ_EXPIRE_MS) {
+            uint8_t a = it->addr;
+            fwLost |= it->fwUpdate && it->cmd != RS485_CMD_BOOT_DATA;
+            it = m_periphReqs.erase(it);
+            notePeriphRequest(a);
+        } else {
+            ++it;
+        }
+    }
+    if (fwLost && rs485_update_busy(&m_fwUpdate))
+        fwUpdateReply(m_fwUpdate.last_cmd, nullptr, -1);
+}
 
-    sendFrame(PROTO_TYPE_PERIPH_CMD, buf, 3 + payload.size());
+// Start flashing `address` with the image at `path`. The engine sends a
+// window of BOOT_DATA and a BOOT_STATUS at a time; the Pico's command pool
+// holds the lot, so the bus streams while the answers come back here.
+void PicoLink::onPeriphUpdate(int address, const QString &path)
+{
+    QVariantMap info;
+    if (rs485_update_busy(&m_fwUpdate)) {
+        info["fwUpdateState"] = "busy";
+        m_state->updatePeripheralRequest(address, info);
+        return;
+    }
+    QFile f(path);
+    if (!m_connected || !f.open(QIODevice::ReadOnly) || f.size() == 0) {
+        info["fwUpdateState"] = "no image";
+        info["fwUpdatePct"]   = 0;
+        m_state->updatePeripheralRequest(address, info);
+        return;
+    }
+    m_fwImage = f.readAll();
+    m_fwAddr  = static_cast<uint8_t>(address);
+    rs485_update_start(&m_fwUpdate, reinterpret_cast<const uint8_t *>(m_fwImage.constData()),
+                       static_cast<uint32_t>(m_fwImage.size()), 0, &PicoLink::fwUpdateSend, this);
+    fwUpdateReply(0, nullptr, 0);
+}
+
+void PicoLink::fwUpdateSend(void *ctx, uint8_t cmd, const uint8_t *payload, uint8_t len)
+{
+    auto *self = static_cast<PicoLink *>(ctx);
+    self->sendPeriphRequest(self->m_fwAddr, cmd, payload, len, true);
+}
+
+// Feed the engine one answer (len < 0: none) and publish its progress;
+// cmd 0 only publishes
+void PicoLink::fwUpdateReply(uint8_t cmd, const uint8_t *payload, int len)
+{
+    if (cmd != 0)
+        rs485_update_reply(&m_fwUpdate, cmd, payload, len);
+
+    QVariantMap info;
+    info["fwUpdateState"]  = rs485_update_state_name(m_fwUpdate.state);
+    info["fwUpdatePct"]    = rs485_update_percent(&m_fwUpdate);
+    info["fwUpdateResent"] = static_cast<int>(m_fwUpdate.chunks_resent);
+    info["fwUpdateStatus"] = m_fwUpdate.status;   // RS485_BOOT_*, 0xFF no answer
+    m_state->updatePeripheralRequest(m_fwAddr, info);
+
+    if (!rs485_update_busy(&m_fwUpdate))
+        m_fwImage.clear();
+}
+
+// Publish how many commands to addr are still in flight
+void PicoLink::notePeriphRequest(uint8_t addr)
+{
+    int pending = 0;
+    for (const PeriphRequest &r : m_periphReqs)
+        if (r.addr == addr) ++pending;
+
+    QVariantMap info;
+    info["reqPending"] = pending;
+    m_state->updatePeripheralRequest(addr, info);
 }
 
 void PicoLink::updateTftMode()
@@ -483,6 +932,11 @@ void PicoLink::onTftPeriphDetail(int address)
     sendFrame(PROTO_TYPE_PERIPH_SCREEN, &addr, 1);
 }
 
+void PicoLink::onPeriphScan()
+{
+    sendFrame(PROTO_TYPE_PERIPH_SCAN, nullptr, 0);
+}
+
 void PicoLink::handleSwitchLogic(uint8_t portA, uint8_t portB)
 {
     uint8_t changedB = portB ^ m_lastPortB;
@@ -593,6 +1047,8 @@ void PicoLink::updatePayloadLeds()
     bool pay2Arm  = m_state->sw3Pay2Arm();
     bool pay2Fire = m_state->sw3Pay2Fire();
 
+    beginBatch();
+
     // PAY1 — WS2811 button 0
     if (pay1Arm && pay1Fire)
         sendLedCmd(0x01, 0, 255, 0, 0, 1);     // solid red
@@ -608,6 +1064,8 @@ void PicoLink::updatePayloadLeds()
         sendLedCmd(0x01, 1, 255, 100, 0, 2);   // blink slow orange
     else
         sendLedCmd(0x01, 1, 0, 0, 0, 0);       // off
+
+    endBatch();
 }
 
 void PicoLink::onWorklightChanged(bool on, const QColor &color)
@@ -3,7 +3,11 @@
 #include <QSerialPort>
 #include <QTimer>
 #include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
 #include "gcsstate.h"
+#include "proto_codec.h"
+#include "rs485_update.h"
 
 class PicoLink : public QObject {
     Q_OBJECT
@@ -11,6 +15,11 @@ public:
     explicit PicoLink(GCSState *state, QObject *parent = nullptr);
     void start();
 
+    // Map a Pico sample timestamp (time_us_32) to Pi wall-clock ms since
+    // epoch, e.g. to line sensor samples up with MAVLink telemetry.
+    // Returns -1 until the first heartbeat echo has synced the clocks.
+    qint64 picoToEpochMs(uint32_t picoUs) const;
+
 private slots:
     void onReadyRead();
     void onSerialError(QSerialPort::SerialPortError error);
@@ -22,18 +31,40 @@ private slots:
     void onPeriphCmd(int address, int cmd, const QByteArray &payload);
     void onTftScreen(int mode);
     void onTftPeriphDetail(int address);
+    void onPeriphScan();
+    void onPeriphUpdate(int address, const QString &path);
     void onWorklightChanged(bool on, const QColor &color);
 
 private:
     void openPort();
+    void requestCobsFraming();
+    void sendSubscriptions();
+    static bool onFrame(void *ctx, proto_rx_status_t status, uint8_t type,
+                        const uint8_t *payload, uint16_t len);
     void processPacket(uint8_t type, const uint8_t *payload, int len);
     void handleAdcPacket(const uint8_t *payload, int len);
     void handleDigitalPacket(const uint8_t *payload, int len);
     void handleHeartbeatPacket(const uint8_t *payload, int len);
+    void updateClockSync(uint32_t t1, uint32_t t2, uint32_t t3, uint32_t t4);
+    uint32_t piClockUs() const;
+    uint32_t picoToPiUs(uint32_t picoUs) const;
+    void noteSampleTime(uint32_t picoUs);
     void handleAlsPacket(const uint8_t *payload, int len);
+    void handleTelemetryPacket(const uint8_t *payload, int len);
+    void handleLinkStatsPacket(const uint8_t *payload, int len);
     void handleEventPacket(const uint8_t *payload, int len);
     void handlePeriphDataPacket(const uint8_t *payload, int len);
     void handlePeriphStatePacket(const uint8_t *payload, int len);
+    void handlePeriphStatsPacket(const uint8_t *payload, int len);
+    void notePeriphRequest(uint8_t addr);
+    void expirePeriphRequests();
+    bool sendPeriphRequest(uint8_t address, uint8_t cmd, const uint8_t *payload,
+                           uint8_t len, bool fwUpdate);
+    static void fwUpdateSend(void *ctx, uint8_t cmd, const uint8_t *payload, uint8_t len);
+    void fwUpdateReply(uint8_t cmd, const uint8_t *payload, int len);
+    void applyAdc(const uint16_t ch[6]);
+    void applyDigital(uint8_t portA, uint8_t portB);
+    void applyAls(uint32_t luxMilli);
     void handleSwitchLogic(uint8_t portA, uint8_t portB);
     void handleButtonPress(uint16_t buttonId);
     void handleButtonRelease(uint16_t buttonId);
@@ -41,9 +72,10 @@ private:
     void sendMcpLed(uint8_t mask, uint8_t state);
     void updatePayloadLeds();
 
-    int  buildFrame(uint8_t *buf, int bufSize, uint8_t type,
-                    const uint8_t *payload, uint16_t payloadLen);
     void sendFrame(uint8_t type, const uint8_t *payload, uint16_t payloadLen);
+    void beginBatch();
+    void endBatch();
+    void flushBatch();
     void sendWarningsToPane();
     void updateTftMode();
 
@@ -53,7 +85,7 @@ private:
 
     GCSState    *m_state;
     QSerialPort  m_serial;
-    QByteArray   m_rxBuf;
+    proto_parser_t m_parser;
     QTimer       m_heartbeatTimer;
     QTimer       m_cpuTempTimer;
     QTimer       m_statsTimer;
@@ -68,6 +100,36 @@ private:
     uint8_t      m_lastPortB      = 0xFF;
     bool         m_initialSyncDone = false;
     QString      m_previousFlightMode;
+    bool         m_cobs            = false;   // framing in effect (both directions)
+    int          m_linkCfgTries    = 0;
+    QByteArray   m_batch;                     // [type][len][payload] sub-commands
+    int          m_batchDepth      = 0;
+
+    // PERIPH_CMDs in flight, by req_id (1–255); answered by PERIPH_DATA
+    struct PeriphRequest {
+        uint8_t addr;
+        uint8_t cmd;
+        qint64  sentMs;
+        bool    fwUpdate;   // one of m_fwUpdate's frames
+    };
+    QHash<uint8_t, PeriphRequest> m_periphReqs;
+    uint8_t      m_periphReqNext   = 1;
+
+    // Firmware update of one peripheral (Peripherals/Framework/host)
+    rs485_update_t m_fwUpdate      = {};
+    QByteArray   m_fwImage;
+    uint8_t      m_fwAddr          = 0;
+
+    // Heartbeat clock sync (NTP-style). Offsets are Pico − Pi, mod 2^32 µs.
+    QElapsedTimer m_clock;                    // Pi µs clock sent as t1
+    qint64       m_clockEpochMs    = 0;       // wall clock when m_clock started
+    bool         m_clockSynced     = false;
+    uint32_t     m_clockOffsetUs   = 0;       // offset at m_clockRefUs
+    uint32_t     m_clockRefUs      = 0;       // Pi time of the last accepted sample
+    double       m_clockDriftPpm   = 0.0;     // Pico clock rate − Pi clock rate
+    int32_t      m_rttFloorUs      = 0;       // slowly rising minimum RTT
+    int32_t      m_rttUs           = 0;       // RTT of the last echo
+    double       m_sampleLatencyMs = 0.0;     // smoothed Pico capture → Pi receive
 
     static constexpr double ADC_VREF      = 3.3;
     static constexpr double ADC_MAX       = 4095.0;
@@ -79,4 +141,10 @@ private:
     static constexpr double NTC_RFIXED    = 10000.0;
     static constexpr double BAT_FULL_V    = 25.2;
     static constexpr double BAT_EMPTY_V   = 19.8;
+
+    static constexpr bool   REQUEST_COBS  = true;   // negotiate COBS framing on connect
+    static constexpr int    LINK_CFG_MAX_TRIES = 3;
+    static constexpr uint16_t ALS_DEADBAND_LUX = 2;  // ALS change that is worth a frame
+    static constexpr double CLOCK_DRIFT_MAX_PPM = 500.0;
+    static constexpr qint64 PERIPH_REQ_EXPIRE_MS = 5000;  // Pico answers far sooner
 };
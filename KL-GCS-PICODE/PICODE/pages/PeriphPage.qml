@@ -43,6 +43,14 @@ Rectangle {
                         anchors { fill: parent; leftMargin: 11; rightMargin: 10 }
                         Text { text: "DEVICES"; color: Theme.textSecondary; font.pixelSize: Theme.fontPageTitle; font.weight: Font.SemiBold; font.letterSpacing: 0.8; Layout.fillWidth: true }
                         Text { text: onlineCount + "/" + GCSState.peripherals.length; color: Theme.accentBlue; font.pixelSize: Theme.fontPageTitle; font.weight: Font.SemiBold }
+                        Rectangle {
+                            width: 52; height: 22; radius: 4
+                            color: scanMa.pressed ? Qt.rgba(0.89, 0.82, 0.29, 0.10) : "transparent"
+                            border.color: scanMa.pressed ? Theme.accentYellow : Theme.border
+                            border.width: 1
+                            Text { anchors.centerIn: parent; text: "SCAN"; color: Theme.textSecondary; font.pixelSize: Theme.fontSectionLabel; font.weight: Font.Medium }
+                            MouseArea { id: scanMa; anchors.fill: parent; onClicked: GCSState.sendPeriphScan() }
+                        }
                     }
                 }
                 Rectangle { Layout.fillWidth: true; height: 1; color: Theme.border }
@@ -163,6 +171,43 @@ Rectangle {
                         }
                     }
                 }
+
+                Rectangle { Layout.fillWidth: true; height: 1; color: Theme.border }
+
+                // Pico CDC link health (LINK_STATS, 1 Hz)
+                ColumnLayout {
+                    Layout.fillWidth: true
+                    Layout.margins: 8
+                    spacing: 3
+
+                    RowLayout {
+                        Layout.fillWidth: true
+                        Text { text: "PICO LINK"; color: Theme.textSecondary; font.pixelSize: Theme.fontSectionLabel; font.weight: Font.SemiBold; font.letterSpacing: 0.8; Layout.fillWidth: true }
+                        StatusDot {
+                            level: !GCSState.picoConnected ? -1
+                                   : (GCSState.picoEventDrops > 0 ? 2
+                                   : (GCSState.picoTxDrops > 0 || GCSState.picoRxRejects > 0 ? 1 : 0))
+                        }
+                    }
+
+                    Repeater {
+                        model: [
+                            { label: "EVENT DROPS", value: GCSState.picoEventDrops },
+                            { label: "TX DROPS",    value: GCSState.picoTxDrops },
+                            { label: "RX REJECTS",  value: GCSState.picoRxRejects },
+                            { label: "SHORT WRITES", value: GCSState.picoShortWrites },
+                            { label: "LANE PEAK",   value: GCSState.picoEventLanePeak + "% / " + GCSState.picoBulkLanePeak + "%" },
+                            { label: "RTT",         value: GCSState.picoHeartbeatMs.toFixed(2) + " ms" },
+                            { label: "SAMPLE AGE",  value: GCSState.picoClockSynced ? GCSState.picoSampleLatencyMs.toFixed(1) + " ms" : "—" },
+                            { label: "CLOCK DRIFT", value: GCSState.picoClockSynced ? GCSState.picoClockDriftPpm.toFixed(1) + " ppm" : "—" }
+                        ]
+                        RowLayout {
+                            Layout.fillWidth: true
+                            Text { text: modelData.label; color: Theme.textDisabled; font.pixelSize: Theme.fontSectionLabel; Layout.fillWidth: true }
+                            Text { text: modelData.value; color: Theme.textPrimary; font.pixelSize: Theme.fontSectionLabel; font.family: "monospace" }
+                        }
+                    }
+                }
             }
         }
 
@@ -240,6 +285,129 @@ Rectangle {
                     }
                 }
 
+                Rectangle { Layout.fillWidth: true; height: 1; color: Theme.border }
+
+                // RS-485 transactions with this device (PERIPH_STATS, 1 Hz)
+                ColumnLayout {
+                    id: busStats
+                    Layout.fillWidth: true
+                    spacing: 4
+                    visible: selectedDevice !== null && selectedDevice.busLatHist !== undefined
+
+                    readonly property var hist: visible ? selectedDevice.busLatHist : []
+                    readonly property int histMax: {
+                        var m = 0
+                        for (var i = 0; i < hist.length; i++) m = Math.max(m, hist[i])
+                        return m
+                    }
+
+                    // Upper edge of latency bin i; the last bin is open-ended
+                    function binLabel(i) {
+                        var us = selectedDevice.busLatBaseUs * Math.pow(2, i === hist.length - 1 ? i - 1 : i)
+                        var t  = us >= 1000 ? (us / 1000).toFixed(us >= 10000 ? 0 : 1) + "m" : us + "µ"
+                        return (i === hist.length - 1 ? ">" : "<") + t
+                    }
+
+                    RowLayout {
+                        Layout.fillWidth: true; spacing: 16
+                        Text { text: "BUS"; color: Theme.textSecondary; font.pixelSize: Theme.fontSectionLabel; font.weight: Font.SemiBold; font.letterSpacing: 0.8 }
+                        Repeater {
+                            model: busStats.visible ? [
+                                { label: "OK",       value: selectedDevice.busAnswered },
+                                { label: "TIMEOUTS", value: selectedDevice.busTimeouts },
+                                { label: "CRC ERR",  value: selectedDevice.busCrcErrors },
+                                { label: "MAX",      value: selectedDevice.busLatMaxMs.toFixed(2) + " ms" },
+                                { label: "TIMEOUT",  value: selectedDevice.busTimeoutMs.toFixed(1) + " ms" }
+                            ] : []
+                            RowLayout {
+                                spacing: 5
+                                Text { text: modelData.label; color: Theme.textDisabled; font.pixelSize: Theme.fontSectionLabel }
+                                Text { text: modelData.value; color: Theme.textPrimary; font.pixelSize: Theme.fontSectionLabel; font.family: "monospace" }
+                            }
+                        }
+                        Item { Layout.fillWidth: true }
+                    }
+
+                    // Latency histogram, send done → CRC valid
+                    RowLayout {
+                        Layout.fillWidth: true; height: 56; spacing: 3
+                        Repeater {
+                            model: busStats.hist.length
+                            ColumnLayout {
+                                Layout.fillWidth: true; Layout.preferredWidth: 1
+                                spacing: 2
+                                Item {
+                                    Layout.fillWidth: true; Layout.preferredHeight: 40
+                                    Rectangle {
+                                        anchors { left: parent.left; right: parent.right; bottom: parent.bottom }
+                                        height: busStats.histMax > 0 ? Math.max(busStats.hist[index] > 0 ? 1 : 0,
+                                                                                parent.height * busStats.hist[index] / busStats.histMax) : 0
+                                        radius: 2
+                                        color: Theme.accentBlue
+                                    }
+                                }
+                                Text {
+                                    Layout.alignment: Qt.AlignHCenter
+                                    text: busStats.binLabel(index)
+                                    color: Theme.textDisabled; font.pixelSize: 9; font.family: "monospace"
+                                }
+                            }
+                        }
+                    }
+                }
+
+                // Outcome of the last command sent to this device
+                RowLayout {
+                    Layout.fillWidth: true; spacing: 16
+                    visible: selectedDevice !== null && selectedDevice.reqLastResult !== undefined
+                    Text { text: "LAST CMD"; color: Theme.textSecondary; font.pixelSize: Theme.fontSectionLabel; font.weight: Font.SemiBold; font.letterSpacing: 0.8 }
+                    Repeater {
+                        model: parent.visible ? [
+                            { label: "CMD",     value: "0x" + selectedDevice.reqLastCmd.toString(16).toUpperCase().padStart(2, '0') },
+                            { label: "RESULT",  value: selectedDevice.reqLastResult },
+                            { label: "RTT",     value: selectedDevice.reqLastMs + " ms" },
+                            { label: "PENDING", value: selectedDevice.reqPending }
+                        ] : []
+                        RowLayout {
+                            spacing: 5
+                            Text { text: modelData.label; color: Theme.textDisabled; font.pixelSize: Theme.fontSectionLabel }
+                            Text {
+                                text: modelData.value
+                                color: modelData.label === "RESULT" && modelData.value !== "OK" && modelData.value !== "SENT"
+                                       ? Theme.statusCrit : Theme.textPrimary
+                                font.pixelSize: Theme.fontSectionLabel; font.family: "monospace"
+                            }
+                        }
+                    }
+                    Item { Layout.fillWidth: true }
+                }
+
+                // Firmware update over the bus (GCSState.startPeriphUpdate)
+                RowLayout {
+                    Layout.fillWidth: true; spacing: 16
+                    visible: selectedDevice !== null && selectedDevice.fwUpdateState !== undefined
+                    Text { text: "FIRMWARE"; color: Theme.textSecondary; font.pixelSize: Theme.fontSectionLabel; font.weight: Font.SemiBold; font.letterSpacing: 0.8 }
+                    Text {
+                        text: parent.visible ? selectedDevice.fwUpdateState.toUpperCase() : ""
+                        color: parent.visible && (selectedDevice.fwUpdateState === "failed" || selectedDevice.fwUpdateState === "no image")
+                               ? Theme.statusCrit : Theme.textPrimary
+                        font.pixelSize: Theme.fontSectionLabel; font.family: "monospace"
+                    }
+                    Rectangle {
+                        Layout.fillWidth: true; height: 6; radius: 3
+                        color: Theme.bgElevated
+                        Rectangle {
+                            width: parent.width * ((selectedDevice && selectedDevice.fwUpdatePct) || 0) / 100
+                            height: parent.height; radius: 3
+                            color: Theme.accentBlue
+                        }
+                    }
+                    Text {
+                        text: parent.visible ? ((selectedDevice.fwUpdatePct || 0) + " %") : ""
+                        color: Theme.textPrimary; font.pixelSize: Theme.fontSectionLabel; font.family: "monospace"
+                    }
+                }
+
                 // Command buttons
                 RowLayout {
                     Layout.fillWidth: true; spacing: 6
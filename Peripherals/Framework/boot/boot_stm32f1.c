@@ -0,0 +1,113 @@
+/*
+ * STM32F103 bootloader for firmware update over the RS-485 bus.
+ *
+ * Sits in the first HAL_STM32F1_APP_ADDR - 0x08000000 bytes of flash,
+ * ahead of the app (stm32f1.cmake, PERIPH_BOOTLOADER). The app receives a
+ * new image into the staging slot (core/rs485_boot.c), marks the slot's
+ * record ready and resets; this copies the image over the app, marks it
+ * installed and starts it. A reset part-way through the copy just copies
+ * again, so the old app is never left half-replaced without a good image
+ * to finish from. Runs on the reset clock (HSI 8 MHz), no interrupts.
+ */
+
+#include "stm32f1xx.h"
+#include "rs485_boot.h"
+#include "crc32.h"
+
+#ifndef HAL_STM32F1_APP_ADDR
+#define HAL_STM32F1_APP_ADDR    0x08001000u
+#endif
+#ifndef HAL_STM32F1_SLOT_ADDR
+#define HAL_STM32F1_SLOT_ADDR   0x08010000u
+#endif
+#ifndef HAL_STM32F1_SLOT_SIZE
+#define HAL_STM32F1_SLOT_SIZE   0x00010000u
+#endif
+#define FLASH_PAGE              1024u
+
+#define FLASH_UNLOCK_KEY1       0x45670123u
+#define FLASH_UNLOCK_KEY2       0xCDEF89ABu
+
+#define APP_MAX                 (HAL_STM32F1_SLOT_ADDR - HAL_STM32F1_APP_ADDR)
+
+static bool flash_wait(void)
+{
+    while (FLASH->SR & FLASH_SR_BSY) { }
+    bool ok = !(FLASH->SR & (FLASH_SR_PGERR | FLASH_SR_WRPRTERR));
+    FLASH->SR = FLASH_SR_EOP | FLASH_SR_PGERR | FLASH_SR_WRPRTERR;
+    return ok;
+}
+
+static bool flash_erase(uint32_t addr)
+{
+    FLASH->CR |= FLASH_CR_PER;
+    FLASH->AR  = addr;
+    FLASH->CR |= FLASH_CR_STRT;
+    bool ok = flash_wait();
+    FLASH->CR &= ~FLASH_CR_PER;
+    return ok;
+}
+
+static bool flash_program(uint32_t addr, const uint16_t *src, uint32_t halfwords)
+{
+    volatile uint16_t *dst = (volatile uint16_t *)addr;
+    bool ok = true;
+    FLASH->CR |= FLASH_CR_PG;
+    for (uint32_t i = 0; i < halfwords && ok; i++) {
+        if (src[i] == 0xFFFFu) continue;
+        dst[i] = src[i];
+        ok = flash_wait();
+    }
+    FLASH->CR &= ~FLASH_CR_PG;
+    return ok;
+}
+
+/* Copy the staged image over the app, page by page, and check it landed */
+static bool install(const rs485_boot_record_t *rec)
+{
+    const uint8_t *slot = (const uint8_t *)HAL_STM32F1_SLOT_ADDR;
+    for (uint32_t off = 0; off < rec->size; off += FLASH_PAGE) {
+        uint32_t n = (rec->size - off < FLASH_PAGE) ? rec->size - off : FLASH_PAGE;
+        if (!flash_erase(HAL_STM32F1_APP_ADDR + off) ||
+            !flash_program(HAL_STM32F1_APP_ADDR + off,
+                           (const uint16_t *)&slot[off], (n + 1u) / 2u)) {
+            return false;
+        }
+    }
+    return crc32((const uint8_t *)HAL_STM32F1_APP_ADDR, rec->size) == rec->crc32;
+}
+
+static void start_app(void)
+{
+    const uint32_t *vt = (const uint32_t *)HAL_STM32F1_APP_ADDR;
+
+    /* Erased or not an app (initial SP outside SRAM): nothing to run */
+    if ((vt[0] & 0x2FFE0000u) != 0x20000000u) {
+        for (;;) { }
+    }
+    SCB->VTOR = HAL_STM32F1_APP_ADDR;
+    __set_MSP(vt[0]);
+    ((void (*)(void))vt[1])();
+}
+
+int main(void)
+{
+    const rs485_boot_record_t *rec = (const rs485_boot_record_t *)
+        (HAL_STM32F1_SLOT_ADDR + HAL_STM32F1_SLOT_SIZE - FLASH_PAGE);
+
+    if (rec->magic == RS485_BOOT_MAGIC && rec->ready == RS485_BOOT_MARK &&
+        rec->installed != RS485_BOOT_MARK && rec->size <= APP_MAX &&
+        crc32((const uint8_t *)HAL_STM32F1_SLOT_ADDR, rec->size) == rec->crc32) {
+        FLASH->KEYR = FLASH_UNLOCK_KEY1;
+        FLASH->KEYR = FLASH_UNLOCK_KEY2;
+        if (!install(rec)) {
+            /* The app is part-copied: never run it, go round again */
+            NVIC_SystemReset();
+        }
+        static const uint16_t mark = RS485_BOOT_MARK;
+        flash_program((uint32_t)&rec->installed, &mark, 1);
+        FLASH->CR |= FLASH_CR_LOCK;
+    }
+    start_app();
+    return 0;
+}
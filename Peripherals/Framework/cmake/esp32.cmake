@@ -33,7 +33,9 @@ function(_peripheral_esp32 NAME SOURCES)
         REQUIRES
             driver
             esp_timer
+            app_update
     )
+    target_compile_options(${COMPONENT_LIB} PRIVATE ${PERIPH_C_FLAGS})
     # The IDF flow produces NAME.bin/elf via idf.py build — no extra
     # post-build step needed here.
 endfunction()
@@ -1,7 +1,7 @@
 # RS-485 peripheral slave framework — top-level CMake entry point.
 #
 # Apps include this file and call:
-#   add_peripheral(NAME <app> MCU <stm32f1|rp2040|esp32> SOURCES <files…>)
+#   add_peripheral(NAME <app> MCU <stm32f1|rp2040|esp32|posix> SOURCES <files…>)
 #
 # The MCU dispatcher pulls in the per-MCU toolchain + SDK and adds the
 # framework's portable core + the matching HAL.
@@ -11,6 +11,8 @@ set(PERIPH_CMAKE_DIR     ${CMAKE_CURRENT_LIST_DIR}    CACHE INTERNAL "")
 
 set(PERIPH_CORE_SOURCES
     ${PERIPH_FRAMEWORK_DIR}/core/crc8.c
+    ${PERIPH_FRAMEWORK_DIR}/core/crc32.c
+    ${PERIPH_FRAMEWORK_DIR}/core/rs485_boot.c
     ${PERIPH_FRAMEWORK_DIR}/core/rs485_slave.c
     CACHE INTERNAL ""
 )
@@ -19,13 +21,16 @@ set(PERIPH_CORE_INCLUDES
     ${PERIPH_FRAMEWORK_DIR}/hal
     CACHE INTERNAL ""
 )
+# Every back-end compiles the app with these: a CMD listed twice in a
+# RS485_DISPATCH_TABLE is an error, not a silently dropped handler
+set(PERIPH_C_FLAGS -Werror=override-init CACHE INTERNAL "")
 
 # The MCU backend must be loaded BEFORE project() so that toolchain
 # variables (CMAKE_C_COMPILER etc.) are in place when CMake probes the
 # compiler. App CMakeLists.txt include framework.cmake before project(),
 # so dispatch on TARGET_MCU here.
 if(NOT DEFINED TARGET_MCU)
-    set(TARGET_MCU stm32f1 CACHE STRING "Target MCU (stm32f1 | rp2040 | esp32)")
+    set(TARGET_MCU stm32f1 CACHE STRING "Target MCU (stm32f1 | rp2040 | esp32 | posix)")
 endif()
 
 if(TARGET_MCU STREQUAL "rp2040")
@@ -34,9 +39,11 @@ elseif(TARGET_MCU STREQUAL "stm32f1")
     include(${PERIPH_CMAKE_DIR}/stm32f1.cmake)
 elseif(TARGET_MCU STREQUAL "esp32")
     include(${PERIPH_CMAKE_DIR}/esp32.cmake)
+elseif(TARGET_MCU STREQUAL "posix")
+    include(${PERIPH_CMAKE_DIR}/posix.cmake)
 else()
     message(FATAL_ERROR "framework.cmake: unknown TARGET_MCU '${TARGET_MCU}' "
-                        "(expected rp2040 | stm32f1 | esp32)")
+                        "(expected rp2040 | stm32f1 | esp32 | posix)")
 endif()
 
 function(add_peripheral)
@@ -0,0 +1,24 @@
+# POSIX backend for the peripheral framework.
+#
+# Builds the app as a Linux executable with the host compiler. Its UART
+# is a node on the virtual RS-485 bus (host/vbus.h): start the hub
+# (host/vbus_hub.c, built by Testcode/VirtualBus) first, then any number
+# of apps and the master, all on the same $RS485_VBUS socket. For
+# bench-testing the protocol and the apps' logic, not timing-exact.
+
+function(_peripheral_posix NAME SOURCES)
+    # After project(): FindThreads needs the C compiler probed
+    find_package(Threads REQUIRED)
+    add_executable(${NAME}
+        ${SOURCES}
+        ${PERIPH_CORE_SOURCES}
+        ${PERIPH_FRAMEWORK_DIR}/hal/hal_posix.c
+        ${PERIPH_FRAMEWORK_DIR}/host/vbus.c
+    )
+    target_include_directories(${NAME} PRIVATE
+        ${PERIPH_CORE_INCLUDES}
+        ${PERIPH_FRAMEWORK_DIR}/host
+    )
+    target_compile_options(${NAME} PRIVATE -Wall -Wextra ${PERIPH_C_FLAGS})
+    target_link_libraries(${NAME} Threads::Threads)
+endfunction()
@@ -36,11 +36,14 @@ function(_peripheral_rp2040 NAME SOURCES)
         ${PERIPH_FRAMEWORK_DIR}/hal/hal_rp2040.c
     )
     target_include_directories(${NAME} PRIVATE ${PERIPH_CORE_INCLUDES})
+    target_compile_options(${NAME} PRIVATE ${PERIPH_C_FLAGS})
     target_link_libraries(${NAME}
         pico_stdlib
         hardware_uart
         hardware_gpio
         hardware_pwm
+        hardware_flash
+        hardware_sync
     )
     pico_add_extra_outputs(${NAME})   # produces NAME.uf2
 endfunction()
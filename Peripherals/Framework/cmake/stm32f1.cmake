@@ -47,6 +47,62 @@ set(STM32F1_STARTUP    ${STM32F1_DEVICE_DIR}/Source/Templates/gcc/startup_stm32f
 set(STM32F1_LINKER     ${STM32F1_DEVICE_DIR}/Source/Templates/gcc/linker/STM32F103XB_FLASH.ld)
 set(STM32F1_SYSTEM     ${STM32F1_DEVICE_DIR}/Source/Templates/system_stm32f1xx.c)
 
+# Firmware update over the bus. ON: flash is bootloader | app | staging
+# slot; each app is linked at STM32F1_APP_ADDR and gets a <name>_boot
+# target (boot/boot_stm32f1.c) for the start of flash. Program both once
+# with a programmer — the .hex files carry their addresses — and later
+# images go over RS-485. OFF by default: an ON app doesn't boot without
+# its <name>_boot image, and the default slot sits in the upper 64 KB,
+# which the C8T6 has but doesn't guarantee. Set STM32F1_FLASH_SIZE to
+# 0x20000 for such parts (or a CB), or move the slot below 64 KB. The
+# slot's last page is the update's progress record.
+option(PERIPH_BOOTLOADER "Link stm32f1 apps behind the RS-485 bootloader" OFF)
+set(STM32F1_FLASH_SIZE 0x10000   CACHE STRING "Flash bytes the part guarantees")
+set(STM32F1_BOOT_SIZE 0x1000     CACHE STRING "Bootloader bytes at 0x08000000")
+set(STM32F1_SLOT_ADDR 0x08010000 CACHE STRING "Staging slot address")
+set(STM32F1_SLOT_SIZE 0x10000    CACHE STRING "Staging slot bytes")
+
+math(EXPR STM32F1_APP_ADDR "0x08000000 + ${STM32F1_BOOT_SIZE}" OUTPUT_FORMAT HEXADECIMAL)
+math(EXPR STM32F1_APP_SIZE "${STM32F1_SLOT_ADDR} - ${STM32F1_APP_ADDR}")
+math(EXPR STM32F1_BOOT_LEN "${STM32F1_BOOT_SIZE}")
+
+if(PERIPH_BOOTLOADER)
+    math(EXPR slot_end  "${STM32F1_SLOT_ADDR} + ${STM32F1_SLOT_SIZE}")
+    math(EXPR flash_end "0x08000000 + ${STM32F1_FLASH_SIZE}")
+    if(slot_end GREATER flash_end)
+        math(EXPR slot_end  "${slot_end}"  OUTPUT_FORMAT HEXADECIMAL)
+        math(EXPR flash_end "${flash_end}" OUTPUT_FORMAT HEXADECIMAL)
+        message(FATAL_ERROR "stm32f1.cmake: staging slot ends at ${slot_end}, "
+            "past the end of flash at ${flash_end} (STM32F1_FLASH_SIZE). "
+            "Move STM32F1_SLOT_ADDR/STM32F1_SLOT_SIZE, or raise "
+            "STM32F1_FLASH_SIZE if the part really has the flash.")
+    endif()
+    if(NOT STM32F1_APP_SIZE GREATER 0)
+        message(FATAL_ERROR "stm32f1.cmake: STM32F1_SLOT_ADDR leaves no room "
+            "for the app after the ${STM32F1_BOOT_SIZE}-byte bootloader")
+    endif()
+endif()
+
+# The stock linker script with its FLASH region moved
+function(_stm32f1_linker_script OUT ORIGIN LENGTH)
+    file(READ ${STM32F1_LINKER} ld)
+    string(REGEX REPLACE "FLASH[ \t]*\\(rx\\)[ \t]*:[^\n]*"
+           "FLASH (rx) : ORIGIN = ${ORIGIN}, LENGTH = ${LENGTH}" moved "${ld}")
+    if(moved STREQUAL ld)
+        message(FATAL_ERROR "stm32f1.cmake: no FLASH (rx) region in ${STM32F1_LINKER}")
+    endif()
+    file(WRITE ${OUT} "${moved}")
+endfunction()
+
+function(_stm32f1_outputs NAME)
+    set_target_properties(${NAME} PROPERTIES SUFFIX ".elf")
+    add_custom_command(TARGET ${NAME} POST_BUILD
+        COMMAND ${CMAKE_OBJCOPY} -O binary $<TARGET_FILE:${NAME}> ${NAME}.bin
+        COMMAND ${CMAKE_OBJCOPY} -O ihex   $<TARGET_FILE:${NAME}> ${NAME}.hex
+        COMMENT "Generating ${NAME}.bin / ${NAME}.hex"
+    )
+endfunction()
+
 function(_peripheral_stm32f1 NAME SOURCES)
     add_executable(${NAME}
         ${SOURCES}
@@ -56,22 +112,51 @@ function(_peripheral_stm32f1 NAME SOURCES)
         ${STM32F1_SYSTEM}
     )
     target_compile_definitions(${NAME} PRIVATE STM32F103xB)
-    target_compile_options(${NAME} PRIVATE ${STM32_CFLAGS})
+    target_compile_options(${NAME} PRIVATE ${STM32_CFLAGS} ${PERIPH_C_FLAGS})
     target_include_directories(${NAME} PRIVATE
         ${PERIPH_CORE_INCLUDES}
         ${cmsis_core_SOURCE_DIR}/CMSIS/Core/Include
         ${STM32F1_DEVICE_DIR}/Include
     )
+
+    set(linker ${STM32F1_LINKER})
+    if(PERIPH_BOOTLOADER)
+        set(linker ${CMAKE_CURRENT_BINARY_DIR}/${NAME}_app.ld)
+        _stm32f1_linker_script(${linker} ${STM32F1_APP_ADDR} ${STM32F1_APP_SIZE})
+        set(layout
+            HAL_STM32F1_APP_ADDR=${STM32F1_APP_ADDR}u
+            HAL_STM32F1_SLOT_ADDR=${STM32F1_SLOT_ADDR}u
+            HAL_STM32F1_SLOT_SIZE=${STM32F1_SLOT_SIZE}u
+        )
+        target_compile_definitions(${NAME} PRIVATE ${layout})
+
+        set(boot_ld ${CMAKE_CURRENT_BINARY_DIR}/${NAME}_boot.ld)
+        _stm32f1_linker_script(${boot_ld} 0x08000000 ${STM32F1_BOOT_LEN})
+        add_executable(${NAME}_boot
+            ${PERIPH_FRAMEWORK_DIR}/boot/boot_stm32f1.c
+            ${PERIPH_FRAMEWORK_DIR}/core/crc32.c
+            ${STM32F1_STARTUP}
+            ${STM32F1_SYSTEM}
+        )
+        target_compile_definitions(${NAME}_boot PRIVATE STM32F103xB ${layout})
+        target_compile_options(${NAME}_boot PRIVATE ${STM32_CFLAGS})
+        target_include_directories(${NAME}_boot PRIVATE
+            ${PERIPH_CORE_INCLUDES}
+            ${cmsis_core_SOURCE_DIR}/CMSIS/Core/Include
+            ${STM32F1_DEVICE_DIR}/Include
+        )
+        target_link_options(${NAME}_boot PRIVATE
+            ${STM32_LDFLAGS}
+            -T${boot_ld}
+            -Wl,-Map=${NAME}_boot.map
+        )
+        _stm32f1_outputs(${NAME}_boot)
+    endif()
+
     target_link_options(${NAME} PRIVATE
         ${STM32_LDFLAGS}
-        -T${STM32F1_LINKER}
+        -T${linker}
         -Wl,-Map=${NAME}.map
     )
-    set_target_properties(${NAME} PROPERTIES SUFFIX ".elf")
-
-    add_custom_command(TARGET ${NAME} POST_BUILD
-        COMMAND ${CMAKE_OBJCOPY} -O binary $<TARGET_FILE:${NAME}> ${NAME}.bin
-        COMMAND ${CMAKE_OBJCOPY} -O ihex   $<TARGET_FILE:${NAME}> ${NAME}.hex
-        COMMENT "Generating ${NAME}.bin / ${NAME}.hex"
-    )
+    _stm32f1_outputs(${NAME})
 endfunction()
@@ -0,0 +1,29 @@
+#include "crc32.h"
+
+/* Reflected polynomial 0xEDB88320, init and final XOR 0xFFFFFFFF.
+
+   Four bits per lookup: the 16-entry table costs 64 bytes of flash where
+   a byte-wide one would cost 1 KB, and is still fast enough to check a
+   whole image on a Cortex-M3 in a few ms. */
+static const uint32_t crc32_nibble[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+    0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+    0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+};
+
+uint32_t crc32_update(uint32_t crc, const uint8_t *data, size_t len)
+{
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        crc = (crc >> 4) ^ crc32_nibble[crc & 0x0F];
+        crc = (crc >> 4) ^ crc32_nibble[crc & 0x0F];
+    }
+    return ~crc;
+}
+
+uint32_t crc32(const uint8_t *data, size_t len)
+{
+    return crc32_update(0, data, len);
+}
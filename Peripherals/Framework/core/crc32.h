@@ -0,0 +1,25 @@
+#ifndef RS485_CRC32_H
+#define RS485_CRC32_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* CRC-32 (IEEE 802.3, as zlib and `crc32` compute it) for firmware update
+   chunks and images. Shared by the slave framework (rs485_boot.c, the
+   bootloader) and the host side (host/rs485_update.c). */
+
+/* Continue a CRC over more data; start from 0. crc32_update(0, a, n) ==
+   crc32(a, n), and feeding the image piecewise gives the same result. */
+uint32_t crc32_update(uint32_t crc, const uint8_t *data, size_t len);
+
+uint32_t crc32(const uint8_t *data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
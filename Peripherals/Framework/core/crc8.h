@@ -8,6 +8,21 @@
 extern "C" {
 #endif
 
+/* CRC-8/MAXIM of the frame bytes after SOF. Shared by the slave framework,
+   the GCS master (GCS/src/rs485.c) and MODBUSTester. */
+
+#define CRC8_INIT   0x00
+
+extern const uint8_t crc8_table[256];
+
+/* Fold one byte into a running CRC — receivers call this per byte as it
+   arrives (starting from CRC8_INIT), so the check at the CRC byte is a
+   compare rather than a second pass over the frame. */
+static inline uint8_t crc8_update(uint8_t crc, uint8_t b)
+{
+    return crc8_table[crc ^ b];
+}
+
 uint8_t crc8(const uint8_t *data, size_t len);
 
 #ifdef __cplusplus
@@ -0,0 +1,240 @@
+#include "rs485_boot.h"
+#include "crc32.h"
+#include "../hal/hal.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#if (RS485_BOOT_CHUNK & 1) || RS485_BOOT_CHUNK + 8 > RS485_MAX_PAYLOAD
+#error "RS485_BOOT_CHUNK must be even and fit a BOOT_DATA frame"
+#endif
+#if RS485_BOOT_WINDOW < 1 || RS485_BOOT_WINDOW > 32
+#error "RS485_BOOT_WINDOW must be 1..32 (the BOOT_STATUS have-mask is 32 bits)"
+#endif
+
+/* ------------------------------------------------------------------ */
+/* Internal state                                                       */
+/* ------------------------------------------------------------------ */
+
+static bool        s_active;           /* BEGIN accepted, END not yet */
+static bool        s_install;          /* END checked out: install after reply */
+static uint32_t    s_size, s_crc;      /* image, from BEGIN */
+static uint32_t    s_page;             /* hal_flash_page_size() */
+static uint32_t    s_rec_off;          /* progress record: last slot page */
+static uint32_t    s_base;             /* image bytes written and verified */
+static uint32_t    s_erased_to;        /* slot erased from s_base up to here */
+
+/* Window: chunk i from s_base lives in s_win[(s_head + i) % WINDOW] */
+static uint32_t    s_have;             /* bit i: chunk i has arrived */
+static uint8_t     s_head;
+static uint8_t     s_win[RS485_BOOT_WINDOW][RS485_BOOT_CHUNK];
+
+#define REC_FIELD(f)    (s_rec_off + (uint32_t)offsetof(rs485_boot_record_t, f))
+
+static uint32_t get_u32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static bool mark(uint32_t off)
+{
+    static const uint8_t m[2] = { (uint8_t)RS485_BOOT_MARK, (uint8_t)(RS485_BOOT_MARK >> 8) };
+    return hal_flash_write(off, m, sizeof(m));
+}
+
+static uint32_t chunk_len(uint32_t off)
+{
+    return (s_size - off < RS485_BOOT_CHUNK) ? s_size - off : RS485_BOOT_CHUNK;
+}
+
+/* ------------------------------------------------------------------ */
+/* Commands                                                             */
+/* ------------------------------------------------------------------ */
+
+/* Same image as the record's unfinished session: pick up after the last
+   page that was written whole. Anything else starts a new record. */
+static uint8_t boot_begin(uint32_t size, uint32_t crc)
+{
+    uint32_t slot = hal_flash_slot_size();
+    s_active = false;
+    if (!slot) return RS485_BOOT_ERR_UNSUPPORTED;
+
+    s_page    = hal_flash_page_size();
+    s_rec_off = slot - s_page;
+    uint32_t pages = (size + s_page - 1) / s_page;
+    if (size == 0 || size > s_rec_off ||
+        sizeof(rs485_boot_record_t) + 2u * pages > s_page) {
+        return RS485_BOOT_ERR_TOO_BIG;
+    }
+
+    rs485_boot_record_t rec;
+    hal_flash_read(s_rec_off, (uint8_t *)&rec, sizeof(rec));
+    s_base = 0;
+    if (rec.magic == RS485_BOOT_MAGIC && rec.size == size && rec.crc32 == crc &&
+        rec.ready != RS485_BOOT_MARK) {
+        for (uint32_t i = 0; i < pages; i++) {
+            uint16_t done;
+            hal_flash_read(REC_FIELD(page_done) + 2u * i, (uint8_t *)&done, 2);
+            if (done != RS485_BOOT_MARK) break;
+            s_base = (i + 1) * s_page;
+        }
+        if (s_base > size) s_base = size;
+    } else {
+        rec.magic     = RS485_BOOT_MAGIC;
+        rec.size      = size;
+        rec.crc32     = crc;
+        rec.ready     = 0xFFFF;
+        rec.installed = 0xFFFF;
+        if (!hal_flash_erase(s_rec_off) ||
+            !hal_flash_write(s_rec_off, (const uint8_t *)&rec, sizeof(rec))) {
+            return RS485_BOOT_ERR_FLASH;
+        }
+    }
+
+    /* A resumed page may be half written: it is erased again first */
+    s_size      = size;
+    s_crc       = crc;
+    s_erased_to = s_base;
+    s_have      = 0;
+    s_head      = 0;
+    s_active    = true;
+    return RS485_BOOT_OK;
+}
+
+/* Out-of-window, damaged or misaligned chunks are dropped without a word:
+   BOOT_STATUS shows the master what to send again. */
+static void boot_data(const uint8_t *p, uint8_t plen)
+{
+    if (!s_active || plen < 8) return;
+    uint8_t  n   = (uint8_t)(plen - 8);
+    uint32_t off = get_u32(p);
+    if (get_u32(&p[4 + n]) != crc32(p, 4u + n)) return;
+    if (off < s_base || off >= s_size || (off - s_base) % RS485_BOOT_CHUNK) return;
+
+    uint32_t i = (off - s_base) / RS485_BOOT_CHUNK;
+    if (i >= RS485_BOOT_WINDOW || n != chunk_len(off)) return;
+
+    uint8_t *w = s_win[(s_head + i) % RS485_BOOT_WINDOW];
+    memcpy(w, &p[4], n);
+    if (n & 1) w[n] = 0xFF;            /* odd image tail: pad the halfword */
+    s_have |= 1u << i;
+}
+
+/* Write the run of chunks at the front of the window, erasing pages as
+   the write reaches them and marking each page done once it is whole.
+   The bus is deaf meanwhile, which is why the master waits for the
+   BOOT_STATUS reply before sending more. */
+static uint8_t boot_flush(void)
+{
+    uint8_t check[RS485_BOOT_CHUNK];
+
+    while (s_have & 1u) {
+        const uint8_t *w   = s_win[s_head];
+        uint32_t       n   = chunk_len(s_base);
+        uint32_t       wl  = (n + 1u) & ~1u;
+        uint32_t       end = s_base + n;
+
+        while (s_erased_to < end) {
+            if (!hal_flash_erase(s_erased_to)) goto fail;
+            s_erased_to += s_page;
+        }
+        if (!hal_flash_write(s_base, w, wl)) goto fail;
+        hal_flash_read(s_base, check, wl);
+        if (memcmp(check, w, wl) != 0) goto fail;
+
+        /* The image's last page is whole once its tail is in */
+        uint32_t done_to = (end == s_size) ? end + s_page - 1u : end;
+        for (uint32_t pg = s_base / s_page; (pg + 1u) * s_page <= done_to; pg++) {
+            if (!mark(REC_FIELD(page_done) + 2u * pg)) goto fail;
+        }
+
+        s_base  = end;
+        s_have >>= 1;
+        s_head  = (uint8_t)((s_head + 1u) % RS485_BOOT_WINDOW);
+    }
+    return RS485_BOOT_OK;
+
+fail:
+    /* BEGIN again resumes from the first page not marked done */
+    s_active = false;
+    return RS485_BOOT_ERR_FLASH;
+}
+
+static uint8_t boot_end(void)
+{
+    if (!s_active) return RS485_BOOT_ERR_NO_SESSION;
+    if (s_base < s_size) return RS485_BOOT_ERR_INCOMPLETE;
+    s_active = false;
+
+    uint8_t  buf[64];
+    uint32_t crc = 0;
+    for (uint32_t off = 0; off < s_size; off += sizeof(buf)) {
+        uint32_t n = (s_size - off < sizeof(buf)) ? s_size - off : sizeof(buf);
+        hal_flash_read(off, buf, n);
+        crc = crc32_update(crc, buf, n);
+    }
+    if (crc != s_crc) {
+        /* Never resume into an image that failed its check */
+        hal_flash_erase(s_rec_off);
+        return RS485_BOOT_ERR_IMAGE_CRC;
+    }
+    if (!mark(REC_FIELD(ready))) return RS485_BOOT_ERR_FLASH;
+    s_install = true;
+    return RS485_BOOT_OK;
+}
+
+/* ------------------------------------------------------------------ */
+/* Public API                                                           */
+/* ------------------------------------------------------------------ */
+
+void rs485_boot_init(void)
+{
+    s_active  = false;
+    s_install = false;
+}
+
+int rs485_boot_dispatch(uint8_t cmd, const uint8_t *payload, uint8_t plen,
+                        uint8_t *resp)
+{
+    switch (cmd) {
+    case RS485_CMD_BOOT_BEGIN:
+        if (plen < 8) return -1;
+        resp[0] = boot_begin(get_u32(payload), get_u32(&payload[4]));
+        resp[1] = RS485_BOOT_CHUNK;
+        resp[2] = RS485_BOOT_WINDOW;
+        put_u32(&resp[3], s_active ? s_base : 0);
+        return 7;
+
+    case RS485_CMD_BOOT_DATA:
+        boot_data(payload, plen);
+        return -1;
+
+    case RS485_CMD_BOOT_STATUS:
+        resp[0] = s_active ? boot_flush() : RS485_BOOT_ERR_NO_SESSION;
+        put_u32(&resp[1], s_base);
+        put_u32(&resp[5], s_have);
+        return 9;
+
+    case RS485_CMD_BOOT_END:
+        resp[0] = boot_end();
+        return 1;
+    }
+    return -1;
+}
+
+void rs485_boot_after_reply(void)
+{
+    if (!s_install) return;
+    s_install = false;
+    while (hal_uart_tx_busy()) { }      /* the BOOT_END reply, first */
+    hal_boot_install(s_size);
+}
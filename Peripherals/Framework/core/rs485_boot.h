@@ -0,0 +1,62 @@
+#ifndef RS485_BOOT_H
+#define RS485_BOOT_H
+
+/* Firmware update over the bus: the slave half of the BOOT_* commands
+   (rs485_proto.h). Chunks collect in a RAM window and go to the HAL's
+   staging slot (hal.h § Firmware update) when the master asks
+   BOOT_STATUS; BOOT_END checks the whole image and hands it to
+   hal_boot_install(). rs485_slave.c dispatches to it — apps do nothing. */
+
+#include "rs485_proto.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Image bytes per BOOT_DATA; even, and with offset + CRC within one frame */
+#ifndef RS485_BOOT_CHUNK
+#define RS485_BOOT_CHUNK        240
+#endif
+/* Chunks the master may send before BOOT_STATUS (RAM: window x chunk) */
+#ifndef RS485_BOOT_WINDOW
+#define RS485_BOOT_WINDOW       8
+#endif
+
+#define RS485_BOOT_REPLY_MAX    9
+
+/* Progress record, in the last page of the staging slot, so an update
+   that is cut off resumes where it stopped. Every field starts erased
+   (all ones) and is programmed once, so no erase is needed until the
+   next image. The bootloader reads it too. */
+#define RS485_BOOT_MAGIC        0x4B4C4254u   /* "TBLK" */
+#define RS485_BOOT_MARK         0x0000u       /* a programmed flag */
+
+typedef struct {
+    uint32_t magic;
+    uint32_t size;          /* image bytes */
+    uint32_t crc32;         /* of the whole image */
+    uint16_t ready;         /* MARK: image checked, install it */
+    uint16_t installed;     /* MARK: bootloader has copied it */
+    uint16_t page_done[];   /* MARK: slot page i written and verified */
+} rs485_boot_record_t;
+
+/* Forget any session in RAM (the record in flash stays). Called by
+   rs485_slave_init(). */
+void rs485_boot_init(void);
+
+/* Handle one addressed BOOT_* frame. Builds the reply into resp
+   (RS485_BOOT_REPLY_MAX bytes) and returns its length, or -1 for none. */
+int rs485_boot_dispatch(uint8_t cmd, const uint8_t *payload, uint8_t plen,
+                        uint8_t *resp);
+
+/* Call once the reply is handed to the HAL: after a good BOOT_END, waits
+   for it to go out, then installs the image and restarts. */
+void rs485_boot_after_reply(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
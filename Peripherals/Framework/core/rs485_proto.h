@@ -10,6 +10,8 @@
 /* Command bytes */
 #define RS485_CMD_PING          0x01
 #define RS485_CMD_PONG          0x02
+#define RS485_CMD_BAUD          0x03
+#define RS485_CMD_GROUP         0x04
 #define RS485_CMD_SET_OUTPUT    0x10
 #define RS485_CMD_GET_STATUS    0x11
 #define RS485_CMD_STATUS        0x12
@@ -19,15 +21,69 @@
 #define RS485_CMD_STREAM_ON     0x30
 #define RS485_CMD_STREAM_OFF    0x31
 #define RS485_CMD_STREAM_DATA   0x32
+#define RS485_CMD_BOOT_BEGIN    0x40
+#define RS485_CMD_BOOT_DATA     0x41
+#define RS485_CMD_BOOT_STATUS   0x42
+#define RS485_CMD_BOOT_END      0x43
 #define RS485_CMD_ERROR         0xF0
 #define RS485_CMD_SYNC          0xFF
 
 #define RS485_ADDR_BROADCAST    0xFF
 
+/* Multicast groups. A frame to a group address is applied by every slave
+   that has joined the group, and answered by none. Membership is a 15-bit
+   mask: bit n = group address RS485_ADDR_GROUP_FIRST + n. */
+#define RS485_ADDR_GROUP_FIRST  0xF0
+#define RS485_ADDR_GROUP_LAST   0xFE
+#define RS485_GROUP_BIT(a)      ((uint16_t)(1u << ((a) - RS485_ADDR_GROUP_FIRST)))
+#define RS485_GROUP_LIGHTS      0xF0   /* searchlight + light bar */
+
 /* Timing — must agree with the master (GCS/src/rs485.h) */
 #define RS485_TIMEOUT_MS        50
 #define RS485_INTERFRAME_GAP_MS 2
 
+/* Baud negotiation. Every node boots at RS485_BAUD_DEFAULT; a rate the
+   master switches the bus to only sticks once the master has addressed
+   this slave at it. */
+#define RS485_BAUD_DEFAULT      115200
+#define RS485_BAUD_PROBATION_MS 250    /* revert unless addressed at new rate */
+#define RS485_BAUD_LINK_LOSS_MS 3000   /* revert after this long with no valid frame */
+
+/* Stream slots. STREAM_DATA goes out only in the slot the master's SYNC
+   assigns; a slot holds a frame of RS485_TDMA_SLOT_BYTES (GCS/src/rs485.h). */
+#define RS485_STREAM_MAX_PAYLOAD 27
+/* Slack a slot leaves after its frame: a slave that times the slot from
+   a SYNC it found up to this late still clears the next one */
+#define RS485_SLOT_MARGIN_MS    1
+
+/* Firmware update (rs485_boot.c; bus spec § Firmware update). Addressed
+   only. BOOT_DATA is never answered, so the master sends a window of them
+   back to back and then asks BOOT_STATUS what arrived.
+     BOOT_BEGIN  [size u32][crc32 u32]
+                 -> [status][chunk u8][window u8][resume u32]
+     BOOT_DATA   [offset u32][data x chunk][crc32 u32 of offset + data]
+     BOOT_STATUS -> [status][base u32][have u32], after writing the window
+     BOOT_END    -> [status], then the slave restarts into the new image
+   base = image bytes already in flash; bit i of have = the chunk at
+   base + i * chunk is held in RAM. */
+#define RS485_BOOT_OK               0
+#define RS485_BOOT_ERR_UNSUPPORTED  1   /* no staging slot on this port */
+#define RS485_BOOT_ERR_TOO_BIG      2
+#define RS485_BOOT_ERR_NO_SESSION   3   /* STATUS / END before BEGIN    */
+#define RS485_BOOT_ERR_FLASH        4   /* erase / program / verify; BEGIN again */
+#define RS485_BOOT_ERR_INCOMPLETE   5   /* END before every byte is in  */
+#define RS485_BOOT_ERR_IMAGE_CRC    6   /* END: image does not match BEGIN's crc32 */
+
+/* Parameters, when the app gives the framework a table (bus spec
+   § Parameters). Addressed requests:
+     GET_PARAM [id]            -> PARAM_VAL [id][value u16]
+     GET_PARAM                 -> PARAM_VAL ([id][value u16]) x every parameter
+     SET_PARAM [id][value u16] -> PARAM_VAL [id][value u16], as now held
+   One the slave cannot serve is answered ERROR [code][id]. */
+#define RS485_ERR_PARAM_UNKNOWN     0x01
+#define RS485_ERR_PARAM_RANGE       0x02
+#define RS485_ERR_PARAM_READ_ONLY   0x03
+
 /* Frame size limits */
 #define RS485_MAX_PAYLOAD       255
 #define RS485_FRAME_OVERHEAD    5    /* SOF + ADDR + CMD + LEN + CRC */
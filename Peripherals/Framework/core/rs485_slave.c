@@ -1,4 +1,5 @@
 #include "rs485_slave.h"
+#include "rs485_boot.h"
 #include "crc8.h"
 #include "../hal/hal.h"
 
@@ -17,22 +18,46 @@ static const rs485_slave_cfg_t *s_cfg;
 /* RX FSM */
 static rx_state_t  s_state;
 static uint8_t     s_rx_addr, s_rx_cmd, s_rx_plen, s_rx_idx;
+static uint8_t     s_rx_crc;           /* running CRC over addr..payload */
 static uint8_t     s_rx_buf[RS485_MAX_PAYLOAD];
 static uint32_t    s_rx_t0;            /* hal_millis() when SOF arrived */
 static uint32_t    s_last_byte_ms;     /* hal_millis() of last byte seen on bus */
 
-/* Streaming */
-static uint16_t    s_stream_interval;  /* 0 = disabled */
-static uint32_t    s_stream_last_ms;
+/* Streaming — only inside the slot the master's last SYNC gave us; the
+   master paces the slots to the STREAM_ON interval */
+static bool        s_streaming;
+static bool        s_slot_armed;       /* a slot is coming this cycle */
+static uint32_t    s_slot_open_ms;     /* hal_millis() when it opens */
+static uint8_t     s_slot_ms;
+static uint32_t    s_rx_empty_ms;      /* hal_millis() the RX ring was last empty */
+static bool        s_rx_prompt;        /* this drain began within the slot margin */
+
+/* Baud rate */
+static uint32_t    s_baud;
+static bool        s_baud_probation;   /* switched, not yet addressed at it */
+static uint32_t    s_baud_t0;          /* hal_millis() at the switch */
+static uint32_t    s_last_valid_ms;    /* hal_millis() of the last good frame */
+
+/* Multicast groups joined, RS485_GROUP_BIT() mask */
+static uint16_t    s_groups;
+
+/* The frame going out: the HAL sends it from here in the background */
+static uint8_t     s_tx_frame[RS485_MAX_FRAME];
 
 /* ------------------------------------------------------------------ */
 /* Frame TX                                                             */
 /* ------------------------------------------------------------------ */
 
+/* Returns as soon as the frame is handed to the HAL; DE drops by itself
+   once it is out. */
 static void send_frame(uint8_t addr, uint8_t cmd,
                        const uint8_t *payload, uint8_t plen)
 {
-    uint8_t frame[RS485_MAX_FRAME];
+    /* Only a master that talks over our last reply gets here while it is
+       still going out */
+    while (hal_uart_tx_busy()) { }
+
+    uint8_t *frame = s_tx_frame;
     frame[0] = RS485_SOF;
     frame[1] = addr;
     frame[2] = cmd;
@@ -40,28 +65,135 @@ static void send_frame(uint8_t addr, uint8_t cmd,
     if (plen && payload) memcpy(&frame[4], payload, plen);
     frame[4 + plen] = crc8(&frame[1], 3 + plen);
 
-    hal_uart_set_tx_enable(true);
     hal_uart_write(frame, 5 + plen);
-    hal_uart_set_tx_enable(false);
+}
+
+/* ------------------------------------------------------------------ */
+/* Baud rate                                                            */
+/* ------------------------------------------------------------------ */
+
+static void set_baud(uint32_t baud)
+{
+    if (baud != RS485_BAUD_DEFAULT && baud > hal_uart_max_baud()) return;
+    if (!hal_uart_set_baud(baud)) return;
+    s_baud           = baud;
+    s_baud_probation = (baud != RS485_BAUD_DEFAULT);
+    s_baud_t0        = hal_millis();
+    s_last_valid_ms  = s_baud_t0;
+}
+
+/* Back to the default rate if the master never confirmed the switch, or
+   has gone quiet (rebooted at the default rate, say). */
+static void baud_tick(void)
+{
+    if (s_baud == RS485_BAUD_DEFAULT) return;
+    uint32_t now = hal_millis();
+    if ((s_baud_probation && (now - s_baud_t0) >= RS485_BAUD_PROBATION_MS) ||
+        (now - s_last_valid_ms) >= RS485_BAUD_LINK_LOSS_MS) {
+        set_baud(RS485_BAUD_DEFAULT);
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/* Stream slot                                                          */
+/* ------------------------------------------------------------------ */
+
+/* SYNC [timestamp_ms u32][slot_ms u8][n u8][addr x n]: being listed i-th
+   gives us the slot opening one inter-frame gap after the SYNC plus
+   i * slot_ms. Not listed = no slot this cycle. The SYNC is stamped when
+   drained, so one that may have waited past the slot margin leaves the
+   open time unknown: sit the cycle out. */
+static void sync_slot(const uint8_t *p, uint8_t plen)
+{
+    s_slot_armed = false;
+    if (plen < 6 || !s_rx_prompt) return;
+    for (uint8_t i = 0; i < p[5] && 6 + i < plen; i++) {
+        if (p[6 + i] != s_cfg->addr) continue;
+        s_slot_ms      = p[4];
+        s_slot_open_ms = s_last_byte_ms + RS485_INTERFRAME_GAP_MS +
+                         (uint32_t)i * p[4];
+        s_slot_armed   = true;
+        return;
+    }
 }
 
 /* ------------------------------------------------------------------ */
 /* Dispatch                                                             */
 /* ------------------------------------------------------------------ */
 
-static const rs485_handler_t *find_handler(uint8_t cmd)
+static const rs485_param_t *find_param(uint8_t id)
 {
-    if (!s_cfg || !s_cfg->handlers) return NULL;
-    for (const rs485_handler_t *h = s_cfg->handlers; h->cmd != 0; h++) {
-        if (h->cmd == cmd) return h;
+    for (uint8_t i = 0; i < s_cfg->n_params; i++) {
+        if (s_cfg->params[i].id == id) return &s_cfg->params[i];
     }
     return NULL;
 }
 
+static bool param_in_range(const rs485_param_t *pr, uint16_t v)
+{
+    if (pr->type == RS485_PARAM_I16) {
+        return (int16_t)v >= (int16_t)pr->min && (int16_t)v <= (int16_t)pr->max;
+    }
+    return v >= pr->min && v <= pr->max;
+}
+
+static uint8_t put_param(uint8_t *r, const rs485_param_t *pr)
+{
+    uint16_t v = pr->get ? pr->get() : 0;
+    r[0] = pr->id;
+    r[1] = (uint8_t)v;
+    r[2] = (uint8_t)(v >> 8);
+    return 3;
+}
+
+/* GET_PARAM / SET_PARAM from cfg.params. Returns the reply length in r
+   and sets *reply_cmd; -1 = no reply. */
+static int param_request(uint8_t cmd, const uint8_t *p, uint8_t plen,
+                         uint8_t *r, uint8_t *reply_cmd)
+{
+    *reply_cmd = RS485_CMD_PARAM_VAL;
+
+    /* GET_PARAM with no id: every parameter that fits one frame */
+    if (cmd == RS485_CMD_GET_PARAM && plen == 0) {
+        int n = 0;
+        for (uint8_t i = 0; i < s_cfg->n_params && n + 3 <= RS485_MAX_PAYLOAD; i++) {
+            n += put_param(&r[n], &s_cfg->params[i]);
+        }
+        return n;
+    }
+    if (plen < 1 || (cmd == RS485_CMD_SET_PARAM && plen < 3)) return -1;
+
+    const rs485_param_t *pr = find_param(p[0]);
+    uint8_t err = 0;
+    if (!pr) {
+        err = RS485_ERR_PARAM_UNKNOWN;
+    } else if (cmd == RS485_CMD_SET_PARAM) {
+        uint16_t v = (uint16_t)(p[1] | (p[2] << 8));
+        if (!pr->set)                        err = RS485_ERR_PARAM_READ_ONLY;
+        else if (!param_in_range(pr, v))     err = RS485_ERR_PARAM_RANGE;
+        else                                 pr->set(v);
+    }
+    if (err) {
+        *reply_cmd = RS485_CMD_ERROR;
+        r[0] = err;
+        r[1] = p[0];
+        return 2;
+    }
+    return put_param(r, pr);
+}
+
+static bool for_us(uint8_t addr)
+{
+    if (addr == s_cfg->addr || addr == RS485_ADDR_BROADCAST) return true;
+    return addr >= RS485_ADDR_GROUP_FIRST && addr <= RS485_ADDR_GROUP_LAST &&
+           (s_groups & RS485_GROUP_BIT(addr));
+}
+
 static void dispatch(uint8_t addr, uint8_t cmd,
                      const uint8_t *payload, uint8_t plen)
 {
-    const bool broadcast = (addr == RS485_ADDR_BROADCAST);
+    /* Broadcast or one of our groups: apply, never reply */
+    const bool broadcast = (addr != s_cfg->addr);
 
     /* Built-in: PING -> PONG with [fw_version]. Skip on broadcast. */
     if (cmd == RS485_CMD_PING) {
@@ -72,30 +204,83 @@ static void dispatch(uint8_t addr, uint8_t cmd,
         return;
     }
 
-    /* Built-in: STREAM_ON / STREAM_OFF */
-    if (cmd == RS485_CMD_STREAM_ON) {
-        if (s_cfg->build_stream && plen >= 2) {
-            s_stream_interval = (uint16_t)(payload[0] | (payload[1] << 8));
-            s_stream_last_ms  = hal_millis();
+    /* Built-in: BAUD. Addressed = query, reply [max_baud u32 LE].
+       Broadcast [baud u32 LE] = switch now, if this port can. */
+    if (cmd == RS485_CMD_BAUD) {
+        if (!broadcast) {
+            uint32_t max = hal_uart_max_baud();
+            uint8_t  r[4] = { (uint8_t)max, (uint8_t)(max >> 8),
+                              (uint8_t)(max >> 16), (uint8_t)(max >> 24) };
+            send_frame(s_cfg->addr, RS485_CMD_BAUD, r, sizeof(r));
+        } else if (addr == RS485_ADDR_BROADCAST && plen >= 4) {
+            set_baud((uint32_t)payload[0] | ((uint32_t)payload[1] << 8) |
+                     ((uint32_t)payload[2] << 16) | ((uint32_t)payload[3] << 24));
         }
         return;
     }
+
+    /* Built-in: GROUP, addressed only. [mask u16 LE] = join exactly these
+       groups; no payload = query. Reply [mask u16 LE]. */
+    if (cmd == RS485_CMD_GROUP) {
+        if (broadcast) return;
+        if (plen >= 2) {
+            s_groups = (uint16_t)(payload[0] | (payload[1] << 8)) &
+                       (uint16_t)(RS485_GROUP_BIT(RS485_ADDR_GROUP_LAST + 1) - 1);
+        }
+        uint8_t r[2] = { (uint8_t)s_groups, (uint8_t)(s_groups >> 8) };
+        send_frame(s_cfg->addr, RS485_CMD_GROUP, r, sizeof(r));
+        return;
+    }
+
+    /* Built-in: firmware update (rs485_boot.c), addressed only. A good
+       BOOT_END restarts into the new image once its reply is out. */
+    if (cmd >= RS485_CMD_BOOT_BEGIN && cmd <= RS485_CMD_BOOT_END) {
+        if (broadcast) return;
+        uint8_t r[RS485_BOOT_REPLY_MAX];
+        int rlen = rs485_boot_dispatch(cmd, payload, plen, r);
+        if (rlen >= 0) send_frame(s_cfg->addr, cmd, r, (uint8_t)rlen);
+        rs485_boot_after_reply();
+        return;
+    }
+
+    /* Built-in: SYNC hands out stream slots; the app may use it too */
+    if (cmd == RS485_CMD_SYNC && addr == RS485_ADDR_BROADCAST) {
+        sync_slot(payload, plen);
+    }
+
+    /* Built-in: STREAM_ON / STREAM_OFF. An interval of 0 is off. */
+    if (cmd == RS485_CMD_STREAM_ON) {
+        if (s_cfg->build_stream && plen >= 2) s_streaming = payload[0] || payload[1];
+        return;
+    }
     if (cmd == RS485_CMD_STREAM_OFF) {
-        s_stream_interval = 0;
+        s_streaming = false;
+        return;
+    }
+
+    /* Parameters, when the app declared them */
+    if (s_cfg->params &&
+        (cmd == RS485_CMD_GET_PARAM || cmd == RS485_CMD_SET_PARAM)) {
+        uint8_t resp[RS485_MAX_PAYLOAD];
+        uint8_t reply_cmd;
+        int rlen = param_request(cmd, payload, plen, resp, &reply_cmd);
+        if (!broadcast && rlen >= 0) {
+            send_frame(s_cfg->addr, reply_cmd, resp, (uint8_t)rlen);
+        }
         return;
     }
 
     /* App handlers */
-    const rs485_handler_t *h = find_handler(cmd);
+    rs485_handler_fn h = s_cfg->dispatch ? s_cfg->dispatch[cmd] : NULL;
     if (!h) return;   /* silently ignore unknown CMDs — keeps the bus quiet */
 
     if (broadcast) {
-        h->handler(payload, plen, NULL, 0);
+        h(payload, plen, NULL, 0);
         return;
     }
 
     uint8_t resp[RS485_MAX_PAYLOAD];
-    int rlen = h->handler(payload, plen, resp, sizeof(resp));
+    int rlen = h(payload, plen, resp, sizeof(resp));
     if (rlen < 0) return;
     if (rlen > (int)sizeof(resp)) rlen = sizeof(resp);
 
@@ -121,72 +306,77 @@ static void feed_byte(uint8_t b)
     switch (s_state) {
     case S_SOF:
         if (b == RS485_SOF) {
-            s_state = S_ADDR;
-            s_rx_t0 = s_last_byte_ms;
+            s_state  = S_ADDR;
+            s_rx_t0  = s_last_byte_ms;
+            s_rx_crc = CRC8_INIT;
         }
         break;
 
     case S_ADDR:
         s_rx_addr = b;
+        s_rx_crc  = crc8_update(s_rx_crc, b);
         s_state   = S_CMD;
         break;
 
     case S_CMD:
         s_rx_cmd = b;
+        s_rx_crc = crc8_update(s_rx_crc, b);
         s_state  = S_LEN;
         break;
 
     case S_LEN:
         s_rx_plen = b;
         s_rx_idx  = 0;
+        s_rx_crc  = crc8_update(s_rx_crc, b);
         s_state   = (b == 0) ? S_CRC : S_PAYLOAD;
         break;
 
     case S_PAYLOAD:
         s_rx_buf[s_rx_idx++] = b;
+        s_rx_crc = crc8_update(s_rx_crc, b);
         if (s_rx_idx >= s_rx_plen) s_state = S_CRC;
         break;
 
-    case S_CRC: {
-        uint8_t hdr[3 + RS485_MAX_PAYLOAD];
-        hdr[0] = s_rx_addr; hdr[1] = s_rx_cmd; hdr[2] = s_rx_plen;
-        if (s_rx_plen) memcpy(&hdr[3], s_rx_buf, s_rx_plen);
-        if (b == crc8(hdr, 3 + s_rx_plen)) {
-            if (s_rx_addr == s_cfg->addr ||
-                s_rx_addr == RS485_ADDR_BROADCAST) {
+    case S_CRC:
+        if (b == s_rx_crc) {
+            /* Any good frame proves the rate; one for us confirms it */
+            s_last_valid_ms = s_last_byte_ms;
+            if (s_rx_addr == s_cfg->addr) s_baud_probation = false;
+            if (for_us(s_rx_addr)) {
                 dispatch(s_rx_addr, s_rx_cmd, s_rx_buf, s_rx_plen);
             }
         }
         rx_reset();
         break;
     }
-    }
 }
 
 /* ------------------------------------------------------------------ */
 /* Streaming                                                            */
 /* ------------------------------------------------------------------ */
 
-static bool bus_quiet(void)
-{
-    /* Don't TX while a frame is mid-flight or the master is back-to-back. */
-    if (s_state != S_SOF) return false;
-    return (hal_millis() - s_last_byte_ms) >= RS485_INTERFRAME_GAP_MS;
-}
-
 static void stream_tick(void)
 {
-    if (!s_stream_interval || !s_cfg->build_stream) return;
-    if ((hal_millis() - s_stream_last_ms) < s_stream_interval) return;
-    if (!bus_quiet()) return;
+    if (!s_streaming || !s_cfg->build_stream || !s_slot_armed) return;
+    if (hal_uart_tx_busy()) return;     /* a reply is still going out */
+
+    uint32_t now = hal_millis();
+    if ((int32_t)(now - s_slot_open_ms) < 0) return;
+    s_slot_armed = false;               /* one frame per slot */
+    if (s_state != S_SOF) return;       /* a frame is still on the bus */
 
     uint8_t buf[RS485_MAX_PAYLOAD];
     int len = s_cfg->build_stream(buf, sizeof(buf));
     if (len < 0) return;
     if (len > (int)sizeof(buf)) len = sizeof(buf);
 
+    /* The whole frame must be off the bus a margin before the slot closes */
+    uint32_t frame_ms = ((uint32_t)(RS485_FRAME_OVERHEAD + len) * 10000u +
+                         s_baud - 1) / s_baud;
+    if ((int32_t)(s_slot_open_ms + s_slot_ms - RS485_SLOT_MARGIN_MS -
+                  (now + frame_ms)) < 0) return;
+
     send_frame(s_cfg->addr, RS485_CMD_STREAM_DATA, buf, (uint8_t)len);
-    s_stream_last_ms = hal_millis();
 }
 
 /* ------------------------------------------------------------------ */
@@ -197,20 +387,35 @@ void rs485_slave_init(const rs485_slave_cfg_t *cfg)
 {
     s_cfg = cfg;
     rx_reset();
-    s_stream_interval = 0;
+    s_streaming       = false;
+    s_slot_armed      = false;
     s_last_byte_ms    = 0;
+    s_rx_empty_ms     = 0;
+    s_baud            = RS485_BAUD_DEFAULT;
+    s_baud_probation  = false;
+    s_groups          = cfg->groups;
+    rs485_boot_init();
 
-    hal_uart_init(115200);
+    hal_uart_init(RS485_BAUD_DEFAULT);
     hal_uart_set_tx_enable(false);
     hal_int_pin_init();
 }
 
 void rs485_slave_poll(void)
 {
-    /* Drain any UART bytes waiting. */
-    uint8_t b;
-    while (hal_uart_read(&b)) {
-        feed_byte(b);
+    /* Drain the RX ring, a contiguous span at a time. Held while our own
+       frame is still going out: what waits in the ring is handled once
+       the bus is free to answer it. */
+    const uint8_t *p;
+    size_t n;
+    s_rx_prompt = (hal_millis() - s_rx_empty_ms) <= RS485_SLOT_MARGIN_MS;
+    while (!hal_uart_tx_busy()) {
+        if ((n = hal_uart_rx_span(&p)) == 0) {
+            s_rx_empty_ms = hal_millis();
+            break;
+        }
+        for (size_t i = 0; i < n; i++) feed_byte(p[i]);
+        hal_uart_rx_consume(n);
     }
 
     /* Drop a stalled mid-frame if no progress for RS485_TIMEOUT_MS. */
@@ -219,6 +424,7 @@ void rs485_slave_poll(void)
         rx_reset();
     }
 
+    baud_tick();
     stream_tick();
 }
 
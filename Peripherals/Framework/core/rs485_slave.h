@@ -10,29 +10,76 @@
 extern "C" {
 #endif
 
-/* Per-command handler entry. Build a response into resp_buf and return its
-   length (0..resp_buf_size). Return -1 to send no reply. For broadcast
+/* Command handler. Build a response into resp_buf and return its length
+   (0..resp_buf_size). Return -1 to send no reply. For broadcast and group
    frames resp_buf is NULL and the return value is ignored — handlers must
    still apply side effects. */
+typedef int (*rs485_handler_fn)(const uint8_t *payload, uint8_t plen,
+                                uint8_t *resp_buf, uint8_t resp_buf_size);
+
+/* Dispatch table: one entry per CMD byte, built at compile time from an
+   X-macro list of (cmd, handler) pairs, so a frame finds its handler with
+   one index:
+
+       #define APP_COMMANDS(X)                      \
+           X(RS485_CMD_SET_OUTPUT, h_set_output)    \
+           X(RS485_CMD_GET_STATUS, h_get_status)
+       RS485_DISPATCH_TABLE(s_dispatch, APP_COMMANDS);
+
+   Commands not listed are ignored. Built-in commands never reach the
+   table. A CMD listed twice fails the build (-Werror=override-init,
+   set for every back-end by framework.cmake). */
+#define RS485_DISPATCH_SIZE             256
+#define RS485_DISPATCH_ENTRY(cmd, fn)   [(cmd)] = (fn),
+#define RS485_DISPATCH_TABLE(name, list) \
+    static const rs485_handler_fn name[RS485_DISPATCH_SIZE] = { list(RS485_DISPATCH_ENTRY) }
+
+/* Parameter served by the framework (bus spec § Parameters). The wire
+   value is a u16; type says how SET_PARAM range-checks it against
+   min..max (inclusive). set == NULL makes the parameter read-only. */
+#define RS485_PARAM_U16         0
+#define RS485_PARAM_I16         1
+
+#define RS485_PARAM_PERSIST     (1u << 0)   /* for flash storage, when it lands */
+
 typedef struct {
-    uint8_t cmd;
-    int   (*handler)(const uint8_t *payload, uint8_t plen,
-                     uint8_t *resp_buf, uint8_t resp_buf_size);
-} rs485_handler_t;
+    uint8_t    id;
+    uint8_t    type;                        /* RS485_PARAM_U16 / _I16 */
+    uint8_t    flags;                       /* RS485_PARAM_PERSIST */
+    uint16_t   min, max;                    /* as the type: I16 is signed */
+    uint16_t (*get)(void);
+    void     (*set)(uint16_t value);
+} rs485_param_t;
 
 typedef struct {
-    uint8_t                 addr;          /* this slave 0x01..0xFE */
+    uint8_t                 addr;          /* this slave 0x01..0xEF */
     uint8_t                 fw_version;    /* returned in PONG payload */
-    const rs485_handler_t  *handlers;      /* terminated by .cmd == 0 */
-    /* Optional: build a STREAM_DATA payload. NULL = streaming unsupported. */
+    uint16_t                groups;        /* RS485_GROUP_BIT()s joined at boot */
+    const rs485_handler_fn *dispatch;      /* RS485_DISPATCH_TABLE, or NULL */
+    /* Optional: GET_PARAM / SET_PARAM are answered from this table and
+       never reach dispatch. NULL = the app handles them itself. */
+    const rs485_param_t    *params;
+    uint8_t                 n_params;
+    /* Optional: build a STREAM_DATA payload. NULL = streaming unsupported.
+       Sent only in the slot the master's SYNC assigns, which holds up to
+       RS485_STREAM_MAX_PAYLOAD bytes; a longer one may not fit and is
+       then skipped. */
     int (*build_stream)(uint8_t *buf, uint8_t buf_size);
 } rs485_slave_cfg_t;
 
 /* Initialise the slave. Calls hal_uart_init / hal_int_pin_init internally. */
 void rs485_slave_init(const rs485_slave_cfg_t *cfg);
 
-/* Drive the protocol. Call as fast as the loop allows — must run at least
-   once per millisecond to avoid losing bytes at 115200 baud. Non-blocking. */
+/* Drive the protocol: handles every frame received since the last call.
+   Must run at least once every RS485_POLL_MAX_MS (hal.h, 10 ms) — the HAL
+   buffers that much at hal_uart_max_baud() — so the app may spend a few
+   milliseconds on other work between calls. Replies and stream frames go
+   out in the background (hal_uart_write), so a call never waits for the
+   bus.
+   A streaming app should call it every RS485_SLOT_MARGIN_MS (1 ms): a
+   stream slot is timed from when the SYNC was drained, since the HAL
+   doesn't stamp bytes, and a SYNC that may have sat in the ring longer
+   than that is sat out rather than risk sending in a neighbour's slot. */
 void rs485_slave_poll(void);
 
 /* Drive the /INT line. Open-drain semantics — true pulls low, false
@@ -18,19 +18,49 @@ extern "C" {
    DE/RE pin as output (driven low = receive). Safe to call once at boot. */
 void hal_uart_init(uint32_t baud);
 
+/* Change the UART rate on the fly, between frames. Returns false and leaves
+   the rate unchanged if the port cannot run at `baud`. */
+bool hal_uart_set_baud(uint32_t baud);
+
+/* Fastest rate this port receives without losing bytes when the core is
+   polled as often as rs485_slave_poll() asks (its RX ring holds at least
+   RS485_POLL_MAX_MS of line time). Reported to the master during baud
+   negotiation. */
+uint32_t hal_uart_max_baud(void);
+
 /* Drive the RS-485 transceiver DE/RE pin. true = transmit, false = receive.
-   Ports that wire DE to the UART driver itself (e.g. ESP-IDF RS-485 mode)
-   may make this a no-op — the symbol must still exist. */
+   The port's own TX path drives it around each frame; the core only
+   calls it at init, to leave the transceiver receiving. Ports that wire
+   DE to the UART driver itself (e.g. ESP-IDF RS-485 mode) may make this
+   a no-op — the symbol must still exist. */
 void hal_uart_set_tx_enable(bool enable);
 
-/* Blocking write. Must not return until the last byte has fully clocked
-   out of the UART shift register, so the caller can deassert DE without
-   truncating the frame. */
+/* Start sending a frame and return at once: the port raises DE, hands
+   buf to DMA (or its TX interrupt) and drops DE from the transmission-
+   complete interrupt, once the last stop bit is out. buf must stay
+   untouched until hal_uart_tx_busy() is false. Whatever the receiver
+   picks up meanwhile — the frame's own echo, on boards that leave RX
+   enabled — never reaches hal_uart_rx_span(). */
 void hal_uart_write(const uint8_t *buf, size_t len);
 
-/* Non-blocking single-byte read. Returns 1 if a byte was available (stored
-   in *byte_out), 0 if not. Never blocks. */
-int  hal_uart_read(uint8_t *byte_out);
+/* A frame started by hal_uart_write() is still going out (DE raised). */
+bool hal_uart_tx_busy(void);
+
+/* Longest the app may go between rs485_slave_poll() calls. Each port's RX
+   ring holds at least this much line time at hal_uart_max_baud(). */
+#ifndef RS485_POLL_MAX_MS
+#define RS485_POLL_MAX_MS       10
+#endif
+
+/* Received bytes not yet consumed, from the port's RX ring — filled by an
+   interrupt or circular DMA, so bytes keep arriving while the app is busy.
+   Points *data at the oldest and returns how many follow contiguously, 0
+   if none. Where the ring wraps, the rest comes in the next span, once
+   this one is consumed. Never blocks. */
+size_t hal_uart_rx_span(const uint8_t **data);
+
+/* Release the first `n` bytes of the last span. */
+void hal_uart_rx_consume(size_t n);
 
 /* Configure the /INT pin as open-drain output, idle high (de-asserted). */
 void hal_int_pin_init(void);
@@ -43,6 +73,35 @@ void hal_int_pin_drive(bool assert_low);
    compare with subtraction so wrap is fine. */
 uint32_t hal_millis(void);
 
+/* ------------------------------------------------------------------ */
+/* Firmware update (core/rs485_boot.c). Offsets are bytes into the
+   staging slot, a flash region apart from the running image that takes
+   the new one; its last page holds the update's progress record. Ports
+   that cannot update over the bus return 0 from hal_flash_slot_size()
+   and may make the rest no-ops. Flash is busy (and, on most parts, the
+   CPU stalled) for the whole of each call.                             */
+/* ------------------------------------------------------------------ */
+
+/* Size of the staging slot in bytes, a multiple of hal_flash_page_size(). */
+uint32_t hal_flash_slot_size(void);
+
+/* Erase granularity of the slot. */
+uint32_t hal_flash_page_size(void);
+
+/* Erase the page starting at page-aligned `off` to all ones. */
+bool hal_flash_erase(uint32_t off);
+
+/* Program `len` bytes at `off` into erased flash. off and len are even.
+   Writing 0xFF leaves a byte erased, so a page may be filled piecewise. */
+bool hal_flash_write(uint32_t off, const uint8_t *buf, size_t len);
+
+/* Read back `len` bytes at `off`. */
+void hal_flash_read(uint32_t off, uint8_t *buf, size_t len);
+
+/* Make the `size`-byte image in the slot the running firmware and
+   restart into it. Only returns if the port cannot install. */
+void hal_boot_install(uint32_t size);
+
 #ifdef __cplusplus
 }
 #endif
@@ -3,6 +3,9 @@
 #include "driver/uart.h"
 #include "driver/gpio.h"
 #include "esp_timer.h"
+#include "esp_ota_ops.h"
+#include "esp_partition.h"
+#include "esp_system.h"
 
 /* Defaults — boards can override on the compiler command line. */
 #ifndef HAL_ESP32_UART
@@ -20,9 +23,24 @@
 #ifndef HAL_ESP32_PIN_INT
 #define HAL_ESP32_PIN_INT    5
 #endif
+/* The driver's interrupt-fed RX buffer is the ring: it holds
+   RS485_POLL_MAX_MS at the top rate, 1250 bytes at 1 Mbaud */
 #ifndef HAL_ESP32_RX_BUF
-#define HAL_ESP32_RX_BUF     512
+#define HAL_ESP32_RX_BUF     2048
 #endif
+/* A TX buffer lets uart_write_bytes() return at once; the driver feeds
+   the FIFO from its interrupt and drops RTS (DE) once the frame is out.
+   DE and /RE share RTS, so the receiver is off meanwhile: no echo. */
+#ifndef HAL_ESP32_TX_BUF
+#define HAL_ESP32_TX_BUF     512
+#endif
+#ifndef HAL_ESP32_MAX_BAUD
+#define HAL_ESP32_MAX_BAUD   1000000
+#endif
+#if HAL_ESP32_RX_BUF < HAL_ESP32_MAX_BAUD / 10 * RS485_POLL_MAX_MS / 1000
+#error "HAL_ESP32_RX_BUF too small for RS485_POLL_MAX_MS at HAL_ESP32_MAX_BAUD"
+#endif
+#define HAL_ESP32_FLASH_SECTOR 4096
 
 void hal_uart_init(uint32_t baud)
 {
@@ -34,7 +52,7 @@ void hal_uart_init(uint32_t baud)
         .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
         .source_clk = UART_SCLK_DEFAULT,
     };
-    uart_driver_install(HAL_ESP32_UART, HAL_ESP32_RX_BUF, 0, 0, NULL, 0);
+    uart_driver_install(HAL_ESP32_UART, HAL_ESP32_RX_BUF, HAL_ESP32_TX_BUF, 0, NULL, 0);
     uart_param_config(HAL_ESP32_UART, &cfg);
     /* DE on RTS — driver auto-toggles in RS-485 half-duplex mode. */
     uart_set_pin(HAL_ESP32_UART,
@@ -43,23 +61,54 @@ void hal_uart_init(uint32_t baud)
     uart_set_mode(HAL_ESP32_UART, UART_MODE_RS485_HALF_DUPLEX);
 }
 
+bool hal_uart_set_baud(uint32_t baud)
+{
+    if (baud > HAL_ESP32_MAX_BAUD) return false;
+    uart_wait_tx_done(HAL_ESP32_UART, portMAX_DELAY);
+    return uart_set_baudrate(HAL_ESP32_UART, baud) == ESP_OK;
+}
+
+uint32_t hal_uart_max_baud(void)
+{
+    return HAL_ESP32_MAX_BAUD;
+}
+
 void hal_uart_set_tx_enable(bool enable)
 {
-    /* No-op: the driver toggles DE around uart_write_bytes. The function
-       must still exist so the core compiles unchanged. */
+    /* No-op: the driver toggles DE around each frame. The function must
+       still exist so the core compiles unchanged. */
     (void)enable;
 }
 
+/* Copied into the driver's TX buffer, so buf is free again on return */
 void hal_uart_write(const uint8_t *buf, size_t len)
 {
     uart_write_bytes(HAL_ESP32_UART, (const char *)buf, len);
-    uart_wait_tx_done(HAL_ESP32_UART, portMAX_DELAY);
 }
 
-int hal_uart_read(uint8_t *byte_out)
+bool hal_uart_tx_busy(void)
+{
+    return uart_wait_tx_done(HAL_ESP32_UART, 0) == ESP_ERR_TIMEOUT;
+}
+
+/* The driver's ring isn't addressable, so spans come from a copy */
+static uint8_t s_span[128];
+static size_t  s_span_len, s_span_pos;
+
+size_t hal_uart_rx_span(const uint8_t **data)
+{
+    if (s_span_pos >= s_span_len) {
+        int n = uart_read_bytes(HAL_ESP32_UART, s_span, sizeof(s_span), 0);
+        s_span_len = n > 0 ? (size_t)n : 0;
+        s_span_pos = 0;
+    }
+    *data = &s_span[s_span_pos];
+    return s_span_len - s_span_pos;
+}
+
+void hal_uart_rx_consume(size_t n)
 {
-    int n = uart_read_bytes(HAL_ESP32_UART, byte_out, 1, 0);
-    return n > 0 ? 1 : 0;
+    s_span_pos += n;
 }
 
 void hal_int_pin_init(void)
@@ -84,3 +133,48 @@ uint32_t hal_millis(void)
 {
     return (uint32_t)(esp_timer_get_time() / 1000);
 }
+
+/* ------------------------------------------------------------------ */
+/* Flash — the staging slot is the OTA partition the next update goes
+   to, so the partition table needs two OTA app partitions. IDF's own
+   bootloader switches over, and survives a power cut mid-switch.       */
+/* ------------------------------------------------------------------ */
+
+static const esp_partition_t *slot(void)
+{
+    static const esp_partition_t *s_slot;
+    if (!s_slot) s_slot = esp_ota_get_next_update_partition(NULL);
+    return s_slot;
+}
+
+uint32_t hal_flash_slot_size(void)
+{
+    return slot() ? (uint32_t)slot()->size : 0;
+}
+
+uint32_t hal_flash_page_size(void)
+{
+    return HAL_ESP32_FLASH_SECTOR;
+}
+
+bool hal_flash_erase(uint32_t off)
+{
+    return slot() &&
+           esp_partition_erase_range(slot(), off, HAL_ESP32_FLASH_SECTOR) == ESP_OK;
+}
+
+bool hal_flash_write(uint32_t off, const uint8_t *buf, size_t len)
+{
+    return slot() && esp_partition_write(slot(), off, buf, len) == ESP_OK;
+}
+
+void hal_flash_read(uint32_t off, uint8_t *buf, size_t len)
+{
+    if (slot()) esp_partition_read(slot(), off, buf, len);
+}
+
+void hal_boot_install(uint32_t size)
+{
+    (void)size;
+    if (slot() && esp_ota_set_boot_partition(slot()) == ESP_OK) esp_restart();
+}
@@ -0,0 +1,207 @@
+#define _GNU_SOURCE
+#include "hal.h"
+#include "rx_ring.h"
+#include "vbus.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Linux port: the UART is a node on the virtual bus (host/vbus.h), so an
+   app runs as a process next to the hub, the master and other slaves.
+   The bus reader thread stands in for the RX interrupt and feeds the
+   ring; TX_DONE from the hub is the transmission-complete interrupt. */
+
+#ifndef HAL_POSIX_RX_RING
+#define HAL_POSIX_RX_RING   2048u
+#endif
+#ifndef HAL_POSIX_MAX_BAUD
+#define HAL_POSIX_MAX_BAUD  1000000
+#endif
+#if HAL_POSIX_RX_RING < HAL_POSIX_MAX_BAUD / 10 * RS485_POLL_MAX_MS / 1000
+#error "HAL_POSIX_RX_RING too small for RS485_POLL_MAX_MS at HAL_POSIX_MAX_BAUD"
+#endif
+#ifndef HAL_POSIX_SLOT_SIZE
+#define HAL_POSIX_SLOT_SIZE 0x10000u
+#endif
+#define HAL_POSIX_PAGE      1024u
+
+static rx_ring_t       s_rx;
+static uint8_t         s_rx_buf[HAL_POSIX_RX_RING];
+static pthread_mutex_t s_rx_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  s_rx_cond;
+static bool            s_tx_busy;
+static uint64_t        s_t0_ns;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/* Reader thread: the RX and TX-complete interrupts */
+static void on_rx(void *ctx, const uint8_t *data, size_t len)
+{
+    (void)ctx;
+    for (size_t i = 0; i < len; i++) rx_ring_put(&s_rx, data[i]);
+    pthread_mutex_lock(&s_rx_lock);
+    pthread_cond_signal(&s_rx_cond);
+    pthread_mutex_unlock(&s_rx_lock);
+}
+
+static void on_tx_done(void *ctx)
+{
+    (void)ctx;
+    __atomic_store_n(&s_tx_busy, false, __ATOMIC_RELEASE);
+}
+
+void hal_uart_init(uint32_t baud)
+{
+    s_t0_ns = now_ns();
+    rx_ring_init(&s_rx, s_rx_buf, HAL_POSIX_RX_RING);
+
+    pthread_condattr_t ca;
+    pthread_condattr_init(&ca);
+    pthread_condattr_setclock(&ca, CLOCK_MONOTONIC);
+    pthread_cond_init(&s_rx_cond, &ca);
+
+    static const vbus_cb_t cb = { .on_rx = on_rx, .on_tx_done = on_tx_done };
+    if (!vbus_open(&cb)) {
+        fprintf(stderr, "hal_posix: no bus hub at $RS485_VBUS or %s\n",
+                VBUS_DEFAULT_PATH);
+        exit(1);
+    }
+    vbus_set_baud(baud);
+}
+
+bool hal_uart_set_baud(uint32_t baud)
+{
+    if (baud > HAL_POSIX_MAX_BAUD) return false;
+    while (hal_uart_tx_busy()) { }
+    vbus_set_baud(baud);
+    return true;
+}
+
+uint32_t hal_uart_max_baud(void)
+{
+    return HAL_POSIX_MAX_BAUD;
+}
+
+void hal_uart_set_tx_enable(bool enable)
+{
+    /* The hub drives the line for exactly the frame's length */
+    (void)enable;
+}
+
+/* Handed to the hub at once, so buf is free again on return */
+void hal_uart_write(const uint8_t *buf, size_t len)
+{
+    __atomic_store_n(&s_tx_busy, true, __ATOMIC_RELEASE);
+    vbus_send(buf, len);
+}
+
+bool hal_uart_tx_busy(void)
+{
+    if (!__atomic_load_n(&s_tx_busy, __ATOMIC_ACQUIRE)) return false;
+    struct timespec nap = { 0, 10000 };     /* about a byte at 1 Mbaud */
+    nanosleep(&nap, NULL);
+    return __atomic_load_n(&s_tx_busy, __ATOMIC_ACQUIRE);
+}
+
+size_t hal_uart_rx_span(const uint8_t **data)
+{
+    size_t n = rx_ring_span(&s_rx, data);
+    if (n) return n;
+
+    /* Empty: sleep until a byte arrives or hal_millis() ticks over — the
+       host's SysTick + WFI, so a slave's poll loop doesn't spin a core.
+       Nothing in the core falls due between ticks. */
+    uint64_t t = now_ns() - s_t0_ns;
+    t = s_t0_ns + (t / 1000000u + 1u) * 1000000u;
+    struct timespec ts = { (time_t)(t / 1000000000u), (long)(t % 1000000000u) };
+    pthread_mutex_lock(&s_rx_lock);
+    while (!(n = rx_ring_span(&s_rx, data)) &&
+           pthread_cond_timedwait(&s_rx_cond, &s_rx_lock, &ts) == 0) { }
+    pthread_mutex_unlock(&s_rx_lock);
+    return n;
+}
+
+void hal_uart_rx_consume(size_t n)
+{
+    rx_ring_consume(&s_rx, n);
+}
+
+void hal_int_pin_init(void)
+{
+    vbus_set_int(false);
+}
+
+void hal_int_pin_drive(bool assert_low)
+{
+    vbus_set_int(assert_low);
+}
+
+uint32_t hal_millis(void)
+{
+    return (uint32_t)((now_ns() - s_t0_ns) / 1000000u);
+}
+
+/* ------------------------------------------------------------------ */
+/* Flash — the staging slot is process memory. There is no image to
+   restart into, so install reports what it got and returns.           */
+/* ------------------------------------------------------------------ */
+
+static uint8_t s_slot[HAL_POSIX_SLOT_SIZE];
+static bool    s_slot_init;
+
+static void slot_init(void)
+{
+    if (s_slot_init) return;
+    memset(s_slot, 0xFF, sizeof(s_slot));
+    s_slot_init = true;
+}
+
+uint32_t hal_flash_slot_size(void)
+{
+    return HAL_POSIX_SLOT_SIZE;
+}
+
+uint32_t hal_flash_page_size(void)
+{
+    return HAL_POSIX_PAGE;
+}
+
+bool hal_flash_erase(uint32_t off)
+{
+    slot_init();
+    if (off % HAL_POSIX_PAGE || off >= HAL_POSIX_SLOT_SIZE) return false;
+    memset(&s_slot[off], 0xFF, HAL_POSIX_PAGE);
+    return true;
+}
+
+bool hal_flash_write(uint32_t off, const uint8_t *buf, size_t len)
+{
+    slot_init();
+    if (off > HAL_POSIX_SLOT_SIZE || len > HAL_POSIX_SLOT_SIZE - off) return false;
+    for (size_t i = 0; i < len; i++) s_slot[off + i] &= buf[i];     /* NOR: 1 → 0 only */
+    return true;
+}
+
+void hal_flash_read(uint32_t off, uint8_t *buf, size_t len)
+{
+    slot_init();
+    if (off > HAL_POSIX_SLOT_SIZE || len > HAL_POSIX_SLOT_SIZE - off) {
+        memset(buf, 0xFF, len);
+        return;
+    }
+    memcpy(buf, &s_slot[off], len);
+}
+
+void hal_boot_install(uint32_t size)
+{
+    fprintf(stderr, "hal_posix: %u-byte image staged, not installed (no flash)\n",
+            (unsigned)size);
+}
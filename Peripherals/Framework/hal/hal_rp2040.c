@@ -1,9 +1,17 @@
 #include "hal.h"
+#include "rx_ring.h"
 
 #include "pico/stdlib.h"
 #include "pico/time.h"
 #include "hardware/uart.h"
 #include "hardware/gpio.h"
+#include "hardware/flash.h"
+#include "hardware/sync.h"
+#include "hardware/irq.h"
+#include "hardware/dma.h"
+#include "hardware/structs/scb.h"
+
+#include <string.h>
 
 /* Pins are weak so a board can override them at link time, otherwise these
    defaults match the master side (GCS) wiring conventions on a Pico. */
@@ -22,18 +30,98 @@
 #ifndef HAL_RP2040_PIN_INT
 #define HAL_RP2040_PIN_INT 3
 #endif
+/* The UART interrupt empties the 32-byte FIFO into a ring that holds
+   RS485_POLL_MAX_MS at the top rate: 1250 bytes at 1 Mbaud */
+#ifndef HAL_RP2040_RX_RING
+#define HAL_RP2040_RX_RING 2048
+#endif
+#ifndef HAL_RP2040_MAX_BAUD
+#define HAL_RP2040_MAX_BAUD 1000000
+#endif
+#if HAL_RP2040_RX_RING < HAL_RP2040_MAX_BAUD / 10 * RS485_POLL_MAX_MS / 1000
+#error "HAL_RP2040_RX_RING too small for RS485_POLL_MAX_MS at HAL_RP2040_MAX_BAUD"
+#endif
+/* Firmware update staging slot, as offsets into flash: the upper half of
+   the Pico's 2 MB by default. The app must end below it. */
+#ifndef HAL_RP2040_SLOT_OFFSET
+#define HAL_RP2040_SLOT_OFFSET (1024u * 1024u)
+#endif
+#ifndef HAL_RP2040_SLOT_SIZE
+#define HAL_RP2040_SLOT_SIZE   (1024u * 1024u)
+#endif
+
+static uint8_t   s_rx_buf[HAL_RP2040_RX_RING];
+static rx_ring_t s_rx;
+
+/* TX: a DMA channel paced by the UART's TX DREQ fills the FIFO. The
+   PL011 has no transmission-complete interrupt, so an alarm set for the
+   frame's line time checks the UART has gone idle and drops DE. */
+static int           s_tx_dma = -1;
+static uint32_t      s_baud;
+static volatile bool s_tx_busy;
+
+static void on_uart_rx(void)
+{
+    while (uart_is_readable(HAL_RP2040_UART)) {
+        uint8_t b = (uint8_t)uart_getc(HAL_RP2040_UART);
+        if (!s_tx_busy) rx_ring_put(&s_rx, b);    /* else our echo */
+    }
+}
+
+static int64_t on_tx_done(alarm_id_t id, void *user)
+{
+    (void)id; (void)user;
+    if (dma_channel_is_busy(s_tx_dma) ||
+        (uart_get_hw(HAL_RP2040_UART)->fr & UART_UARTFR_BUSY_BITS)) {
+        return (int64_t)(10000000u / s_baud + 1u);     /* a byte time on */
+    }
+    gpio_put(HAL_RP2040_PIN_DE, 0);
+    on_uart_rx();                       /* the echo's last byte, if any */
+    s_tx_busy = false;
+    return 0;
+}
 
 void hal_uart_init(uint32_t baud)
 {
-    uart_init(HAL_RP2040_UART, baud);
+    s_baud = uart_init(HAL_RP2040_UART, baud);
     gpio_set_function(HAL_RP2040_PIN_TX, GPIO_FUNC_UART);
     gpio_set_function(HAL_RP2040_PIN_RX, GPIO_FUNC_UART);
 
+    /* RX and RX-timeout interrupts, so a short frame's tail isn't left
+       sitting in the FIFO below its trigger level */
+    rx_ring_init(&s_rx, s_rx_buf, HAL_RP2040_RX_RING);
+    int irq = uart_get_index(HAL_RP2040_UART) ? UART1_IRQ : UART0_IRQ;
+    irq_set_exclusive_handler(irq, on_uart_rx);
+    irq_set_enabled(irq, true);
+    uart_set_irq_enables(HAL_RP2040_UART, true, false);
+
+    s_tx_dma = dma_claim_unused_channel(true);
+    dma_channel_config c = dma_channel_get_default_config(s_tx_dma);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, uart_get_dreq(HAL_RP2040_UART, true));
+    dma_channel_configure(s_tx_dma, &c, &uart_get_hw(HAL_RP2040_UART)->dr,
+                          NULL, 0, false);
+
     gpio_init(HAL_RP2040_PIN_DE);
     gpio_set_dir(HAL_RP2040_PIN_DE, GPIO_OUT);
     gpio_put(HAL_RP2040_PIN_DE, 0);
 }
 
+bool hal_uart_set_baud(uint32_t baud)
+{
+    if (baud > HAL_RP2040_MAX_BAUD) return false;
+    while (s_tx_busy) { }
+    s_baud = uart_set_baudrate(HAL_RP2040_UART, baud);
+    return true;
+}
+
+uint32_t hal_uart_max_baud(void)
+{
+    return HAL_RP2040_MAX_BAUD;
+}
+
 void hal_uart_set_tx_enable(bool enable)
 {
     gpio_put(HAL_RP2040_PIN_DE, enable ? 1 : 0);
@@ -41,15 +129,34 @@ void hal_uart_set_tx_enable(bool enable)
 
 void hal_uart_write(const uint8_t *buf, size_t len)
 {
-    uart_write_blocking(HAL_RP2040_UART, buf, len);
-    uart_tx_wait_blocking(HAL_RP2040_UART);
+    while (s_tx_busy) { }
+    s_tx_busy = true;
+    gpio_put(HAL_RP2040_PIN_DE, 1);
+    dma_channel_transfer_from_buffer_now(s_tx_dma, buf, len);
+    if (add_alarm_in_us((uint64_t)len * 10000000u / s_baud + 1u,
+                        on_tx_done, NULL, true) < 0) {
+        /* No alarm slot: wait out the frame here, or DE stays up */
+        while (dma_channel_is_busy(s_tx_dma) ||
+               (uart_get_hw(HAL_RP2040_UART)->fr & UART_UARTFR_BUSY_BITS)) { }
+        uint32_t irq = save_and_disable_interrupts();
+        on_tx_done(0, NULL);
+        restore_interrupts(irq);
+    }
+}
+
+bool hal_uart_tx_busy(void)
+{
+    return s_tx_busy;
 }
 
-int hal_uart_read(uint8_t *byte_out)
+size_t hal_uart_rx_span(const uint8_t **data)
 {
-    if (!uart_is_readable(HAL_RP2040_UART)) return 0;
-    *byte_out = (uint8_t)uart_getc(HAL_RP2040_UART);
-    return 1;
+    return rx_ring_span(&s_rx, data);
+}
+
+void hal_uart_rx_consume(size_t n)
+{
+    rx_ring_consume(&s_rx, n);
 }
 
 void hal_int_pin_init(void)
@@ -75,3 +182,80 @@ uint32_t hal_millis(void)
 {
     return (uint32_t)(to_ms_since_boot(get_absolute_time()));
 }
+
+/* ------------------------------------------------------------------ */
+/* Flash — XIP is off for the duration of each call, so interrupts are
+   too (their handlers live in flash).                                 */
+/* ------------------------------------------------------------------ */
+
+uint32_t hal_flash_slot_size(void)
+{
+    return HAL_RP2040_SLOT_SIZE;
+}
+
+uint32_t hal_flash_page_size(void)
+{
+    return FLASH_SECTOR_SIZE;
+}
+
+bool hal_flash_erase(uint32_t off)
+{
+    if (off % FLASH_SECTOR_SIZE || off >= HAL_RP2040_SLOT_SIZE) return false;
+    uint32_t irq = save_and_disable_interrupts();
+    flash_range_erase(HAL_RP2040_SLOT_OFFSET + off, FLASH_SECTOR_SIZE);
+    restore_interrupts(irq);
+    return true;
+}
+
+/* Programming goes by 256-byte page; the rest of the page is sent as
+   0xFF, which leaves those bytes as they are. */
+bool hal_flash_write(uint32_t off, const uint8_t *buf, size_t len)
+{
+    if (off + len > HAL_RP2040_SLOT_SIZE) return false;
+    uint8_t page[FLASH_PAGE_SIZE];
+    while (len) {
+        uint32_t at = off % FLASH_PAGE_SIZE;
+        size_t   n  = FLASH_PAGE_SIZE - at < len ? FLASH_PAGE_SIZE - at : len;
+        memset(page, 0xFF, sizeof(page));
+        memcpy(&page[at], buf, n);
+
+        uint32_t irq = save_and_disable_interrupts();
+        flash_range_program(HAL_RP2040_SLOT_OFFSET + off - at, page, FLASH_PAGE_SIZE);
+        restore_interrupts(irq);
+        off += n;
+        buf += n;
+        len -= n;
+    }
+    return true;
+}
+
+void hal_flash_read(uint32_t off, uint8_t *buf, size_t len)
+{
+    memcpy(buf, (const uint8_t *)(XIP_BASE + HAL_RP2040_SLOT_OFFSET + off), len);
+}
+
+/* No bootloader of our own here: the copy over the app runs from RAM and
+   then resets. Power lost during it leaves a broken app, recovered with
+   BOOTSEL over USB. */
+static uint8_t s_sector[FLASH_SECTOR_SIZE];
+
+static void __no_inline_not_in_flash_func(install_from_ram)(uint32_t size)
+{
+    for (uint32_t off = 0; off < size; off += FLASH_SECTOR_SIZE) {
+        const volatile uint8_t *src =
+            (const volatile uint8_t *)(XIP_BASE + HAL_RP2040_SLOT_OFFSET + off);
+        for (uint32_t i = 0; i < FLASH_SECTOR_SIZE; i++) s_sector[i] = src[i];
+        flash_range_erase(off, FLASH_SECTOR_SIZE);
+        flash_range_program(off, s_sector, FLASH_SECTOR_SIZE);
+    }
+    /* SYSRESETREQ — watchdog_reboot() is in flash */
+    scb_hw->aircr = 0x05FA0004u;
+    for (;;) { }
+}
+
+void hal_boot_install(uint32_t size)
+{
+    if (size > HAL_RP2040_SLOT_OFFSET) return;
+    save_and_disable_interrupts();
+    install_from_ram(size);
+}
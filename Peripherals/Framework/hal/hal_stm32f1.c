@@ -1,7 +1,10 @@
 #include "hal.h"
+#include "rx_ring.h"
 
 #include "stm32f1xx.h"
 
+#include <string.h>
+
 /* ------------------------------------------------------------------ */
 /* Pin map — defaults match KL-GCS-MODBUS03 PCB1 (STM32F103C8T6).
    USART2 PA2/PA3 to RS-485 transceiver, DE on PA1, /INT on PA4.
@@ -13,6 +16,10 @@
 #ifndef HAL_STM32F1_USART_APB1EN
 #define HAL_STM32F1_USART_APB1EN  RCC_APB1ENR_USART2EN
 #endif
+#ifndef HAL_STM32F1_USART_IRQn     /* override both with the USART */
+#define HAL_STM32F1_USART_IRQn  USART2_IRQn
+#define HAL_STM32F1_USART_IRQHandler  USART2_IRQHandler
+#endif
 #ifndef HAL_STM32F1_GPIO_PORT
 #define HAL_STM32F1_GPIO_PORT   GPIOA
 #endif
@@ -32,6 +39,39 @@
 #define HAL_STM32F1_PIN_INT     4u    /* PA4  /INT to master */
 #endif
 
+/* RX runs into a ring by circular DMA (USART2_RX is DMA1 channel 6), so
+   it needs no CPU and carries on through flash stalls. The ring holds
+   RS485_POLL_MAX_MS at the top rate: 1250 bytes at 1 Mbaud. */
+#ifndef HAL_STM32F1_RX_DMA
+#define HAL_STM32F1_RX_DMA      DMA1_Channel6
+#endif
+#ifndef HAL_STM32F1_RX_RING
+#define HAL_STM32F1_RX_RING     2048u
+#endif
+/* TX goes out by DMA (USART2_TX is DMA1 channel 7); the USART's
+   transmission-complete interrupt drops DE after the last stop bit */
+#ifndef HAL_STM32F1_TX_DMA
+#define HAL_STM32F1_TX_DMA      DMA1_Channel7
+#endif
+#ifndef HAL_STM32F1_MAX_BAUD
+#define HAL_STM32F1_MAX_BAUD    1000000u
+#endif
+#if HAL_STM32F1_RX_RING < HAL_STM32F1_MAX_BAUD / 10u * RS485_POLL_MAX_MS / 1000u
+#error "HAL_STM32F1_RX_RING too small for RS485_POLL_MAX_MS at HAL_STM32F1_MAX_BAUD"
+#endif
+
+/* Firmware update: the staging slot, above the app. stm32f1.cmake sets
+   these when PERIPH_BOOTLOADER links the app behind boot/boot_stm32f1.c,
+   which copies a staged image over the app at reset. Without it the slot
+   size stays 0 and BOOT_BEGIN is refused. */
+#ifndef HAL_STM32F1_SLOT_ADDR
+#define HAL_STM32F1_SLOT_ADDR   0x08010000u
+#endif
+#ifndef HAL_STM32F1_SLOT_SIZE
+#define HAL_STM32F1_SLOT_SIZE   0u
+#endif
+#define HAL_STM32F1_FLASH_PAGE  1024u
+
 /* APB1 PCLK after our HSI->PLL setup. USART2 lives on APB1. */
 #define HAL_STM32F1_SYSCLK      64000000u
 #define HAL_STM32F1_PCLK1       32000000u
@@ -124,6 +164,23 @@ static void gpio_set_cfg(GPIO_TypeDef *p, uint32_t pin, uint32_t cfg)
 /* HAL                                                                  */
 /* ------------------------------------------------------------------ */
 
+static uint8_t   s_rx_buf[HAL_STM32F1_RX_RING];
+static rx_ring_t s_rx;
+static volatile bool s_tx_busy;
+
+/* The last stop bit is out: back to receiving */
+void HAL_STM32F1_USART_IRQHandler(void)
+{
+    if (!(HAL_STM32F1_USART->CR1 & USART_CR1_TCIE) ||
+        !(HAL_STM32F1_USART->SR & USART_SR_TC)) return;
+    HAL_STM32F1_USART->CR1 &= ~USART_CR1_TCIE;
+    HAL_STM32F1_USART->CR3 &= ~USART_CR3_DMAT;
+    HAL_STM32F1_TX_DMA->CCR = 0;
+    hal_uart_set_tx_enable(false);
+    HAL_STM32F1_USART->CR1 |= USART_CR1_RE;
+    s_tx_busy = false;
+}
+
 void hal_uart_init(uint32_t baud)
 {
     clock_init_hsi_pll_64mhz();
@@ -145,33 +202,80 @@ void hal_uart_init(uint32_t baud)
     HAL_STM32F1_USART->CR2 = 0;
     HAL_STM32F1_USART->CR3 = 0;
     HAL_STM32F1_USART->BRR = HAL_STM32F1_PCLK1 / baud;
+
+    /* RX DMA: DR -> ring, byte wide, circular, for ever */
+    rx_ring_init(&s_rx, s_rx_buf, HAL_STM32F1_RX_RING);
+    RCC->AHBENR |= RCC_AHBENR_DMA1EN;
+    HAL_STM32F1_RX_DMA->CCR   = 0;
+    HAL_STM32F1_RX_DMA->CPAR  = (uint32_t)&HAL_STM32F1_USART->DR;
+    HAL_STM32F1_RX_DMA->CMAR  = (uint32_t)s_rx_buf;
+    HAL_STM32F1_RX_DMA->CNDTR = HAL_STM32F1_RX_RING;
+    HAL_STM32F1_RX_DMA->CCR   = DMA_CCR_MINC | DMA_CCR_CIRC | DMA_CCR_EN;
+    HAL_STM32F1_USART->CR3    = USART_CR3_DMAR;
+
+    /* TX DMA: buffer -> DR, byte wide; armed per frame */
+    HAL_STM32F1_TX_DMA->CCR   = 0;
+    HAL_STM32F1_TX_DMA->CPAR  = (uint32_t)&HAL_STM32F1_USART->DR;
+    NVIC_EnableIRQ(HAL_STM32F1_USART_IRQn);
+
     HAL_STM32F1_USART->CR1 = USART_CR1_TE | USART_CR1_RE | USART_CR1_UE;
 
     /* SysTick at 1 kHz from SYSCLK. */
     SysTick_Config(HAL_STM32F1_SYSCLK / 1000u);
 }
 
+bool hal_uart_set_baud(uint32_t baud)
+{
+    if (baud > HAL_STM32F1_MAX_BAUD) return false;
+    /* BRR may only change with the USART idle and disabled. */
+    while (s_tx_busy) { }
+    HAL_STM32F1_USART->CR1 &= ~USART_CR1_UE;
+    HAL_STM32F1_USART->BRR = HAL_STM32F1_PCLK1 / baud;
+    HAL_STM32F1_USART->CR1 |= USART_CR1_UE;
+    return true;
+}
+
+uint32_t hal_uart_max_baud(void)
+{
+    return HAL_STM32F1_MAX_BAUD;
+}
+
 void hal_uart_set_tx_enable(bool enable)
 {
     if (enable) HAL_STM32F1_GPIO_PORT->BSRR = (1u << HAL_STM32F1_PIN_DE);
     else        HAL_STM32F1_GPIO_PORT->BSRR = (1u << (HAL_STM32F1_PIN_DE + 16));
 }
 
+/* The receiver is off while DE is up, so no echo lands in the ring */
 void hal_uart_write(const uint8_t *buf, size_t len)
 {
-    for (size_t i = 0; i < len; i++) {
-        while (!(HAL_STM32F1_USART->SR & USART_SR_TXE)) { }
-        HAL_STM32F1_USART->DR = buf[i];
-    }
-    /* Wait for the last byte to fully clock out before releasing DE. */
-    while (!(HAL_STM32F1_USART->SR & USART_SR_TC)) { }
+    while (s_tx_busy) { }
+    s_tx_busy = true;
+    HAL_STM32F1_USART->CR1 &= ~USART_CR1_RE;
+    hal_uart_set_tx_enable(true);
+
+    HAL_STM32F1_TX_DMA->CMAR  = (uint32_t)buf;
+    HAL_STM32F1_TX_DMA->CNDTR = (uint32_t)len;
+    HAL_STM32F1_USART->SR     = ~USART_SR_TC;
+    HAL_STM32F1_USART->CR3   |= USART_CR3_DMAT;
+    HAL_STM32F1_TX_DMA->CCR   = DMA_CCR_DIR | DMA_CCR_MINC | DMA_CCR_EN;
+    HAL_STM32F1_USART->CR1   |= USART_CR1_TCIE;
+}
+
+bool hal_uart_tx_busy(void)
+{
+    return s_tx_busy;
+}
+
+size_t hal_uart_rx_span(const uint8_t **data)
+{
+    rx_ring_dma_head(&s_rx, (uint16_t)(HAL_STM32F1_RX_RING - HAL_STM32F1_RX_DMA->CNDTR));
+    return rx_ring_span(&s_rx, data);
 }
 
-int hal_uart_read(uint8_t *byte_out)
+void hal_uart_rx_consume(size_t n)
 {
-    if (!(HAL_STM32F1_USART->SR & USART_SR_RXNE)) return 0;
-    *byte_out = (uint8_t)HAL_STM32F1_USART->DR;
-    return 1;
+    rx_ring_consume(&s_rx, n);
 }
 
 void hal_int_pin_init(void)
@@ -189,3 +293,82 @@ void hal_int_pin_drive(bool assert_low)
     else
         HAL_STM32F1_GPIO_PORT->BSRR = (1u << HAL_STM32F1_PIN_INT);
 }
+
+/* ------------------------------------------------------------------ */
+/* Flash — the slot only. Programming is by halfword; the CPU stalls on
+   any flash fetch until the operation completes.                      */
+/* ------------------------------------------------------------------ */
+
+#define FLASH_UNLOCK_KEY1       0x45670123u
+#define FLASH_UNLOCK_KEY2       0xCDEF89ABu
+
+static void flash_unlock(void)
+{
+    if (FLASH->CR & FLASH_CR_LOCK) {
+        FLASH->KEYR = FLASH_UNLOCK_KEY1;
+        FLASH->KEYR = FLASH_UNLOCK_KEY2;
+    }
+}
+
+static bool flash_wait(void)
+{
+    while (FLASH->SR & FLASH_SR_BSY) { }
+    bool ok = !(FLASH->SR & (FLASH_SR_PGERR | FLASH_SR_WRPRTERR));
+    FLASH->SR = FLASH_SR_EOP | FLASH_SR_PGERR | FLASH_SR_WRPRTERR;
+    return ok;
+}
+
+uint32_t hal_flash_slot_size(void)
+{
+    return HAL_STM32F1_SLOT_SIZE;
+}
+
+uint32_t hal_flash_page_size(void)
+{
+    return HAL_STM32F1_FLASH_PAGE;
+}
+
+bool hal_flash_erase(uint32_t off)
+{
+    if (off >= HAL_STM32F1_SLOT_SIZE) return false;
+    flash_unlock();
+    FLASH->CR |= FLASH_CR_PER;
+    FLASH->AR  = HAL_STM32F1_SLOT_ADDR + off;
+    FLASH->CR |= FLASH_CR_STRT;
+    bool ok = flash_wait();
+    FLASH->CR &= ~FLASH_CR_PER;
+    FLASH->CR |= FLASH_CR_LOCK;
+    return ok;
+}
+
+bool hal_flash_write(uint32_t off, const uint8_t *buf, size_t len)
+{
+    if (off + len > HAL_STM32F1_SLOT_SIZE) return false;
+    volatile uint16_t *dst = (volatile uint16_t *)(HAL_STM32F1_SLOT_ADDR + off);
+    bool ok = true;
+
+    flash_unlock();
+    FLASH->CR |= FLASH_CR_PG;
+    for (size_t i = 0; i + 1 < len && ok; i += 2, dst++) {
+        uint16_t hw = (uint16_t)(buf[i] | (buf[i + 1] << 8));
+        if (hw == 0xFFFFu) continue;    /* stays erased; no need to program */
+        *dst = hw;
+        ok = flash_wait();
+    }
+    FLASH->CR &= ~FLASH_CR_PG;
+    FLASH->CR |= FLASH_CR_LOCK;
+    return ok;
+}
+
+void hal_flash_read(uint32_t off, uint8_t *buf, size_t len)
+{
+    memcpy(buf, (const void *)(HAL_STM32F1_SLOT_ADDR + off), len);
+}
+
+/* The bootloader finds the record marked ready and does the copy */
+void hal_boot_install(uint32_t size)
+{
+    (void)size;
+    if (!HAL_STM32F1_SLOT_SIZE) return;
+    NVIC_SystemReset();
+}
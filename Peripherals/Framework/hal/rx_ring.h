@@ -0,0 +1,76 @@
+#ifndef RS485_RX_RING_H
+#define RS485_RX_RING_H
+
+/* Single-producer / single-consumer byte ring behind hal_uart_rx_span().
+   The producer is the port's UART interrupt (rx_ring_put) or a circular
+   DMA channel writing buf itself (rx_ring_dma_head); the consumer is
+   rs485_slave_poll(). head and tail run free modulo 2^16, so a full ring
+   is told apart from an empty one without a spare slot. */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint8_t  *buf;
+    uint16_t  size;         /* power of two, <= 32768 */
+    uint16_t  head;         /* producer: bytes written */
+    uint16_t  tail;         /* consumer: bytes read    */
+    uint32_t  dropped;      /* bytes lost to a full ring (interrupt producer) */
+} rx_ring_t;
+
+static inline void rx_ring_init(rx_ring_t *r, uint8_t *buf, uint16_t size)
+{
+    r->buf     = buf;
+    r->size    = size;
+    r->head    = 0;
+    r->tail    = 0;
+    r->dropped = 0;
+}
+
+/* Producer, from the RX interrupt. A full ring drops the new byte. */
+static inline void rx_ring_put(rx_ring_t *r, uint8_t b)
+{
+    uint16_t head = r->head;
+    uint16_t tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+    if ((uint16_t)(head - tail) >= r->size) {
+        r->dropped++;
+        return;
+    }
+    r->buf[head & (r->size - 1u)] = b;
+    __atomic_store_n(&r->head, (uint16_t)(head + 1u), __ATOMIC_RELEASE);
+}
+
+/* Producer, for circular DMA: `pos` is the channel's next write index.
+   A DMA ring has no way to notice it lapped the reader; size it for the
+   longest gap between polls. */
+static inline void rx_ring_dma_head(rx_ring_t *r, uint16_t pos)
+{
+    uint16_t tail = r->tail;
+    r->head = (uint16_t)(tail + ((uint16_t)(pos - tail) & (r->size - 1u)));
+}
+
+/* Consumer: the unread bytes up to the end of buf */
+static inline size_t rx_ring_span(rx_ring_t *r, const uint8_t **data)
+{
+    uint16_t head  = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+    uint16_t avail = (uint16_t)(head - r->tail);
+    uint16_t at    = r->tail & (r->size - 1u);
+    uint16_t run   = (uint16_t)(r->size - at);
+    *data = &r->buf[at];
+    return avail < run ? avail : run;
+}
+
+static inline void rx_ring_consume(rx_ring_t *r, size_t n)
+{
+    __atomic_store_n(&r->tail, (uint16_t)(r->tail + n), __ATOMIC_RELEASE);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
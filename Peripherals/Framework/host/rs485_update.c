@@ -0,0 +1,182 @@
+#include "rs485_update.h"
+#include "rs485_proto.h"
+#include "crc32.h"
+
+#include <string.h>
+
+#define NO_REPLY        0xFF
+
+static uint32_t get_u32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static void send_control(rs485_update_t *u, uint8_t cmd)
+{
+    uint8_t p[8] = { 0 };
+    uint8_t n = 0;
+    if (cmd == RS485_CMD_BOOT_BEGIN) {
+        put_u32(&p[0], u->size);
+        put_u32(&p[4], u->crc);
+        n = 8;
+        u->state = RS485_UPDATE_BEGIN;
+    } else if (cmd == RS485_CMD_BOOT_END) {
+        u->state = RS485_UPDATE_END;
+    } else {
+        u->state = RS485_UPDATE_WINDOW;
+    }
+    u->last_cmd = cmd;
+    u->send(u->ctx, cmd, p, n);
+}
+
+static void fail(rs485_update_t *u, uint8_t status)
+{
+    u->status = status;
+    u->state  = RS485_UPDATE_FAILED;
+}
+
+/* Every chunk of the window from base the slave doesn't hold, then the
+   STATUS that writes them out and reports back */
+static void send_window(rs485_update_t *u, uint32_t have)
+{
+    uint8_t p[4 + 255 + 4];
+
+    for (uint32_t i = 0; i < u->window; i++) {
+        uint32_t off = u->base + i * u->chunk;
+        if (off >= u->size) break;
+        if (have & (1u << i)) continue;
+
+        uint32_t n = (u->size - off < u->chunk) ? u->size - off : u->chunk;
+        put_u32(&p[0], off);
+        memcpy(&p[4], &u->image[off], n);
+        put_u32(&p[4 + n], crc32(p, 4u + n));
+        u->send(u->ctx, RS485_CMD_BOOT_DATA, p, (uint8_t)(n + 8u));
+
+        u->chunks_sent++;
+        if (off < u->sent_to) u->chunks_resent++;
+        else                  u->sent_to = off + n;
+    }
+    send_control(u, RS485_CMD_BOOT_STATUS);
+}
+
+/* Lost reply or a flash error: try again, up to RS485_UPDATE_RETRIES */
+static bool retry(rs485_update_t *u, uint8_t status)
+{
+    if (++u->retries > RS485_UPDATE_RETRIES) {
+        fail(u, status);
+        return false;
+    }
+    return true;
+}
+
+void rs485_update_start(rs485_update_t *u, const uint8_t *image, uint32_t size,
+                        uint8_t window_limit, rs485_update_send_t send, void *ctx)
+{
+    memset(u, 0, sizeof(*u));
+    u->image        = image;
+    u->size         = size;
+    u->crc          = crc32(image, size);
+    u->window_limit = window_limit;
+    u->send         = send;
+    u->ctx          = ctx;
+    send_control(u, RS485_CMD_BOOT_BEGIN);
+}
+
+void rs485_update_reply(rs485_update_t *u, uint8_t cmd,
+                        const uint8_t *payload, int len)
+{
+    if (!rs485_update_busy(u)) return;
+
+    /* Nothing back: ask again. A lost STATUS reply costs nothing — the
+       slave has flushed, and the next reply says what it holds. */
+    if (len < 1 || cmd != u->last_cmd) {
+        if (retry(u, NO_REPLY)) send_control(u, u->last_cmd);
+        return;
+    }
+
+    uint8_t status = payload[0];
+    u->status = status;
+
+    switch (cmd) {
+    case RS485_CMD_BOOT_BEGIN:
+        if (status != RS485_BOOT_OK) { fail(u, status); return; }
+        if (len < 7 || payload[1] == 0 || payload[2] == 0) { fail(u, NO_REPLY); return; }
+        u->chunk  = payload[1];
+        u->window = payload[2];
+        if (u->window > 32) u->window = 32;
+        if (u->window_limit && u->window_limit < u->window) u->window = u->window_limit;
+        u->base       = get_u32(&payload[3]);
+        u->resumed_at = u->base;
+        if (u->sent_to < u->base) u->sent_to = u->base;
+        u->retries    = 0;
+        if (u->base >= u->size) send_control(u, RS485_CMD_BOOT_END);
+        else                    send_window(u, 0);
+        return;
+
+    case RS485_CMD_BOOT_STATUS:
+        if (status == RS485_BOOT_ERR_FLASH || status == RS485_BOOT_ERR_NO_SESSION) {
+            /* Flash write failed, or the slave restarted: BEGIN resumes
+               from the last page it has marked done */
+            if (retry(u, status)) send_control(u, RS485_CMD_BOOT_BEGIN);
+            return;
+        }
+        if (status != RS485_BOOT_OK || len < 9) { fail(u, status); return; }
+        u->rounds++;
+        {
+            uint32_t base = get_u32(&payload[1]);
+            if (base > u->base) u->retries = 0;
+            u->base = base;
+        }
+        if (u->base >= u->size) send_control(u, RS485_CMD_BOOT_END);
+        else                    send_window(u, get_u32(&payload[5]));
+        return;
+
+    case RS485_CMD_BOOT_END:
+        if (status == RS485_BOOT_OK) {
+            u->state = RS485_UPDATE_DONE;
+        } else if (status == RS485_BOOT_ERR_NO_SESSION && u->retries) {
+            /* The first END got through and the slave restarted before
+               its reply made it back */
+            u->status = RS485_BOOT_OK;
+            u->state  = RS485_UPDATE_DONE;
+        } else {
+            fail(u, status);
+        }
+        return;
+    }
+}
+
+int rs485_update_percent(const rs485_update_t *u)
+{
+    if (u->state == RS485_UPDATE_DONE) return 100;
+    if (!u->size) return 0;
+    return (int)((uint64_t)u->base * 100u / u->size);
+}
+
+bool rs485_update_busy(const rs485_update_t *u)
+{
+    return u->state == RS485_UPDATE_BEGIN || u->state == RS485_UPDATE_WINDOW ||
+           u->state == RS485_UPDATE_END;
+}
+
+const char *rs485_update_state_name(rs485_update_state_t s)
+{
+    switch (s) {
+    case RS485_UPDATE_IDLE:   return "idle";
+    case RS485_UPDATE_BEGIN:  return "starting";
+    case RS485_UPDATE_WINDOW: return "sending";
+    case RS485_UPDATE_END:    return "checking";
+    case RS485_UPDATE_DONE:   return "done";
+    case RS485_UPDATE_FAILED: return "failed";
+    }
+    return "?";
+}
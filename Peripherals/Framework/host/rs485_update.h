@@ -0,0 +1,81 @@
+#ifndef RS485_UPDATE_H
+#define RS485_UPDATE_H
+
+/* Firmware update over the bus: the master half of the BOOT_* commands
+   (core/rs485_proto.h), for whatever drives the master — the Pi app
+   through PERIPH_CMD, or a host simulation. Transport-free: it hands
+   frames to a send callback and is fed the replies to BEGIN / STATUS /
+   END as they come back. Each round sends a whole window of BOOT_DATA
+   and then one BOOT_STATUS, so the bus never waits on a single chunk. */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Unanswered BEGIN / STATUS / END, or flash errors, in a row before the
+   update gives up; any progress resets the count */
+#ifndef RS485_UPDATE_RETRIES
+#define RS485_UPDATE_RETRIES    5
+#endif
+
+typedef enum {
+    RS485_UPDATE_IDLE = 0,
+    RS485_UPDATE_BEGIN,         /* BOOT_BEGIN out                      */
+    RS485_UPDATE_WINDOW,        /* a window of BOOT_DATA + BOOT_STATUS */
+    RS485_UPDATE_END,           /* BOOT_END out                        */
+    RS485_UPDATE_DONE,          /* slave checked the image, restarting */
+    RS485_UPDATE_FAILED,        /* see status                          */
+} rs485_update_state_t;
+
+/* Put one frame for the slave on the bus (addressing is the caller's) */
+typedef void (*rs485_update_send_t)(void *ctx, uint8_t cmd,
+                                    const uint8_t *payload, uint8_t len);
+
+typedef struct {
+    rs485_update_state_t state;
+    uint8_t              status;        /* last RS485_BOOT_* from the slave;
+                                           0xFF: it stopped answering    */
+    const uint8_t       *image;
+    uint32_t             size;
+    uint32_t             crc;
+    uint32_t             base;          /* bytes the slave has in flash */
+    uint32_t             resumed_at;    /* base BEGIN reported          */
+    uint8_t              chunk;         /* from the BEGIN reply         */
+    uint8_t              window;        /* min(slave's, window_limit)   */
+    uint8_t              window_limit;
+    uint8_t              retries;
+    uint8_t              last_cmd;      /* what a lost reply re-sends   */
+    uint32_t             sent_to;       /* end of the furthest chunk sent */
+    uint32_t             chunks_sent;
+    uint32_t             chunks_resent;
+    uint32_t             rounds;        /* BOOT_STATUS replies          */
+    rs485_update_send_t  send;
+    void                *ctx;
+} rs485_update_t;
+
+/* Start sending image (kept by reference until DONE / FAILED) with at
+   most window_limit chunks per round, 0 = the slave's window. Sends
+   BOOT_BEGIN; a slave holding part of the same image resumes there. */
+void rs485_update_start(rs485_update_t *u, const uint8_t *image, uint32_t size,
+                        uint8_t window_limit, rs485_update_send_t send, void *ctx);
+
+/* The slave's reply to the last BEGIN / STATUS / END, or len < 0 for none
+   (timeout, bad frame). Sends whatever comes next. */
+void rs485_update_reply(rs485_update_t *u, uint8_t cmd,
+                        const uint8_t *payload, int len);
+
+/* 0..100 */
+int rs485_update_percent(const rs485_update_t *u);
+
+bool rs485_update_busy(const rs485_update_t *u);
+
+const char *rs485_update_state_name(rs485_update_state_t s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
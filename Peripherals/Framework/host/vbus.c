@@ -0,0 +1,116 @@
+#define _GNU_SOURCE
+#include "vbus.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static int       s_fd = -1;
+static vbus_cb_t s_cb;
+
+/* vbus_stats(): one request in flight, answered on the reader thread */
+static pthread_mutex_t s_stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  s_stats_cond = PTHREAD_COND_INITIALIZER;
+static vbus_stats_t    s_stats;
+static bool            s_stats_ready;
+
+static void send_msg(uint8_t type, const void *body, size_t len)
+{
+    uint8_t m[VBUS_MAX_MSG];
+    if (s_fd < 0 || len > sizeof(m) - 1u) return;
+    m[0] = type;
+    if (len) memcpy(&m[1], body, len);
+    send(s_fd, m, len + 1u, MSG_NOSIGNAL);
+}
+
+static void *reader(void *arg)
+{
+    (void)arg;
+    uint8_t m[VBUS_MAX_MSG];
+    for (;;) {
+        ssize_t n = recv(s_fd, m, sizeof(m), 0);
+        if (n <= 0) {
+            fprintf(stderr, "vbus: hub closed the bus\n");
+            exit(0);
+        }
+        switch (m[0]) {
+        case VBUS_MSG_RX:
+            if (s_cb.on_rx && n > 1) s_cb.on_rx(s_cb.ctx, &m[1], (size_t)n - 1u);
+            break;
+        case VBUS_MSG_TX_DONE:
+            if (s_cb.on_tx_done) s_cb.on_tx_done(s_cb.ctx);
+            break;
+        case VBUS_MSG_INT:
+            if (s_cb.on_int && n > 1) s_cb.on_int(s_cb.ctx, m[1] != 0);
+            break;
+        case VBUS_MSG_STATS:
+            if ((size_t)n < 1u + sizeof(vbus_stats_t)) break;
+            pthread_mutex_lock(&s_stats_lock);
+            memcpy(&s_stats, &m[1], sizeof(s_stats));
+            s_stats_ready = true;
+            pthread_cond_broadcast(&s_stats_cond);
+            pthread_mutex_unlock(&s_stats_lock);
+            break;
+        }
+    }
+    return NULL;
+}
+
+bool vbus_open(const vbus_cb_t *cb)
+{
+    const char *path = getenv("RS485_VBUS");
+    if (!path || !*path) path = VBUS_DEFAULT_PATH;
+
+    struct sockaddr_un sa = { .sun_family = AF_UNIX };
+    strncpy(sa.sun_path, path, sizeof(sa.sun_path) - 1u);
+
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    if (fd < 0) return false;
+    if (connect(fd, (struct sockaddr *)&sa, sizeof(sa)) < 0) {
+        close(fd);
+        return false;
+    }
+    s_fd = fd;
+    if (cb) s_cb = *cb;
+
+    pthread_t th;
+    if (pthread_create(&th, NULL, reader, NULL) != 0) {
+        close(fd);
+        s_fd = -1;
+        return false;
+    }
+    pthread_detach(th);
+    return true;
+}
+
+void vbus_set_baud(uint32_t baud)
+{
+    send_msg(VBUS_MSG_BAUD, &baud, sizeof(baud));
+}
+
+void vbus_send(const uint8_t *buf, size_t len)
+{
+    send_msg(VBUS_MSG_TX, buf, len);
+}
+
+void vbus_set_int(bool asserted)
+{
+    uint8_t a = asserted ? 1u : 0u;
+    send_msg(VBUS_MSG_INT, &a, 1);
+}
+
+bool vbus_stats(vbus_stats_t *out)
+{
+    if (s_fd < 0) return false;
+    pthread_mutex_lock(&s_stats_lock);
+    s_stats_ready = false;
+    send_msg(VBUS_MSG_STATS, NULL, 0);
+    while (!s_stats_ready) pthread_cond_wait(&s_stats_cond, &s_stats_lock);
+    *out = s_stats;
+    pthread_mutex_unlock(&s_stats_lock);
+    return true;
+}
@@ -0,0 +1,72 @@
+#ifndef RS485_VBUS_H
+#define RS485_VBUS_H
+
+/* Virtual RS-485 bus for running the master, slaves and tools as Linux
+   processes: each is a node on a hub (host/vbus_hub.c) reached over a
+   Unix-domain socket, $RS485_VBUS or VBUS_DEFAULT_PATH. The hub plays
+   the wire: a node's frame reaches every other node a byte at a time at
+   its line rate, a receiver on a different rate sees noise, frames that
+   overlap garble each other, and /INT is wired-OR across the nodes.
+
+   Client side. One connection per process; callbacks run on its reader
+   thread, as an interrupt would. */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define VBUS_DEFAULT_PATH   "/tmp/rs485_vbus"
+
+/* Messages, one per SOCK_SEQPACKET packet: a type byte then its body */
+#define VBUS_MSG_BAUD       0x01    /* node → hub: [baud u32]                     */
+#define VBUS_MSG_TX         0x02    /* node → hub: frame bytes                    */
+#define VBUS_MSG_INT        0x03    /* node → hub: [asserted u8]; hub → node: [low u8] */
+#define VBUS_MSG_STATS      0x04    /* node → hub: empty; hub → node: vbus_stats_t */
+#define VBUS_MSG_RX         0x81    /* hub → node: bytes off the line             */
+#define VBUS_MSG_TX_DONE    0x82    /* hub → node: last stop bit of our frame out */
+
+#define VBUS_MAX_MSG        1024
+
+/* Hub counters since it started */
+typedef struct {
+    uint64_t uptime_ns;
+    uint64_t busy_ns;           /* time anything was on the line        */
+    uint64_t frames;            /* TX messages put on the line          */
+    uint64_t bytes;
+    uint64_t collisions;        /* frames that overlapped another       */
+    uint32_t nodes;             /* connected now                        */
+} vbus_stats_t;
+
+typedef struct {
+    void (*on_rx)(void *ctx, const uint8_t *data, size_t len);
+    void (*on_tx_done)(void *ctx);
+    void (*on_int)(void *ctx, bool low);        /* /INT line level changed */
+    void  *ctx;
+} vbus_cb_t;
+
+/* Connect and start the reader thread. The process exits when the hub
+   goes away. False if no hub is listening. */
+bool vbus_open(const vbus_cb_t *cb);
+
+/* Line rate of this node's UART, for both directions */
+void vbus_set_baud(uint32_t baud);
+
+/* Put a frame on the line; on_tx_done fires once it is out. A frame sent
+   before the last one is out follows it back to back. */
+void vbus_send(const uint8_t *buf, size_t len);
+
+/* Pull /INT low (true) or release it */
+void vbus_set_int(bool asserted);
+
+/* Ask the hub for its counters; blocks until the reply */
+bool vbus_stats(vbus_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,401 @@
+/*
+ * Virtual RS-485 bus hub (host/vbus.h)
+ *
+ * Plays the wire between the nodes connected to its Unix-domain socket.
+ * A frame goes on the line when its TX message arrives, or back to back
+ * after the sender's previous one, and reaches every other node a byte at
+ * a time as each byte's stop bit would — in batches at most one tick
+ * apart, as a UART's FIFO and RX timeout would hand them over. The sender
+ * hears nothing of its own frame (DE and /RE tied) and gets TX_DONE when
+ * the last byte is out. A receiver on a different rate from the sender
+ * gets what its UART would sample from the frame's waveform. Frames from
+ * two nodes that overlap on the line garble the bytes that overlap, in
+ * both, and count as a collision. /INT is open-drain: low while any node
+ * pulls it, every change sent to all.
+ *
+ * Runs in real time on CLOCK_MONOTONIC; prints its counters on exit.
+ *
+ * Usage:  vbus_hub [-p path] [-t tick_us] [-v]
+ */
+
+#define _GNU_SOURCE
+#include "vbus.h"
+
+#include <errno.h>
+#include <math.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#define HUB_MAX_NODES       64
+#define HUB_MAX_XFERS       128
+#define HUB_DEFAULT_BAUD    115200u     /* until a node says otherwise */
+#define HUB_TICK_US         50u
+
+typedef struct {
+    int      fd;            /* -1 = free */
+    uint32_t baud;
+    bool     int_low;
+    uint64_t tx_end_ns;     /* end of this node's last frame on the line */
+} node_t;
+
+typedef struct {
+    bool     used;
+    int      node;          /* sender; -1 once it has gone */
+    uint32_t baud;
+    uint64_t t0_ns;         /* first start bit */
+    uint64_t byte_ns;
+    uint16_t len;
+    uint16_t sent;          /* bytes already handed to the receivers */
+    uint8_t  data[VBUS_MAX_MSG];
+} xfer_t;
+
+static node_t       s_node[HUB_MAX_NODES];
+static xfer_t       s_xfer[HUB_MAX_XFERS];
+static vbus_stats_t s_stats;
+static uint64_t     s_t0_ns, s_busy_until_ns;
+static bool         s_line_low, s_verbose;
+static uint32_t     s_rng = 0x2545F491u;
+static volatile sig_atomic_t s_stop;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static uint8_t noise(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return (uint8_t)s_rng;
+}
+
+static void node_send(int i, uint8_t type, const uint8_t *body, size_t len)
+{
+    uint8_t m[VBUS_MAX_MSG];
+    if (s_node[i].fd < 0) return;
+    m[0] = type;
+    if (len) memcpy(&m[1], body, len);
+    send(s_node[i].fd, m, len + 1u, MSG_NOSIGNAL | MSG_DONTWAIT);
+}
+
+/* ------------------------------------------------------------------ */
+/* The line                                                             */
+/* ------------------------------------------------------------------ */
+
+static uint64_t xfer_end(const xfer_t *x)
+{
+    return x->t0_ns + x->len * x->byte_ns;
+}
+
+/* Garble x's bytes on the line during [from, to) that nobody has yet */
+static void garble(xfer_t *x, uint64_t from, uint64_t to)
+{
+    uint64_t a = from > x->t0_ns ? (from - x->t0_ns) / x->byte_ns : 0;
+    uint64_t b = (to - x->t0_ns + x->byte_ns - 1u) / x->byte_ns;
+    if (b > x->len) b = x->len;
+    for (uint64_t k = a < x->sent ? x->sent : a; k < b; k++) {
+        x->data[k] ^= (uint8_t)(noise() | 1u);
+    }
+}
+
+static void line_put(int node, const uint8_t *buf, size_t len, uint64_t now)
+{
+    if (!len) return;
+    xfer_t *x = NULL;
+    for (int i = 0; i < HUB_MAX_XFERS && !x; i++) {
+        if (!s_xfer[i].used) x = &s_xfer[i];
+    }
+    if (!x) {
+        fprintf(stderr, "vbus_hub: too many frames on the line, one dropped\n");
+        return;
+    }
+
+    node_t *n = &s_node[node];
+    x->used    = true;
+    x->node    = node;
+    x->baud    = n->baud;
+    x->byte_ns = 10000000000ull / n->baud;
+    x->t0_ns   = n->tx_end_ns > now ? n->tx_end_ns : now;
+    x->len     = (uint16_t)len;
+    x->sent    = 0;
+    memcpy(x->data, buf, len);
+    n->tx_end_ns = xfer_end(x);
+
+    /* Another node driving the line at the same time: both lose */
+    for (int i = 0; i < HUB_MAX_XFERS; i++) {
+        xfer_t *o = &s_xfer[i];
+        if (!o->used || o == x || o->node == node) continue;
+        uint64_t from = o->t0_ns > x->t0_ns ? o->t0_ns : x->t0_ns;
+        uint64_t to   = xfer_end(o) < xfer_end(x) ? xfer_end(o) : xfer_end(x);
+        if (from >= to) continue;
+        garble(o, from, to);
+        garble(x, from, to);
+        s_stats.collisions++;
+        if (s_verbose) printf("%10.6f  collision: node %d and node %d\n",
+                              (double)(now - s_t0_ns) / 1e9, node, o->node);
+    }
+
+    s_stats.frames++;
+    s_stats.bytes += len;
+    uint64_t busy_from = x->t0_ns > s_busy_until_ns ? x->t0_ns : s_busy_until_ns;
+    if (xfer_end(x) > busy_from) {
+        s_stats.busy_ns  += xfer_end(x) - busy_from;
+        s_busy_until_ns   = xfer_end(x);
+    }
+
+    if (s_verbose) {
+        printf("%10.6f  node %d @%u:", (double)(x->t0_ns - s_t0_ns) / 1e9, node, x->baud);
+        for (size_t i = 0; i < len; i++) printf(" %02X", buf[i]);
+        printf("\n");
+    }
+}
+
+/* Line level `t` ns into x: start bit, 8 data bits LSB first, stop bit,
+   then idle high */
+static int line_level(const xfer_t *x, double bit_ns, double t)
+{
+    if (t < 0) return 1;
+    uint64_t i = (uint64_t)(t / bit_ns);
+    uint64_t k = i / 10u, b = i % 10u;
+    if (k >= x->len || b == 9u) return 1;
+    return b == 0u ? 0 : (x->data[k] >> (b - 1u)) & 1;
+}
+
+/* What a UART at `baud` makes of x: waits for a falling edge, samples
+   each bit mid-way at its own rate and keeps the byte whatever its stop
+   bit says, as the ports' RX interrupts do */
+static size_t line_sample(const xfer_t *x, uint32_t baud, uint8_t *out)
+{
+    double tb  = 1e9 / ((double)x->baud), rb = 1e9 / (double)baud;
+    double end = (double)x->len * 10.0 * tb;
+    double t   = 0;
+    size_t n   = 0;
+    bool   idle = true;         /* high since the last stop bit */
+    while (t < end && n < VBUS_MAX_MSG - 1u) {
+        while (!idle && t < end && line_level(x, tb, t) == 0) t = (floor(t / tb) + 1.0) * tb;
+        while (t < end && line_level(x, tb, t) == 1) t = (floor(t / tb) + 1.0) * tb;
+        if (t >= end) break;
+        uint8_t v = 0;
+        for (int j = 0; j < 8; j++) {
+            v |= (uint8_t)(line_level(x, tb, t + (j + 1.5) * rb) << j);
+        }
+        out[n++] = v;
+        t   += 9.5 * rb;
+        idle = line_level(x, tb, t) == 1;
+    }
+    return n;
+}
+
+/* Hand every byte whose stop bit is past to the receivers on the
+   sender's rate; the others get what they sampled when the frame ends.
+   Returns the time the next byte is due, or UINT64_MAX. */
+static uint64_t line_deliver(uint64_t now)
+{
+    uint64_t next = UINT64_MAX;
+    for (int i = 0; i < HUB_MAX_XFERS; i++) {
+        xfer_t *x = &s_xfer[i];
+        if (!x->used) continue;
+
+        uint64_t due = now > x->t0_ns ? (now - x->t0_ns) / x->byte_ns : 0;
+        if (due > x->len) due = x->len;
+        if (due > x->sent) {
+            for (int r = 0; r < HUB_MAX_NODES; r++) {
+                if (s_node[r].fd < 0 || r == x->node || s_node[r].baud != x->baud) continue;
+                node_send(r, VBUS_MSG_RX, &x->data[x->sent], (size_t)due - x->sent);
+            }
+            x->sent = (uint16_t)due;
+        }
+        if (x->sent < x->len) {
+            uint64_t t = x->t0_ns + (x->sent + 1u) * x->byte_ns;
+            if (t < next) next = t;
+            continue;
+        }
+
+        uint8_t junk[VBUS_MAX_MSG];
+        for (int r = 0; r < HUB_MAX_NODES; r++) {
+            if (s_node[r].fd < 0 || r == x->node || s_node[r].baud == x->baud) continue;
+            size_t n = line_sample(x, s_node[r].baud, junk);
+            if (n) node_send(r, VBUS_MSG_RX, junk, n);
+        }
+        if (x->node >= 0) node_send(x->node, VBUS_MSG_TX_DONE, NULL, 0);
+        x->used = false;
+    }
+    return next;
+}
+
+/* ------------------------------------------------------------------ */
+/* Nodes                                                                */
+/* ------------------------------------------------------------------ */
+
+static void int_update(void)
+{
+    bool low = false;
+    for (int i = 0; i < HUB_MAX_NODES; i++) {
+        if (s_node[i].fd >= 0 && s_node[i].int_low) low = true;
+    }
+    if (low == s_line_low) return;
+    s_line_low = low;
+    uint8_t l = low ? 1u : 0u;
+    for (int i = 0; i < HUB_MAX_NODES; i++) node_send(i, VBUS_MSG_INT, &l, 1);
+}
+
+static void node_accept(int lfd)
+{
+    int fd = accept(lfd, NULL, NULL);
+    if (fd < 0) return;
+    for (int i = 0; i < HUB_MAX_NODES; i++) {
+        if (s_node[i].fd >= 0) continue;
+        s_node[i] = (node_t){ .fd = fd, .baud = HUB_DEFAULT_BAUD };
+        s_stats.nodes++;
+        uint8_t l = s_line_low ? 1u : 0u;
+        node_send(i, VBUS_MSG_INT, &l, 1);
+        return;
+    }
+    fprintf(stderr, "vbus_hub: %d nodes already, connection refused\n", HUB_MAX_NODES);
+    close(fd);
+}
+
+static void node_close(int i)
+{
+    close(s_node[i].fd);
+    s_node[i].fd = -1;
+    s_stats.nodes--;
+    for (int k = 0; k < HUB_MAX_XFERS; k++) {
+        if (s_xfer[k].used && s_xfer[k].node == i) s_xfer[k].node = -1;
+    }
+    int_update();
+}
+
+static void node_read(int i, uint64_t now)
+{
+    uint8_t m[VBUS_MAX_MSG];
+    ssize_t n = recv(s_node[i].fd, m, sizeof(m), MSG_DONTWAIT);
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR)) {
+        node_close(i);
+        return;
+    }
+    if (n <= 0) return;
+
+    switch (m[0]) {
+    case VBUS_MSG_BAUD: {
+        uint32_t baud;
+        if (n < 5) break;
+        memcpy(&baud, &m[1], sizeof(baud));
+        if (baud) s_node[i].baud = baud;
+        break;
+    }
+    case VBUS_MSG_TX:
+        line_put(i, &m[1], (size_t)n - 1u, now);
+        break;
+    case VBUS_MSG_INT:
+        if (n < 2) break;
+        s_node[i].int_low = m[1] != 0;
+        int_update();
+        break;
+    case VBUS_MSG_STATS: {
+        vbus_stats_t st = s_stats;
+        st.uptime_ns = now - s_t0_ns;
+        node_send(i, VBUS_MSG_STATS, (const uint8_t *)&st, sizeof(st));
+        break;
+    }
+    }
+}
+
+/* ------------------------------------------------------------------ */
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    s_stop = 1;
+}
+
+int main(int argc, char **argv)
+{
+    const char *path    = getenv("RS485_VBUS");
+    uint64_t    tick_ns = HUB_TICK_US * 1000ull;
+    int opt;
+    while ((opt = getopt(argc, argv, "p:t:v")) != -1) {
+        switch (opt) {
+        case 'p': path    = optarg; break;
+        case 't': tick_ns = strtoull(optarg, NULL, 0) * 1000ull; break;
+        case 'v': s_verbose = true; break;
+        default:
+            fprintf(stderr, "usage: %s [-p path] [-t tick_us] [-v]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (!path || !*path) path = VBUS_DEFAULT_PATH;
+
+    struct sockaddr_un sa = { .sun_family = AF_UNIX };
+    strncpy(sa.sun_path, path, sizeof(sa.sun_path) - 1u);
+    int lfd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    unlink(path);
+    if (lfd < 0 || bind(lfd, (struct sockaddr *)&sa, sizeof(sa)) < 0 ||
+        listen(lfd, HUB_MAX_NODES) < 0) {
+        perror("vbus_hub");
+        return 1;
+    }
+
+    struct sigaction act = { .sa_handler = on_signal };
+    sigaction(SIGINT, &act, NULL);
+    sigaction(SIGTERM, &act, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    for (int i = 0; i < HUB_MAX_NODES; i++) s_node[i].fd = -1;
+    s_t0_ns = now_ns();
+    printf("vbus_hub: listening on %s, %llu us tick\n", path,
+           (unsigned long long)(tick_ns / 1000u));
+    fflush(stdout);
+
+    struct pollfd pfd[HUB_MAX_NODES + 1];
+    int           idx[HUB_MAX_NODES + 1];
+    uint64_t      last = s_t0_ns;
+    while (!s_stop) {
+        uint64_t now  = now_ns();
+        uint64_t next = line_deliver(now);
+        if (next != UINT64_MAX && next < last + tick_ns) next = last + tick_ns;
+        last = now;
+        if (s_verbose) fflush(stdout);
+
+        int np = 0;
+        pfd[np].fd = lfd; pfd[np].events = POLLIN; idx[np++] = -1;
+        for (int i = 0; i < HUB_MAX_NODES; i++) {
+            if (s_node[i].fd < 0) continue;
+            pfd[np].fd = s_node[i].fd; pfd[np].events = POLLIN; idx[np++] = i;
+        }
+
+        struct timespec  ts, *tp = NULL;
+        if (next != UINT64_MAX) {
+            uint64_t wait = next > now ? next - now : 0;
+            ts.tv_sec  = (time_t)(wait / 1000000000u);
+            ts.tv_nsec = (long)(wait % 1000000000u);
+            tp = &ts;
+        }
+        if (ppoll(pfd, (nfds_t)np, tp, NULL) <= 0) continue;
+
+        now = now_ns();
+        for (int k = 0; k < np; k++) {
+            if (!(pfd[k].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+            if (idx[k] < 0) node_accept(lfd);
+            else if (s_node[idx[k]].fd >= 0) node_read(idx[k], now);
+        }
+    }
+
+    uint64_t up = now_ns() - s_t0_ns;
+    printf("vbus_hub: %.1f s, %llu frames, %llu bytes, bus busy %.1f %%, %llu collisions\n",
+           (double)up / 1e9, (unsigned long long)s_stats.frames,
+           (unsigned long long)s_stats.bytes, 100.0 * (double)s_stats.busy_ns / (double)up,
+           (unsigned long long)s_stats.collisions);
+    unlink(path);
+    return 0;
+}
@@ -0,0 +1,35 @@
+#include "board.h"
+
+#include <stdio.h>
+
+/* LightBar as a Linux process on the virtual bus (hal_posix.c): the
+   strip is a line on stdout, written from board_tick() when anything
+   changed — where the MCU ports push pixels. */
+
+static uint8_t  s_brightness;
+static uint8_t  s_mode;
+static uint16_t s_colour;
+static uint8_t  s_dirty;
+
+void     board_init(void)                         { s_dirty = 1; }
+void     board_set_brightness(uint8_t b)          { s_brightness = b; s_dirty = 1; }
+uint8_t  board_get_brightness(void)               { return s_brightness; }
+void     board_set_mode(uint8_t m)                { s_mode = m;       s_dirty = 1; }
+uint8_t  board_get_mode(void)                     { return s_mode; }
+void     board_set_colour_rgb16(uint16_t c)       { s_colour = c;     s_dirty = 1; }
+uint16_t board_get_colour_rgb16(void)             { return s_colour; }
+
+void board_tick(void)
+{
+    if (!s_dirty) return;
+    s_dirty = 0;
+    printf("lightbar: %u pixels, colour 0x%04X, brightness %u, mode %u\n",
+           BOARD_NUM_PIXELS, s_colour, s_brightness, s_mode);
+    fflush(stdout);
+}
+
+uint16_t board_estimate_power_mw(void)
+{
+    uint32_t mw = (uint32_t)BOARD_NUM_PIXELS * 60u * s_brightness / 255u;
+    return mw > 0xFFFFu ? 0xFFFFu : (uint16_t)mw;
+}
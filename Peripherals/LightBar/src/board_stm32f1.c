@@ -2,48 +2,95 @@
 
 #include "stm32f1xx.h"
 
+#include <stdbool.h>
+#include <string.h>
+
 /* LightBar on STM32F103C8T6 (KL-GCS-MODBUS03): WS2812B (LED1) on PB0.
    On this board only one LED is fitted, but the framework happily
    streams BOARD_NUM_PIXELS worth of bits — the extra bits clock past
    the last LED and are discarded.
 
-   Bit-bang protocol — at 64 MHz SYSCLK, 1 cycle = 15.625 ns. WS2812B:
-       T0H ≈ 0.35 µs ≈ 22 cycles
-       T1H ≈ 0.70 µs ≈ 45 cycles
-       period ≈ 1.25 µs ≈ 80 cycles
-   Cycle-accurate timing is enforced via the DWT cycle counter and the
-   send loop runs with interrupts disabled. */
+   PB0 is TIM3_CH3, so the strip is driven by PWM: one timer period per
+   bit, its duty cycle reloaded from a bit buffer by DMA on each update
+   event (TIM3_UP is DMA1 channel 3). The CPU only fills the buffer;
+   interrupts stay on and the main loop goes back to rs485_slave_poll()
+   while the strip clocks out (~1 ms for 32 pixels).
+
+   TIM3 runs at 64 MHz (APB1 /2, doubled for the timers), 1 tick =
+   15.625 ns. WS2812B:
+       T0H ≈ 0.35 µs ≈ 22 ticks
+       T1H ≈ 0.70 µs ≈ 45 ticks
+       period ≈ 1.25 µs ≈ 80 ticks
+   RAM: one byte per bit, 24 per pixel — the price of a larger
+   BOARD_NUM_PIXELS. */
 
 #undef BOARD_PIN_LED
-#define BOARD_PIN_LED   0u    /* PB0 (LED1) */
+#define BOARD_PIN_LED   0u    /* PB0 (LED1), TIM3_CH3 */
 
 #define WS2812_T0H_CYC  22u
 #define WS2812_T1H_CYC  45u
 #define WS2812_BIT_CYC  80u
 
+/* Low periods after the last bit (60 µs): the strip latches after ≥50 µs
+   low, and the DMA finishes a period or two before the timer does */
+#define WS2812_RESET_BITS   48u
+
+#define WS2812_DMA          DMA1_Channel3
+
 static uint8_t  s_brightness;
 static uint8_t  s_mode;
 static uint16_t s_colour;
 static uint8_t  s_dirty;
 
-static void dwt_init(void)
+/* CCR3 per bit, then the reset; 8-bit entries widened to CCR by the DMA */
+static uint8_t  s_bits[BOARD_NUM_PIXELS * 24 + WS2812_RESET_BITS];
+
+static void ws2812_init(void)
 {
-    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
-    DWT->CYCCNT = 0;
-    DWT->CTRL  |= DWT_CTRL_CYCCNTENA_Msk;
+    RCC->AHBENR  |= RCC_AHBENR_DMA1EN;
+    RCC->APB1ENR |= RCC_APB1ENR_TIM3EN;
+
+    /* PWM mode 1 on CH3 with CCR preload, so each DMA write takes effect
+       at the next period boundary. Idle: CCR3 = 0, output held low. */
+    TIM3->CR1   = 0;
+    TIM3->PSC   = 0;
+    TIM3->ARR   = WS2812_BIT_CYC - 1u;
+    TIM3->CCR3  = 0;
+    TIM3->CCMR2 = TIM_CCMR2_OC3M_2 | TIM_CCMR2_OC3M_1 | TIM_CCMR2_OC3PE;
+    TIM3->CCER  = TIM_CCER_CC3E;
+    TIM3->CR1   = TIM_CR1_ARPE;
+    TIM3->EGR   = TIM_EGR_UG;
+
+    /* Memory byte -> CCR3 halfword, one per update request */
+    WS2812_DMA->CCR  = 0;
+    WS2812_DMA->CPAR = (uint32_t)&TIM3->CCR3;
+    WS2812_DMA->CMAR = (uint32_t)s_bits;
 }
 
-static inline void ws2812_send_byte(uint8_t b)
+/* Last frame still clocking out (the reset included) */
+static bool ws2812_busy(void)
 {
-    for (int i = 0; i < 8; i++) {
-        uint32_t t = DWT->CYCCNT;
-        GPIOB->BSRR = (1u << BOARD_PIN_LED);
-        uint32_t hi = (b & 0x80) ? WS2812_T1H_CYC : WS2812_T0H_CYC;
-        while ((DWT->CYCCNT - t) < hi) { }
-        GPIOB->BSRR = (1u << (BOARD_PIN_LED + 16));
-        while ((DWT->CYCCNT - t) < WS2812_BIT_CYC) { }
-        b <<= 1;
-    }
+    if (!(WS2812_DMA->CCR & DMA_CCR_EN)) return false;
+    if (WS2812_DMA->CNDTR) return true;
+
+    /* DMA done: the reset bits it wrote last leave the line low */
+    TIM3->CR1       &= ~TIM_CR1_CEN;
+    TIM3->DIER       = 0;
+    WS2812_DMA->CCR  = 0;
+    return false;
+}
+
+static void ws2812_start(void)
+{
+    DMA1->IFCR        = DMA_IFCR_CGIF3;
+    WS2812_DMA->CNDTR = sizeof(s_bits);
+    WS2812_DMA->CCR   = DMA_CCR_DIR | DMA_CCR_MINC | DMA_CCR_PSIZE_0 | DMA_CCR_EN;
+
+    /* CNT restarts at 0 with CCR3 still 0: one low period ahead of bit 0 */
+    TIM3->CNT   = 0;
+    TIM3->SR    = 0;
+    TIM3->DIER  = TIM_DIER_UDE;
+    TIM3->CR1  |= TIM_CR1_CEN;
 }
 
 /* RGB16 565 → 24-bit GRB (WS2812 wire order). */
@@ -65,24 +112,29 @@ static void ws2812_send_strip(uint16_t colour, uint8_t bright)
     uint8_t grb[3];
     rgb16_to_grb(colour, bright, grb);
 
-    __disable_irq();
-    for (int n = 0; n < BOARD_NUM_PIXELS; n++) {
-        ws2812_send_byte(grb[0]);
-        ws2812_send_byte(grb[1]);
-        ws2812_send_byte(grb[2]);
+    /* Every pixel the same colour: encode one, repeat it */
+    uint8_t *o = s_bits;
+    for (int i = 0; i < 3; i++) {
+        for (int bit = 7; bit >= 0; bit--) {
+            *o++ = ((grb[i] >> bit) & 1u) ? WS2812_T1H_CYC : WS2812_T0H_CYC;
+        }
     }
-    __enable_irq();
-    /* Latch: line low ≥50 µs handled naturally by main-loop cadence. */
+    for (int n = 1; n < BOARD_NUM_PIXELS; n++, o += 24) {
+        memcpy(o, s_bits, 24);
+    }
+    memset(o, 0, WS2812_RESET_BITS);
+
+    ws2812_start();
 }
 
 void board_init(void)
 {
     RCC->APB2ENR |= RCC_APB2ENR_IOPBEN;
-    /* PB0 = output push-pull 50 MHz: CRL nibble at bit 0 → 0x3. */
-    GPIOB->CRL = (GPIOB->CRL & ~(0xFu << 0)) | (0x3u << 0);
-    GPIOB->BSRR = (1u << (BOARD_PIN_LED + 16));   /* idle low */
+    /* PB0 = alternate-function push-pull 50 MHz (TIM3_CH3): CRL nibble
+       at bit 0 → 0xB. CCR3 = 0 keeps it low. */
+    GPIOB->CRL = (GPIOB->CRL & ~(0xFu << 0)) | (0xBu << 0);
 
-    dwt_init();
+    ws2812_init();
     s_dirty = 1;
 }
 
@@ -95,7 +147,8 @@ uint16_t board_get_colour_rgb16(void)       { return s_colour; }
 
 void board_tick(void)
 {
-    if (!s_dirty) return;
+    /* A change during a frame goes out once it has finished */
+    if (!s_dirty || ws2812_busy()) return;
     s_dirty = 0;
     ws2812_send_strip(s_colour, s_brightness);
 }
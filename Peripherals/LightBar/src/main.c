@@ -10,19 +10,8 @@ static int h_set_output(const uint8_t *p, uint8_t n,
     return 0;
 }
 
-static int h_set_param(const uint8_t *p, uint8_t n,
-                       uint8_t *r, uint8_t rs)
-{
-    (void)r; (void)rs;
-    if (n != 3) return -1;
-    uint16_t v = (uint16_t)(p[1] | (p[2] << 8));
-    switch (p[0]) {
-    case LB_PARAM_MODE:   board_set_mode((uint8_t)v); break;
-    case LB_PARAM_COLOUR: board_set_colour_rgb16(v);  break;
-    default: return -1;
-    }
-    return 0;
-}
+static uint16_t get_mode(void)       { return board_get_mode(); }
+static void     set_mode(uint16_t v) { board_set_mode((uint8_t)v); }
 
 static int h_get_status(const uint8_t *p, uint8_t n,
                         uint8_t *r, uint8_t rs)
@@ -46,11 +35,19 @@ static int build_stream(uint8_t *buf, uint8_t buf_size)
     return 2;
 }
 
-static const rs485_handler_t s_handlers[] = {
-    { RS485_CMD_SET_OUTPUT, h_set_output },
-    { RS485_CMD_SET_PARAM,  h_set_param  },
-    { RS485_CMD_GET_STATUS, h_get_status },
-    { 0, NULL }
+#define APP_COMMANDS(X)                     \
+    X(RS485_CMD_SET_OUTPUT, h_set_output)   \
+    X(RS485_CMD_GET_STATUS, h_get_status)
+RS485_DISPATCH_TABLE(s_dispatch, APP_COMMANDS);
+
+/* GET_PARAM / SET_PARAM are served by the framework from this table */
+static const rs485_param_t s_params[] = {
+    { .id = LB_PARAM_MODE,   .type = RS485_PARAM_U16,
+      .min = LB_MODE_SOLID, .max = LB_MODE_BREATHE,
+      .get = get_mode, .set = set_mode },
+    { .id = LB_PARAM_COLOUR, .type = RS485_PARAM_U16,
+      .min = 0, .max = 0xFFFF,
+      .get = board_get_colour_rgb16, .set = board_set_colour_rgb16 },
 };
 
 int main(void)
@@ -59,7 +56,10 @@ int main(void)
     rs485_slave_cfg_t cfg = {
         .addr        = BOARD_ADDR,
         .fw_version  = 1,
-        .handlers    = s_handlers,
+        .groups      = RS485_GROUP_BIT(RS485_GROUP_LIGHTS),
+        .dispatch    = s_dispatch,
+        .params      = s_params,
+        .n_params    = sizeof(s_params) / sizeof(s_params[0]),
         .build_stream = build_stream,
     };
     rs485_slave_init(&cfg);
@@ -0,0 +1,45 @@
+#include "board.h"
+#include "hal.h"
+
+#include <stdio.h>
+
+/* PanTilt as a Linux process on the virtual bus (hal_posix.c). Each
+   servo slews to its set angle at SIM_DEG_PER_S, so board_is_moving()
+   reports something a real gimbal would; arrivals go to stdout. */
+
+#define SIM_DEG_PER_S   300u
+
+static uint8_t  s_target[2];
+static uint8_t  s_start[2];
+static uint32_t s_start_ms[2];
+
+static uint8_t servo_pos(uint8_t ch)
+{
+    uint32_t moved = (hal_millis() - s_start_ms[ch]) * SIM_DEG_PER_S / 1000u;
+    uint8_t  a = s_start[ch], t = s_target[ch];
+    if (a < t) return (uint8_t)(moved >= (uint32_t)(t - a) ? t : a + moved);
+    return (uint8_t)(moved >= (uint32_t)(a - t) ? t : a - moved);
+}
+
+void board_init(void)
+{
+    s_target[0] = s_target[1] = s_start[0] = s_start[1] = 90;
+}
+
+void board_set_angle(uint8_t ch, uint8_t deg)
+{
+    if (ch > 1) return;
+    if (deg > 180) deg = 180;
+    s_start[ch]    = servo_pos(ch);
+    s_start_ms[ch] = hal_millis();
+    s_target[ch]   = deg;
+    printf("pantilt: %s -> %u deg\n", ch == 0 ? "pan" : "tilt", deg);
+    fflush(stdout);
+}
+
+uint8_t board_get_angle(uint8_t ch) { return ch < 2 ? servo_pos(ch) : 0; }
+
+uint8_t board_is_moving(void)
+{
+    return servo_pos(0) != s_target[0] || servo_pos(1) != s_target[1];
+}
@@ -21,17 +21,16 @@ static int h_get_status(const uint8_t *p, uint8_t n,
     return 3;
 }
 
-static const rs485_handler_t s_handlers[] = {
-    { RS485_CMD_SET_OUTPUT, h_set_output },
-    { RS485_CMD_GET_STATUS, h_get_status },
-    { 0, NULL }
-};
+#define APP_COMMANDS(X)                     \
+    X(RS485_CMD_SET_OUTPUT, h_set_output)   \
+    X(RS485_CMD_GET_STATUS, h_get_status)
+RS485_DISPATCH_TABLE(s_dispatch, APP_COMMANDS);
 
 int main(void)
 {
     board_init();
     rs485_slave_cfg_t cfg = {
-        .addr = BOARD_ADDR, .fw_version = 1, .handlers = s_handlers,
+        .addr = BOARD_ADDR, .fw_version = 1, .dispatch = s_dispatch,
     };
     rs485_slave_init(&cfg);
     while (1) rs485_slave_poll();
@@ -0,0 +1,48 @@
+#include "board.h"
+#include "hal.h"
+
+#include <stdio.h>
+
+/* Searchlight as a Linux process on the virtual bus (hal_posix.c). The
+   LED is a line on stdout; the NTC reads a first-order thermal model
+   that settles at 25 °C + 70 °C × duty with a 10 s time constant, so
+   running at full power trips the over-temperature /INT in a few
+   seconds and dimming clears it. */
+
+#define SIM_AMBIENT_C   25
+#define SIM_RISE_C      70
+#define SIM_TAU_MS      10000
+
+static uint8_t  s_duty;
+static int32_t  s_temp_mc = SIM_AMBIENT_C * 1000;   /* milli-°C */
+static uint32_t s_temp_ms;
+
+void board_init(void)
+{
+    s_temp_ms = hal_millis();
+}
+
+void board_set_pwm(uint8_t duty)
+{
+    if (duty != s_duty) printf("searchlight: pwm %u\n", duty);
+    fflush(stdout);
+    s_duty = duty;
+}
+
+uint8_t board_get_pwm(void) { return s_duty; }
+
+int8_t board_read_temp_c(void)
+{
+    uint32_t now = hal_millis();
+    uint32_t dt  = now - s_temp_ms;
+    if (dt) {
+        int32_t target = (SIM_AMBIENT_C + SIM_RISE_C * s_duty / 255) * 1000;
+        if (dt > SIM_TAU_MS) dt = SIM_TAU_MS;
+        s_temp_mc += (int32_t)((int64_t)(target - s_temp_mc) * dt / SIM_TAU_MS);
+        s_temp_ms  = now;
+    }
+    return (int8_t)(s_temp_mc / 1000);
+}
+
+bool    board_overtemp(void)    { return board_read_temp_c() >= BOARD_OVERTEMP_C; }
+uint8_t board_fault_flags(void) { return board_overtemp() ? FAULT_OVERTEMP : 0; }
@@ -24,11 +24,10 @@ static int h_get_status(const uint8_t *p, uint8_t n,
     return 3;
 }
 
-static const rs485_handler_t s_handlers[] = {
-    { RS485_CMD_SET_OUTPUT, h_set_output },
-    { RS485_CMD_GET_STATUS, h_get_status },
-    { 0, NULL }
-};
+#define APP_COMMANDS(X)                     \
+    X(RS485_CMD_SET_OUTPUT, h_set_output)   \
+    X(RS485_CMD_GET_STATUS, h_get_status)
+RS485_DISPATCH_TABLE(s_dispatch, APP_COMMANDS);
 
 int main(void)
 {
@@ -37,7 +36,8 @@ int main(void)
     rs485_slave_cfg_t cfg = {
         .addr        = BOARD_ADDR,
         .fw_version  = 1,
-        .handlers    = s_handlers,
+        .groups      = RS485_GROUP_BIT(RS485_GROUP_LIGHTS),
+        .dispatch    = s_dispatch,
         .build_stream = NULL,
     };
     rs485_slave_init(&cfg);
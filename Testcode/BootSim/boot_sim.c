@@ -0,0 +1,496 @@
+/*
+ * Simulation of a firmware update over the RS-485 bus
+ *
+ * Runs the real slave framework (core/rs485_slave.c + rs485_boot.c) against
+ * a simulated HAL and the real master engine (host/rs485_update.c) against
+ * a model of the GCS master, all on one virtual clock, and reports how long
+ * an image takes to go across. Nothing runs in real time.
+ *
+ *   bus      bytes take 10 bit times; a slave whose RX buffer is full when
+ *            the next byte lands loses it (overrun)
+ *   slave    per-byte CPU cost, a CRC-32 cost per BOOT_DATA, and flash
+ *            erase / program times that stall the CPU, per MCU profile
+ *   master   the GCS rs485_task: one pooled command at a time,
+ *            RS485_GAP_US after each answered frame, RS485_BOOT_GAP_US
+ *            between BOOT_DATA frames, RS485_BOOT_TIMEOUT_MS for replies
+ *   Pi       runs the engine; USB adds a latency each way between a reply
+ *            reaching the Pico and the next window reaching its pool
+ *
+ * Housekeeping PINGs, stream slots and the CDC link's own limits are left
+ * out: during an update the Pi's commands have the bus.
+ *
+ * Prints, per MCU profile and bus rate, the update time with a window of 1
+ * (stop-and-wait) and the slave's full window, then an update cut off half
+ * way by a slave reset and resumed, and one over a noisy bus.
+ *
+ * Usage:  boot_sim [image_kb] [bit_error_rate] [usb_latency_us]
+ */
+
+#include "rs485_slave.h"
+#include "rs485_boot.h"
+#include "rs485_update.h"
+#include "crc8.h"
+#include "hal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Master timing, as GCS/src/rs485.h */
+#define GAP_US              2000
+#define BOOT_GAP_US         100
+#define BOOT_TIMEOUT_MS     400
+
+#define SLAVE_ADDR          0x10
+#define SLOT_SIZE           (132u * 1024u)
+
+/* ------------------------------------------------------------------ */
+/* MCU profiles                                                         */
+/* ------------------------------------------------------------------ */
+
+typedef struct {
+    const char *name;
+    uint32_t    page;           /* erase unit                          */
+    uint32_t    prog_unit;      /* bytes programmed per step           */
+    uint32_t    erase_us;       /* per page                            */
+    double      prog_us;        /* per step                            */
+    double      byte_ns;        /* CPU per received / read-back byte   */
+    double      crc32_ns;       /* CPU per byte of a BOOT_DATA check   */
+    uint32_t    poll_ns;        /* one idle pass of the main loop      */
+    uint32_t    rx_hold;        /* bytes RX keeps through a flash stall */
+    uint32_t    max_baud;       /* hal_uart_max_baud()                 */
+} profile_t;
+
+/* Datasheet typicals: STM32F103 internal flash (tERASE 20 ms, tPROG
+   52.5 us per halfword), W25Q16 on the Pico (sector 45 ms, 256-byte page
+   0.7 ms), ESP32 SPI flash alike. CPU figures are rough: a nibble-table
+   CRC at 64 MHz, or at 125 / 160+ MHz. Through a flash stall the F1's RX
+   DMA keeps filling its ring; the RP2040 and ESP32 have only the UART's
+   FIFO, with interrupts off. */
+static const profile_t k_profiles[] = {
+    { "stm32f1", 1024,   2, 20000,  52.5, 400, 350, 2000, 2048, 1000000 },
+    { "rp2040",  4096, 256, 45000, 700.0, 120, 110,  500,   32, 1000000 },
+    { "esp32",   4096, 256, 45000, 700.0,  80,  80,  500,  128, 1000000 },
+};
+
+static const profile_t *s_prof;
+
+/* ------------------------------------------------------------------ */
+/* Virtual clock, bus and flash                                         */
+/* ------------------------------------------------------------------ */
+
+static uint64_t s_now_ns;       /* master */
+static uint64_t s_slave_ns;     /* slave: runs ahead while busy */
+static uint64_t s_byte_ns;      /* 10 bit times */
+
+static double   s_ber;
+static uint32_t s_rng = 1;
+
+static uint32_t rng_next(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+static uint8_t line_noise(uint8_t b)
+{
+    if (s_ber > 0) {
+        for (int i = 0; i < 10; i++) {
+            if ((double)rng_next() / 4294967296.0 < s_ber) b ^= (uint8_t)(1u << (i & 7));
+        }
+    }
+    return b;
+}
+
+/* Master -> slave bytes in flight, by arrival time */
+typedef struct {
+    uint64_t t_ns;
+    uint32_t cost_ns;           /* slave CPU once this byte is read */
+    uint8_t  b;
+} arrival_t;
+
+#define ARRIVALS    8192
+static arrival_t s_arr[ARRIVALS];
+static uint32_t  s_arr_head, s_arr_tail;
+
+#define FIFO        4096
+static uint8_t   s_fifo[FIFO];
+static uint32_t  s_fifo_n, s_fifo_head;
+static uint32_t  s_fifo_cost[FIFO];
+static uint32_t  s_overruns;
+
+/* Slave -> master: the last reply */
+static uint8_t   s_reply[RS485_MAX_FRAME];
+static uint32_t  s_reply_len;
+static uint64_t  s_reply_start_ns, s_reply_done_ns;
+
+static uint8_t   s_flash[SLOT_SIZE];
+static bool      s_installed;
+
+static void rx_land(void)
+{
+    while (s_arr_head != s_arr_tail && s_arr[s_arr_head].t_ns <= s_slave_ns) {
+        arrival_t *a = &s_arr[s_arr_head];
+        s_arr_head = (s_arr_head + 1) % ARRIVALS;
+        if (s_fifo_n < s_prof->rx_hold) {
+            uint32_t i = (s_fifo_head + s_fifo_n++) % FIFO;
+            s_fifo[i]      = a->b;
+            s_fifo_cost[i] = a->cost_ns;
+        } else {
+            s_overruns++;
+        }
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/* Simulated HAL                                                        */
+/* ------------------------------------------------------------------ */
+
+void hal_uart_init(uint32_t baud)              { (void)baud; }
+bool hal_uart_set_baud(uint32_t baud)          { (void)baud; return true; }
+uint32_t hal_uart_max_baud(void)               { return s_prof->max_baud; }
+void hal_uart_set_tx_enable(bool enable)       { (void)enable; }
+void hal_int_pin_init(void)                    { }
+void hal_int_pin_drive(bool assert_low)        { (void)assert_low; }
+uint32_t hal_millis(void)                      { return (uint32_t)(s_slave_ns / 1000000u); }
+
+/* Goes out in the background, as the ports' DMA TX */
+void hal_uart_write(const uint8_t *buf, size_t len)
+{
+    s_reply_start_ns = s_slave_ns;
+    for (size_t i = 0; i < len; i++) s_reply[i] = line_noise(buf[i]);
+    s_reply_len      = (uint32_t)len;
+    s_reply_done_ns  = s_slave_ns + len * s_byte_ns;
+}
+
+/* Each look costs a little, so a loop spinning on it gets somewhere */
+bool hal_uart_tx_busy(void)
+{
+    if (s_slave_ns >= s_reply_done_ns) return false;
+    s_slave_ns += 100;
+    return true;
+}
+
+/* One byte per span, so each byte's CPU cost lands as it is handled */
+size_t hal_uart_rx_span(const uint8_t **data)
+{
+    rx_land();
+    if (!s_fifo_n) return 0;
+    *data = &s_fifo[s_fifo_head];
+    return 1;
+}
+
+void hal_uart_rx_consume(size_t n)
+{
+    while (n--) {
+        s_slave_ns  += (uint64_t)s_prof->byte_ns + s_fifo_cost[s_fifo_head];
+        s_fifo_head  = (s_fifo_head + 1) % FIFO;
+        s_fifo_n--;
+    }
+}
+
+uint32_t hal_flash_slot_size(void)  { return SLOT_SIZE; }
+uint32_t hal_flash_page_size(void)  { return s_prof->page; }
+
+bool hal_flash_erase(uint32_t off)
+{
+    memset(&s_flash[off], 0xFF, s_prof->page);
+    s_slave_ns += (uint64_t)s_prof->erase_us * 1000u;
+    return true;
+}
+
+/* NOR: programming only clears bits; all-ones steps are skipped */
+bool hal_flash_write(uint32_t off, const uint8_t *buf, size_t len)
+{
+    uint32_t u = s_prof->prog_unit;
+    for (uint32_t s = off / u * u; s < off + len; s += u) {
+        bool any = false;
+        for (uint32_t i = s; i < s + u; i++) {
+            if (i >= off && i < off + len && buf[i - off] != 0xFF) {
+                s_flash[i] &= buf[i - off];
+                any = true;
+            }
+        }
+        if (any) s_slave_ns += (uint64_t)(s_prof->prog_us * 1000.0);
+    }
+    return true;
+}
+
+void hal_flash_read(uint32_t off, uint8_t *buf, size_t len)
+{
+    memcpy(buf, &s_flash[off], len);
+    s_slave_ns += (uint64_t)(len * s_prof->byte_ns / 4);
+}
+
+void hal_boot_install(uint32_t size)
+{
+    (void)size;
+    s_installed = true;
+}
+
+/* ------------------------------------------------------------------ */
+/* Slave                                                                */
+/* ------------------------------------------------------------------ */
+
+static const rs485_slave_cfg_t k_cfg = { .addr = SLAVE_ADDR, .fw_version = 1 };
+
+static void slave_reset(void)
+{
+    s_arr_head = s_arr_tail = 0;
+    s_fifo_n   = s_fifo_head = 0;
+    rs485_slave_init(&k_cfg);
+}
+
+/* Run the slave's main loop up to `until`, or until it has replied */
+static void slave_run(uint64_t until, bool stop_on_reply)
+{
+    while (s_slave_ns < until) {
+        if (stop_on_reply && s_reply_len) return;
+        rx_land();
+        if (!s_fifo_n) {
+            /* Idle: nothing happens before the next byte lands */
+            uint64_t next = (s_arr_head != s_arr_tail) ? s_arr[s_arr_head].t_ns : until;
+            if (next > s_slave_ns + s_prof->poll_ns) {
+                s_slave_ns = next < until ? next : until;
+                continue;
+            }
+        }
+        rs485_slave_poll();
+        s_slave_ns += s_prof->poll_ns;
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/* Master                                                               */
+/* ------------------------------------------------------------------ */
+
+typedef struct {
+    uint64_t ready_ns;          /* in the Pico's pool from here */
+    uint8_t  cmd, len;
+    uint8_t  payload[RS485_MAX_PAYLOAD];
+} pooled_t;
+
+#define POOL    64
+static pooled_t s_pool[POOL];
+static uint32_t s_pool_head, s_pool_tail;
+static uint64_t s_usb_ns;
+static uint64_t s_engine_ns;    /* when the Pi ran the engine last */
+
+static void engine_send(void *ctx, uint8_t cmd, const uint8_t *payload, uint8_t len)
+{
+    (void)ctx;
+    pooled_t *c = &s_pool[s_pool_tail];
+    s_pool_tail = (s_pool_tail + 1) % POOL;
+    if (s_pool_tail == s_pool_head) {
+        fprintf(stderr, "boot_sim: command pool overflow\n");
+        exit(1);
+    }
+    c->ready_ns = s_engine_ns + s_usb_ns;
+    c->cmd      = cmd;
+    c->len      = len;
+    memcpy(c->payload, payload, len);
+}
+
+static void transmit(const pooled_t *c)
+{
+    uint8_t f[RS485_MAX_FRAME];
+    f[0] = RS485_SOF;
+    f[1] = SLAVE_ADDR;
+    f[2] = c->cmd;
+    f[3] = c->len;
+    memcpy(&f[4], c->payload, c->len);
+    f[4 + c->len] = crc8(&f[1], 3u + c->len);
+
+    uint32_t n = 5u + c->len;
+    for (uint32_t i = 0; i < n; i++) {
+        arrival_t *a = &s_arr[s_arr_tail];
+        s_arr_tail = (s_arr_tail + 1) % ARRIVALS;
+        a->t_ns    = s_now_ns + (i + 1) * s_byte_ns;
+        a->b       = line_noise(f[i]);
+        a->cost_ns = (i == n - 1 && c->cmd == RS485_CMD_BOOT_DATA)
+                   ? (uint32_t)(s_prof->crc32_ns * (c->len - 4)) : 0;
+    }
+    s_now_ns += n * s_byte_ns;
+}
+
+/* The reply the master's rs485_recv() would accept, or -1 */
+static int take_reply(uint8_t cmd, uint64_t deadline, uint8_t *out)
+{
+    if (!s_reply_len || s_reply_start_ns > deadline) {
+        s_now_ns = deadline;
+        return -1;
+    }
+    s_now_ns = s_reply_done_ns;
+    const uint8_t *r = s_reply;
+    if (s_reply_len < 5 || r[0] != RS485_SOF || r[1] != SLAVE_ADDR || r[2] != cmd ||
+        s_reply_len != 5u + r[3] || crc8(&r[1], 3u + r[3]) != r[4 + r[3]]) {
+        return -1;
+    }
+    memcpy(out, &r[4], r[3]);
+    return r[3];
+}
+
+typedef struct {
+    double   secs;
+    uint32_t chunks, extra, rounds, overruns;
+    uint32_t resumed_at;
+    bool     ok;
+} result_t;
+
+/* Update the slave from `image`; cut_at > 0 resets the slave once the
+   master is about to send the first chunk at or past that offset */
+static result_t run_update(const profile_t *p, uint32_t baud, uint8_t window,
+                           const uint8_t *image, uint32_t size, uint32_t cut_at)
+{
+    s_prof      = p;
+    s_byte_ns   = 10000000000ull / baud;
+    s_now_ns    = s_slave_ns = s_engine_ns = 0;
+    s_pool_head = s_pool_tail = 0;
+    s_overruns  = 0;
+    s_installed = false;
+    s_reply_len = 0;
+    s_reply_done_ns = 0;
+    memset(s_flash, 0xFF, sizeof(s_flash));
+    slave_reset();
+
+    result_t        res = { 0 };
+    rs485_update_t  u;
+    uint32_t        sent = 0;
+    uint64_t        bus_free = 0;
+    uint8_t         reply[RS485_MAX_PAYLOAD];
+
+    rs485_update_start(&u, image, size, window, engine_send, NULL);
+
+    while (rs485_update_busy(&u)) {
+        if (s_pool_head == s_pool_tail) {
+            fprintf(stderr, "boot_sim: engine busy with nothing queued\n");
+            exit(1);
+        }
+        pooled_t *c = &s_pool[s_pool_head];
+        s_pool_head = (s_pool_head + 1) % POOL;
+
+        if (cut_at && c->cmd == RS485_CMD_BOOT_DATA &&
+            (uint32_t)c->payload[0] + ((uint32_t)c->payload[1] << 8) +
+            ((uint32_t)c->payload[2] << 16) >= cut_at) {
+            /* Power cut: the slave restarts, the Pi starts over */
+            cut_at = 0;
+            sent += u.chunks_sent;
+            s_pool_head = s_pool_tail;
+            if (s_slave_ns < s_now_ns) s_slave_ns = s_now_ns;
+            slave_reset();
+            s_engine_ns = s_now_ns;
+            rs485_update_start(&u, image, size, window, engine_send, NULL);
+            continue;
+        }
+
+        if (s_now_ns < bus_free)    s_now_ns = bus_free;
+        if (s_now_ns < c->ready_ns) s_now_ns = c->ready_ns;
+        slave_run(s_now_ns, false);
+        transmit(c);
+
+        if (c->cmd == RS485_CMD_BOOT_DATA) {
+            bus_free = s_now_ns + BOOT_GAP_US * 1000ull;
+            continue;
+        }
+
+        uint64_t deadline = s_now_ns + BOOT_TIMEOUT_MS * 1000000ull;
+        s_reply_len = 0;
+        slave_run(deadline, true);
+        int len = take_reply(c->cmd, deadline, reply);
+        bus_free = s_now_ns + GAP_US * 1000ull;
+
+        /* Back to the Pi, which answers with the next window */
+        s_engine_ns = s_now_ns + s_usb_ns;
+        uint32_t before = u.resumed_at;
+        rs485_update_reply(&u, c->cmd, reply, len);
+        if (c->cmd == RS485_CMD_BOOT_BEGIN && u.resumed_at != before) res.resumed_at = u.resumed_at;
+    }
+
+    res.secs     = (double)(s_engine_ns) / 1e9;
+    res.chunks   = sent + u.chunks_sent;
+    res.extra    = res.chunks - (size + RS485_BOOT_CHUNK - 1) / RS485_BOOT_CHUNK;
+    res.rounds   = u.rounds;
+    res.overruns = s_overruns;
+    res.ok       = u.state == RS485_UPDATE_DONE && s_installed &&
+                   memcmp(s_flash, image, size) == 0;
+    if (u.state != RS485_UPDATE_DONE) {
+        fprintf(stderr, "boot_sim: %s %u baud window %u: %s, status %u\n",
+                p->name, (unsigned)baud, window, rs485_update_state_name(u.state), u.status);
+    }
+    return res;
+}
+
+/* ------------------------------------------------------------------ */
+
+int main(int argc, char **argv)
+{
+    uint32_t kb  = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 0) : 64;
+    double   ber = argc > 2 ? atof(argv[2]) : 1e-5;
+    s_usb_ns     = (argc > 3 ? strtoul(argv[3], NULL, 0) : 1000) * 1000ull;
+
+    uint32_t size = kb * 1024u;
+    if (size == 0 || size > SLOT_SIZE - 4096u) {
+        fprintf(stderr, "boot_sim: image must be 1..%u KB\n", (SLOT_SIZE - 4096u) / 1024u);
+        return 1;
+    }
+    uint8_t *image = malloc(size);
+    for (uint32_t i = 0; i < size; i++) image[i] = (uint8_t)rng_next();
+
+    static const uint32_t k_bauds[] = { 115200, 230400, 1000000 };
+    const uint8_t full = RS485_BOOT_WINDOW;
+
+    printf("%u KB image, %u-byte chunks, USB %u us each way\n\n",
+           (unsigned)kb, RS485_BOOT_CHUNK, (unsigned)(s_usb_ns / 1000));
+    printf("%-8s %8s %12s %12s %8s %10s\n", "mcu", "baud", "window 1", "window 8",
+           "speedup", "bus use");
+
+    bool all_ok = true;
+    for (size_t m = 0; m < sizeof(k_profiles) / sizeof(k_profiles[0]); m++) {
+        for (size_t b = 0; b < sizeof(k_bauds) / sizeof(k_bauds[0]); b++) {
+            const profile_t *p = &k_profiles[m];
+            result_t one  = run_update(p, k_bauds[b], 1, image, size, 0);
+            result_t many = run_update(p, k_bauds[b], full, image, size, 0);
+            all_ok &= one.ok && many.ok;
+
+            /* Image bytes over what the line could carry in that time */
+            double use = (double)size * 10.0 / k_bauds[b] / many.secs;
+            printf("%-8s %8u %10.2f s %10.2f s %7.1fx %9.0f %%%s\n", p->name,
+                   (unsigned)k_bauds[b], one.secs, many.secs, one.secs / many.secs,
+                   use * 100.0, k_bauds[b] > p->max_baud ? "  (above today's max baud)" : "");
+        }
+    }
+
+    printf("\nInterrupted half way by a slave reset, then resumed (window %u):\n", full);
+    for (size_t m = 0; m < sizeof(k_profiles) / sizeof(k_profiles[0]); m++) {
+        const profile_t *p = &k_profiles[m];
+        result_t clean = run_update(p, p->max_baud, full, image, size, 0);
+        result_t cut   = run_update(p, p->max_baud, full, image, size, size / 2);
+        all_ok &= clean.ok && cut.ok;
+        printf("  %-8s %8u baud  %6.2f s (uninterrupted %.2f s), resumed at %u, "
+               "%u chunks sent twice\n", p->name, (unsigned)p->max_baud, cut.secs, clean.secs,
+               (unsigned)cut.resumed_at, (unsigned)cut.extra);
+    }
+
+    if (ber > 0) {
+        printf("\nBit error rate %g on both directions (window %u):\n", ber, full);
+        s_ber = ber;
+        for (size_t m = 0; m < sizeof(k_profiles) / sizeof(k_profiles[0]); m++) {
+            const profile_t *p = &k_profiles[m];
+            result_t r = run_update(p, p->max_baud, full, image, size, 0);
+            all_ok &= r.ok;
+            printf("  %-8s %8u baud  %6.2f s, %u of %u chunks sent twice, %u overruns%s\n",
+                   p->name, (unsigned)p->max_baud, r.secs, (unsigned)r.extra,
+                   (unsigned)r.chunks, (unsigned)r.overruns, r.ok ? "" : "  FAILED");
+        }
+        s_ber = 0;
+    }
+
+    free(image);
+    if (!all_ok) {
+        fprintf(stderr, "boot_sim: an update did not land intact\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,261 @@
+/*
+ * Benchmark for the RS-485 CRC-8 (Peripherals/Framework/core/crc8.c)
+ *
+ * Builds a stream of bus frames and reports MB/s and ns/frame for:
+ *   block bitwise     the old eight-step loop per byte over addr..payload
+ *   block table       crc8(), one table lookup per byte
+ *   rx copy+bitwise   byte-at-a-time receiver that copies the frame into a
+ *                     scratch array at the CRC byte and checks it in a second
+ *                     pass, as rs485_slave.c's feed_byte() used to
+ *   rx copy+table     the same with crc8()
+ *   rx running        crc8_update() folded in as each byte arrives
+ *
+ * The mix is weighted towards what the bus carries: PINGs, status replies
+ * and STREAM_DATA, with the occasional full 255-byte payload.
+ *
+ * Usage:  crc8_bench [frames] [rounds]
+ */
+
+#include "crc8.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SOF             0xAB
+#define MAX_PAYLOAD     255
+
+typedef struct {
+    uint8_t len;
+    uint8_t weight;
+} mix_entry_t;
+
+static const mix_entry_t k_mix[] = {
+    {   0, 6 },     /* PING / PONG, STREAM_ON ack */
+    {   4, 4 },     /* GET_STATUS reply */
+    {  27, 6 },     /* STREAM_DATA, one slot */
+    {  64, 2 },
+    { 255, 1 },
+};
+
+static uint32_t s_rng = 1;
+
+static uint32_t rng_next(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/* Reference: the bit-serial loop every copy of crc8() used before */
+static uint8_t crc8_bitwise(const uint8_t *data, size_t len)
+{
+    uint8_t crc = 0x00;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int b = 0; b < 8; b++)
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x31) : (uint8_t)(crc << 1);
+    }
+    return crc;
+}
+
+/* Encode `count` frames from the mix; returns the stream length */
+static size_t make_stream(uint8_t *buf, size_t count)
+{
+    unsigned total = 0;
+    for (size_t i = 0; i < sizeof(k_mix) / sizeof(k_mix[0]); i++) total += k_mix[i].weight;
+
+    size_t n = 0;
+    for (size_t i = 0; i < count; i++) {
+        unsigned pick = rng_next() % total;
+        size_t   m    = 0;
+        while (pick >= k_mix[m].weight) pick -= k_mix[m++].weight;
+
+        uint8_t *f = &buf[n];
+        f[0] = SOF;
+        f[1] = (uint8_t)(1 + rng_next() % 0xEF);
+        f[2] = (uint8_t)(0x10 + rng_next() % 0x20);
+        f[3] = k_mix[m].len;
+        for (unsigned j = 0; j < k_mix[m].len; j++) f[4 + j] = (uint8_t)rng_next();
+        f[4 + f[3]] = crc8_bitwise(&f[1], 3u + f[3]);
+        n += 5u + f[3];
+    }
+    return n;
+}
+
+/* ------------------------------------------------------------------ */
+/* Receivers — the slave's FSM, minus dispatch                          */
+/* ------------------------------------------------------------------ */
+
+typedef enum { S_SOF = 0, S_ADDR, S_CMD, S_LEN, S_PAYLOAD, S_CRC } rx_state_t;
+
+typedef struct {
+    rx_state_t state;
+    uint8_t    addr, cmd, plen, idx, crc;
+    uint8_t    buf[MAX_PAYLOAD];
+    size_t     good;
+} rx_t;
+
+typedef uint8_t (*block_fn_t)(const uint8_t *data, size_t len);
+
+static void rx_copy(rx_t *r, const uint8_t *p, size_t n, block_fn_t fn)
+{
+    for (size_t i = 0; i < n; i++) {
+        uint8_t b = p[i];
+        switch (r->state) {
+        case S_SOF:     if (b == SOF) r->state = S_ADDR;          break;
+        case S_ADDR:    r->addr = b; r->state = S_CMD;            break;
+        case S_CMD:     r->cmd  = b; r->state = S_LEN;            break;
+        case S_LEN:
+            r->plen  = b;
+            r->idx   = 0;
+            r->state = b ? S_PAYLOAD : S_CRC;
+            break;
+        case S_PAYLOAD:
+            r->buf[r->idx++] = b;
+            if (r->idx >= r->plen) r->state = S_CRC;
+            break;
+        case S_CRC: {
+            uint8_t hdr[3 + MAX_PAYLOAD];
+            hdr[0] = r->addr; hdr[1] = r->cmd; hdr[2] = r->plen;
+            if (r->plen) memcpy(&hdr[3], r->buf, r->plen);
+            if (b == fn(hdr, 3u + r->plen)) r->good++;
+            r->state = S_SOF;
+            break;
+        }
+        }
+    }
+}
+
+static void rx_running(rx_t *r, const uint8_t *p, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        uint8_t b = p[i];
+        switch (r->state) {
+        case S_SOF:
+            if (b == SOF) { r->state = S_ADDR; r->crc = CRC8_INIT; }
+            break;
+        case S_ADDR:    r->addr = b; r->crc = crc8_update(r->crc, b); r->state = S_CMD; break;
+        case S_CMD:     r->cmd  = b; r->crc = crc8_update(r->crc, b); r->state = S_LEN; break;
+        case S_LEN:
+            r->plen  = b;
+            r->idx   = 0;
+            r->crc   = crc8_update(r->crc, b);
+            r->state = b ? S_PAYLOAD : S_CRC;
+            break;
+        case S_PAYLOAD:
+            r->buf[r->idx++] = b;
+            r->crc = crc8_update(r->crc, b);
+            if (r->idx >= r->plen) r->state = S_CRC;
+            break;
+        case S_CRC:
+            if (b == r->crc) r->good++;
+            r->state = S_SOF;
+            break;
+        }
+    }
+}
+
+/* ------------------------------------------------------------------ */
+
+static void report(const char *what, double secs, size_t bytes, size_t frames)
+{
+    printf("%-18s %9.1f MB/s %9.1f ns/frame\n", what,
+           (double)bytes / secs / 1e6, secs * 1e9 / (double)frames);
+}
+
+static void check_good(const char *what, size_t good, size_t want)
+{
+    if (good != want) {
+        fprintf(stderr, "crc8_bench: %s accepted %zu of %zu frames\n", what, good, want);
+        exit(1);
+    }
+}
+
+/* The table must match the bit loop for every single byte and random runs */
+static void self_check(void)
+{
+    for (unsigned i = 0; i < 256; i++) {
+        uint8_t b = (uint8_t)i;
+        if (crc8(&b, 1) != crc8_bitwise(&b, 1)) {
+            fprintf(stderr, "crc8_bench: table mismatch at 0x%02X\n", i);
+            exit(1);
+        }
+    }
+    uint8_t buf[300];
+    for (int r = 0; r < 10000; r++) {
+        size_t n = rng_next() % sizeof(buf);
+        for (size_t i = 0; i < n; i++) buf[i] = (uint8_t)rng_next();
+        if (crc8(buf, n) != crc8_bitwise(buf, n)) {
+            fprintf(stderr, "crc8_bench: crc8() mismatch, len %zu\n", n);
+            exit(1);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    size_t count  = argc > 1 ? strtoul(argv[1], NULL, 0) : 20000;
+    int    rounds = argc > 2 ? atoi(argv[2]) : 50;
+
+    self_check();
+
+    uint8_t *buf = malloc(count * (5 + MAX_PAYLOAD));
+    size_t   n   = make_stream(buf, count);
+    size_t   frames = count * (size_t)rounds;
+    size_t   bytes  = n * (size_t)rounds;
+
+    printf("%zu frames (%zu bytes) x %d rounds per measurement\n", count, n, rounds);
+
+    static const struct { const char *name; block_fn_t fn; } k_block[] = {
+        { "bitwise", crc8_bitwise },
+        { "table",   crc8 },
+    };
+
+    /* Block: CRC of each frame's addr..payload, as a sender computes it */
+    for (size_t v = 0; v < 2; v++) {
+        volatile uint8_t sink = 0;
+        double t0 = now_s();
+        for (int r = 0; r < rounds; r++) {
+            for (size_t i = 0; i < n; i += 5u + buf[i + 3]) {
+                sink ^= k_block[v].fn(&buf[i + 1], 3u + buf[i + 3]);
+            }
+        }
+        char what[32];
+        snprintf(what, sizeof(what), "block %s", k_block[v].name);
+        report(what, now_s() - t0, bytes, frames);
+        (void)sink;
+    }
+
+    /* Receive: byte-at-a-time FSM checking each frame's CRC */
+    static rx_t rx;
+    for (size_t v = 0; v < 2; v++) {
+        memset(&rx, 0, sizeof(rx));
+        double t0 = now_s();
+        for (int r = 0; r < rounds; r++) rx_copy(&rx, buf, n, k_block[v].fn);
+        double t = now_s() - t0;
+
+        char what[32];
+        snprintf(what, sizeof(what), "rx copy+%s", k_block[v].name);
+        check_good(what, rx.good, frames);
+        report(what, t, bytes, frames);
+    }
+
+    memset(&rx, 0, sizeof(rx));
+    double t0 = now_s();
+    for (int r = 0; r < rounds; r++) rx_running(&rx, buf, n);
+    double t = now_s() - t0;
+    check_good("rx running", rx.good, frames);
+    report("rx running", t, bytes, frames);
+
+    free(buf);
+    return 0;
+}
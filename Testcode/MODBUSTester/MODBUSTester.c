@@ -50,6 +50,7 @@
 #include "hardware/gpio.h"
 
 #include "web.h"
+#include "crc8.h"      /* Peripherals/Framework/core */
 
 /* ------------------------------------------------------------------ */
 /* Wi-Fi AP credentials (change to taste)                             */
@@ -77,9 +78,13 @@
 /* ------------------------------------------------------------------ */
 #define RS485_SOF              0xAB
 #define RS485_ADDR_BROADCAST   0xFF
+#define RS485_ADDR_GROUP_FIRST 0xF0     /* 0xF0..0xFE multicast groups */
+#define RS485_ADDR_GROUP_LAST  0xFE
+#define GROUP_BIT(a)           ((uint16_t)(1u << ((a) - RS485_ADDR_GROUP_FIRST)))
 
 #define CMD_PING        0x01
 #define CMD_PONG        0x02
+#define CMD_GROUP       0x04
 #define CMD_SET_OUTPUT  0x10
 #define CMD_GET_STATUS  0x11
 #define CMD_STATUS      0x12
@@ -104,8 +109,10 @@ typedef struct {
     bool     enabled;
     bool     stream_on;
     uint16_t stream_interval_ms;
-    uint32_t next_stream_at;
+    bool     slot_armed;        /* listed in the last SYNC             */
+    uint32_t slot_at;           /* ms its stream slot opens            */
     bool     int_pending;       /* will assert /INT on next service    */
+    uint16_t groups;            /* multicast groups joined, GROUP_BIT  */
     /* Searchlight */
     uint8_t  sl_brightness;     /* 0..255 PWM                          */
     int8_t   sl_temp_c;         /* deg C                               */
@@ -133,7 +140,7 @@ typedef struct {
 
 #define N_PERIPH 4
 static periph_t g_dev[N_PERIPH] = {
-    { .addr = 0x01, .enabled = true,
+    { .addr = 0x01, .enabled = true, .groups = GROUP_BIT(0xF0),
       .sl_brightness = 0, .sl_temp_c = 25, .sl_faults = 0 },
     { .addr = 0x02, .enabled = true,
       .rd_distance_mm = 5000, .rd_signal = 200, .rd_status = 0,
@@ -141,7 +148,7 @@ static periph_t g_dev[N_PERIPH] = {
     { .addr = 0x03, .enabled = true,
       .pt_pan_deg = 90, .pt_tilt_deg = 45, .pt_moving = 0,
       .pt_slew_dps = 60 },
-    { .addr = 0x04, .enabled = true,
+    { .addr = 0x04, .enabled = true, .groups = GROUP_BIT(0xF0),
       .lb_brightness = 0, .lb_mode = 0, .lb_color_rgb565 = 0xFFFF },
 };
 
@@ -153,20 +160,6 @@ static periph_t *find_dev(uint8_t addr) {
     return NULL;
 }
 
-/* ------------------------------------------------------------------ */
-/* CRC-8/MAXIM (poly 0x31), Dallas/Maxim                              */
-/* ------------------------------------------------------------------ */
-static uint8_t crc8(const uint8_t *data, size_t len) {
-    uint8_t crc = 0x00;
-    for (size_t i = 0; i < len; i++) {
-        crc ^= data[i];
-        for (int b = 0; b < 8; b++)
-            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x31)
-                               : (uint8_t)(crc << 1);
-    }
-    return crc;
-}
-
 /* ------------------------------------------------------------------ */
 /* Frame TX                                                           */
 /* ------------------------------------------------------------------ */
@@ -327,9 +320,32 @@ static void dispatch(uint8_t addr, uint8_t cmd,
         printf("\n");
     }
 
-    /* Broadcast — no response */
+    /* Broadcast — no response. SYNC [ts u32][slot_ms][n][addr x n] hands
+     * out stream slots: the i-th listed device may send one STREAM_DATA
+     * from 2 ms + i * slot_ms after it. */
     if (addr == RS485_ADDR_BROADCAST) {
         if (cmd == CMD_SYNC && g_trace) printf("[BUS] SYNC received\n");
+        if (cmd == CMD_SYNC && n >= 6) {
+            uint32_t now = to_ms_since_boot(get_absolute_time());
+            for (uint8_t i = 0; i < p[5] && 6 + i < n; i++) {
+                periph_t *s = find_dev(p[6 + i]);
+                if (!s) continue;
+                s->slot_at    = now + 2 + (uint32_t)i * p[4];
+                s->slot_armed = true;
+            }
+        }
+        return;
+    }
+
+    /* Group — every enabled member applies it, none responds */
+    if (addr >= RS485_ADDR_GROUP_FIRST && addr <= RS485_ADDR_GROUP_LAST) {
+        for (int i = 0; i < N_PERIPH; i++) {
+            periph_t *m = &g_dev[i];
+            if (!m->enabled || !(m->groups & GROUP_BIT(addr))) continue;
+            if (cmd == CMD_SET_OUTPUT) handle_set_output(m, p, n);
+            else if (cmd == CMD_SET_PARAM && n >= 3)
+                handle_set_param(m, p[0], (uint16_t)p[1] | ((uint16_t)p[2] << 8));
+        }
         return;
     }
 
@@ -342,6 +358,12 @@ static void dispatch(uint8_t addr, uint8_t cmd,
         rs485_tx(addr, CMD_PONG, &v, 1);
         break;
     }
+    case CMD_GROUP: {
+        if (n >= 2) d->groups = ((uint16_t)p[0] | ((uint16_t)p[1] << 8)) & 0x7FFF;
+        uint8_t r[2] = { (uint8_t)(d->groups & 0xFF), (uint8_t)(d->groups >> 8) };
+        rs485_tx(addr, CMD_GROUP, r, 2);
+        break;
+    }
     case CMD_GET_STATUS:
         send_status(d);
         break;
@@ -371,8 +393,6 @@ static void dispatch(uint8_t addr, uint8_t cmd,
             d->stream_interval_ms = (uint16_t)p[0] | ((uint16_t)p[1] << 8);
             if (d->stream_interval_ms < 10) d->stream_interval_ms = 10;
             d->stream_on = true;
-            d->next_stream_at = to_ms_since_boot(get_absolute_time())
-                              + d->stream_interval_ms;
         }
         send_status(d);
         break;
@@ -393,7 +413,7 @@ static void dispatch(uint8_t addr, uint8_t cmd,
 /* ------------------------------------------------------------------ */
 static void rs485_rx_poll(void) {
     static enum { S_SOF, S_ADDR, S_CMD, S_LEN, S_PAY, S_CRC } st = S_SOF;
-    static uint8_t addr, cmd, len, idx;
+    static uint8_t addr, cmd, len, idx, crc;
     static uint8_t buf[256];
     static uint32_t last_byte_ms = 0;
 
@@ -407,32 +427,31 @@ static void rs485_rx_poll(void) {
         uint8_t b = uart_getc(RS485_UART);
         last_byte_ms = now;
         switch (st) {
-        case S_SOF:  if (b == RS485_SOF) st = S_ADDR; break;
-        case S_ADDR: addr = b; st = S_CMD;            break;
-        case S_CMD:  cmd  = b; st = S_LEN;            break;
+        case S_SOF:
+            if (b == RS485_SOF) { st = S_ADDR; crc = CRC8_INIT; }
+            break;
+        case S_ADDR: addr = b; crc = crc8_update(crc, b); st = S_CMD; break;
+        case S_CMD:  cmd  = b; crc = crc8_update(crc, b); st = S_LEN; break;
         case S_LEN:
             len = b; idx = 0;
+            crc = crc8_update(crc, b);
             st = (len == 0) ? S_CRC : S_PAY;
             break;
         case S_PAY:
             buf[idx++] = b;
+            crc = crc8_update(crc, b);
             if (idx >= len) st = S_CRC;
             break;
-        case S_CRC: {
-            /* recompute over ADDR..end-of-payload */
-            uint8_t tmp[3 + 255];
-            tmp[0] = addr; tmp[1] = cmd; tmp[2] = len;
-            if (len) memcpy(&tmp[3], buf, len);
-            uint8_t calc = crc8(tmp, 3 + len);
-            if (calc == b) {
+        case S_CRC:
+            /* running CRC over ADDR..end-of-payload */
+            if (crc == b) {
                 dispatch(addr, cmd, buf, len);
             } else if (g_trace) {
-                printf("[RX] CRC fail (got %02X want %02X)\n", b, calc);
+                printf("[RX] CRC fail (got %02X want %02X)\n", b, crc);
             }
             st = S_SOF;
             break;
         }
-        }
     }
 }
 
@@ -446,9 +465,9 @@ static void periodic_tick(void) {
 
     for (int i = 0; i < N_PERIPH; i++) {
         periph_t *d = &g_dev[i];
-        if (!d->enabled || !d->stream_on) continue;
-        if ((int32_t)(now - d->next_stream_at) >= 0) {
-            d->next_stream_at = now + d->stream_interval_ms;
+        if (!d->enabled || !d->stream_on || !d->slot_armed) continue;
+        if ((int32_t)(now - d->slot_at) >= 0) {
+            d->slot_armed = false;
             send_stream_data(d);
         }
     }
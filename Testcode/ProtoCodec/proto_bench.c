@@ -0,0 +1,174 @@
+/*
+ * Throughput benchmark for the CDC frame codec (GCS/src/proto_codec.c)
+ *
+ * Builds a synthetic traffic mix in both framings and reports MB/s and
+ * ns/packet for:
+ *   serialize  proto_encode() of every frame in the mix
+ *   parse      proto_parser_feed() over the encoded stream, in chunk sizes
+ *              from a byte at a time up to whole buffers (64 = one USB FS
+ *              CDC packet)
+ *
+ * Mixes: "pico" is Pico→Pi traffic (telemetry bundles, heartbeats, events,
+ * peripheral data); "pi" is Pi→Pico control traffic, dominated by full
+ * SK6812 chain updates.
+ *
+ * Usage:  proto_bench [frames] [rounds]
+ */
+
+#include "proto_codec.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct {
+    uint8_t  type;
+    uint16_t len;
+    uint8_t  weight;
+} mix_entry_t;
+
+static const mix_entry_t k_mix_pico[] = {
+    { PROTO_TYPE_TELEMETRY,   27, 10 },
+    { PROTO_TYPE_HEARTBEAT,   13,  1 },
+    { PROTO_TYPE_EVENT,        3,  2 },
+    { PROTO_TYPE_PERIPH_DATA, 20,  4 },
+    { PROTO_TYPE_LINK_STATS,  97,  1 },
+};
+
+static const mix_entry_t k_mix_pi[] = {
+    { PROTO_TYPE_LED,        514,  4 },     /* full SK6812 chain */
+    { PROTO_TYPE_LED,          8,  4 },
+    { PROTO_TYPE_BATCH,       30,  2 },
+    { PROTO_TYPE_HEARTBEAT,    5,  1 },
+};
+
+typedef struct {
+    uint8_t  type;
+    uint16_t len;
+    uint8_t *payload;
+} frame_t;
+
+static uint32_t s_rng = 1;
+
+static uint32_t rng_next(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static frame_t *make_frames(const mix_entry_t *mix, size_t mix_n, size_t count)
+{
+    unsigned total = 0;
+    for (size_t i = 0; i < mix_n; i++) total += mix[i].weight;
+
+    frame_t *f = calloc(count, sizeof(*f));
+    for (size_t i = 0; i < count; i++) {
+        unsigned pick = rng_next() % total;
+        size_t   m    = 0;
+        while (pick >= mix[m].weight) pick -= mix[m++].weight;
+
+        f[i].type    = mix[m].type;
+        f[i].len     = mix[m].len;
+        f[i].payload = malloc(f[i].len ? f[i].len : 1);
+        for (uint16_t j = 0; j < f[i].len; j++) {
+            /* Sensor data: plenty of zero high bytes, which COBS must encode */
+            f[i].payload[j] = (j & 1) ? (uint8_t)(rng_next() & 0x0F) : (uint8_t)rng_next();
+        }
+    }
+    return f;
+}
+
+static size_t s_frames_seen;
+
+static bool count_cb(void *ctx, proto_rx_status_t status, uint8_t type,
+                     const uint8_t *payload, uint16_t len)
+{
+    (void)ctx; (void)type; (void)payload; (void)len;
+    if (status == PROTO_RX_OK) s_frames_seen++;
+    return false;
+}
+
+static void report(const char *mix, const char *framing, const char *what,
+                   double secs, size_t bytes, size_t frames)
+{
+    printf("%-5s %-5s %-18s %9.1f MB/s %9.1f ns/packet\n", mix, framing, what,
+           (double)bytes / secs / 1e6, secs * 1e9 / (double)frames);
+}
+
+static void bench_mix(const char *name, const mix_entry_t *mix, size_t mix_n,
+                      size_t count, int rounds)
+{
+    frame_t *f   = make_frames(mix, mix_n, count);
+    size_t   cap = count * PROTO_FRAME_MAX(PROTO_MAX_PAYLOAD);
+    uint8_t *buf = malloc(cap);
+
+    static const size_t chunks[] = { 1, 64, 512, 0 };
+    static proto_parser_t parser;
+
+    for (uint8_t framing = PROTO_FRAMING_SOF; framing <= PROTO_FRAMING_COBS; framing++) {
+        const char *fname = framing == PROTO_FRAMING_COBS ? "COBS" : "SOF";
+
+        /* Serialize */
+        size_t n = 0;
+        double t0 = now_s();
+        for (int r = 0; r < rounds; r++) {
+            n = 0;
+            for (size_t i = 0; i < count; i++) {
+                n += proto_encode(&buf[n], cap - n, framing, f[i].type,
+                                  f[i].payload, f[i].len);
+            }
+        }
+        double t = now_s() - t0;
+        report(name, fname, "serialize", t, n * (size_t)rounds, count * (size_t)rounds);
+
+        /* Parse */
+        for (size_t c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++) {
+            size_t chunk = chunks[c] ? chunks[c] : n;
+            proto_parser_init(&parser, framing, count_cb, NULL);
+            s_frames_seen = 0;
+
+            t0 = now_s();
+            for (int r = 0; r < rounds; r++) {
+                for (size_t i = 0; i < n; i += chunk) {
+                    proto_parser_feed(&parser, &buf[i], chunk < n - i ? chunk : n - i);
+                }
+            }
+            t = now_s() - t0;
+
+            if (s_frames_seen != count * (size_t)rounds) {
+                fprintf(stderr, "proto_bench: parsed %zu of %zu frames\n",
+                        s_frames_seen, count * (size_t)rounds);
+                exit(1);
+            }
+
+            char what[32];
+            if (chunks[c]) snprintf(what, sizeof(what), "parse chunk=%zu", chunk);
+            else           snprintf(what, sizeof(what), "parse whole");
+            report(name, fname, what, t, n * (size_t)rounds, count * (size_t)rounds);
+        }
+    }
+
+    for (size_t i = 0; i < count; i++) free(f[i].payload);
+    free(f);
+    free(buf);
+}
+
+int main(int argc, char **argv)
+{
+    size_t count  = argc > 1 ? strtoul(argv[1], NULL, 0) : 20000;
+    int    rounds = argc > 2 ? atoi(argv[2]) : 20;
+
+    printf("%zu frames x %d rounds per measurement\n", count, rounds);
+    bench_mix("pico", k_mix_pico, sizeof(k_mix_pico) / sizeof(k_mix_pico[0]), count, rounds);
+    bench_mix("pi",   k_mix_pi,   sizeof(k_mix_pi)   / sizeof(k_mix_pi[0]),   count, rounds);
+    return 0;
+}
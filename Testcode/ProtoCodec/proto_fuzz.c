@@ -0,0 +1,369 @@
+/*
+ * Fuzz harness for the CDC frame codec (GCS/src/proto_codec.c)
+ *
+ * Every input is used two ways:
+ *   1. As a raw byte stream, parsed in both framings. The frames reported
+ *      (good and rejected) must match a byte-at-a-time reference receiver —
+ *      the parser as it was before the fast paths — however the stream is
+ *      split into chunks, and also when the callback stops the parser after
+ *      every frame.
+ *   2. As a recipe for a run of frames, which are encoded in both framings,
+ *      checked against a reference COBS encoder, then parsed back.
+ *
+ * Any mismatch aborts. Built as a libFuzzer target with -DPROTO_LIBFUZZER=ON,
+ * otherwise as a standalone driver that feeds random and bit-flipped input.
+ *
+ * Usage:  proto_fuzz [iterations] [seed]
+ */
+
+#include "proto_codec.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FAIL(...) do { fprintf(stderr, "proto_fuzz: " __VA_ARGS__); \
+                       fputc('\n', stderr); abort(); } while (0)
+
+/* ------------------------------------------------------------------ */
+/* Frame log — [status][type][len_lo][len_hi][payload if OK] per frame  */
+/* ------------------------------------------------------------------ */
+typedef struct {
+    uint8_t *d;
+    size_t   n;
+    size_t   cap;
+    size_t   frames;
+    bool     stop;      /* callback return value */
+} frame_log_t;
+
+static void log_put(frame_log_t *l, const void *src, size_t n)
+{
+    if (l->n + n > l->cap) {
+        l->cap = (l->n + n) * 2 + 64;
+        l->d   = realloc(l->d, l->cap);
+        if (!l->d) FAIL("out of memory");
+    }
+    memcpy(&l->d[l->n], src, n);
+    l->n += n;
+}
+
+static void log_frame(frame_log_t *l, proto_rx_status_t status, uint8_t type,
+                      const uint8_t *payload, uint16_t len)
+{
+    uint8_t hdr[4] = { (uint8_t)status, type, (uint8_t)(len & 0xFF), (uint8_t)(len >> 8) };
+    log_put(l, hdr, sizeof(hdr));
+    if (status == PROTO_RX_OK) log_put(l, payload, len);
+    l->frames++;
+}
+
+static bool log_cb(void *ctx, proto_rx_status_t status, uint8_t type,
+                   const uint8_t *payload, uint16_t len)
+{
+    frame_log_t *l = ctx;
+    log_frame(l, status, type, payload, len);
+    return l->stop;
+}
+
+static void log_expect(const frame_log_t *got, const frame_log_t *want,
+                       const char *what)
+{
+    if (got->n != want->n || got->frames != want->frames ||
+        (want->n && memcmp(got->d, want->d, want->n) != 0)) {
+        FAIL("%s: %zu frames / %zu log bytes, expected %zu / %zu",
+             what, got->frames, got->n, want->frames, want->n);
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/* Reference receiver — one byte at a time, no fast paths               */
+/* ------------------------------------------------------------------ */
+enum { R_SOF, R_TYPE, R_LEN, R_LEN2, R_PAYLOAD, R_CKSUM };
+
+typedef struct {
+    uint8_t  framing, state, type, cobs_left, cobs_code;
+    uint16_t len, idx;
+    uint8_t  buf[PROTO_MAX_PAYLOAD];
+} ref_rx_t;
+
+static void ref_byte(ref_rx_t *r, uint8_t b, frame_log_t *l)
+{
+    switch (r->state) {
+        case R_SOF:
+            if (b == PROTO_SOF && r->framing == PROTO_FRAMING_SOF) r->state = R_TYPE;
+            break;
+        case R_TYPE:
+            r->type  = b;
+            r->state = R_LEN;
+            break;
+        case R_LEN:
+            r->len   = b;
+            r->state = R_LEN2;
+            break;
+        case R_LEN2:
+            r->len |= (uint16_t)(b << 8);
+            r->idx  = 0;
+            if (r->len == 0) {
+                r->state = R_CKSUM;
+            } else if (r->len > PROTO_MAX_PAYLOAD) {
+                log_frame(l, PROTO_RX_OVERSIZE, r->type, NULL, r->len);
+                r->state = R_SOF;
+            } else {
+                r->state = R_PAYLOAD;
+            }
+            break;
+        case R_PAYLOAD:
+            r->buf[r->idx++] = b;
+            if (r->idx >= r->len) r->state = R_CKSUM;
+            break;
+        case R_CKSUM: {
+            uint8_t c = (uint8_t)(r->type ^ (r->len & 0xFF) ^ (r->len >> 8));
+            for (uint16_t i = 0; i < r->len; i++) c ^= r->buf[i];
+            log_frame(l, c == b ? PROTO_RX_OK : PROTO_RX_BAD_CKSUM, r->type, r->buf, r->len);
+            r->state = R_SOF;
+            break;
+        }
+    }
+}
+
+static void ref_parse(uint8_t framing, const uint8_t *d, size_t n, frame_log_t *l)
+{
+    static ref_rx_t r;
+    r.framing   = framing;
+    r.state     = (framing == PROTO_FRAMING_COBS) ? R_TYPE : R_SOF;
+    r.cobs_left = 0;
+    r.cobs_code = 0xFF;
+
+    for (size_t i = 0; i < n; i++) {
+        uint8_t b = d[i];
+        if (framing == PROTO_FRAMING_SOF) {
+            ref_byte(&r, b, l);
+        } else if (b == 0x00) {
+            r.state     = R_TYPE;
+            r.cobs_left = 0;
+            r.cobs_code = 0xFF;
+        } else if (r.cobs_left == 0) {
+            if (r.cobs_code != 0xFF) ref_byte(&r, 0x00, l);
+            r.cobs_code = b;
+            r.cobs_left = (uint8_t)(b - 1);
+        } else {
+            ref_byte(&r, b, l);
+            r.cobs_left--;
+        }
+    }
+}
+
+/* Classic byte-at-a-time COBS encoder */
+static size_t ref_cobs_encode(uint8_t *dst, const uint8_t *src, size_t n)
+{
+    size_t  code_idx = 0, o = 1;
+    uint8_t code     = 1;
+    for (size_t i = 0; i < n; i++) {
+        if (src[i] == 0) {
+            dst[code_idx] = code;
+            code_idx = o++;
+            code = 1;
+        } else {
+            dst[o++] = src[i];
+            if (++code == 0xFF) {
+                dst[code_idx] = code;
+                code_idx = o++;
+                code = 1;
+            }
+        }
+    }
+    dst[code_idx] = code;
+    return o;
+}
+
+/* ------------------------------------------------------------------ */
+/* Checks                                                                */
+/* ------------------------------------------------------------------ */
+static uint32_t rng_next(uint32_t *s)
+{
+    uint32_t x = *s ? *s : 0x9E3779B9u;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *s = x;
+}
+
+static proto_parser_t s_parser;
+
+/* Parse d in chunks from chunk() — 0 means random sizes from rng */
+static void codec_parse(uint8_t framing, const uint8_t *d, size_t n,
+                        size_t chunk, uint32_t rng, bool stop, frame_log_t *l)
+{
+    l->stop = stop;
+    proto_parser_init(&s_parser, framing, log_cb, l);
+
+    size_t i = 0;
+    while (i < n) {
+        size_t want = chunk ? chunk : 1 + rng_next(&rng) % 97;
+        if (want > n - i) want = n - i;
+
+        size_t before = l->frames;
+        size_t used   = proto_parser_feed(&s_parser, &d[i], want);
+        if (used > want) FAIL("feed consumed %zu of %zu", used, want);
+        if (used < want && (!stop || l->frames == before)) {
+            FAIL("feed stopped early without a stop request");
+        }
+        if (used == 0 && want > 0) FAIL("feed made no progress");
+        i += used;
+    }
+}
+
+static void check_parse(uint8_t framing, const uint8_t *d, size_t n, uint32_t seed)
+{
+    frame_log_t want = {0}, got = {0};
+    ref_parse(framing, d, n, &want);
+
+    static const size_t chunks[] = { 1, 7, 64, 0 };
+    for (size_t c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++) {
+        got.n = got.frames = 0;
+        codec_parse(framing, d, n, chunks[c], seed, false, &got);
+        log_expect(&got, &want, framing ? "COBS parse" : "SOF parse");
+    }
+    got.n = got.frames = 0;
+    codec_parse(framing, d, n, n ? n : 1, seed, true, &got);
+    log_expect(&got, &want, framing ? "COBS parse with stop" : "SOF parse with stop");
+
+    free(want.d);
+    free(got.d);
+}
+
+/* Encode a run of frames described by d, then parse the stream back */
+static void check_roundtrip(uint8_t framing, const uint8_t *d, size_t n, uint32_t seed)
+{
+    static uint8_t payload[PROTO_MAX_PAYLOAD];
+    static uint8_t frame[PROTO_FRAME_MAX(PROTO_MAX_PAYLOAD)];
+    static uint8_t ref[PROTO_FRAME_MAX(PROTO_MAX_PAYLOAD)];
+    static uint8_t raw[PROTO_RAW_LEN(PROTO_MAX_PAYLOAD)];
+
+    frame_log_t want = {0}, got = {0}, stream = {0};
+    size_t i = 0;
+
+    for (int k = 0; k < 16 && i + 3 <= n; k++) {
+        uint8_t  type = d[i];
+        uint16_t len  = (uint16_t)((d[i + 1] | (d[i + 2] << 8)) % (PROTO_MAX_PAYLOAD + 1));
+        i += 3;
+        for (uint16_t j = 0; j < len; j++) {
+            /* Input bytes first, then a mix of zeros and noise */
+            payload[j] = (i < n) ? d[i++] : ((rng_next(&seed) & 3) ? 0 : (uint8_t)seed);
+        }
+
+        uint16_t used = proto_encode(frame, sizeof(frame), framing, type, payload, len);
+        if (used == 0) FAIL("encode refused %u-byte payload", len);
+        if (used > PROTO_FRAME_MAX(len)) FAIL("encode overran PROTO_FRAME_MAX");
+
+        /* Reference frame */
+        uint8_t c = (uint8_t)(type ^ (len & 0xFF) ^ (len >> 8));
+        raw[0] = type;
+        raw[1] = (uint8_t)(len & 0xFF);
+        raw[2] = (uint8_t)(len >> 8);
+        for (uint16_t j = 0; j < len; j++) {
+            raw[3 + j] = payload[j];
+            c ^= payload[j];
+        }
+        raw[3 + len] = c;
+
+        size_t ref_len;
+        if (framing == PROTO_FRAMING_COBS) {
+            ref_len = ref_cobs_encode(ref, raw, PROTO_RAW_LEN(len));
+            ref[ref_len++] = 0x00;
+            if (memchr(frame, 0x00, (size_t)used - 1)) FAIL("0x00 inside COBS frame");
+        } else {
+            ref[0] = PROTO_SOF;
+            memcpy(&ref[1], raw, PROTO_RAW_LEN(len));
+            ref_len = 1 + PROTO_RAW_LEN(len);
+        }
+        if (used != ref_len || memcmp(frame, ref, ref_len) != 0) {
+            FAIL("%s encode of type 0x%02X len %u differs from reference",
+                 framing ? "COBS" : "SOF", type, len);
+        }
+
+        log_frame(&want, PROTO_RX_OK, type, payload, len);
+        log_put(&stream, frame, used);
+    }
+
+    if (proto_encode(frame, sizeof(frame), framing, 0x01, payload, PROTO_MAX_PAYLOAD + 1) != 0) {
+        FAIL("encode accepted an oversize payload");
+    }
+    if (proto_encode(frame, PROTO_FRAME_MAX(8) - 1, framing, 0x01, payload, 8) != 0) {
+        FAIL("encode accepted a short buffer");
+    }
+
+    codec_parse(framing, stream.d, stream.n, 0, seed, false, &got);
+    log_expect(&got, &want, framing ? "COBS round trip" : "SOF round trip");
+
+    free(want.d);
+    free(got.d);
+    free(stream.d);
+}
+
+static void check_input(const uint8_t *d, size_t n)
+{
+    uint32_t seed = 0;
+    for (size_t i = 0; i < n && i < 4; i++) seed = (seed << 8) | d[i];
+
+    check_parse(PROTO_FRAMING_SOF, d, n, seed);
+    check_parse(PROTO_FRAMING_COBS, d, n, seed);
+    check_roundtrip(PROTO_FRAMING_SOF, d, n, seed);
+    check_roundtrip(PROTO_FRAMING_COBS, d, n, seed);
+}
+
+#ifdef PROTO_LIBFUZZER
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    check_input(data, size);
+    return 0;
+}
+
+#else
+
+/* Valid frames in one framing, with a few bits flipped */
+static size_t make_stream(uint8_t *out, size_t cap, uint32_t *rng)
+{
+    static uint8_t payload[PROTO_MAX_PAYLOAD];
+    uint8_t framing = rng_next(rng) & 1;
+    size_t  n = 0;
+
+    while (n + PROTO_FRAME_MAX(PROTO_MAX_PAYLOAD) <= cap && (rng_next(rng) & 7)) {
+        uint16_t len = (uint16_t)(rng_next(rng) % 4 ? rng_next(rng) % 40
+                                                    : rng_next(rng) % (PROTO_MAX_PAYLOAD + 1));
+        for (uint16_t j = 0; j < len; j++) {
+            payload[j] = (rng_next(rng) & 3) ? (uint8_t)*rng : 0;
+        }
+        n += proto_encode(&out[n], cap - n, framing, (uint8_t)rng_next(rng), payload, len);
+    }
+    for (int flips = (int)(rng_next(rng) % 4); flips > 0 && n > 0; flips--) {
+        out[rng_next(rng) % n] ^= (uint8_t)(1u << (rng_next(rng) & 7));
+    }
+    return n;
+}
+
+int main(int argc, char **argv)
+{
+    long     iters = argc > 1 ? strtol(argv[1], NULL, 0) : 20000;
+    uint32_t rng   = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 0) : 1;
+    static uint8_t buf[8192];
+
+    for (long it = 0; it < iters; it++) {
+        size_t n;
+        if (it & 1) {
+            n = make_stream(buf, sizeof(buf), &rng);
+        } else {
+            n = rng_next(&rng) % 2048;
+            for (size_t i = 0; i < n; i++) {
+                /* Bias towards the bytes the parser treats specially */
+                uint32_t r = rng_next(&rng);
+                buf[i] = (r & 7) == 0 ? 0x00 : (r & 7) == 1 ? PROTO_SOF : (uint8_t)(r >> 8);
+            }
+        }
+        check_input(buf, n);
+    }
+
+    printf("proto_fuzz: %ld inputs ok\n", iters);
+    return 0;
+}
+
+#endif
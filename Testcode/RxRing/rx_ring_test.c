@@ -0,0 +1,210 @@
+/*
+ * Line-rate test of the peripheral HALs' RX ring (hal/rx_ring.h)
+ *
+ * A thread stands in for the UART interrupt: it puts bytes into the ring
+ * with rx_ring_put() as fast as the line delivers them, back-to-back frames
+ * to one slave, each carrying a sequence number. The main thread is the
+ * app: the real slave core (core/rs485_slave.c) on a HAL over the same
+ * ring, with rs485_slave_poll() called once every poll period and nothing
+ * in between. Both run in real time.
+ *
+ * Runs twice: with the ports' ring (HAL_*_RX_RING, 2048 bytes), which must
+ * hand every frame over with no byte dropped, and with a ring smaller than
+ * one poll period of line time, which must not — so a pass means the
+ * ring, not the test, kept up.
+ *
+ * Prints frames sent and received, bytes dropped, the ring's high-water
+ * mark and the longest gap the host's scheduler actually left between
+ * polls. Exits 1 if either run goes the wrong way.
+ *
+ * Usage:  rx_ring_test [baud] [poll_ms] [seconds]
+ */
+
+#define _GNU_SOURCE
+#include "rs485_slave.h"
+#include "rx_ring.h"
+#include "crc8.h"
+#include "hal.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SLAVE_ADDR      0x10
+#define PORT_RING       2048u           /* HAL_STM32F1_RX_RING et al. */
+#define RING_MAX        32768u
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/* ------------------------------------------------------------------ */
+/* Host HAL over the ring                                               */
+/* ------------------------------------------------------------------ */
+
+static rx_ring_t s_rx;
+static uint8_t   s_rx_buf[RING_MAX];
+static uint64_t  s_t0_ns;
+
+void hal_uart_init(uint32_t baud)              { (void)baud; }
+bool hal_uart_set_baud(uint32_t baud)          { (void)baud; return true; }
+uint32_t hal_uart_max_baud(void)               { return 1000000; }
+void hal_uart_set_tx_enable(bool enable)       { (void)enable; }
+void hal_uart_write(const uint8_t *buf, size_t len) { (void)buf; (void)len; }
+bool hal_uart_tx_busy(void)                    { return false; }
+void hal_int_pin_init(void)                    { }
+void hal_int_pin_drive(bool assert_low)        { (void)assert_low; }
+uint32_t hal_millis(void)                      { return (uint32_t)((now_ns() - s_t0_ns) / 1000000u); }
+
+size_t hal_uart_rx_span(const uint8_t **data)  { return rx_ring_span(&s_rx, data); }
+void hal_uart_rx_consume(size_t n)             { rx_ring_consume(&s_rx, n); }
+
+uint32_t hal_flash_slot_size(void)             { return 0; }
+uint32_t hal_flash_page_size(void)             { return 0; }
+bool hal_flash_erase(uint32_t off)             { (void)off; return false; }
+bool hal_flash_write(uint32_t off, const uint8_t *buf, size_t len) { (void)off; (void)buf; (void)len; return false; }
+void hal_flash_read(uint32_t off, uint8_t *buf, size_t len) { (void)off; memset(buf, 0xFF, len); }
+void hal_boot_install(uint32_t size)           { (void)size; }
+
+/* ------------------------------------------------------------------ */
+/* Slave: counts frames, checks their sequence                          */
+/* ------------------------------------------------------------------ */
+
+static uint32_t s_expect, s_received, s_out_of_order;
+
+static int on_frame(const uint8_t *p, uint8_t plen, uint8_t *resp, uint8_t resp_size)
+{
+    (void)resp; (void)resp_size;
+    if (plen < 4) return -1;
+    uint32_t seq = (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+                   ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    if (seq != s_expect) s_out_of_order++;
+    s_expect = seq + 1;
+    s_received++;
+    return -1;
+}
+
+#define K_COMMANDS(X)   X(RS485_CMD_SET_OUTPUT, on_frame)
+RS485_DISPATCH_TABLE(k_dispatch, K_COMMANDS);
+static const rs485_slave_cfg_t k_cfg = { .addr = SLAVE_ADDR, .fw_version = 1,
+                                         .dispatch = k_dispatch };
+
+/* ------------------------------------------------------------------ */
+/* Line: the UART interrupt at full rate                                */
+/* ------------------------------------------------------------------ */
+
+typedef struct {
+    uint32_t baud;
+    uint64_t run_ns;
+    uint32_t frames;            /* out */
+    uint64_t bytes;             /* out */
+    uint16_t high_water;        /* out */
+    int      done;
+} line_t;
+
+/* Frame `seq`: payload is the sequence number plus 0..60 filler bytes */
+static size_t encode(uint8_t *f, uint32_t seq)
+{
+    uint8_t plen = (uint8_t)(4u + (seq * 7u) % 61u);
+    f[0] = RS485_SOF;
+    f[1] = SLAVE_ADDR;
+    f[2] = RS485_CMD_SET_OUTPUT;
+    f[3] = plen;
+    for (uint8_t i = 0; i < plen; i++) f[4 + i] = (uint8_t)(seq >> (8 * (i & 3)));
+    f[4 + plen] = crc8(&f[1], 3u + plen);
+    return 5u + plen;
+}
+
+static void *line_thread(void *arg)
+{
+    line_t  *l = arg;
+    uint8_t  f[RS485_MAX_FRAME];
+    size_t   flen = 0, fpos = 0;
+    uint64_t t0 = now_ns();
+
+    for (;;) {
+        uint64_t t   = now_ns() - t0;
+        uint64_t due = t * l->baud / 10u / 1000000000u;
+        while (l->bytes < due) {
+            if (fpos == flen) {
+                if (t >= l->run_ns) goto done;  /* stop on a frame boundary */
+                flen = encode(f, l->frames++);
+                fpos = 0;
+            }
+            rx_ring_put(&s_rx, f[fpos++]);
+            l->bytes++;
+            uint16_t fill = (uint16_t)(s_rx.head - __atomic_load_n(&s_rx.tail, __ATOMIC_ACQUIRE));
+            if (fill > l->high_water) l->high_water = fill;
+        }
+        struct timespec nap = { 0, 20000 };
+        nanosleep(&nap, NULL);
+    }
+done:
+    __atomic_store_n(&l->done, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+/* ------------------------------------------------------------------ */
+/* One run                                                              */
+/* ------------------------------------------------------------------ */
+
+static bool run(uint16_t ring, uint32_t baud, uint32_t poll_ms, double seconds, bool expect_loss)
+{
+    rx_ring_init(&s_rx, s_rx_buf, ring);
+    s_expect = s_received = s_out_of_order = 0;
+    s_t0_ns  = now_ns();
+    rs485_slave_init(&k_cfg);
+
+    line_t l = { .baud = baud, .run_ns = (uint64_t)(seconds * 1e9) };
+    pthread_t th;
+    pthread_create(&th, NULL, line_thread, &l);
+
+    uint64_t period = (uint64_t)poll_ms * 1000000u;
+    uint64_t next   = now_ns(), last = 0, max_gap = 0;
+    for (;;) {
+        bool done = __atomic_load_n(&l.done, __ATOMIC_ACQUIRE);
+        uint64_t t = now_ns();
+        if (last && t - last > max_gap) max_gap = t - last;
+        last = t;
+        rs485_slave_poll();
+        if (done) break;
+
+        next += period;
+        struct timespec ts = { (time_t)(next / 1000000000u), (long)(next % 1000000000u) };
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+    }
+    pthread_join(th, NULL);
+
+    bool lost = s_rx.dropped || s_received != l.frames || s_out_of_order;
+    bool ok   = lost == expect_loss;
+    printf("ring %5u  %8u frames %10llu bytes  received %8u  dropped %7u bytes"
+           "  high water %5u  max poll gap %5.1f ms  %s\n",
+           ring, l.frames, (unsigned long long)l.bytes, s_received,
+           s_rx.dropped, l.high_water, (double)max_gap / 1e6,
+           ok ? "ok" : (expect_loss ? "FAIL (expected loss)" : "FAIL"));
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t baud    = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 0) : 1000000;
+    uint32_t poll_ms = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 0) : RS485_POLL_MAX_MS;
+    double   seconds = argc > 3 ? atof(argv[3]) : 3.0;
+
+    /* Largest power of two under one poll period of line time */
+    uint32_t per_poll = baud / 10u * poll_ms / 1000u;
+    uint16_t small = 16;
+    while (small * 2u < per_poll && small * 2u <= RING_MAX) small *= 2u;
+
+    printf("%u baud, rs485_slave_poll() every %u ms (%u bytes of line time), %.1f s\n",
+           baud, poll_ms, per_poll, seconds);
+
+    bool ok = run(PORT_RING, baud, poll_ms, seconds, false);
+    ok &= run(small, baud, poll_ms, seconds, true);
+    return ok ? 0 : 1;
+}
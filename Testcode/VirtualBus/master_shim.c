@@ -0,0 +1,316 @@
+/*
+ * The Pico SDK and FreeRTOS calls GCS/src/rs485.c and tx_ring.c make,
+ * on Linux: the UART is a node on the virtual bus (vbus.h), the RX
+ * interrupt runs on the bus reader thread, tasks are pthreads and a
+ * FreeRTOS tick is a millisecond of CLOCK_MONOTONIC. The headers are in
+ * shim/. The Pi side (proto_*) is vbus_master.c's.
+ */
+
+#define _GNU_SOURCE
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "hardware/uart.h"
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+#include "hardware/flash.h"
+#include "pico/stdlib.h"
+#include "pico/flash.h"
+#include "vbus.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t boot_ns(void)
+{
+    static uint64_t t0;
+    if (!t0) t0 = now_ns();
+    return t0;
+}
+
+static struct timespec deadline(TickType_t ticks)
+{
+    uint64_t t = now_ns() + (uint64_t)ticks * 1000000u;
+    return (struct timespec){ (time_t)(t / 1000000000u), (long)(t % 1000000000u) };
+}
+
+uint32_t time_us_32(void)
+{
+    return (uint32_t)((now_ns() - boot_ns()) / 1000u);
+}
+
+void busy_wait_us_32(uint32_t us)
+{
+    uint64_t end = now_ns() + (uint64_t)us * 1000u;
+    while (now_ns() < end) { }
+}
+
+/* ------------------------------------------------------------------ */
+/* Tasks                                                                */
+/* ------------------------------------------------------------------ */
+
+struct shim_task {
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    uint32_t        notified;
+};
+
+static __thread struct shim_task *t_self;
+static pthread_mutex_t s_critical;
+
+static void __attribute__((constructor)) shim_init(void)
+{
+    pthread_mutexattr_t ma;
+    pthread_mutexattr_init(&ma);
+    pthread_mutexattr_settype(&ma, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&s_critical, &ma);
+    memset(shim_flash, 0xFF, sizeof(shim_flash));
+    boot_ns();
+}
+
+void shim_enter_critical(void) { pthread_mutex_lock(&s_critical); }
+void shim_exit_critical(void)  { pthread_mutex_unlock(&s_critical); }
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)((now_ns() - boot_ns()) / 1000000u);
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    struct timespec ts = deadline(ticks);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) != 0) { }
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    if (!t_self) {
+        t_self = calloc(1, sizeof(*t_self));
+        pthread_condattr_t ca;
+        pthread_condattr_init(&ca);
+        pthread_condattr_setclock(&ca, CLOCK_MONOTONIC);
+        pthread_mutex_init(&t_self->lock, NULL);
+        pthread_cond_init(&t_self->cond, &ca);
+    }
+    return t_self;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t wait)
+{
+    struct shim_task *t  = xTaskGetCurrentTaskHandle();
+    struct timespec   ts = deadline(wait);
+    pthread_mutex_lock(&t->lock);
+    while (!t->notified && wait) {
+        if (wait == portMAX_DELAY) pthread_cond_wait(&t->cond, &t->lock);
+        else if (pthread_cond_timedwait(&t->cond, &t->lock, &ts) != 0) break;
+    }
+    uint32_t n = t->notified;
+    if (n) t->notified = clear ? 0 : n - 1u;
+    pthread_mutex_unlock(&t->lock);
+    return n;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t t)
+{
+    pthread_mutex_lock(&t->lock);
+    t->notified++;
+    pthread_cond_signal(&t->cond);
+    pthread_mutex_unlock(&t->lock);
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t t, BaseType_t *woken)
+{
+    xTaskNotifyGive(t);
+    if (woken) *woken = pdTRUE;
+}
+
+/* ------------------------------------------------------------------ */
+/* Mutexes                                                              */
+/* ------------------------------------------------------------------ */
+
+struct shim_mutex {
+    pthread_mutex_t m;
+};
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    SemaphoreHandle_t s = calloc(1, sizeof(*s));
+    pthread_mutex_init(&s->m, NULL);
+    return s;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t wait)
+{
+    if (wait == portMAX_DELAY) return pthread_mutex_lock(&s->m) == 0;
+    if (wait == 0) return pthread_mutex_trylock(&s->m) == 0;
+    struct timespec ts = deadline(wait);
+    return pthread_mutex_clocklock(&s->m, CLOCK_MONOTONIC, &ts) == 0;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t s)
+{
+    return pthread_mutex_unlock(&s->m) == 0;
+}
+
+/* ------------------------------------------------------------------ */
+/* UART on the bus                                                      */
+/* ------------------------------------------------------------------ */
+
+struct shim_uart { int unused; };
+static struct shim_uart s_uart1;
+uart_inst_t *const shim_uart1 = &s_uart1;
+
+static irq_handler_t   s_isr;
+static bool            s_irq_on, s_rx_irq_on;
+static const uint8_t  *s_rx_data;       /* the chunk the "ISR" is draining */
+static size_t          s_rx_len, s_rx_pos;
+
+static pthread_mutex_t s_tx_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  s_tx_cond = PTHREAD_COND_INITIALIZER;
+static bool            s_tx_busy;
+static volatile bool   s_int_low;
+
+/* Bus reader thread: bytes off the line raise the RX interrupt */
+static void on_rx(void *ctx, const uint8_t *data, size_t len)
+{
+    (void)ctx;
+    shim_enter_critical();
+    if (s_isr && s_irq_on && s_rx_irq_on) {
+        s_rx_data = data;
+        s_rx_len  = len;
+        s_rx_pos  = 0;
+        s_isr();
+        s_rx_len  = 0;
+    }
+    shim_exit_critical();
+}
+
+static void on_tx_done(void *ctx)
+{
+    (void)ctx;
+    pthread_mutex_lock(&s_tx_lock);
+    s_tx_busy = false;
+    pthread_cond_broadcast(&s_tx_cond);
+    pthread_mutex_unlock(&s_tx_lock);
+}
+
+static void on_int(void *ctx, bool low)
+{
+    (void)ctx;
+    s_int_low = low;
+}
+
+unsigned uart_init(uart_inst_t *uart, unsigned baud)
+{
+    (void)uart;
+    static const vbus_cb_t cb = { .on_rx = on_rx, .on_tx_done = on_tx_done,
+                                  .on_int = on_int };
+    if (!vbus_open(&cb)) {
+        fprintf(stderr, "master: no bus hub at $RS485_VBUS or %s\n", VBUS_DEFAULT_PATH);
+        exit(1);
+    }
+    vbus_set_baud(baud);
+    return baud;
+}
+
+unsigned uart_set_baudrate(uart_inst_t *uart, unsigned baud)
+{
+    (void)uart;
+    vbus_set_baud(baud);
+    return baud;
+}
+
+void uart_set_irq_enables(uart_inst_t *uart, bool rx, bool tx)
+{
+    (void)uart; (void)tx;
+    s_rx_irq_on = rx;
+}
+
+bool uart_is_readable(uart_inst_t *uart)
+{
+    (void)uart;
+    return s_rx_pos < s_rx_len;
+}
+
+char uart_getc(uart_inst_t *uart)
+{
+    (void)uart;
+    return s_rx_pos < s_rx_len ? (char)s_rx_data[s_rx_pos++] : 0;
+}
+
+void uart_write_blocking(uart_inst_t *uart, const uint8_t *src, size_t len)
+{
+    (void)uart;
+    pthread_mutex_lock(&s_tx_lock);
+    s_tx_busy = true;
+    pthread_mutex_unlock(&s_tx_lock);
+    vbus_send(src, len);
+}
+
+/* Until the hub has put the last stop bit on the line */
+void uart_tx_wait_blocking(uart_inst_t *uart)
+{
+    (void)uart;
+    pthread_mutex_lock(&s_tx_lock);
+    while (s_tx_busy) pthread_cond_wait(&s_tx_cond, &s_tx_lock);
+    pthread_mutex_unlock(&s_tx_lock);
+}
+
+void irq_set_exclusive_handler(unsigned num, irq_handler_t handler)
+{
+    (void)num;
+    s_isr = handler;
+}
+
+void irq_set_enabled(unsigned num, bool enabled)
+{
+    (void)num;
+    s_irq_on = enabled;
+}
+
+/* The only input rs485.c reads is /INT */
+bool gpio_get(unsigned pin)
+{
+    (void)pin;
+    return !s_int_low;
+}
+
+/* ------------------------------------------------------------------ */
+/* Flash                                                                */
+/* ------------------------------------------------------------------ */
+
+uint8_t shim_flash[PICO_FLASH_SIZE_BYTES];
+
+void flash_range_erase(uint32_t off, size_t count)
+{
+    if (off < sizeof(shim_flash) && count <= sizeof(shim_flash) - off) {
+        memset(&shim_flash[off], 0xFF, count);
+    }
+}
+
+void flash_range_program(uint32_t off, const uint8_t *data, size_t count)
+{
+    if (off < sizeof(shim_flash) && count <= sizeof(shim_flash) - off) {
+        for (size_t i = 0; i < count; i++) shim_flash[off + i] &= data[i];
+    }
+}
+
+int flash_safe_execute(void (*func)(void *), void *param, uint32_t timeout_ms)
+{
+    (void)timeout_ms;
+    shim_enter_critical();
+    func(param);
+    shim_exit_critical();
+    return PICO_OK;
+}
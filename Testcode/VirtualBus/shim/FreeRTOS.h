@@ -0,0 +1,25 @@
+#ifndef SHIM_FREERTOS_H
+#define SHIM_FREERTOS_H
+
+/* Just enough FreeRTOS for GCS/src/rs485.c and tx_ring.c as host
+   threads (master_shim.c): a tick is a millisecond of CLOCK_MONOTONIC */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <assert.h>
+
+typedef uint32_t TickType_t;
+typedef int32_t  BaseType_t;
+typedef uint32_t UBaseType_t;
+
+#define pdTRUE                  1
+#define pdFALSE                 0
+#define pdPASS                  pdTRUE
+#define portTICK_PERIOD_MS      1u
+#define portMAX_DELAY           0xFFFFFFFFu
+#define pdMS_TO_TICKS(ms)       ((TickType_t)(ms))
+#define portYIELD_FROM_ISR(w)   ((void)(w))
+#define configASSERT(x)         assert(x)
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef SHIM_HARDWARE_FLASH_H
+#define SHIM_HARDWARE_FLASH_H
+
+/* Flash is an array in the process, XIP-mapped at XIP_BASE */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define FLASH_SECTOR_SIZE       4096u
+#define FLASH_PAGE_SIZE         256u
+#define PICO_FLASH_SIZE_BYTES   (64u * 1024u)
+
+extern uint8_t shim_flash[PICO_FLASH_SIZE_BYTES];
+#define XIP_BASE                ((uintptr_t)shim_flash)
+
+void flash_range_erase(uint32_t off, size_t count);
+void flash_range_program(uint32_t off, const uint8_t *data, size_t count);
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef SHIM_HARDWARE_GPIO_H
+#define SHIM_HARDWARE_GPIO_H
+
+/* Pins are no-ops but for /INT, which reads the bus's line (master_shim.c) */
+
+#include <stdbool.h>
+
+#define GPIO_FUNC_UART  2
+#define GPIO_OUT        true
+#define GPIO_IN         false
+
+static inline void gpio_init(unsigned pin)                      { (void)pin; }
+static inline void gpio_set_function(unsigned pin, int fn)      { (void)pin; (void)fn; }
+static inline void gpio_set_dir(unsigned pin, bool out)         { (void)pin; (void)out; }
+static inline void gpio_put(unsigned pin, bool value)           { (void)pin; (void)value; }
+static inline void gpio_pull_up(unsigned pin)                   { (void)pin; }
+bool gpio_get(unsigned pin);
+
+#endif
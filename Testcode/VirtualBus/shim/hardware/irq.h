@@ -0,0 +1,16 @@
+#ifndef SHIM_HARDWARE_IRQ_H
+#define SHIM_HARDWARE_IRQ_H
+
+/* The UART "interrupt" runs on the bus reader thread (master_shim.c) */
+
+#include <stdbool.h>
+
+#define UART1_IRQ   21
+#define __isr
+
+typedef void (*irq_handler_t)(void);
+
+void irq_set_exclusive_handler(unsigned num, irq_handler_t handler);
+void irq_set_enabled(unsigned num, bool enabled);
+
+#endif
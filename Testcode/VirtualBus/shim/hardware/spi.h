@@ -0,0 +1,4 @@
+#ifndef SHIM_HARDWARE_SPI_H
+#define SHIM_HARDWARE_SPI_H
+/* pins.h names spi1 in macros rs485.c never expands */
+#endif
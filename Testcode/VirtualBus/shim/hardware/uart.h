@@ -0,0 +1,22 @@
+#ifndef SHIM_HARDWARE_UART_H
+#define SHIM_HARDWARE_UART_H
+
+/* The master's UART is a node on the virtual bus (master_shim.c) */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct shim_uart uart_inst_t;
+extern uart_inst_t *const shim_uart1;
+#define uart1   shim_uart1
+
+unsigned uart_init(uart_inst_t *uart, unsigned baud);
+unsigned uart_set_baudrate(uart_inst_t *uart, unsigned baud);
+void     uart_set_irq_enables(uart_inst_t *uart, bool rx, bool tx);
+bool     uart_is_readable(uart_inst_t *uart);
+char     uart_getc(uart_inst_t *uart);
+void     uart_write_blocking(uart_inst_t *uart, const uint8_t *src, size_t len);
+void     uart_tx_wait_blocking(uart_inst_t *uart);
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef SHIM_PICO_STDLIB_H
+#define SHIM_PICO_STDLIB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "hardware/uart.h"
+#include "hardware/gpio.h"
+
+typedef unsigned int uint;
+
+uint32_t time_us_32(void);
+void     busy_wait_us_32(uint32_t us);
+
+#endif
@@ -0,0 +1,8 @@
+#ifndef SHIM_QUEUE_H
+#define SHIM_QUEUE_H
+
+#include "FreeRTOS.h"
+
+typedef struct shim_queue *QueueHandle_t;
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef SHIM_SEMPHR_H
+#define SHIM_SEMPHR_H
+
+#include "FreeRTOS.h"
+
+typedef struct shim_mutex *SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+BaseType_t        xSemaphoreTake(SemaphoreHandle_t m, TickType_t wait);
+BaseType_t        xSemaphoreGive(SemaphoreHandle_t m);
+
+#endif
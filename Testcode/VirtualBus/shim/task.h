@@ -0,0 +1,22 @@
+#ifndef SHIM_TASK_H
+#define SHIM_TASK_H
+
+#include "FreeRTOS.h"
+
+typedef struct shim_task *TaskHandle_t;
+
+TickType_t   xTaskGetTickCount(void);
+void         vTaskDelay(TickType_t ticks);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+uint32_t     ulTaskNotifyTake(BaseType_t clear, TickType_t wait);
+BaseType_t   xTaskNotifyGive(TaskHandle_t task);
+void         vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken);
+
+/* One lock for every critical section, also held around the "ISR" —
+   as masking interrupts on the single core rs485_task runs on */
+void shim_enter_critical(void);
+void shim_exit_critical(void);
+#define taskENTER_CRITICAL()    shim_enter_critical()
+#define taskEXIT_CRITICAL()     shim_exit_critical()
+
+#endif
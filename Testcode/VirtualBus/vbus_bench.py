@@ -0,0 +1,101 @@
+# Virtual RS-485 bus benchmark — hub, N slaves and the GCS master as Linux
+# processes (see CMakeLists.txt in this directory)
+#
+# Starts vbus_hub on a private socket, `--slaves` vbus_slave processes at
+# addresses 0x10 upwards plus any `--app` executables (Peripherals/<App>
+# built with -DTARGET_MCU=posix), then vbus_master expecting all of them,
+# and prints its report. Everything is stopped afterwards.
+#
+# `--dead N` kills the last N slaves once discovery and baud negotiation
+# are over, as the master starts its load (or its -k settle time): a
+# partly dead bus, where the master must notice the silence, flag them
+# offline and back off.
+#
+# Usage:  python3 vbus_bench.py [--build build] [--slaves 30] [--app PATH ...]
+#                               [--int] [--dead N] [-- vbus_master options]
+#
+#   python3 vbus_bench.py --slaves 30 -- -s 10 -w 4
+#   python3 vbus_bench.py --slaves 8 --app ../../Peripherals/Searchlight/build/searchlight -- -t 100
+#   python3 vbus_bench.py --slaves 8 --int --dead 4 -- -s 60 -r 130 -w 8 [-k 5000]
+
+import argparse
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+
+def main() -> int:
+    ap = argparse.ArgumentParser()
+    ap.add_argument("--build", default=os.path.join(os.path.dirname(__file__), "build"))
+    ap.add_argument("--slaves", type=int, default=30)
+    ap.add_argument("--app", action="append", default=[],
+                    help="peripheral app built with TARGET_MCU=posix")
+    ap.add_argument("--int", action="store_true",
+                    help="slaves pulse /INT every few seconds")
+    ap.add_argument("--dead", type=int, default=0,
+                    help="slaves killed when the load starts")
+    ap.add_argument("master_args", nargs=argparse.REMAINDER)
+    args = ap.parse_args()
+    if not 0 <= args.dead <= args.slaves:
+        print("--dead must be 0..--slaves", file=sys.stderr)
+        return 2
+
+    # rs485.c keeps RS485_MAX_PERIPHERALS (32) devices
+    total = args.slaves + len(args.app)
+    if total > 32:
+        print("at most 32 peripherals (RS485_MAX_PERIPHERALS)", file=sys.stderr)
+        return 2
+
+    tmp  = tempfile.mkdtemp(prefix="vbus_")
+    env  = dict(os.environ, RS485_VBUS=os.path.join(tmp, "bus"))
+    bin_ = lambda name: os.path.join(args.build, name)
+    quiet = dict(env=env, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    procs = []
+    slaves = []
+    try:
+        procs.append(subprocess.Popen([bin_("vbus_hub")], env=env, stdout=subprocess.PIPE,
+                                      text=True))
+        while not os.path.exists(env["RS485_VBUS"]):
+            time.sleep(0.01)
+
+        for i in range(args.slaves):
+            cmd = [bin_("vbus_slave"), "0x%02X" % (0x10 + i)]
+            if args.int:
+                cmd.append("-i")
+            slaves.append(subprocess.Popen(cmd, **quiet))
+            procs.append(slaves[-1])
+        for app in args.app:
+            procs.append(subprocess.Popen([app], **quiet))
+        time.sleep(0.2)
+
+        extra = [a for a in args.master_args if a != "--"]
+        master = subprocess.Popen([bin_("vbus_master"), "-n", str(total)] + extra, env=env,
+                                  stdout=subprocess.PIPE, text=True)
+        for line in master.stdout:
+            print(line, end="", flush=True)
+            if line.startswith("bus at") and args.dead:
+                for p in slaves[len(slaves) - args.dead:]:
+                    p.kill()
+                print("killed %d of %d slaves" % (args.dead, args.slaves), flush=True)
+        rc = master.wait()
+    finally:
+        procs[0].terminate() if procs else None
+        for p in procs[1:]:
+            try:
+                p.wait(timeout=2)
+            except subprocess.TimeoutExpired:
+                p.kill()
+        if procs:
+            print(procs[0].communicate()[0].strip().splitlines()[-1])
+        try:
+            os.unlink(env["RS485_VBUS"])
+        except OSError:
+            pass
+        os.rmdir(tmp)
+    return rc
+
+
+if __name__ == "__main__":
+    sys.exit(main())
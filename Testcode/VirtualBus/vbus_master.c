@@ -0,0 +1,367 @@
+/*
+ * RS-485 bus master on the virtual bus: GCS/src/rs485.c itself, with its
+ * Pico SDK and FreeRTOS calls answered by master_shim.c, and a stand-in
+ * Pi on the other end of proto_*.
+ *
+ * Waits for discovery to find the expected number of peripherals and for
+ * the bus to settle at its negotiated rate, then runs a load: GET_STATUS
+ * to every online peripheral in turn through rs485_forward_cmd(), with up
+ * to `window` commands in flight, optionally paced to `rate` per second,
+ * optionally with every peripheral streaming. A peripheral flagged offline
+ * meanwhile is skipped, as the Pi does once PERIPH_STATE says so. Reports the Pi's view of
+ * command latency, the scheduler's counters, the per-peripheral stats
+ * (PROTO_TYPE_PERIPH_STATS) and the hub's bus load.
+ *
+ * Exits 1 if discovery came up short or a command was refused or never
+ * answered at all. Timeouts are reported, not failed: how many there are
+ * depends on how promptly the host schedules the slaves.
+ *
+ * `-k settle_ms` waits that long between the baud settling and the load,
+ * so peripherals vbus_bench.py --dead kills meanwhile are already flagged
+ * offline when it starts.
+ *
+ * Usage:  vbus_master [-n peripherals] [-s seconds] [-w window]
+ *                     [-r cmds_per_s] [-t stream_ms] [-k settle_ms] [-v]
+ */
+
+#define _GNU_SOURCE
+#include "rs485.h"
+#include "protocol.h"
+#include "screen_display.h"
+#include "vbus.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static void sleep_ms(uint32_t ms)
+{
+    struct timespec ts = { (time_t)(ms / 1000u), (long)(ms % 1000u) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+/* ------------------------------------------------------------------ */
+/* The Pi: what rs485.c sends up the CDC link                            */
+/* ------------------------------------------------------------------ */
+
+static pthread_mutex_t s_pi_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  s_pi_cond = PTHREAD_COND_INITIALIZER;
+static bool            s_verbose;
+
+static uint8_t  s_pi_type;
+static uint16_t s_pi_len;
+static uint8_t  s_pi_frame[PROTO_MAX_PAYLOAD];
+
+/* Commands in flight, by req_id */
+static uint64_t s_sent_ns[256];
+static bool     s_in_flight[256];
+static uint32_t s_outstanding;
+
+static uint32_t s_results[PERIPH_RESULT_NACK + 1];
+static uint32_t s_stream_frames, s_unsolicited, s_state_events;
+static uint32_t *s_lat_us;
+static size_t   s_lat_n, s_lat_cap;
+
+/* PERIPH_STATS, summed over the registry (each frame carries on where
+   the last left off, and wraps) */
+static bool     s_ps_seen[256];
+static uint32_t s_ps_entries, s_ps_answered, s_ps_timeouts, s_ps_crc, s_ps_lat_max;
+
+static void pi_periph_data(const periph_data_t *d)
+{
+    if (d->req_id == 0) {
+        if (d->cmd == RS485_CMD_STREAM_DATA) s_stream_frames++;
+        else s_unsolicited++;
+        return;
+    }
+    if (!s_in_flight[d->req_id]) return;
+    s_in_flight[d->req_id] = false;
+    s_outstanding--;
+    if (d->result <= PERIPH_RESULT_NACK) s_results[d->result]++;
+    if (d->result == PERIPH_RESULT_OK) {
+        if (s_lat_n == s_lat_cap) {
+            s_lat_cap = s_lat_cap ? s_lat_cap * 2u : 4096u;
+            s_lat_us  = realloc(s_lat_us, s_lat_cap * sizeof(*s_lat_us));
+        }
+        s_lat_us[s_lat_n++] = (uint32_t)((now_ns() - s_sent_ns[d->req_id]) / 1000u);
+    }
+    pthread_cond_broadcast(&s_pi_cond);
+}
+
+static void pi_periph_stats(const uint8_t *p, uint16_t len)
+{
+    const periph_stats_hdr_t *h = (const periph_stats_hdr_t *)p;
+    if (len < sizeof(*h)) return;
+    const periph_stats_entry_t *e = (const periph_stats_entry_t *)(p + sizeof(*h));
+    for (uint8_t i = 0; i < h->n_periph; i++) {
+        if (s_ps_seen[e[i].addr]) continue;
+        s_ps_seen[e[i].addr] = true;
+        s_ps_entries++;
+        s_ps_answered += e[i].answered;
+        s_ps_timeouts += e[i].timeouts;
+        s_ps_crc      += e[i].crc_errors;
+        if (e[i].lat_max_us > s_ps_lat_max) s_ps_lat_max = e[i].lat_max_us;
+    }
+}
+
+uint8_t *proto_tx_begin(uint8_t type, uint16_t payload_len)
+{
+    if (payload_len > sizeof(s_pi_frame)) return NULL;
+    pthread_mutex_lock(&s_pi_lock);
+    s_pi_type = type;
+    s_pi_len  = payload_len;
+    return s_pi_frame;
+}
+
+void proto_tx_end(uint8_t *payload)
+{
+    switch (s_pi_type) {
+    case PROTO_TYPE_PERIPH_DATA:
+        pi_periph_data((const periph_data_t *)payload);
+        break;
+    case PROTO_TYPE_PERIPH_STATE: {
+        const periph_state_t *s = (const periph_state_t *)payload;
+        s_state_events++;
+        if (s_verbose) printf("  0x%02X %s\n", s->addr, s->online ? "online" : "offline");
+        break;
+    }
+    case PROTO_TYPE_PERIPH_STATS:
+        pi_periph_stats(payload, s_pi_len);
+        break;
+    }
+    pthread_mutex_unlock(&s_pi_lock);
+}
+
+bool proto_send(uint8_t type, const void *payload, uint16_t payload_len)
+{
+    uint8_t *p = proto_tx_begin(type, payload_len);
+    if (!p) return false;
+    memcpy(p, payload, payload_len);
+    proto_tx_end(p);
+    return true;
+}
+
+void screen_periph_update_data(uint8_t addr, uint8_t cmd,
+                               const uint8_t *payload, uint8_t len)
+{
+    (void)addr; (void)cmd; (void)payload; (void)len;
+}
+
+/* Queue one command as cdc_task would; s_pi_lock held */
+static uint8_t s_next_id = 1;
+
+static void pi_send(uint8_t addr, uint8_t cmd, const uint8_t *payload, uint8_t len)
+{
+    while (s_in_flight[s_next_id]) s_next_id = (uint8_t)(s_next_id % 255u + 1u);
+    uint8_t id = s_next_id;
+    s_next_id  = (uint8_t)(s_next_id % 255u + 1u);
+
+    uint8_t buf[sizeof(periph_cmd_t) + 255];
+    periph_cmd_t *c = (periph_cmd_t *)buf;
+    c->req_id = id;
+    c->addr   = addr;
+    c->cmd    = cmd;
+    c->len    = len;
+    if (len) memcpy(c->payload, payload, len);
+
+    s_in_flight[id] = true;
+    s_outstanding++;
+    s_sent_ns[id] = now_ns();
+
+    /* A NACK comes straight back through proto_tx_begin() on this thread */
+    pthread_mutex_unlock(&s_pi_lock);
+    rs485_forward_cmd(buf, (uint16_t)(sizeof(periph_cmd_t) + len));
+    pthread_mutex_lock(&s_pi_lock);
+}
+
+/* ------------------------------------------------------------------ */
+
+static void *bus_task(void *arg)
+{
+    rs485_task(arg);
+    return NULL;
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static uint32_t pct(double p)
+{
+    if (!s_lat_n) return 0;
+    size_t i = (size_t)(p / 100.0 * (double)(s_lat_n - 1u) + 0.5);
+    return s_lat_us[i];
+}
+
+int main(int argc, char **argv)
+{
+    unsigned expect = 1, window = 1, rate = 0, stream_ms = 0, settle_ms = 0;
+    double   seconds = 5.0;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:s:w:r:t:k:v")) != -1) {
+        switch (opt) {
+        case 'n': expect    = (unsigned)strtoul(optarg, NULL, 0); break;
+        case 's': seconds   = atof(optarg); break;
+        case 'w': window    = (unsigned)strtoul(optarg, NULL, 0); break;
+        case 'r': rate      = (unsigned)strtoul(optarg, NULL, 0); break;
+        case 't': stream_ms = (unsigned)strtoul(optarg, NULL, 0); break;
+        case 'k': settle_ms = (unsigned)strtoul(optarg, NULL, 0); break;
+        case 'v': s_verbose = true; break;
+        default:
+            fprintf(stderr, "usage: %s [-n peripherals] [-s seconds] [-w window] "
+                            "[-r cmds_per_s] [-t stream_ms] [-k settle_ms] [-v]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    if (window < 1)   window = 1;
+    if (window > 254) window = 254;
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    uint64_t t0 = now_ns();
+    rs485_init();
+    pthread_t th;
+    pthread_create(&th, NULL, bus_task, NULL);
+
+    /* Discovery: no flash cache at boot, so rs485_task scans everything */
+    uint8_t addrs[RS485_MAX_PERIPHERALS];
+    bool    online[RS485_MAX_PERIPHERALS];
+    uint8_t found = 0, n = 0;
+    while ((now_ns() - t0) < 30000000000ull) {
+        n = rs485_get_peripherals(addrs, online, RS485_MAX_PERIPHERALS);
+        found = 0;
+        for (uint8_t i = 0; i < n; i++) found += online[i];
+        if (found >= expect) break;
+        sleep_ms(10);
+    }
+    printf("discovery: %u of %u peripherals online after %.0f ms\n",
+           found, expect, (double)(now_ns() - t0) / 1e6);
+    if (found < expect) return 1;
+    n = 0;
+    for (uint8_t i = 0; i < RS485_MAX_PERIPHERALS && n < found; i++) {
+        if (online[i]) addrs[n++] = addrs[i];
+    }
+
+    /* Baud negotiation, RS485_BAUD_SETTLE_MS after boot */
+    rs485_sched_stats_t st;
+    do {
+        sleep_ms(50);
+        rs485_get_sched_stats(&st);
+    } while (st.baud != RS485_BAUD_MAX && now_ns() - t0 < 10000000000ull);
+    printf("bus at %u baud after %.0f ms\n", st.baud, (double)(now_ns() - t0) / 1e6);
+    sleep_ms(settle_ms);
+
+    if (stream_ms) {
+        uint8_t every[2] = { (uint8_t)stream_ms, (uint8_t)(stream_ms >> 8) };
+        pthread_mutex_lock(&s_pi_lock);
+        pi_send(RS485_ADDR_BROADCAST, RS485_CMD_STREAM_ON, every, sizeof(every));
+        pthread_mutex_unlock(&s_pi_lock);
+        sleep_ms(100);
+    }
+
+    /* Load */
+    rs485_sched_stats_t st0;
+    vbus_stats_t        hub0, hub1;
+    rs485_get_sched_stats(&st0);
+    vbus_stats(&hub0);
+    memset(s_results, 0, sizeof(s_results));
+    uint32_t stream0 = s_stream_frames;
+
+    uint64_t start = now_ns(), end = start + (uint64_t)(seconds * 1e9);
+    uint32_t sent  = 0, target = 0;
+    pthread_mutex_lock(&s_pi_lock);
+    while (now_ns() < end) {
+        if (rate) {
+            uint64_t due = (uint64_t)((double)(now_ns() - start) * rate / 1e9) + 1u;
+            if (sent >= due) {
+                pthread_mutex_unlock(&s_pi_lock);
+                sleep_ms(1);
+                pthread_mutex_lock(&s_pi_lock);
+                continue;
+            }
+        }
+        if (s_outstanding >= window) {
+            struct timespec ts;
+            clock_gettime(CLOCK_REALTIME, &ts);
+            ts.tv_nsec += 1000000;
+            if (ts.tv_nsec >= 1000000000L) { ts.tv_sec++; ts.tv_nsec -= 1000000000L; }
+            pthread_cond_timedwait(&s_pi_cond, &s_pi_lock, &ts);
+            continue;
+        }
+        uint8_t cur[RS485_MAX_PERIPHERALS];
+        bool    up[RS485_MAX_PERIPHERALS];
+        uint8_t m = rs485_get_peripherals(cur, up, RS485_MAX_PERIPHERALS);
+        bool    any = false;
+        for (uint8_t k = 0; k < n && !any; k++) {
+            uint8_t a = addrs[target++ % n];
+            for (uint8_t i = 0; i < m; i++) {
+                if (cur[i] == a && up[i]) { any = true; break; }
+            }
+            if (any) pi_send(a, RS485_CMD_GET_STATUS, NULL, 0);
+        }
+        if (!any) {
+            pthread_mutex_unlock(&s_pi_lock);
+            sleep_ms(1);
+            pthread_mutex_lock(&s_pi_lock);
+            continue;
+        }
+        sent++;
+    }
+    /* Let what is in flight finish */
+    uint64_t drain = now_ns() + 1000000000ull;
+    while (s_outstanding && now_ns() < drain) {
+        pthread_mutex_unlock(&s_pi_lock);
+        sleep_ms(1);
+        pthread_mutex_lock(&s_pi_lock);
+    }
+    uint32_t lost = s_outstanding;
+    pthread_mutex_unlock(&s_pi_lock);
+    double el = (double)(now_ns() - start) / 1e9;
+
+    rs485_get_sched_stats(&st);
+    vbus_stats(&hub1);
+    for (unsigned i = 0; i < (found + PERIPH_STATS_MAX_ENTRIES - 1u) / PERIPH_STATS_MAX_ENTRIES; i++) {
+        rs485_send_periph_stats();
+    }
+
+    pthread_mutex_lock(&s_pi_lock);
+    qsort(s_lat_us, s_lat_n, sizeof(*s_lat_us), cmp_u32);
+    uint32_t cmds = st.cmds - st0.cmds;
+    printf("load: %u peripherals, window %u, %s%.1f s at %u baud\n",
+           found, window, rate ? "paced, " : "", el, st.baud);
+    printf("  commands   %u sent, %.0f/s: ok %u, timeout %u, bad reply %u, nack %u, lost %u\n",
+           sent, (double)sent / el, s_results[PERIPH_RESULT_OK],
+           s_results[PERIPH_RESULT_TIMEOUT], s_results[PERIPH_RESULT_BAD_REPLY],
+           s_results[PERIPH_RESULT_NACK], lost);
+    printf("  latency    p50 %u  p90 %u  p99 %u  max %u us (Pi queued -> reply)\n",
+           pct(50), pct(90), pct(99), s_lat_n ? s_lat_us[s_lat_n - 1u] : 0);
+    printf("  scheduler  wait mean %u  max %u us, hk timeouts %u, baud fallbacks %u, "
+           "stream frames %u\n",
+           cmds ? (st.cmd_wait_sum_us - st0.cmd_wait_sum_us) / cmds : 0,
+           st.cmd_wait_max_us, st.hk_timeouts - st0.hk_timeouts,
+           st.baud_fallbacks, s_stream_frames - stream0);
+    printf("  registry   %u entries: answered %u, timeouts %u, crc errors %u, "
+           "slowest reply %u us\n",
+           s_ps_entries, s_ps_answered, s_ps_timeouts, s_ps_crc, s_ps_lat_max);
+    printf("  bus        %.1f %% busy, %llu frames, %llu bytes, %llu collisions, %u nodes\n",
+           100.0 * (double)(hub1.busy_ns - hub0.busy_ns) / (double)(hub1.uptime_ns - hub0.uptime_ns),
+           (unsigned long long)(hub1.frames - hub0.frames),
+           (unsigned long long)(hub1.bytes - hub0.bytes),
+           (unsigned long long)(hub1.collisions - hub0.collisions), hub1.nodes);
+
+    bool ok = !s_results[PERIPH_RESULT_NACK] && !lost;
+    pthread_mutex_unlock(&s_pi_lock);
+    return ok ? 0 : 1;
+}
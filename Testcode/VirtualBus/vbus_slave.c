@@ -0,0 +1,91 @@
+/*
+ * Generic peripheral for the virtual bus: the slave framework on
+ * hal_posix.c at any address, so a bench can put 30+ of them on one bus
+ * next to the real apps (Peripherals/<App> built with TARGET_MCU=posix).
+ *
+ * Answers GET_STATUS with [addr][polls u16][0], takes SET_OUTPUT, streams
+ * [seq u16] when the master turns streaming on, and with -i pulls /INT
+ * for a while every few seconds to draw the master's status polls.
+ *
+ * Usage:  vbus_slave <addr> [-i]
+ */
+
+#include "rs485_slave.h"
+#include "hal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INT_EVERY_MS    3000u
+#define INT_HOLD_MS     50u
+
+static uint8_t  s_addr;
+static uint8_t  s_output;
+static uint16_t s_polls, s_seq;
+
+static int h_set_output(const uint8_t *p, uint8_t n, uint8_t *r, uint8_t rs)
+{
+    (void)r; (void)rs;
+    if (n != 2) return -1;
+    if (p[0] == 0) s_output = p[1];
+    return 0;
+}
+
+static int h_get_status(const uint8_t *p, uint8_t n, uint8_t *r, uint8_t rs)
+{
+    (void)p; (void)n;
+    if (rs < 4) return -1;
+    s_polls++;
+    r[0] = s_addr;
+    r[1] = (uint8_t)s_polls;
+    r[2] = (uint8_t)(s_polls >> 8);
+    r[3] = s_output;
+    return 4;
+}
+
+static int build_stream(uint8_t *buf, uint8_t buf_size)
+{
+    if (buf_size < 2) return -1;
+    s_seq++;
+    buf[0] = (uint8_t)s_seq;
+    buf[1] = (uint8_t)(s_seq >> 8);
+    return 2;
+}
+
+#define SLAVE_COMMANDS(X)                   \
+    X(RS485_CMD_SET_OUTPUT, h_set_output)   \
+    X(RS485_CMD_GET_STATUS, h_get_status)
+RS485_DISPATCH_TABLE(s_dispatch, SLAVE_COMMANDS);
+
+int main(int argc, char **argv)
+{
+    unsigned long a = argc > 1 ? strtoul(argv[1], NULL, 0) : 0;
+    bool int_demo   = argc > 2 && strcmp(argv[2], "-i") == 0;
+    if (a < 0x01 || a >= RS485_ADDR_GROUP_FIRST) {
+        fprintf(stderr, "usage: %s <addr 0x01..0xEF> [-i]\n", argv[0]);
+        return 2;
+    }
+    s_addr = (uint8_t)a;
+
+    rs485_slave_cfg_t cfg = {
+        .addr         = s_addr,
+        .fw_version   = 1,
+        .dispatch     = s_dispatch,
+        .build_stream = build_stream,
+    };
+    rs485_slave_init(&cfg);
+
+    /* Stagger the /INT pulses across the addresses */
+    uint32_t int_at = hal_millis() + INT_EVERY_MS + s_addr * 37u % INT_EVERY_MS;
+    bool     int_on = false;
+    while (1) {
+        rs485_slave_poll();
+        if (!int_demo) continue;
+        uint32_t now = hal_millis();
+        if ((int32_t)(now - int_at) < 0) continue;
+        int_on = !int_on;
+        rs485_slave_assert_int(int_on);
+        int_at = now + (int_on ? INT_HOLD_MS : INT_EVERY_MS);
+    }
+}
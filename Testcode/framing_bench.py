@@ -0,0 +1,272 @@
+# CDC framing resync benchmark — SOF/length framing vs. COBS framing
+#
+# Replays a synthetic Pico→Pi traffic mix (telemetry bundles, events,
+# heartbeats, peripheral data) through byte-level models of both receivers,
+# flips random bits, and measures what each corruption costs: how many intact
+# frames are swallowed behind it and how long delivery stalls.
+#
+# No dependencies (does not import the GUI).
+#
+# Usage:  python framing_bench.py [--seconds 120] [--ber 1e-5 1e-4 1e-3] [--seed 1]
+
+import argparse
+import bisect
+import random
+import struct
+
+SOF             = 0xAA
+MAX_PAYLOAD     = 514
+
+TYPE_HEARTBEAT   = 0x05
+TYPE_EVENT       = 0x06
+TYPE_PERIPH_DATA = 0x0D
+TYPE_TELEMETRY   = 0x11
+
+
+# ---------------------------------------------------------------------------
+# Encoders (same wire formats as protocol.c / picolink.cpp)
+# ---------------------------------------------------------------------------
+
+def _raw(msg_type: int, payload: bytes) -> bytes:
+    n = len(payload)
+    c = msg_type ^ (n & 0xFF) ^ (n >> 8)
+    for b in payload:
+        c ^= b
+    return bytes([msg_type, n & 0xFF, n >> 8]) + payload + bytes([c])
+
+
+def encode_sof(msg_type: int, payload: bytes) -> bytes:
+    return bytes([SOF]) + _raw(msg_type, payload)
+
+
+def cobs_encode(data: bytes) -> bytes:
+    out = bytearray([0])
+    code_idx, code = 0, 1
+    for b in data:
+        if b == 0:
+            out[code_idx] = code
+            code_idx, code = len(out), 1
+            out.append(0)
+        else:
+            out.append(b)
+            code += 1
+            if code == 0xFF:
+                out[code_idx] = code
+                code_idx, code = len(out), 1
+                out.append(0)
+    out[code_idx] = code
+    return bytes(out)
+
+
+def encode_cobs(msg_type: int, payload: bytes) -> bytes:
+    return cobs_encode(_raw(msg_type, payload)) + b"\x00"
+
+
+# ---------------------------------------------------------------------------
+# Streaming receivers — byte-for-byte models of proto_handle_rx()
+# ---------------------------------------------------------------------------
+
+class _Fsm:
+    """Frame FSM shared by both framings (starts after SOF / delimiter)."""
+
+    WAIT_SOF, TYPE, LEN, LEN2, PAYLOAD, CKSUM = range(6)
+
+    def __init__(self):
+        self.state = self.WAIT_SOF
+        self.delivered = []     # (offset, type, payload)
+
+    def feed(self, b: int, offset: int, sof_mode: bool) -> None:
+        s = self.state
+        if s == self.WAIT_SOF:
+            if sof_mode and b == SOF:
+                self.state = self.TYPE
+        elif s == self.TYPE:
+            self.type, self.state = b, self.LEN
+        elif s == self.LEN:
+            self.len, self.state = b, self.LEN2
+        elif s == self.LEN2:
+            self.len |= b << 8
+            self.buf = bytearray()
+            if self.len == 0:
+                self.state = self.CKSUM
+            elif self.len > MAX_PAYLOAD:
+                self.state = self.WAIT_SOF
+            else:
+                self.state = self.PAYLOAD
+        elif s == self.PAYLOAD:
+            self.buf.append(b)
+            if len(self.buf) >= self.len:
+                self.state = self.CKSUM
+        else:
+            c = self.type ^ (self.len & 0xFF) ^ (self.len >> 8)
+            for x in self.buf:
+                c ^= x
+            if c == b:
+                self.delivered.append((offset, self.type, bytes(self.buf)))
+            self.state = self.WAIT_SOF
+
+
+class SofReceiver(_Fsm):
+    def feed_byte(self, b: int, offset: int) -> None:
+        self.feed(b, offset, sof_mode=True)
+
+
+class CobsReceiver(_Fsm):
+    def __init__(self):
+        super().__init__()
+        self.left = 0
+        self.code = 0xFF
+
+    def feed_byte(self, b: int, offset: int) -> None:
+        if b == 0:
+            self.state, self.left, self.code = self.TYPE, 0, 0xFF
+            return
+        if self.left == 0:
+            if self.code != 0xFF:
+                self.feed(0, offset, sof_mode=False)
+            self.code, self.left = b, b - 1
+        else:
+            self.feed(b, offset, sof_mode=False)
+            self.left -= 1
+
+
+# ---------------------------------------------------------------------------
+# Traffic model
+# ---------------------------------------------------------------------------
+
+def make_traffic(seconds: float, rng: random.Random) -> list:
+    """Return [(t_ms, type, payload)] sorted by time."""
+    frames = []
+    t = 0
+    adc = [rng.randrange(4096) for _ in range(6)]
+    while t < seconds * 1000:
+        # 50 Hz telemetry bundle — ADC counts wander, so 0xAA shows up naturally
+        adc = [max(0, min(4095, a + rng.randint(-40, 40))) for a in adc]
+        bundle = struct.pack("<IB6HBBHHI", t * 1000, 0x07, *adc,
+                             rng.randrange(256), rng.randrange(256),
+                             rng.randrange(65536), rng.randrange(65536),
+                             rng.randrange(1 << 20))
+        frames.append((t, TYPE_TELEMETRY, bundle))
+        if t % 1000 == 0:
+            frames.append((t, TYPE_HEARTBEAT, bytes([(t // 1000) & 0xFF])))
+        if rng.random() < 0.05:     # ~2.5 operator events/s
+            frames.append((t, TYPE_EVENT,
+                           struct.pack("<BH", rng.randint(1, 4), rng.randrange(16))))
+        if rng.random() < 0.02:     # occasional peripheral status, up to 255 B
+            n = rng.randint(3, 255)
+            frames.append((t, TYPE_PERIPH_DATA,
+                           bytes([1, 0x12]) + bytes(rng.randrange(256) for _ in range(n))))
+        t += 20
+    return frames
+
+
+def build_stream(frames: list, encoder) -> tuple:
+    """Concatenate frames; return (stream, [(start, end_offset_of_last_byte, t_ms)])."""
+    stream = bytearray()
+    spans = []
+    for t, msg_type, payload in frames:
+        enc = encoder(msg_type, payload)
+        spans.append((len(stream), len(stream) + len(enc) - 1, t))
+        stream += enc
+    return stream, spans
+
+
+def corrupt(stream: bytearray, spans: list, ber: float, rng: random.Random) -> set:
+    """Flip bits with probability `ber`; return indices of frames hit."""
+    hit = set()
+    nbits = len(stream) * 8
+    # Geometric gaps between flips — equivalent to an independent BER per bit
+    pos = int(rng.expovariate(ber)) if ber > 0 else nbits
+    while pos < nbits:
+        stream[pos // 8] ^= 1 << (pos % 8)
+        hit.add(pos // 8)
+        pos += 1 + int(rng.expovariate(ber))
+    frame_hits = set()
+    j = 0
+    for byte_idx in sorted(hit):
+        while j < len(spans) and spans[j][1] < byte_idx:
+            j += 1
+        if j < len(spans):
+            frame_hits.add(j)
+    return frame_hits
+
+
+# ---------------------------------------------------------------------------
+# Metrics
+# ---------------------------------------------------------------------------
+
+def run(frames: list, encoder, receiver_cls, ber: float, seed: int) -> dict:
+    rng = random.Random(seed)
+    stream, spans = build_stream(frames, encoder)
+    hit = corrupt(stream, spans, ber, rng)
+
+    rx = receiver_cls()
+    for off, b in enumerate(stream):
+        rx.feed_byte(b, off)
+
+    starts = [start for start, _, _ in spans]
+    got = set()
+    bogus = 0
+    for off, msg_type, payload in rx.delivered:
+        i = bisect.bisect_right(starts, off) - 1
+        if (msg_type, payload) != frames[i][1:]:
+            bogus += 1          # checksum collision on garbage / corrupted frame
+        elif i not in hit:
+            got.add(i)          # (a hit frame can still arrive intact, e.g. a flipped delimiter)
+
+    intact = [i for i in range(len(spans)) if i not in hit]
+    lost = [i for i in intact if i not in got]
+
+    # Stall per corruption: time from the first intact frame after a hit to
+    # the first frame the receiver actually delivered after the hit.
+    stalls = []
+    delivered_sorted = sorted(got)
+    k = 0
+    for h in sorted(hit):
+        nxt = next((i for i in range(h + 1, len(spans)) if i not in hit), None)
+        if nxt is None:
+            continue
+        while k < len(delivered_sorted) and delivered_sorted[k] <= h:
+            k += 1
+        if k >= len(delivered_sorted):
+            continue
+        stalls.append(spans[delivered_sorted[k]][2] - spans[nxt][2])
+
+    stalls.sort()
+    lost_events = sum(1 for i in lost if frames[i][1] == TYPE_EVENT)
+    return {
+        "bytes":       len(stream),
+        "corrupted":   len(hit),
+        "lost":        len(lost),
+        "lost_events": lost_events,
+        "bogus":       bogus,
+        "stall_mean":  sum(stalls) / len(stalls) if stalls else 0.0,
+        "stall_p99":   stalls[int(0.99 * (len(stalls) - 1))] if stalls else 0,
+        "stall_max":   stalls[-1] if stalls else 0,
+    }
+
+
+def main() -> None:
+    ap = argparse.ArgumentParser(description=__doc__)
+    ap.add_argument("--seconds", type=float, default=120.0)
+    ap.add_argument("--ber", type=float, nargs="+", default=[1e-5, 1e-4, 1e-3])
+    ap.add_argument("--seed", type=int, default=1)
+    args = ap.parse_args()
+
+    frames = make_traffic(args.seconds, random.Random(args.seed))
+    print(f"{len(frames)} frames over {args.seconds:.0f} s of simulated traffic\n")
+    print(f"{'BER':>8}  {'framing':<5}  {'bytes':>7}  {'corrupt':>7}  {'lost':>5}"
+          f"  {'lost ev':>7}  {'bogus':>5}  {'stall mean':>10}  {'p99':>6}  {'max':>6}")
+    for ber in args.ber:
+        for name, enc, rx in (("SOF", encode_sof, SofReceiver),
+                              ("COBS", encode_cobs, CobsReceiver)):
+            r = run(frames, enc, rx, ber, args.seed)
+            print(f"{ber:>8.0e}  {name:<5}  {r['bytes']:>7}  {r['corrupted']:>7}"
+                  f"  {r['lost']:>5}  {r['lost_events']:>7}  {r['bogus']:>5}"
+                  f"  {r['stall_mean']:>8.1f}ms  {r['stall_p99']:>4}ms  {r['stall_max']:>4}ms")
+    print("\nlost    = intact frames swallowed behind a corrupted one")
+    print("stall   = delay until the receiver delivers again after a corrupted frame")
+
+
+if __name__ == "__main__":
+    main()
@@ -41,6 +41,60 @@ class GCSProtocol:
     TYPE_PERIPH_STATE  = 0x0E  # Pico→Pi: peripheral online/offline notification
     TYPE_PERIPH_SCREEN = 0x0F  # Pi→Pico: select peripheral detail screen
     TYPE_WORKLIGHT     = 0x10  # Pi→Pico: worklight on/off + colour
+    TYPE_TELEMETRY     = 0x11  # Pico→Pi: ADC + digital + ALS bundle
+    TYPE_LINK_CFG      = 0x12  # both:    framing negotiation
+    TYPE_LINK_STATS    = 0x13  # Pico→Pi: CDC link health counters (1 Hz)
+    TYPE_BATCH         = 0x14  # Pi→Pico: several control commands, applied at once
+    TYPE_SUBSCRIBE     = 0x15  # Pi→Pico: telemetry topic rates / modes
+    TYPE_PERIPH_SCAN   = 0x16  # Pi→Pico: rediscover RS-485 peripherals
+    TYPE_PERIPH_STATS  = 0x17  # Pico→Pi: RS-485 per-device latency / errors (1 Hz)
+
+    # Framing modes (TYPE_LINK_CFG payload)
+    FRAMING_SOF  = 0
+    FRAMING_COBS = 1
+    MAX_PAYLOAD  = 514
+
+    # Sample timestamps are the Pico's time_us_32() (µs, wraps every ~71.6 min)
+    ADC_FMT     = "<6HI"    # adc_packet_t:     ch[6](u16) ts_us(u32) = 16 bytes
+    DIGITAL_FMT = "<BBI"    # digital_packet_t: port_a port_b ts_us(u32) = 6 bytes
+    ALS_FMT     = "<HHII"   # als_packet_t:     als_raw white_raw lux_milli ts_us = 12 bytes
+
+    # heartbeat_pkt_t: seq(u8) t_us(u32) = 5 bytes (Pi→Pico and Pico's own)
+    # heartbeat_echo_t: seq(u8) t1_us t2_us t3_us (u32) = 13 bytes (Pico's echo)
+    HEARTBEAT_FMT      = "<BI"
+    HEARTBEAT_ECHO_FMT = "<BIII"
+
+    # telemetry_bundle_t: ts_us(u32) fresh(u8) adc[6](u16) port_a port_b
+    #                     als_raw(u16) white_raw(u16) lux_milli(u32) = 27 bytes
+    TELEMETRY_FMT       = "<IB6HBBHHI"
+    TELEM_FRESH_ADC     = 0x01
+    TELEM_FRESH_DIGITAL = 0x02
+    TELEM_FRESH_ALS     = 0x04
+
+    # subscribe_entry_t: topic mode period_ms(u16) decimation deadband(u16) = 7 bytes;
+    # TYPE_SUBSCRIBE carries 1-3 of them. Until one arrives (per USB session)
+    # every topic streams at the default rate, which is what this tester uses.
+    SUBSCRIBE_FMT       = "<BBHBH"
+    TELEM_TOPIC_ADC     = 0
+    TELEM_TOPIC_DIGITAL = 1
+    TELEM_TOPIC_ALS     = 2
+    SUB_MODE_OFF        = 0
+    SUB_MODE_PERIODIC   = 1
+    SUB_MODE_ON_CHANGE  = 2
+
+    # link_stats_hdr_t: ts_ms(u32) event_hwm event_size bulk_hwm bulk_size (u16)
+    #   event_dropped bulk_dropped cdc_short_writes rx_bad_cksum rx_oversize (u32)
+    #   n_types(u8) = 33 bytes, then n_types × link_stats_type_t:
+    #   type(u8) enqueued serialized dropped rx_ok rx_rejected (u32) = 21 bytes
+    LINK_STATS_HDR_FMT  = "<IHHHHIIIIIB"
+    LINK_STATS_TYPE_FMT = "<BIIIII"
+
+    # periph_stats_hdr_t: ts_ms baud (u32) lat_base_us (u16) lat_bins n_periph (u8)
+    #   = 12 bytes, then n_periph × periph_stats_entry_t: addr online (u8)
+    #   answered timeouts crc_errors timeout_us lat_max_us (u32), then
+    #   lat_hist[lat_bins] (u32)
+    PERIPH_STATS_HDR_FMT   = "<IIHBB"
+    PERIPH_STATS_ENTRY_FMT = "<BBIIIII"
 
     # LED chain IDs (first byte of LED payload)
     CHAIN_SK6812    = 0x00
@@ -79,6 +133,9 @@ class GCSProtocol:
         0xF0: "ERROR",      0xFF: "SYNC",
     }
 
+    # periph_data_t.result  (index == value)
+    PERIPH_RESULT_NAMES = ["OK", "SENT", "TIMEOUT", "BAD_REPLY", "NACK"]
+
     # Warning icon names  (index == payload byte position)
     WARN_NAMES = [
         "TEMP", "SIGNAL", "AIRCRAFT", "DRONE_LINK", "MAIN",
@@ -89,6 +146,13 @@ class GCSProtocol:
     # Firmware max payload = 514 bytes.
     # SK6812 chain: payload = [chain(1), num_px(1), GRBW*n] → max n = (514-2)/4 = 128
     SK6812_MAX_PIXELS_PER_SEND = 128
+    SK6812_MAX_PIXELS          = 128
+
+    # SK6812 partial updates: payload = [chain=0, num_px=0, op, a, b, data...]
+    SK_OP_FILL    = 0x01  # [start][count] G R B W
+    SK_OP_RUNS    = 0x02  # [start][n_runs] n × (len G R B W)
+    SK_OP_PALETTE = 0x03  # [first][count] count × (G R B W)
+    SK_OP_INDEXED = 0x04  # [start][count] 4-bit indices, high nibble first
 
     @staticmethod
     def _checksum(msg_type: int, length: int, payload: bytes) -> int:
@@ -105,11 +169,12 @@ class GCSProtocol:
                       length & 0xFF, (length >> 8) & 0xFF]) + payload + bytes([cksum])
 
     @staticmethod
-    def parse_stream(buffer: bytes) -> tuple:
+    def parse_stream(buffer: bytes, stop_type: int | None = None) -> tuple:
         """
         Scan buffer for complete, valid packets.
         Returns (list_of_(type, payload_bytes), remaining_unprocessed_bytes).
         Skips garbage bytes before each SOF.  Leaves partial packets buffered.
+        Stops right after a packet of stop_type (used for framing switches).
         """
         packets = []
         i = 0
@@ -131,10 +196,79 @@ class GCSProtocol:
             if cksum_rx == cksum_exp:
                 packets.append((msg_type, bytes(payload)))
                 i += 5 + length
+                if msg_type == stop_type:
+                    break
             else:
                 i += 1  # bad checksum, skip this SOF byte and keep scanning
         return packets, buffer[i:]
 
+    # -- COBS framing: COBS([type][len_lo][len_hi][payload][cksum]) 0x00 ----
+
+    @staticmethod
+    def cobs_encode(data: bytes) -> bytes:
+        out = bytearray([0])
+        code_idx, code = 0, 1
+        for b in data:
+            if b == 0:
+                out[code_idx] = code
+                code_idx, code = len(out), 1
+                out.append(0)
+            else:
+                out.append(b)
+                code += 1
+                if code == 0xFF:
+                    out[code_idx] = code
+                    code_idx, code = len(out), 1
+                    out.append(0)
+        out[code_idx] = code
+        return bytes(out)
+
+    @staticmethod
+    def cobs_decode(data: bytes):
+        """Decode one COBS frame (delimiter stripped). Returns bytes or None."""
+        out = bytearray()
+        i = 0
+        while i < len(data):
+            code = data[i]
+            if code == 0 or i + code > len(data):
+                return None
+            out += data[i + 1:i + code]
+            i += code
+            if code != 0xFF and i < len(data):
+                out.append(0)
+        return bytes(out)
+
+    @staticmethod
+    def sof_to_cobs(frame: bytes) -> bytes:
+        """Re-frame one packet from build_packet() for a COBS link."""
+        return GCSProtocol.cobs_encode(frame[1:]) + b"\x00"
+
+    @staticmethod
+    def parse_stream_cobs(buffer: bytes, stop_type: int | None = None) -> tuple:
+        """
+        COBS counterpart of parse_stream(): split on 0x00, decode and verify
+        each frame. A corrupt frame is dropped on its own.
+        """
+        packets = []
+        while True:
+            end = buffer.find(b"\x00")
+            if end < 0:
+                break
+            raw = GCSProtocol.cobs_decode(buffer[:end])
+            buffer = buffer[end + 1:]
+            if raw is None or len(raw) < 4:
+                continue
+            msg_type = raw[0]
+            length   = raw[1] | (raw[2] << 8)
+            if len(raw) != 4 + length:
+                continue
+            payload = raw[3:3 + length]
+            if raw[3 + length] == GCSProtocol._checksum(msg_type, length, payload):
+                packets.append((msg_type, bytes(payload)))
+                if msg_type == stop_type:
+                    break
+        return packets, buffer
+
 
 # ---------------------------------------------------------------------------
 # ComboBox adapter
@@ -187,12 +321,14 @@ class SerialDriver:
         self._rx_callback = rx_callback
         self._rx_buf = b""
         self._lock = threading.Lock()  # guards _ser.write access
+        self.cobs = False              # framing in effect; switched by TYPE_LINK_CFG
 
     def connect(self, port: str, baud: int = 115200) -> bool:
         try:
             self._ser = serial.Serial(port, baud, timeout=0.05)
             self._running = True
             self._rx_buf = b""
+            self.cobs = False          # Pico reverts to SOF framing on every connect
             self._thread = threading.Thread(target=self._rx_loop, daemon=True)
             self._thread.start()
             return True
@@ -215,6 +351,8 @@ class SerialDriver:
     def send(self, data: bytes) -> bool:
         if not self.is_connected():
             return False
+        if self.cobs:
+            data = GCSProtocol.sof_to_cobs(data)
         try:
             with self._lock:
                 self._ser.write(data)
@@ -234,14 +372,28 @@ class SerialDriver:
                     # Cap buffer to prevent unbounded growth on garbage data
                     if len(self._rx_buf) > 1024:
                         self._rx_buf = self._rx_buf[-512:]
-                    packets, self._rx_buf = GCSProtocol.parse_stream(self._rx_buf)
-                    for msg_type, payload in packets:
-                        self._rx_callback(msg_type, payload)
+                    self._drain_rx_buf()
             except (serial.SerialException, OSError):
                 self._running = False
                 self._rx_callback(None, None)
                 return
 
+    def _drain_rx_buf(self) -> None:
+        # A LINK_CFG reply switches framing mid-buffer, so parsing stops after
+        # it and the remainder is parsed again with the new framing.
+        while True:
+            parse = (GCSProtocol.parse_stream_cobs if self.cobs
+                     else GCSProtocol.parse_stream)
+            packets, self._rx_buf = parse(self._rx_buf,
+                                          stop_type=GCSProtocol.TYPE_LINK_CFG)
+            for msg_type, payload in packets:
+                self._rx_callback(msg_type, payload)
+            if not packets or packets[-1][0] != GCSProtocol.TYPE_LINK_CFG:
+                return
+            cfg = packets[-1][1]
+            if cfg:
+                self.cobs = cfg[0] == GCSProtocol.FRAMING_COBS
+
     @staticmethod
     def list_ports() -> list:
         return sorted(p.device for p in serial.tools.list_ports.comports())
@@ -281,6 +433,7 @@ class GCSTesterApp(ctk.CTk):
 
         self._driver = SerialDriver(rx_callback=self._on_rx_packet)
         self._hb_seq = 0
+        self._periph_req_id = 0     # last PERIPH_CMD req_id, 1–255
         self._hb_auto = False
         self._hb_after_id = None
         self._log_queue: queue.SimpleQueue = queue.SimpleQueue()
@@ -335,6 +488,10 @@ class GCSTesterApp(ctk.CTk):
         self._baud_entry.insert(0, "115200")
         self._baud_entry.pack(side="left", padx=2)
 
+        self._cobs_var = tk.BooleanVar(value=False)
+        ctk.CTkCheckBox(bar, text="COBS", width=60,
+                        variable=self._cobs_var).pack(side="left", padx=(10, 2))
+
         self._connect_btn = ctk.CTkButton(bar, text="Connect", width=90,
                                           fg_color="#1a7a1a", hover_color="#247a24",
                                           command=self._on_connect)
@@ -777,7 +934,7 @@ class GCSTesterApp(ctk.CTk):
         self._sk_end.insert(0, "60")
         self._sk_end.pack(side="left")
 
-        note = ctk.CTkLabel(sk_box, text=f"Max {GCSProtocol.SK6812_MAX_PIXELS_PER_SEND} px/send (protocol limit)",
+        note = ctk.CTkLabel(sk_box, text="Sent as one FILL op (partial update, other pixels unchanged)",
                              font=ctk.CTkFont(size=10), text_color="#888888")
         note.pack(anchor="w", padx=10, pady=(0, 4))
 
@@ -962,7 +1119,7 @@ class GCSTesterApp(ctk.CTk):
 
     def _send_heartbeat_once(self):
         seq = self._hb_seq & 0xFF
-        payload = bytes([seq])
+        payload = struct.pack(GCSProtocol.HEARTBEAT_FMT, seq, self._clock_us())
         pkt = GCSProtocol.build_packet(GCSProtocol.TYPE_HEARTBEAT, payload)
         if self._driver.send(pkt):
             self._log_tx(GCSProtocol.TYPE_HEARTBEAT, payload, f"seq={seq}")
@@ -1015,36 +1172,20 @@ class GCSTesterApp(ctk.CTk):
         b_val = int(self._sk_b.get())
         w_val = int(self._sk_w.get())
 
-        cap = GCSProtocol.SK6812_MAX_PIXELS_PER_SEND
-        # Send in chunks of at most cap pixels
-        px = start
-        while px <= end:
-            chunk_end  = min(end, px + cap - 1)
-            # Payload: all pixels from 0 to chunk_end (zeros before 'px')
-            num_pixels = chunk_end + 1
-            pixel_data = bytearray(num_pixels * 4)
-            for p in range(px, chunk_end + 1):
-                base = p * 4
-                pixel_data[base]     = g_val
-                pixel_data[base + 1] = r_val
-                pixel_data[base + 2] = b_val
-                pixel_data[base + 3] = w_val
-            payload = bytes([GCSProtocol.CHAIN_SK6812, num_pixels]) + bytes(pixel_data)
-            pkt = GCSProtocol.build_packet(GCSProtocol.TYPE_LED, payload)
-            if self._driver.send(pkt):
-                self._log_tx(GCSProtocol.TYPE_LED, payload,
-                             f"SK6812 px {px}-{chunk_end} G={g_val} R={r_val} B={b_val} W={w_val}")
-            px = chunk_end + 1
+        # One FILL op (9 bytes) instead of a full-frame dump up to 'end'
+        payload = bytes([GCSProtocol.CHAIN_SK6812, 0, GCSProtocol.SK_OP_FILL,
+                         start, end - start + 1, g_val, r_val, b_val, w_val])
+        pkt = GCSProtocol.build_packet(GCSProtocol.TYPE_LED, payload)
+        if self._driver.send(pkt):
+            self._log_tx(GCSProtocol.TYPE_LED, payload,
+                         f"SK6812 fill px {start}-{end} G={g_val} R={r_val} B={b_val} W={w_val}")
 
     def _send_sk6812_clear(self):
-        cap = GCSProtocol.SK6812_MAX_PIXELS_PER_SEND
-        for start in range(0, 128, cap):
-            num = min(cap, 128 - start)
-            pixel_data = bytes(num * 4)
-            payload = bytes([GCSProtocol.CHAIN_SK6812, num]) + pixel_data
-            pkt = GCSProtocol.build_packet(GCSProtocol.TYPE_LED, payload)
-            self._driver.send(pkt)
-        self._log_tx(GCSProtocol.TYPE_LED, b"", "SK6812 clear all (black)")
+        payload = bytes([GCSProtocol.CHAIN_SK6812, 0, GCSProtocol.SK_OP_FILL,
+                         0, GCSProtocol.SK6812_MAX_PIXELS, 0, 0, 0, 0])
+        pkt = GCSProtocol.build_packet(GCSProtocol.TYPE_LED, payload)
+        if self._driver.send(pkt):
+            self._log_tx(GCSProtocol.TYPE_LED, payload, "SK6812 clear all (black)")
 
     def _send_brightness(self):
         val = self._bright_target.get()
@@ -1097,12 +1238,18 @@ class GCSTesterApp(ctk.CTk):
             self._log_info("Invalid payload hex — use pairs like  00 FF  or  00FF")
             return
 
-        # Build TYPE_PERIPH_CMD packet: [addr, cmd, len, payload...]
-        pkt_payload = bytes([addr, cmd, len(payload_bytes)]) + payload_bytes
+        if len(payload_bytes) > 255:
+            self._log_info("Payload too long — at most 255 bytes")
+            return
+
+        # Build TYPE_PERIPH_CMD packet: [req_id, addr, cmd, len, payload...]
+        self._periph_req_id = self._periph_req_id % 255 + 1
+        req_id = self._periph_req_id
+        pkt_payload = bytes([req_id, addr, cmd, len(payload_bytes)]) + payload_bytes
         pkt = GCSProtocol.build_packet(GCSProtocol.TYPE_PERIPH_CMD, pkt_payload)
         if self._driver.send(pkt):
             cmd_name = GCSProtocol.RS485_CMD_NAMES.get(cmd, f"0x{cmd:02X}")
-            note = f"→ 0x{addr:02X} cmd={cmd_name}"
+            note = f"#{req_id} → 0x{addr:02X} cmd={cmd_name}"
             if payload_bytes:
                 note += f"  payload={payload_bytes.hex(' ').upper()}"
             self._log_tx(GCSProtocol.TYPE_PERIPH_CMD, pkt_payload, note)
@@ -1122,14 +1269,17 @@ class GCSTesterApp(ctk.CTk):
         if self._driver.send(pkt):
             self._log_tx(GCSProtocol.TYPE_SCREEN, payload, "→ PERIPH overview screen")
 
+    @staticmethod
+    def _clock_us() -> int:
+        return (time.perf_counter_ns() // 1000) & 0xFFFFFFFF
+
     # -----------------------------------------------------------------------
     # RX handlers (called via self.after() — main thread only)
     # -----------------------------------------------------------------------
 
     def _update_adc(self, payload: bytes):
         try:
-            channels = struct.unpack_from("<6H", payload, 0)
-            ts = struct.unpack_from("<H", payload, 12)[0]
+            *channels, ts = struct.unpack_from(GCSProtocol.ADC_FMT, payload, 0)
         except struct.error:
             return
         for i, raw in enumerate(channels):
@@ -1139,13 +1289,12 @@ class GCSTesterApp(ctk.CTk):
             self._adc_raw[i].configure(text=str(raw))
             self._adc_volt[i].configure(text=f"{v:6.3f}V")
             self._adc_bar[i].set(raw / 4095.0)
-        self._adc_ts_label.configure(text=f"ts: {ts} ms")
+        self._adc_ts_label.configure(text=f"ts: {ts / 1000:.3f} ms")
         self._pkt_count += 1
 
     def _update_als(self, payload: bytes):
-        # als_packet_t: als_raw(u16) + white_raw(u16) + lux_milli(u32) + ts_ms(u16) = 10 bytes
         try:
-            als_raw, white_raw, lux_milli, ts = struct.unpack_from("<HHIH", payload, 0)
+            als_raw, white_raw, lux_milli, ts = struct.unpack_from(GCSProtocol.ALS_FMT, payload, 0)
         except struct.error:
             return
         lux = lux_milli / 1000.0
@@ -1154,7 +1303,7 @@ class GCSTesterApp(ctk.CTk):
         self._als_bar.set(min(1.0, lux / 120000.0))
         self._als_raw_label.configure(text=str(als_raw))
         self._als_white_label.configure(text=str(white_raw))
-        self._als_ts_label.configure(text=f"ts: {ts} ms")
+        self._als_ts_label.configure(text=f"ts: {ts / 1000:.3f} ms")
         self._pkt_count += 1
 
     def _update_digital(self, port_a: int, port_b: int, ts: int):
@@ -1172,7 +1321,7 @@ class GCSTesterApp(ctk.CTk):
             canvas = self._dig_indicators.get(name)
             if canvas:
                 canvas.itemconfig("dot", fill=color)
-        self._dig_ts_label.configure(text=f"ts: {ts} ms")
+        self._dig_ts_label.configure(text=f"ts: {ts / 1000:.3f} ms")
         self._pkt_count += 1
 
     def _handle_event(self, evt_id: int, value: int):
@@ -1223,19 +1372,26 @@ class GCSTesterApp(ctk.CTk):
         self._log_rx(msg_type, payload)
 
         if msg_type == GCSProtocol.TYPE_ADC:
-            if len(payload) >= 14:
+            if len(payload) >= 16:
                 self.after(0, self._update_adc, payload)
 
         elif msg_type == GCSProtocol.TYPE_DIGITAL:
-            if len(payload) >= 4:
-                port_a = payload[0]
-                port_b = payload[1]
-                ts     = struct.unpack_from("<H", payload, 2)[0]
+            if len(payload) >= 6:
+                port_a, port_b, ts = struct.unpack_from(GCSProtocol.DIGITAL_FMT, payload, 0)
                 self.after(0, self._update_digital, port_a, port_b, ts)
 
         elif msg_type == GCSProtocol.TYPE_HEARTBEAT:
             seq = payload[0] if payload else 0
-            self.after(0, lambda s=seq: self._hb_seq_label.configure(text=f"SEQ: {s}"))
+            text = f"SEQ: {seq}"
+            if len(payload) >= 13:
+                # Echo of our heartbeat: NTP round trip and Pico − tester offset
+                t4 = self._clock_us()
+                _, t1, t2, t3 = struct.unpack_from(GCSProtocol.HEARTBEAT_ECHO_FMT, payload, 0)
+                s32 = lambda v: ((v + (1 << 31)) & 0xFFFFFFFF) - (1 << 31)
+                rtt = s32(t4 - t1) - s32(t3 - t2)
+                offset = s32(t2 - t1) - rtt // 2
+                text += f"  RTT: {rtt / 1000:.2f} ms  OFFSET: {offset / 1e6:+.3f} s"
+            self.after(0, lambda t=text: self._hb_seq_label.configure(text=t))
 
         elif msg_type == GCSProtocol.TYPE_EVENT:
             if len(payload) >= 3:
@@ -1243,9 +1399,82 @@ class GCSTesterApp(ctk.CTk):
                 self.after(0, self._handle_event, evt_id, value)
 
         elif msg_type == GCSProtocol.TYPE_ALS:
-            if len(payload) >= 10:
+            if len(payload) >= 12:
                 self.after(0, self._update_als, payload)
 
+        elif msg_type == GCSProtocol.TYPE_TELEMETRY:
+            try:
+                f = struct.unpack_from(GCSProtocol.TELEMETRY_FMT, payload, 0)
+            except struct.error:
+                return
+            ts, fresh = f[0], f[1]
+            ch, port_a, port_b = f[2:8], f[8], f[9]
+            als_raw, white_raw, lux_milli = f[10], f[11], f[12]
+            # Re-pack into the legacy layouts so the existing widgets update unchanged
+            if fresh & GCSProtocol.TELEM_FRESH_ADC:
+                self.after(0, self._update_adc,
+                           struct.pack(GCSProtocol.ADC_FMT, *ch, ts))
+            if fresh & GCSProtocol.TELEM_FRESH_DIGITAL:
+                self.after(0, self._update_digital, port_a, port_b, ts)
+            if fresh & GCSProtocol.TELEM_FRESH_ALS:
+                self.after(0, self._update_als,
+                           struct.pack(GCSProtocol.ALS_FMT, als_raw, white_raw, lux_milli, ts))
+
+        elif msg_type == GCSProtocol.TYPE_LINK_CFG:
+            if payload:
+                mode = "COBS" if payload[0] == GCSProtocol.FRAMING_COBS else "SOF"
+                self._log_queue.put(("EVENT", f"LINK_CFG  framing now {mode}"))
+
+        elif msg_type == GCSProtocol.TYPE_LINK_STATS:
+            try:
+                h = struct.unpack_from(GCSProtocol.LINK_STATS_HDR_FMT, payload, 0)
+            except struct.error:
+                return
+            ev_hwm, ev_size, bk_hwm, bk_size = h[1:5]
+            ev_drop, bk_drop, short_wr, bad_ck, oversize, n_types = h[5:11]
+            hdr = struct.calcsize(GCSProtocol.LINK_STATS_HDR_FMT)
+            ent = struct.calcsize(GCSProtocol.LINK_STATS_TYPE_FMT)
+            tx_drop = 0
+            for i in range(n_types):
+                if hdr + (i + 1) * ent > len(payload):
+                    break
+                tx_drop += struct.unpack_from(GCSProtocol.LINK_STATS_TYPE_FMT,
+                                              payload, hdr + i * ent)[3]
+            # Only worth a log line when something got worse
+            key = (ev_drop, bk_drop, tx_drop, bad_ck + oversize)
+            if key != getattr(self, "_last_link_stats", key):
+                self._log_queue.put((
+                    "ERR" if ev_drop != self._last_link_stats[0] else "EVENT",
+                    f"LINK_STATS  evt drop={ev_drop} bulk drop={bk_drop} tx drop={tx_drop}"
+                    f"  rx rej={bad_ck + oversize}  short wr={short_wr}"
+                    f"  peak evt={ev_hwm}/{ev_size} bulk={bk_hwm}/{bk_size}"))
+            self._last_link_stats = key
+
+        elif msg_type == GCSProtocol.TYPE_PERIPH_STATS:
+            try:
+                _, baud, _, bins, n = struct.unpack_from(
+                    GCSProtocol.PERIPH_STATS_HDR_FMT, payload, 0)
+            except struct.error:
+                return
+            off = struct.calcsize(GCSProtocol.PERIPH_STATS_HDR_FMT)
+            fixed = struct.calcsize(GCSProtocol.PERIPH_STATS_ENTRY_FMT)
+            last = getattr(self, "_last_periph_stats", {})
+            for _ in range(n):
+                if off + fixed + 4 * bins > len(payload):
+                    break
+                addr, online, ok, tmo, crc, tmo_us, max_us = struct.unpack_from(
+                    GCSProtocol.PERIPH_STATS_ENTRY_FMT, payload, off)
+                off += fixed + 4 * bins
+                # Only worth a log line when a device times out or corrupts more
+                if (tmo, crc) != last.get(addr, (tmo, crc)):
+                    self._log_queue.put((
+                        "ERR",
+                        f"PERIPH_STATS  0x{addr:02X} ok={ok} timeouts={tmo} crc err={crc}"
+                        f"  max={max_us / 1000:.2f} ms  timeout={tmo_us / 1000:.1f} ms"
+                        f"  @{baud} baud"))
+                last[addr] = (tmo, crc)
+            self._last_periph_stats = last
+
         elif msg_type == GCSProtocol.TYPE_ERROR:
             code = payload[0] if payload else 0
             err_names = {1: "WATCHDOG_RESET", 2: "STACK_OVERFLOW", 3: "MALLOC_FAILED"}
@@ -1264,19 +1493,23 @@ class GCSTesterApp(ctk.CTk):
                 self.after(0, self._update_periph_state, addr, online)
 
         elif msg_type == GCSProtocol.TYPE_PERIPH_DATA:
-            # periph_data_t on wire: [addr, cmd, data...]
-            if len(payload) >= 2:
-                addr = payload[0]
-                cmd  = payload[1]
-                data = payload[2:]
+            # periph_data_t on wire: [req_id, result, addr, cmd, len, data...]
+            if len(payload) >= 5:
+                req_id, result, addr, cmd, dlen = payload[:5]
+                data = payload[5:5 + dlen]
                 name     = GCSProtocol.PERIPH_NAMES.get(addr, f"0x{addr:02X}")
                 cmd_name = GCSProtocol.RS485_CMD_NAMES.get(cmd, f"0x{cmd:02X}")
+                res_name = (GCSProtocol.PERIPH_RESULT_NAMES[result]
+                            if result < len(GCSProtocol.PERIPH_RESULT_NAMES)
+                            else f"0x{result:02X}")
                 self._log_queue.put((
                     "RX",
                     f"PERIPH_DATA   0x{addr:02X} {name}  cmd={cmd_name}"
+                    + (f"  #{req_id} {res_name}" if req_id else "")
                     + (f"  {data.hex(' ').upper()}" if data else "")
                 ))
-                self.after(0, self._update_periph_data, addr, cmd, data)
+                if result == 0:
+                    self.after(0, self._update_periph_data, addr, cmd, data)
 
     # -----------------------------------------------------------------------
     # Connection management
@@ -1303,6 +1536,12 @@ class GCSTesterApp(ctk.CTk):
             self._connect_btn.configure(state="disabled")
             self._disconnect_btn.configure(state="normal")
             self._log_info(f"Connected to {port} @ {baud}")
+            if self._cobs_var.get():
+                payload = bytes([GCSProtocol.FRAMING_COBS])
+                pkt = GCSProtocol.build_packet(GCSProtocol.TYPE_LINK_CFG, payload)
+                if self._driver.send(pkt):
+                    self._log_tx(GCSProtocol.TYPE_LINK_CFG, payload,
+                                 "request COBS framing")
         else:
             self._status_label.configure(text="● FAILED", text_color="#FF4444")
             self._log_info(f"Failed to open {port}")